@@ -0,0 +1,175 @@
+/*
+* Copyright (c) 2012-2016, NVIDIA CORPORATION. All rights reserved.
+*
+* NVIDIA CORPORATION and its licensors retain all intellectual property
+* and proprietary rights in and to this software, related documentation
+* and any modifications thereto. Any use, reproduction, disclosure or
+* distribution of this software and related documentation without an express
+* license agreement from NVIDIA CORPORATION is strictly prohibited.
+*/
+
+#pragma once
+
+#include <GFSDK_NVRHI.h>
+#include "GFSDK_NVRHI_Hash.h"
+
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace NVRHI
+{
+    // Default limits of the state object caches, see IRendererInterface::setStateCacheLimits
+    static const uint32_t DefaultStateCacheMaxEntries = 4096;
+    static const uint64_t DefaultStateCacheMaxBytes = 0;
+
+    // A cache of backend objects that are created on demand, bounded by a number of entries and by an estimate of their memory.
+    // Entries are kept in least recently used order: Find moves an entry to the front, and Insert evicts from the back
+    // until both limits are met again. The entry that is being inserted is never evicted, so it can be used right away.
+    // The cache never destroys anything itself: the values that are evicted or erased are handed back to the caller,
+    // which knows when the GPU has finished using them.
+    template<typename Key, typename Value, typename Hash = BytewiseHash<Key>, typename Equal = BytewiseEqual<Key>>
+    class BoundedCache
+    {
+    public:
+        struct Entry
+        {
+            Key key;
+            Value value;
+            uint64_t bytes;
+        };
+
+        typedef typename std::list<Entry>::iterator iterator;
+
+    private:
+        std::list<Entry> m_Entries;
+        std::unordered_map<Key, iterator, Hash, Equal> m_Index;
+        uint32_t m_MaxEntries;
+        uint64_t m_MaxBytes;
+        CacheStatistics m_Statistics;
+
+        void EvictToLimits(size_t keepEntries, std::vector<Value>& evicted)
+        {
+            while (m_Entries.size() > keepEntries &&
+                ((m_MaxEntries && m_Entries.size() > m_MaxEntries) || (m_MaxBytes && m_Statistics.bytes > m_MaxBytes)))
+            {
+                Entry& entry = m_Entries.back();
+                evicted.push_back(entry.value);
+                m_Index.erase(entry.key);
+                m_Statistics.bytes -= entry.bytes;
+                m_Statistics.evictions++;
+                m_Entries.pop_back();
+            }
+
+            m_Statistics.entries = m_Entries.size();
+        }
+
+    public:
+        BoundedCache()
+            : m_MaxEntries(DefaultStateCacheMaxEntries)
+            , m_MaxBytes(DefaultStateCacheMaxBytes)
+        { }
+
+        // A limit of 0 means no limit. Entries beyond the new limits are evicted immediately.
+        void SetLimits(uint32_t maxEntries, uint64_t maxBytes, std::vector<Value>& evicted)
+        {
+            m_MaxEntries = maxEntries;
+            m_MaxBytes = maxBytes;
+            EvictToLimits(0, evicted);
+        }
+
+        // Returns the cached value and makes it the most recently used one, or nullptr when the key is not cached
+        Value* Find(const Key& key)
+        {
+            auto it = m_Index.find(key);
+            if (it == m_Index.end())
+            {
+                m_Statistics.misses++;
+                return nullptr;
+            }
+
+            m_Statistics.hits++;
+            m_Entries.splice(m_Entries.begin(), m_Entries, it->second);
+            // addressof, because ComPtr overloads the & operator
+            return std::addressof(it->second->value);
+        }
+
+        // Returns the most recently used value if its key satisfies the predicate, or nullptr otherwise.
+        // This lets callers that tend to look up the same key many times in a row compare it with their inputs
+        // directly, without building a key and hashing it.
+        template<typename Predicate> Value* FindFront(Predicate matches)
+        {
+            if (m_Entries.empty() || !matches(m_Entries.front().key))
+                return nullptr;
+
+            m_Statistics.hits++;
+            return std::addressof(m_Entries.front().value);
+        }
+
+        // Adds a value for a key that Find has not found. Values that are evicted to stay within the limits are appended to evicted.
+        void Insert(const Key& key, const Value& value, uint64_t bytes, std::vector<Value>& evicted)
+        {
+            Entry entry = { key, value, bytes };
+            m_Entries.push_front(entry);
+            m_Index[key] = m_Entries.begin();
+            m_Statistics.bytes += bytes;
+
+            EvictToLimits(1, evicted);
+        }
+
+        // Removes the entries whose values satisfy the predicate, and appends their values to removed
+        template<typename Predicate> void EraseIf(Predicate predicate, std::vector<Value>& removed)
+        {
+            for (auto it = m_Entries.begin(); it != m_Entries.end(); )
+            {
+                if (predicate(it->value))
+                {
+                    removed.push_back(it->value);
+                    m_Index.erase(it->key);
+                    m_Statistics.bytes -= it->bytes;
+                    it = m_Entries.erase(it);
+                }
+                else
+                    ++it;
+            }
+
+            m_Statistics.entries = m_Entries.size();
+        }
+
+        // Removes the entry with the given key if there is one, and appends its value to removed
+        void Erase(const Key& key, std::vector<Value>& removed)
+        {
+            auto it = m_Index.find(key);
+            if (it == m_Index.end())
+                return;
+
+            removed.push_back(it->second->value);
+            m_Statistics.bytes -= it->second->bytes;
+            m_Entries.erase(it->second);
+            m_Index.erase(it);
+            m_Statistics.entries = m_Entries.size();
+        }
+
+        // Removes all entries, and appends their values to removed
+        void Clear(std::vector<Value>& removed)
+        {
+            EraseIf([](const Value&) { return true; }, removed);
+        }
+
+        iterator begin() { return m_Entries.begin(); }
+        iterator end() { return m_Entries.end(); }
+
+        const CacheStatistics& GetStatistics() const { return m_Statistics; }
+    };
+
+    // Adds the counters of one cache to the totals reported in FrameStatistics
+    inline void AccumulateCacheStatistics(CacheStatistics& total, const CacheStatistics& cache)
+    {
+        total.hits += cache.hits;
+        total.misses += cache.misses;
+        total.evictions += cache.evictions;
+        total.entries += cache.entries;
+        total.bytes += cache.bytes;
+    }
+}
@@ -0,0 +1,398 @@
+/*
+* Copyright (c) 2012-2016, NVIDIA CORPORATION. All rights reserved.
+*
+* NVIDIA CORPORATION and its licensors retain all intellectual property
+* and proprietary rights in and to this software, related documentation
+* and any modifications thereto. Any use, reproduction, disclosure or
+* distribution of this software and related documentation without an express
+* license agreement from NVIDIA CORPORATION is strictly prohibited.
+*/
+
+#pragma once
+
+#include <GFSDK_NVRHI.h>
+
+#include <vector>
+#include <string.h>
+
+namespace NVRHI
+{
+    // Backend-independent implementation of ICommandList.
+    // Commands are stored in a compact, self-contained buffer: every command is a header followed by its arguments,
+    // and the graphics or compute state is only stored when it differs from the state of the previous command.
+    // Recording only appends to the buffer, so lists can be recorded on any thread. The buffer is replayed
+    // on the render thread by calling the corresponding IRendererInterface methods.
+    class DeferredCommandList : public ICommandList
+    {
+    public:
+        DeferredCommandList()
+            : m_GraphicsStateOffset(NO_STATE)
+            , m_ComputeStateOffset(NO_STATE)
+        { }
+
+        void reset() override
+        {
+            // keep the storage, lists are normally re-recorded every frame with a similar amount of commands
+            m_Commands.clear();
+            m_GraphicsStateOffset = NO_STATE;
+            m_ComputeStateOffset = NO_STATE;
+        }
+
+        void draw(const GraphicsState& state, const DrawArguments* args, uint32_t numDrawCalls) override
+        {
+            setGraphicsState(state);
+            recordDraw(CommandType::DRAW, args, numDrawCalls);
+        }
+
+        void drawIndexed(const GraphicsState& state, const DrawArguments* args, uint32_t numDrawCalls) override
+        {
+            setGraphicsState(state);
+            recordDraw(CommandType::DRAW_INDEXED, args, numDrawCalls);
+        }
+
+        void drawIndirect(const GraphicsState& state, BufferHandle indirectParams, uint32_t offsetBytes) override
+        {
+            setGraphicsState(state);
+            IndirectArgs* cmd = append<IndirectArgs>(CommandType::DRAW_INDIRECT);
+            cmd->buffer = indirectParams;
+            cmd->offsetBytes = offsetBytes;
+        }
+
+        void drawIndexedIndirect(const GraphicsState& state, BufferHandle indirectParams, uint32_t offsetBytes) override
+        {
+            setGraphicsState(state);
+            IndirectArgs* cmd = append<IndirectArgs>(CommandType::DRAW_INDEXED_INDIRECT);
+            cmd->buffer = indirectParams;
+            cmd->offsetBytes = offsetBytes;
+        }
+
+        void multiDrawIndirect(const GraphicsState& state, BufferHandle argsBuffer, uint32_t argsOffsetBytes, uint32_t argsStrideBytes, uint32_t maxDrawCount, BufferHandle countBuffer, uint32_t countOffsetBytes) override
+        {
+            setGraphicsState(state);
+            recordMultiDrawIndirect(CommandType::MULTI_DRAW_INDIRECT, argsBuffer, argsOffsetBytes, argsStrideBytes, maxDrawCount, countBuffer, countOffsetBytes);
+        }
+
+        void multiDrawIndexedIndirect(const GraphicsState& state, BufferHandle argsBuffer, uint32_t argsOffsetBytes, uint32_t argsStrideBytes, uint32_t maxDrawCount, BufferHandle countBuffer, uint32_t countOffsetBytes) override
+        {
+            setGraphicsState(state);
+            recordMultiDrawIndirect(CommandType::MULTI_DRAW_INDEXED_INDIRECT, argsBuffer, argsOffsetBytes, argsStrideBytes, maxDrawCount, countBuffer, countOffsetBytes);
+        }
+
+        void dispatch(const ComputeState& state, uint32_t groupsX, uint32_t groupsY, uint32_t groupsZ) override
+        {
+            setComputeState(state);
+            DispatchArgs* cmd = append<DispatchArgs>(CommandType::DISPATCH);
+            cmd->groupsX = groupsX;
+            cmd->groupsY = groupsY;
+            cmd->groupsZ = groupsZ;
+        }
+
+        void dispatchIndirect(const ComputeState& state, BufferHandle indirectParams, uint32_t offsetBytes) override
+        {
+            setComputeState(state);
+            IndirectArgs* cmd = append<IndirectArgs>(CommandType::DISPATCH_INDIRECT);
+            cmd->buffer = indirectParams;
+            cmd->offsetBytes = offsetBytes;
+        }
+
+        void clearTextureFloat(TextureHandle t, const Color& clearColor) override
+        {
+            ClearTextureFloatArgs* cmd = append<ClearTextureFloatArgs>(CommandType::CLEAR_TEXTURE_FLOAT);
+            cmd->texture = t;
+            cmd->clearColor = clearColor;
+        }
+
+        void clearTextureUInt(TextureHandle t, uint32_t clearColor) override
+        {
+            ClearTextureUIntArgs* cmd = append<ClearTextureUIntArgs>(CommandType::CLEAR_TEXTURE_UINT);
+            cmd->texture = t;
+            cmd->clearValue = clearColor;
+        }
+
+        void clearBufferUInt(BufferHandle b, uint32_t clearValue) override
+        {
+            ClearBufferUIntArgs* cmd = append<ClearBufferUIntArgs>(CommandType::CLEAR_BUFFER_UINT);
+            cmd->buffer = b;
+            cmd->clearValue = clearValue;
+        }
+
+        void copyToBuffer(BufferHandle dest, uint32_t destOffsetBytes, BufferHandle src, uint32_t srcOffsetBytes, size_t dataSizeBytes) override
+        {
+            CopyBufferArgs* cmd = append<CopyBufferArgs>(CommandType::COPY_TO_BUFFER);
+            cmd->dest = dest;
+            cmd->destOffsetBytes = destOffsetBytes;
+            cmd->src = src;
+            cmd->srcOffsetBytes = srcOffsetBytes;
+            cmd->dataSizeBytes = dataSizeBytes;
+        }
+
+        void writeConstantBuffer(ConstantBufferHandle b, const void* data, size_t dataSize) override
+        {
+            WriteConstantBufferArgs* cmd = append<WriteConstantBufferArgs>(CommandType::WRITE_CONSTANT_BUFFER, dataSize);
+            cmd->buffer = b;
+            cmd->dataSize = dataSize;
+            memcpy(cmd + 1, data, dataSize);
+        }
+
+        // Issues the recorded commands on the renderer. Must be called on the render thread.
+        void execute(IRendererInterface* renderer) const
+        {
+            const GraphicsState* graphicsState = nullptr;
+            const ComputeState* computeState = nullptr;
+
+            size_t offset = 0;
+            while (offset < m_Commands.size())
+            {
+                const CommandHeader* header = reinterpret_cast<const CommandHeader*>(&m_Commands[offset]);
+                const void* args = header + 1;
+                offset += header->sizeInWords;
+
+                switch (header->type)
+                {
+                case CommandType::SET_GRAPHICS_STATE:
+                    graphicsState = static_cast<const GraphicsState*>(args);
+                    break;
+
+                case CommandType::SET_COMPUTE_STATE:
+                    computeState = static_cast<const ComputeState*>(args);
+                    break;
+
+                case CommandType::DRAW: {
+                    const DrawArgs* cmd = static_cast<const DrawArgs*>(args);
+                    renderer->drawWithPipeline(*graphicsState, reinterpret_cast<const DrawArguments*>(cmd + 1), cmd->numDrawCalls);
+                    break;
+                }
+
+                case CommandType::DRAW_INDEXED: {
+                    const DrawArgs* cmd = static_cast<const DrawArgs*>(args);
+                    renderer->drawIndexedWithPipeline(*graphicsState, reinterpret_cast<const DrawArguments*>(cmd + 1), cmd->numDrawCalls);
+                    break;
+                }
+
+                case CommandType::DRAW_INDIRECT: {
+                    const IndirectArgs* cmd = static_cast<const IndirectArgs*>(args);
+                    renderer->drawIndirectWithPipeline(*graphicsState, cmd->buffer, cmd->offsetBytes);
+                    break;
+                }
+
+                case CommandType::DRAW_INDEXED_INDIRECT: {
+                    const IndirectArgs* cmd = static_cast<const IndirectArgs*>(args);
+                    renderer->drawIndexedIndirectWithPipeline(*graphicsState, cmd->buffer, cmd->offsetBytes);
+                    break;
+                }
+
+                case CommandType::MULTI_DRAW_INDIRECT: {
+                    const MultiDrawIndirectArgs* cmd = static_cast<const MultiDrawIndirectArgs*>(args);
+                    renderer->multiDrawIndirectWithPipeline(*graphicsState, cmd->argsBuffer, cmd->argsOffsetBytes, cmd->argsStrideBytes, cmd->maxDrawCount, cmd->countBuffer, cmd->countOffsetBytes);
+                    break;
+                }
+
+                case CommandType::MULTI_DRAW_INDEXED_INDIRECT: {
+                    const MultiDrawIndirectArgs* cmd = static_cast<const MultiDrawIndirectArgs*>(args);
+                    renderer->multiDrawIndexedIndirectWithPipeline(*graphicsState, cmd->argsBuffer, cmd->argsOffsetBytes, cmd->argsStrideBytes, cmd->maxDrawCount, cmd->countBuffer, cmd->countOffsetBytes);
+                    break;
+                }
+
+                case CommandType::DISPATCH: {
+                    const DispatchArgs* cmd = static_cast<const DispatchArgs*>(args);
+                    renderer->dispatchWithPipeline(*computeState, cmd->groupsX, cmd->groupsY, cmd->groupsZ);
+                    break;
+                }
+
+                case CommandType::DISPATCH_INDIRECT: {
+                    const IndirectArgs* cmd = static_cast<const IndirectArgs*>(args);
+                    renderer->dispatchIndirectWithPipeline(*computeState, cmd->buffer, cmd->offsetBytes);
+                    break;
+                }
+
+                case CommandType::CLEAR_TEXTURE_FLOAT: {
+                    const ClearTextureFloatArgs* cmd = static_cast<const ClearTextureFloatArgs*>(args);
+                    renderer->clearTextureFloat(cmd->texture, cmd->clearColor);
+                    break;
+                }
+
+                case CommandType::CLEAR_TEXTURE_UINT: {
+                    const ClearTextureUIntArgs* cmd = static_cast<const ClearTextureUIntArgs*>(args);
+                    renderer->clearTextureUInt(cmd->texture, cmd->clearValue);
+                    break;
+                }
+
+                case CommandType::CLEAR_BUFFER_UINT: {
+                    const ClearBufferUIntArgs* cmd = static_cast<const ClearBufferUIntArgs*>(args);
+                    renderer->clearBufferUInt(cmd->buffer, cmd->clearValue);
+                    break;
+                }
+
+                case CommandType::COPY_TO_BUFFER: {
+                    const CopyBufferArgs* cmd = static_cast<const CopyBufferArgs*>(args);
+                    renderer->copyToBuffer(cmd->dest, cmd->destOffsetBytes, cmd->src, cmd->srcOffsetBytes, cmd->dataSizeBytes);
+                    break;
+                }
+
+                case CommandType::WRITE_CONSTANT_BUFFER: {
+                    const WriteConstantBufferArgs* cmd = static_cast<const WriteConstantBufferArgs*>(args);
+                    renderer->writeConstantBuffer(cmd->buffer, cmd + 1, cmd->dataSize);
+                    break;
+                }
+                }
+            }
+        }
+
+        // Size of the recorded commands, in bytes
+        size_t getRecordedSize() const { return m_Commands.size() * sizeof(uint64_t); }
+
+    private:
+        struct CommandType
+        {
+            enum Enum
+            {
+                SET_GRAPHICS_STATE,
+                SET_COMPUTE_STATE,
+                DRAW,
+                DRAW_INDEXED,
+                DRAW_INDIRECT,
+                DRAW_INDEXED_INDIRECT,
+                MULTI_DRAW_INDIRECT,
+                MULTI_DRAW_INDEXED_INDIRECT,
+                DISPATCH,
+                DISPATCH_INDIRECT,
+                CLEAR_TEXTURE_FLOAT,
+                CLEAR_TEXTURE_UINT,
+                CLEAR_BUFFER_UINT,
+                COPY_TO_BUFFER,
+                WRITE_CONSTANT_BUFFER
+            };
+        };
+
+        // The header occupies one storage word, so the arguments that follow it are 8-byte aligned
+        struct CommandHeader
+        {
+            uint32_t type;
+            uint32_t sizeInWords; // including the header
+        };
+
+        // followed by numDrawCalls DrawArguments
+        struct DrawArgs
+        {
+            uint32_t numDrawCalls;
+        };
+
+        struct IndirectArgs
+        {
+            BufferHandle buffer;
+            uint32_t offsetBytes;
+        };
+
+        struct MultiDrawIndirectArgs
+        {
+            BufferHandle argsBuffer;
+            BufferHandle countBuffer;
+            uint32_t argsOffsetBytes;
+            uint32_t argsStrideBytes;
+            uint32_t maxDrawCount;
+            uint32_t countOffsetBytes;
+        };
+
+        struct DispatchArgs
+        {
+            uint32_t groupsX;
+            uint32_t groupsY;
+            uint32_t groupsZ;
+        };
+
+        struct ClearTextureFloatArgs
+        {
+            TextureHandle texture;
+            Color clearColor;
+        };
+
+        struct ClearTextureUIntArgs
+        {
+            TextureHandle texture;
+            uint32_t clearValue;
+        };
+
+        struct ClearBufferUIntArgs
+        {
+            BufferHandle buffer;
+            uint32_t clearValue;
+        };
+
+        struct CopyBufferArgs
+        {
+            BufferHandle dest;
+            BufferHandle src;
+            uint32_t destOffsetBytes;
+            uint32_t srcOffsetBytes;
+            size_t dataSizeBytes;
+        };
+
+        // followed by dataSize bytes of data
+        struct WriteConstantBufferArgs
+        {
+            ConstantBufferHandle buffer;
+            size_t dataSize;
+        };
+
+        static const size_t NO_STATE = ~size_t(0);
+
+        // Storage is a vector of 64-bit words to keep all command arguments aligned
+        std::vector<uint64_t> m_Commands;
+
+        // Word offsets of the arguments of the last SET_GRAPHICS_STATE and SET_COMPUTE_STATE commands
+        size_t m_GraphicsStateOffset;
+        size_t m_ComputeStateOffset;
+
+        template<typename TArgs>
+        TArgs* append(CommandType::Enum type, size_t extraBytes = 0)
+        {
+            size_t sizeInWords = 1 + (sizeof(TArgs) + extraBytes + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+            size_t offset = m_Commands.size();
+            m_Commands.resize(offset + sizeInWords);
+
+            CommandHeader* header = reinterpret_cast<CommandHeader*>(&m_Commands[offset]);
+            header->type = type;
+            header->sizeInWords = uint32_t(sizeInWords);
+            return reinterpret_cast<TArgs*>(header + 1);
+        }
+
+        void recordDraw(CommandType::Enum type, const DrawArguments* args, uint32_t numDrawCalls)
+        {
+            DrawArgs* cmd = append<DrawArgs>(type, sizeof(DrawArguments) * numDrawCalls);
+            cmd->numDrawCalls = numDrawCalls;
+            memcpy(cmd + 1, args, sizeof(DrawArguments) * numDrawCalls);
+        }
+
+        void recordMultiDrawIndirect(CommandType::Enum type, BufferHandle argsBuffer, uint32_t argsOffsetBytes, uint32_t argsStrideBytes, uint32_t maxDrawCount, BufferHandle countBuffer, uint32_t countOffsetBytes)
+        {
+            MultiDrawIndirectArgs* cmd = append<MultiDrawIndirectArgs>(type);
+            cmd->argsBuffer = argsBuffer;
+            cmd->countBuffer = countBuffer;
+            cmd->argsOffsetBytes = argsOffsetBytes;
+            cmd->argsStrideBytes = argsStrideBytes;
+            cmd->maxDrawCount = maxDrawCount;
+            cmd->countOffsetBytes = countOffsetBytes;
+        }
+
+        // The states are compared bitwise. Differences in padding only cost a redundant state command.
+        void setGraphicsState(const GraphicsState& state)
+        {
+            if (m_GraphicsStateOffset != NO_STATE && memcmp(&m_Commands[m_GraphicsStateOffset], &state, sizeof(state)) == 0)
+                return;
+
+            GraphicsState* cmd = append<GraphicsState>(CommandType::SET_GRAPHICS_STATE);
+            memcpy(cmd, &state, sizeof(state));
+            m_GraphicsStateOffset = reinterpret_cast<uint64_t*>(cmd) - m_Commands.data();
+        }
+
+        void setComputeState(const ComputeState& state)
+        {
+            if (m_ComputeStateOffset != NO_STATE && memcmp(&m_Commands[m_ComputeStateOffset], &state, sizeof(state)) == 0)
+                return;
+
+            ComputeState* cmd = append<ComputeState>(CommandType::SET_COMPUTE_STATE);
+            memcpy(cmd, &state, sizeof(state));
+            m_ComputeStateOffset = reinterpret_cast<uint64_t*>(cmd) - m_Commands.data();
+        }
+    };
+}
@@ -0,0 +1,446 @@
+/*
+* Copyright (c) 2012-2016, NVIDIA CORPORATION. All rights reserved.
+*
+* NVIDIA CORPORATION and its licensors retain all intellectual property
+* and proprietary rights in and to this software, related documentation
+* and any modifications thereto. Any use, reproduction, disclosure or
+* distribution of this software and related documentation without an express
+* license agreement from NVIDIA CORPORATION is strictly prohibited.
+*/
+
+#pragma once
+
+#include <math.h>
+#include <string.h>
+#include <vector>
+
+#include <GFSDK_NVRHI.h>
+#include <GFSDK_VXGI_MathTypes.h>
+
+namespace NVRHI
+{
+    // Source of the culling compute shader for the GL backend, passed to createShader as is.
+    static const char* const g_DrawCullingShaderGLSL = R"(
+#version 430
+layout(local_size_x = 64) in;
+
+layout(std140, binding = 0) uniform CullingConstants
+{
+    vec4 g_Planes[6];
+    uint g_ObjectCount;
+    uint g_RegionCount;
+    uint g_RecordWords;
+    uint g_Mode;
+};
+
+layout(std430, binding = 0) readonly buffer ObjectBounds { float g_Bounds[]; };
+layout(std430, binding = 1) readonly buffer ObjectRecords { uint g_SourceRecords[]; };
+layout(std430, binding = 2) readonly buffer Regions { float g_Regions[]; };
+layout(std430, binding = 3) buffer DrawArguments { uint g_DrawArguments[]; };
+layout(std430, binding = 4) buffer DrawCount { uint g_DrawCount[]; };
+layout(std430, binding = 5) buffer ObjectIndices { uint g_ObjectIndices[]; };
+
+void main()
+{
+    uint objectIndex = gl_GlobalInvocationID.x;
+    if (objectIndex >= g_ObjectCount)
+        return;
+
+    vec3 lower = vec3(g_Bounds[objectIndex * 6 + 0], g_Bounds[objectIndex * 6 + 1], g_Bounds[objectIndex * 6 + 2]);
+    vec3 upper = vec3(g_Bounds[objectIndex * 6 + 3], g_Bounds[objectIndex * 6 + 4], g_Bounds[objectIndex * 6 + 5]);
+
+    bool visible;
+    if (g_Mode == 0)
+    {
+        // Same test as VXGI::Frustum::intersectsWith(Box3f)
+        visible = true;
+        for (uint i = 0; i < 6; i++)
+        {
+            vec3 normal = g_Planes[i].xyz;
+            vec3 minPt = mix(upper, lower, greaterThan(normal, vec3(0)));
+            if (normal.x * minPt.x + normal.y * minPt.y + normal.z * minPt.z > g_Planes[i].w)
+                visible = false;
+        }
+    }
+    else
+    {
+        // Same test as VXGI::Box3f::intersectsWith
+        visible = false;
+        for (uint i = 0; i < g_RegionCount && !visible; i++)
+        {
+            vec3 regionLower = vec3(g_Regions[i * 6 + 0], g_Regions[i * 6 + 1], g_Regions[i * 6 + 2]);
+            vec3 regionUpper = vec3(g_Regions[i * 6 + 3], g_Regions[i * 6 + 4], g_Regions[i * 6 + 5]);
+            visible = all(lessThanEqual(regionLower, upper)) && all(greaterThanEqual(regionUpper, lower));
+        }
+    }
+
+    if (!visible)
+        return;
+
+    uint slot = atomicAdd(g_DrawCount[0], 1u);
+
+    for (uint i = 0; i < g_RecordWords; i++)
+        g_DrawArguments[slot * g_RecordWords + i] = g_SourceRecords[objectIndex * g_RecordWords + i];
+
+    g_ObjectIndices[slot] = objectIndex;
+}
+)";
+
+    // Source of the culling compute shader for the D3D11 and D3D12 backends, to be compiled for cs_5_0 with entry point "main".
+    static const char* const g_DrawCullingShaderHLSL = R"(
+cbuffer CullingConstants : register(b0)
+{
+    float4 g_Planes[6];
+    uint g_ObjectCount;
+    uint g_RegionCount;
+    uint g_RecordWords;
+    uint g_Mode;
+};
+
+StructuredBuffer<float> g_Bounds : register(t0);
+StructuredBuffer<uint> g_SourceRecords : register(t1);
+StructuredBuffer<float> g_Regions : register(t2);
+RWBuffer<uint> g_DrawArguments : register(u3);
+RWBuffer<uint> g_DrawCount : register(u4);
+RWBuffer<uint> g_ObjectIndices : register(u5);
+
+[numthreads(64, 1, 1)]
+void main(uint3 threadId : SV_DispatchThreadID)
+{
+    uint objectIndex = threadId.x;
+    if (objectIndex >= g_ObjectCount)
+        return;
+
+    float3 lower = float3(g_Bounds[objectIndex * 6 + 0], g_Bounds[objectIndex * 6 + 1], g_Bounds[objectIndex * 6 + 2]);
+    float3 upper = float3(g_Bounds[objectIndex * 6 + 3], g_Bounds[objectIndex * 6 + 4], g_Bounds[objectIndex * 6 + 5]);
+
+    bool visible;
+    if (g_Mode == 0)
+    {
+        // Same test as VXGI::Frustum::intersectsWith(Box3f)
+        visible = true;
+        for (uint i = 0; i < 6; i++)
+        {
+            float3 normal = g_Planes[i].xyz;
+            float3 minPt = normal > 0 ? lower : upper;
+            if (normal.x * minPt.x + normal.y * minPt.y + normal.z * minPt.z > g_Planes[i].w)
+                visible = false;
+        }
+    }
+    else
+    {
+        // Same test as VXGI::Box3f::intersectsWith
+        visible = false;
+        for (uint i = 0; i < g_RegionCount && !visible; i++)
+        {
+            float3 regionLower = float3(g_Regions[i * 6 + 0], g_Regions[i * 6 + 1], g_Regions[i * 6 + 2]);
+            float3 regionUpper = float3(g_Regions[i * 6 + 3], g_Regions[i * 6 + 4], g_Regions[i * 6 + 5]);
+            visible = all(regionLower <= upper) && all(regionUpper >= lower);
+        }
+    }
+
+    if (!visible)
+        return;
+
+    uint slot;
+    InterlockedAdd(g_DrawCount[0], 1, slot);
+
+    for (uint i = 0; i < g_RecordWords; i++)
+        g_DrawArguments[slot * g_RecordWords + i] = g_SourceRecords[objectIndex * g_RecordWords + i];
+
+    g_ObjectIndices[slot] = objectIndex;
+}
+)";
+
+    // GPU culling of per-object draws, built on IRendererInterface::dispatch.
+    // Every object has a Box3f bound and a draw record, which is a DrawIndirectArguments or a DrawIndexedIndirectArguments.
+    // A cull pass tests the bounds against a frustum or against a list of regions, such as the invalidated regions
+    // returned by IGlobalIllumination::getInvalidatedRegions, and writes the records of the visible objects into a compacted
+    // argument buffer. The order of the compacted records is not deterministic.
+    // The outputs are:
+    //  - the argument buffer: record i is at offset i * getRecordSize(). The records past the visible count are zero,
+    //    so they can be drawn with drawIndirect at per-record offsets, or all at once with multiDrawIndirect and maxObjects;
+    //  - the count buffer: the number of visible objects as a uint at offset 0, for multiDrawIndirect with a count buffer;
+    //  - the object index buffer: the index of the object of every compacted record, for fetching per-object data in shaders.
+    // The stage only records commands on the renderer, so it must be used on the render thread.
+    // validateFrustum and validateRegions repeat the last pass on the CPU and compare, for bringing up a new backend or driver.
+    class DrawCullingStage
+    {
+    public:
+        // The shader must be created from g_DrawCullingShaderGLSL on GL, or from g_DrawCullingShaderHLSL on D3D.
+        // The shader is owned by the application and must outlive the stage.
+        DrawCullingStage(IRendererInterface* renderer, ShaderHandle cullingShader, uint32_t maxObjects, bool indexedDraws)
+            : m_Renderer(renderer)
+            , m_Shader(cullingShader)
+            , m_MaxObjects(maxObjects)
+            , m_RecordWords(indexedDraws ? sizeof(DrawIndexedIndirectArguments) / 4 : sizeof(DrawIndirectArguments) / 4)
+            , m_ObjectCount(0)
+            , m_RegionCapacity(0)
+            , m_Pipeline(nullptr)
+            , m_Bindings(nullptr)
+            , m_Constants(nullptr)
+            , m_Bounds(nullptr)
+            , m_SourceRecords(nullptr)
+            , m_Regions(nullptr)
+            , m_DrawArguments(nullptr)
+            , m_DrawCount(nullptr)
+            , m_ObjectIndices(nullptr)
+        {
+            ComputePipelineDesc pipelineDesc;
+            pipelineDesc.CS = m_Shader;
+            m_Pipeline = m_Renderer->createComputePipeline(pipelineDesc);
+
+            m_Constants = m_Renderer->createConstantBuffer(ConstantBufferDesc(sizeof(Constants), "CullingConstants"), nullptr);
+
+            m_Bounds = createBuffer(m_MaxObjects * sizeof(VXGI::Box3f), sizeof(float), false, false, "CullingObjectBounds");
+            m_SourceRecords = createBuffer(m_MaxObjects * getRecordSize(), sizeof(uint32_t), false, false, "CullingObjectRecords");
+            m_DrawArguments = createBuffer(m_MaxObjects * getRecordSize(), 0, true, true, "CullingDrawArguments");
+            m_DrawCount = createBuffer(sizeof(uint32_t), 0, true, true, "CullingDrawCount");
+            m_ObjectIndices = createBuffer(m_MaxObjects * sizeof(uint32_t), 0, true, false, "CullingObjectIndices");
+
+            reserveRegions(INITIAL_REGION_CAPACITY);
+        }
+
+        ~DrawCullingStage()
+        {
+            if (m_Bindings) m_Renderer->destroyBindingSet(m_Bindings);
+            if (m_Pipeline) m_Renderer->destroyComputePipeline(m_Pipeline);
+            if (m_Constants) m_Renderer->destroyConstantBuffer(m_Constants);
+            if (m_Bounds) m_Renderer->destroyBuffer(m_Bounds);
+            if (m_SourceRecords) m_Renderer->destroyBuffer(m_SourceRecords);
+            if (m_Regions) m_Renderer->destroyBuffer(m_Regions);
+            if (m_DrawArguments) m_Renderer->destroyBuffer(m_DrawArguments);
+            if (m_DrawCount) m_Renderer->destroyBuffer(m_DrawCount);
+            if (m_ObjectIndices) m_Renderer->destroyBuffer(m_ObjectIndices);
+        }
+
+        // Uploads the bounds and the draw records of the objects. Records are getRecordSize() bytes each.
+        // Objects past maxObjects are ignored.
+        void setObjects(const VXGI::Box3f* bounds, const void* drawRecords, uint32_t objectCount)
+        {
+            m_ObjectCount = objectCount < m_MaxObjects ? objectCount : m_MaxObjects;
+
+            if (m_ObjectCount == 0)
+                return;
+
+            m_Renderer->writeBuffer(m_Bounds, bounds, m_ObjectCount * sizeof(VXGI::Box3f));
+            m_Renderer->writeBuffer(m_SourceRecords, drawRecords, m_ObjectCount * getRecordSize());
+        }
+
+        // Keeps the objects whose bounds intersect the frustum
+        void cullFrustum(const VXGI::Frustum& frustum)
+        {
+            Constants constants;
+            for (int i = 0; i < VXGI::Frustum::PLANES_COUNT; i++)
+            {
+                constants.planes[i][0] = frustum.planes[i].normal.x;
+                constants.planes[i][1] = frustum.planes[i].normal.y;
+                constants.planes[i][2] = frustum.planes[i].normal.z;
+                constants.planes[i][3] = frustum.planes[i].distance;
+            }
+            constants.regionCount = 0;
+            constants.mode = MODE_FRUSTUM;
+
+            cull(constants);
+        }
+
+        // Keeps the objects whose bounds intersect at least one of the regions
+        void cullRegions(const VXGI::Box3f* regions, uint32_t regionCount)
+        {
+            if (regionCount > m_RegionCapacity)
+                reserveRegions(regionCount);
+
+            if (regionCount)
+                m_Renderer->writeBuffer(m_Regions, regions, regionCount * sizeof(VXGI::Box3f));
+
+            Constants constants;
+            memset(constants.planes, 0, sizeof(constants.planes));
+            constants.regionCount = regionCount;
+            constants.mode = MODE_REGIONS;
+
+            cull(constants);
+        }
+
+        // CPU reference for the last cullFrustum or cullRegions call, which must have been given the same arguments.
+        // bounds and drawRecords are the arrays that were passed to setObjects.
+        // Reads the outputs back, which waits for the GPU, so these are meant for testing only.
+        // Returns true if the outputs hold exactly the visible objects with their records, in any order.
+        bool validateFrustum(const VXGI::Box3f* bounds, const void* drawRecords, const VXGI::Frustum& frustum)
+        {
+            std::vector<bool> expected(m_ObjectCount);
+            for (uint32_t i = 0; i < m_ObjectCount; i++)
+                expected[i] = frustum.intersectsWith(bounds[i]);
+
+            return validate(expected, drawRecords);
+        }
+
+        bool validateRegions(const VXGI::Box3f* bounds, const void* drawRecords, const VXGI::Box3f* regions, uint32_t regionCount)
+        {
+            std::vector<bool> expected(m_ObjectCount);
+            for (uint32_t i = 0; i < m_ObjectCount; i++)
+            {
+                for (uint32_t r = 0; r < regionCount && !expected[i]; r++)
+                    expected[i] = regions[r].intersectsWith(bounds[i]);
+            }
+
+            return validate(expected, drawRecords);
+        }
+
+        BufferHandle getDrawArgumentsBuffer() const { return m_DrawArguments; }
+        BufferHandle getDrawCountBuffer() const { return m_DrawCount; }
+        BufferHandle getObjectIndexBuffer() const { return m_ObjectIndices; }
+        uint32_t getRecordSize() const { return m_RecordWords * sizeof(uint32_t); }
+        uint32_t getMaxObjects() const { return m_MaxObjects; }
+
+    private:
+        enum { GROUP_SIZE = 64, INITIAL_REGION_CAPACITY = 64 };
+        enum { MODE_FRUSTUM = 0, MODE_REGIONS = 1 };
+
+        // Layout of the CullingConstants block in both shaders
+        struct Constants
+        {
+            float planes[6][4];
+            uint32_t objectCount;
+            uint32_t regionCount;
+            uint32_t recordWords;
+            uint32_t mode;
+        };
+
+        IRendererInterface* m_Renderer;
+        ShaderHandle m_Shader;
+        uint32_t m_MaxObjects;
+        uint32_t m_RecordWords;
+        uint32_t m_ObjectCount;
+        uint32_t m_RegionCapacity;
+
+        ComputePipelineHandle m_Pipeline;
+        BindingSetHandle m_Bindings;
+        ConstantBufferHandle m_Constants;
+        BufferHandle m_Bounds;
+        BufferHandle m_SourceRecords;
+        BufferHandle m_Regions;
+        BufferHandle m_DrawArguments;
+        BufferHandle m_DrawCount;
+        BufferHandle m_ObjectIndices;
+
+        BufferHandle createBuffer(uint32_t byteSize, uint32_t structStride, bool canHaveUAVs, bool isDrawIndirectArgs, const char* debugName)
+        {
+            BufferDesc desc;
+            desc.byteSize = byteSize > 0 ? byteSize : sizeof(uint32_t);
+            desc.structStride = structStride;
+            desc.canHaveUAVs = canHaveUAVs;
+            desc.isDrawIndirectArgs = isDrawIndirectArgs;
+            desc.debugName = debugName;
+            return m_Renderer->createBuffer(desc, nullptr);
+        }
+
+        // Grows the region buffer, which also requires a new binding set
+        void reserveRegions(uint32_t regionCount)
+        {
+            if (m_Bindings)
+            {
+                m_Renderer->destroyBindingSet(m_Bindings);
+                m_Bindings = nullptr;
+            }
+
+            if (m_Regions)
+                m_Renderer->destroyBuffer(m_Regions);
+
+            m_RegionCapacity = regionCount;
+            m_Regions = createBuffer(m_RegionCapacity * sizeof(VXGI::Box3f), sizeof(float), false, false, "CullingRegions");
+
+            // The slots are unique across SRVs and UAVs because GL uses one namespace for all storage buffers
+            BindingSetDesc bindingSetDesc;
+            PipelineStageBindings& cs = bindingSetDesc.CS;
+            cs.shader = m_Shader;
+            cs.constantBuffers[0].buffer = m_Constants;
+            cs.constantBuffers[0].slot = 0;
+            cs.constantBufferBindingCount = 1;
+
+            BufferHandle buffers[] = { m_Bounds, m_SourceRecords, m_Regions, m_DrawArguments, m_DrawCount, m_ObjectIndices };
+            for (uint32_t slot = 0; slot < 6; slot++)
+            {
+                BufferBinding& binding = cs.buffers[slot];
+                binding.buffer = buffers[slot];
+                binding.slot = slot;
+                binding.format = Format::UNKNOWN;
+                binding.isWritable = slot >= 3;
+            }
+            cs.bufferBindingCount = 6;
+
+            m_Bindings = m_Renderer->createBindingSet(bindingSetDesc);
+        }
+
+        void cull(Constants& constants)
+        {
+            // The records past the visible count must be zero for consumers that do not use the count buffer
+            m_Renderer->clearBufferUInt(m_DrawArguments, 0);
+            m_Renderer->clearBufferUInt(m_DrawCount, 0);
+
+            if (m_ObjectCount == 0 || !m_Pipeline || !m_Bindings)
+                return;
+
+            constants.objectCount = m_ObjectCount;
+            constants.recordWords = m_RecordWords;
+            m_Renderer->writeConstantBuffer(m_Constants, &constants, sizeof(constants));
+
+            ComputeState state;
+            state.pipeline = m_Pipeline;
+            state.bindings = m_Bindings;
+            m_Renderer->dispatch(state, (m_ObjectCount + GROUP_SIZE - 1) / GROUP_SIZE, 1, 1);
+        }
+
+        void readBack(BufferHandle buffer, void* data, size_t size)
+        {
+            ReadbackHandle readback = m_Renderer->beginBufferReadback(buffer, 0, size);
+            const void* mapped = readback ? m_Renderer->mapReadback(readback, nullptr, nullptr) : nullptr;
+            if (mapped)
+                memcpy(data, mapped, size);
+            else
+                memset(data, 0xff, size);
+
+            if (readback)
+                m_Renderer->releaseReadback(readback);
+        }
+
+        bool validate(const std::vector<bool>& expected, const void* drawRecords)
+        {
+            uint32_t count = 0;
+            std::vector<uint32_t> arguments(m_MaxObjects * m_RecordWords);
+            std::vector<uint32_t> objectIndices(m_MaxObjects);
+            readBack(m_DrawCount, &count, sizeof(count));
+            readBack(m_DrawArguments, arguments.data(), arguments.size() * sizeof(uint32_t));
+            readBack(m_ObjectIndices, objectIndices.data(), objectIndices.size() * sizeof(uint32_t));
+
+            uint32_t expectedCount = 0;
+            for (bool visible : expected)
+                expectedCount += visible ? 1 : 0;
+
+            if (count != expectedCount)
+                return false;
+
+            // Every visible object appears once, with its own record
+            const uint32_t* sourceRecords = static_cast<const uint32_t*>(drawRecords);
+            std::vector<bool> seen(m_ObjectCount);
+            for (uint32_t slot = 0; slot < count; slot++)
+            {
+                uint32_t objectIndex = objectIndices[slot];
+                if (objectIndex >= m_ObjectCount || !expected[objectIndex] || seen[objectIndex])
+                    return false;
+
+                seen[objectIndex] = true;
+
+                if (memcmp(&arguments[slot * m_RecordWords], sourceRecords + objectIndex * m_RecordWords, getRecordSize()) != 0)
+                    return false;
+            }
+
+            for (size_t word = count * m_RecordWords; word < arguments.size(); word++)
+            {
+                if (arguments[word] != 0)
+                    return false;
+            }
+
+            return true;
+        }
+    };
+}
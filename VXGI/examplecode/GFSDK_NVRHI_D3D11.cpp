@@ -9,6 +9,7 @@
 */
 
 #include "GFSDK_NVRHI_D3D11.h"
+#include "GFSDK_NVRHI_CommandList.h"
 #include <algorithm>
 
 #ifndef NVRHI_D3D11_WITH_NVAPI
@@ -50,6 +51,104 @@ namespace NVRHI
         { }
     };
 
+    class GraphicsPipeline
+    {
+    public:
+        GraphicsPipelineDesc desc;
+        D3D11_PRIMITIVE_TOPOLOGY primitiveTopology;
+        ID3D11InputLayout* inputLayout;
+        ComPtr<ID3D11VertexShader> VS;
+        ComPtr<ID3D11HullShader> HS;
+        ComPtr<ID3D11DomainShader> DS;
+        ComPtr<ID3D11GeometryShader> GS;
+        ComPtr<ID3D11PixelShader> PS;
+
+        // Shared with the state caches in RendererInterfaceD3D11, which may evict them while the pipeline exists
+        ComPtr<ID3D11RasterizerState> rasterizerState;
+        ComPtr<ID3D11BlendState> blendState;
+        ComPtr<ID3D11DepthStencilState> depthStencilState;
+        FLOAT blendFactor[4];
+
+        GraphicsPipeline()
+            : primitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_UNDEFINED)
+            , inputLayout(NULL)
+        { }
+    };
+
+    class ComputePipeline
+    {
+    public:
+        ComputePipelineDesc desc;
+        ComPtr<ID3D11ComputeShader> CS;
+    };
+
+    //Views and buffers of one shader stage, stored as contiguous ranges starting at the lowest bound slot
+    struct StageResourceBindings
+    {
+        ShaderHandle shader;
+        UINT minSRV, minUAV, minCB, minSS;
+        std::vector<ID3D11ShaderResourceView*> shaderResourceViews;
+        std::vector<ID3D11UnorderedAccessView*> unorderedAccessViews;
+        std::vector<ID3D11Buffer*> constantBuffers;
+        std::vector<ID3D11SamplerState*> samplers;
+
+        StageResourceBindings()
+            : shader(NULL)
+            , minSRV(0)
+            , minUAV(0)
+            , minCB(0)
+            , minSS(0)
+        { }
+    };
+
+    class BindingSet
+    {
+    public:
+        StageResourceBindings graphicsStages[ShaderType::GRAPHIC_SHADERS_NUM];
+        StageResourceBindings CS;
+    };
+
+    //Staging resource used for one readback at a time, recycled through RendererInterfaceD3D11::freeReadbacks
+    class Readback
+    {
+    public:
+        ComPtr<ID3D11Resource> staging;
+        D3D11_RESOURCE_DIMENSION dimension;
+        DXGI_FORMAT format;
+        UINT width; //capacity in bytes for buffers
+        UINT height;
+        UINT depth;
+        UINT size; //bytes requested, for buffers
+        UINT64 byteSize; //staging memory, for statistics
+        D3D11_MAPPED_SUBRESOURCE mapped;
+        bool isMapped;
+
+        Readback()
+            : dimension(D3D11_RESOURCE_DIMENSION_UNKNOWN)
+            , format(DXGI_FORMAT_UNKNOWN)
+            , width(0)
+            , height(0)
+            , depth(0)
+            , size(0)
+            , byteSize(0)
+            , isMapped(false)
+        {
+            ZeroMemory(&mapped, sizeof(mapped));
+        }
+    };
+
+    //D3D11.0 has no timeline fences, so a fence is a chain of event queries, one per signaled value
+    class Fence
+    {
+    public:
+        uint64_t completedValue;
+        std::deque<std::pair<uint64_t, ComPtr<ID3D11Query>>> pendingSignals;
+
+        Fence()
+            : completedValue(0)
+        { }
+    };
+
     //convert the format to a DXGI format
     static DXGI_FORMAT getUntypedTextureFormat(Format::Enum format, UINT& outPixelSizeBytes)
     {
@@ -265,103 +364,17 @@ namespace NVRHI
         return allocFormat;
     }
 
-    bool GetSSE42Support()
-    {
-        int cpui[4];
-        __cpuidex(cpui, 1, 0);
-        return !!(cpui[2] & 0x100000);
-    }
-
-    static const bool CpuSupportsSSE42 = GetSSE42Support();
-
-    static const uint32_t CrcTable[] = {
-        0x00000000, 0x77073096, 0xee0e612c, 0x990951ba, 0x076dc419, 0x706af48f,
-        0xe963a535, 0x9e6495a3, 0x0edb8832, 0x79dcb8a4, 0xe0d5e91e, 0x97d2d988,
-        0x09b64c2b, 0x7eb17cbd, 0xe7b82d07, 0x90bf1d91, 0x1db71064, 0x6ab020f2,
-        0xf3b97148, 0x84be41de, 0x1adad47d, 0x6ddde4eb, 0xf4d4b551, 0x83d385c7,
-        0x136c9856, 0x646ba8c0, 0xfd62f97a, 0x8a65c9ec, 0x14015c4f, 0x63066cd9,
-        0xfa0f3d63, 0x8d080df5, 0x3b6e20c8, 0x4c69105e, 0xd56041e4, 0xa2677172,
-        0x3c03e4d1, 0x4b04d447, 0xd20d85fd, 0xa50ab56b, 0x35b5a8fa, 0x42b2986c,
-        0xdbbbc9d6, 0xacbcf940, 0x32d86ce3, 0x45df5c75, 0xdcd60dcf, 0xabd13d59,
-        0x26d930ac, 0x51de003a, 0xc8d75180, 0xbfd06116, 0x21b4f4b5, 0x56b3c423,
-        0xcfba9599, 0xb8bda50f, 0x2802b89e, 0x5f058808, 0xc60cd9b2, 0xb10be924,
-        0x2f6f7c87, 0x58684c11, 0xc1611dab, 0xb6662d3d, 0x76dc4190, 0x01db7106,
-        0x98d220bc, 0xefd5102a, 0x71b18589, 0x06b6b51f, 0x9fbfe4a5, 0xe8b8d433,
-        0x7807c9a2, 0x0f00f934, 0x9609a88e, 0xe10e9818, 0x7f6a0dbb, 0x086d3d2d,
-        0x91646c97, 0xe6635c01, 0x6b6b51f4, 0x1c6c6162, 0x856530d8, 0xf262004e,
-        0x6c0695ed, 0x1b01a57b, 0x8208f4c1, 0xf50fc457, 0x65b0d9c6, 0x12b7e950,
-        0x8bbeb8ea, 0xfcb9887c, 0x62dd1ddf, 0x15da2d49, 0x8cd37cf3, 0xfbd44c65,
-        0x4db26158, 0x3ab551ce, 0xa3bc0074, 0xd4bb30e2, 0x4adfa541, 0x3dd895d7,
-        0xa4d1c46d, 0xd3d6f4fb, 0x4369e96a, 0x346ed9fc, 0xad678846, 0xda60b8d0,
-        0x44042d73, 0x33031de5, 0xaa0a4c5f, 0xdd0d7cc9, 0x5005713c, 0x270241aa,
-        0xbe0b1010, 0xc90c2086, 0x5768b525, 0x206f85b3, 0xb966d409, 0xce61e49f,
-        0x5edef90e, 0x29d9c998, 0xb0d09822, 0xc7d7a8b4, 0x59b33d17, 0x2eb40d81,
-        0xb7bd5c3b, 0xc0ba6cad, 0xedb88320, 0x9abfb3b6, 0x03b6e20c, 0x74b1d29a,
-        0xead54739, 0x9dd277af, 0x04db2615, 0x73dc1683, 0xe3630b12, 0x94643b84,
-        0x0d6d6a3e, 0x7a6a5aa8, 0xe40ecf0b, 0x9309ff9d, 0x0a00ae27, 0x7d079eb1,
-        0xf00f9344, 0x8708a3d2, 0x1e01f268, 0x6906c2fe, 0xf762575d, 0x806567cb,
-        0x196c3671, 0x6e6b06e7, 0xfed41b76, 0x89d32be0, 0x10da7a5a, 0x67dd4acc,
-        0xf9b9df6f, 0x8ebeeff9, 0x17b7be43, 0x60b08ed5, 0xd6d6a3e8, 0xa1d1937e,
-        0x38d8c2c4, 0x4fdff252, 0xd1bb67f1, 0xa6bc5767, 0x3fb506dd, 0x48b2364b,
-        0xd80d2bda, 0xaf0a1b4c, 0x36034af6, 0x41047a60, 0xdf60efc3, 0xa867df55,
-        0x316e8eef, 0x4669be79, 0xcb61b38c, 0xbc66831a, 0x256fd2a0, 0x5268e236,
-        0xcc0c7795, 0xbb0b4703, 0x220216b9, 0x5505262f, 0xc5ba3bbe, 0xb2bd0b28,
-        0x2bb45a92, 0x5cb36a04, 0xc2d7ffa7, 0xb5d0cf31, 0x2cd99e8b, 0x5bdeae1d,
-        0x9b64c2b0, 0xec63f226, 0x756aa39c, 0x026d930a, 0x9c0906a9, 0xeb0e363f,
-        0x72076785, 0x05005713, 0x95bf4a82, 0xe2b87a14, 0x7bb12bae, 0x0cb61b38,
-        0x92d28e9b, 0xe5d5be0d, 0x7cdcefb7, 0x0bdbdf21, 0x86d3d2d4, 0xf1d4e242,
-        0x68ddb3f8, 0x1fda836e, 0x81be16cd, 0xf6b9265b, 0x6fb077e1, 0x18b74777,
-        0x88085ae6, 0xff0f6a70, 0x66063bca, 0x11010b5c, 0x8f659eff, 0xf862ae69,
-        0x616bffd3, 0x166ccf45, 0xa00ae278, 0xd70dd2ee, 0x4e048354, 0x3903b3c2,
-        0xa7672661, 0xd06016f7, 0x4969474d, 0x3e6e77db, 0xaed16a4a, 0xd9d65adc,
-        0x40df0b66, 0x37d83bf0, 0xa9bcae53, 0xdebb9ec5, 0x47b2cf7f, 0x30b5ffe9,
-        0xbdbdf21c, 0xcabac28a, 0x53b39330, 0x24b4a3a6, 0xbad03605, 0xcdd70693,
-        0x54de5729, 0x23d967bf, 0xb3667a2e, 0xc4614ab8, 0x5d681b02, 0x2a6f2b94,
-        0xb40bbe37, 0xc30c8ea1, 0x5a05df1b, 0x2d02ef8d
-    };
-
-    class CrcHash
+    static DXGI_FORMAT getClearUAVFormat(const TextureDesc& textureDesc, bool asUINT)
     {
-    private:
-        uint32_t crc;
-    public:
-        CrcHash() 
-            : crc(0) 
-        { 
-        }
-
-        uint32_t Get() 
-        {
-            return crc;
-        }
-
-        template<size_t size> __forceinline void AddBytesSSE42(void* p)
-        {
-            static_assert(size % 4 == 0, "Size of hashable types must be multiple of 4");
-
-            uint32_t* data = (uint32_t*)p;
-
-            const size_t numIterations = size / sizeof(uint32_t);
-            for (size_t i = 0; i < numIterations; i++)
-            {
-                crc = _mm_crc32_u32(crc, data[i]);
-            }
-        }
-
-        __forceinline void AddBytes(char* p, uint32_t size)
-        {
-            for (uint32_t idx = 0; idx < size; idx++)
-                crc = CrcTable[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
-        }
-
-        template<typename T> void Add(const T& value)
-        {
-            if (CpuSupportsSSE42)
-                AddBytesSSE42<sizeof(value)>((void*)&value);
-            else
-                AddBytes((char*)&value, sizeof(value));
-        }
-    };
+        if (asUINT)
+            return DXGI_FORMAT_R32_UINT;
+        else if (textureDesc.format == Format::RGBA16_FLOAT)
+            return DXGI_FORMAT_R16G16B16A16_FLOAT;
+        else if (textureDesc.format == Format::R8_UNORM)
+            return DXGI_FORMAT_R8_UNORM;
+        else
+            return DXGI_FORMAT_R32_FLOAT;
+    }
 
     RendererInterfaceD3D11::~RendererInterfaceD3D11()
     {
@@ -378,6 +391,9 @@ namespace NVRHI
         : context(context)
         , errorCB(errorCB)
         , nvapiIsInitalized(false)
+        , readbackPeakBytes(0)
+        , maxFramesInFlight(2)
+        , frameIndex(0)
     {
         this->context->GetDevice(&device);
 
@@ -387,6 +403,9 @@ namespace NVRHI
 #endif
             
         context->QueryInterface(IID_PPV_ARGS(&userDefinedAnnotation));
+
+        //optional, only needed for clears of partial slices
+        context->QueryInterface(IID_PPV_ARGS(&context1));
     }
 
     TextureHandle RendererInterfaceD3D11::createTexture(const TextureDesc& d, const void* data)
@@ -573,15 +592,234 @@ namespace NVRHI
         }
     }
 
+    void RendererInterfaceD3D11::clearTextureRegionFloat(TextureHandle t, const TextureRegion& region, const Color& clearColor)
+    {
+        clearTextureRegion(t, region, false, clearColor, 0);
+    }
+
+    void RendererInterfaceD3D11::clearTextureRegionUInt(TextureHandle t, const TextureRegion& region, uint32_t clearColor)
+    {
+        clearTextureRegion(t, region, true, Color(float(clearColor)), clearColor);
+    }
+
+    void RendererInterfaceD3D11::clearTextureRegion(TextureHandle t, const TextureRegion& region, bool asUINT, const Color& clearColor, uint32_t clearValue)
+    {
+        TextureObjectMap::value_type* handle = (TextureObjectMap::value_type*)t;
+        if (!handle || !region.isValid(handle->second.textureDesc))
+        {
+            signalError(__FILE__, __LINE__, "Invalid texture clear region");
+            return;
+        }
+
+        const TextureDesc& textureDesc = handle->second.textureDesc;
+        TextureRegion box = region.resolve(textureDesc);
+        if (box.width == 0 || box.height == 0 || box.depth == 0)
+            return;
+
+        bool is3D = !textureDesc.isArray && !textureDesc.isCubeMap && textureDesc.depthOrArraySize > 1;
+        bool isDepthStencil = textureDesc.format == Format::D16 || textureDesc.format == Format::D24S8 || textureDesc.format == Format::D32;
+
+        //the regular clears always cover whole slices; rectangles need ClearView from D3D11.1, which doesn't support 3D textures or DSVs
+        TextureRegion wholeMip = TextureRegion(box.mipLevel, box.arraySlice).resolve(textureDesc);
+        bool wholeSlices = box.x == 0 && box.y == 0 && box.width == wholeMip.width && box.height == wholeMip.height;
+
+        if (!wholeSlices && (!context1 || is3D || (isDepthStencil && !textureDesc.isUAV)))
+        {
+            signalError(__FILE__, __LINE__, "This texture region can only be cleared in whole slices");
+            return;
+        }
+
+        D3D11_RECT rect = { LONG(box.x), LONG(box.y), LONG(box.x + box.width), LONG(box.y + box.height) };
+
+        if (textureDesc.isUAV)
+        {
+            //a temporary view that covers exactly the mip level and the slices of the region
+            D3D11_UNORDERED_ACCESS_VIEW_DESC desc11;
+            desc11.Format = getClearUAVFormat(textureDesc, asUINT);
+            if (textureDesc.isArray || textureDesc.isCubeMap)
+            {
+                desc11.ViewDimension = D3D11_UAV_DIMENSION_TEXTURE2DARRAY;
+                desc11.Texture2DArray.MipSlice = box.mipLevel;
+                desc11.Texture2DArray.FirstArraySlice = box.arraySlice;
+                desc11.Texture2DArray.ArraySize = 1;
+            }
+            else if (is3D)
+            {
+                desc11.ViewDimension = D3D11_UAV_DIMENSION_TEXTURE3D;
+                desc11.Texture3D.MipSlice = box.mipLevel;
+                desc11.Texture3D.FirstWSlice = box.z;
+                desc11.Texture3D.WSize = box.depth;
+            }
+            else
+            {
+                desc11.ViewDimension = D3D11_UAV_DIMENSION_TEXTURE2D;
+                desc11.Texture2D.MipSlice = box.mipLevel;
+            }
+
+            ComPtr<ID3D11UnorderedAccessView> uav;
+            CHECK_ERROR(SUCCEEDED(device->CreateUnorderedAccessView(handle->first.Get(), &desc11, &uav)), "Creating the view failed");
+            if (!uav)
+                return;
+
+            if (!wholeSlices)
+            {
+                context1->ClearView(uav.Get(), &clearColor.r, &rect, 1);
+            }
+            else if (asUINT)
+            {
+                UINT clearValues[4] = { clearValue, clearValue, clearValue, clearValue };
+                context->ClearUnorderedAccessViewUint(uav.Get(), clearValues);
+            }
+            else
+            {
+                context->ClearUnorderedAccessViewFloat(uav.Get(), &clearColor.r);
+            }
+        }
+        else if (textureDesc.isRenderTarget)
+        {
+            //render target views of 3D textures cover one depth slice each
+            uint32_t firstItem = is3D ? box.z : box.arraySlice;
+            uint32_t numItems = is3D ? box.depth : 1;
+
+            for (uint32_t item = firstItem; item < firstItem + numItems; item++)
+            {
+                if (isDepthStencil)
+                {
+                    ID3D11DepthStencilView* dsv = getDSVForTexture(handle, item, box.mipLevel);
+                    //re-interpret .y as stencil, like clearTextureFloat does
+                    UINT8 stencil = asUINT ? UINT8(clearValue) : *((UINT8*)&clearColor.g);
+                    context->ClearDepthStencilView(dsv, D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, clearColor.r, stencil);
+                }
+                else
+                {
+                    ID3D11RenderTargetView* rtv = getRTVForTexture(handle, item, box.mipLevel);
+                    if (wholeSlices)
+                        context->ClearRenderTargetView(rtv, &clearColor.r);
+                    else
+                        context1->ClearView(rtv, &clearColor.r, &rect, 1);
+                }
+            }
+        }
+        else
+        {
+            CHECK_ERROR(0, "This resource cannot be cleared");
+        }
+    }
+
     void RendererInterfaceD3D11::writeTexture(TextureHandle t, uint32_t subresource, const void* data, uint32_t rowPitch, uint32_t depthPitch)
     {
         TextureObjectMap::value_type* handle = (TextureObjectMap::value_type*)t;
+        uint32_t mipLevels = handle ? std::max(1u, handle->second.textureDesc.mipLevels) : 1;
+        if (!handle || !data || !TextureRegion(subresource % mipLevels, subresource / mipLevels).isValid(handle->second.textureDesc))
+        {
+            signalError(__FILE__, __LINE__, "Invalid texture write");
+            return;
+        }
 
         ID3D11Resource* resource = handle->first.Get();
 
         context->UpdateSubresource(resource, subresource, NULL, data, rowPitch, depthPitch);
     }
 
+    void RendererInterfaceD3D11::writeTextureRegion(TextureHandle t, const TextureRegion& region, const void* data, uint32_t rowPitch, uint32_t depthPitch)
+    {
+        TextureObjectMap::value_type* handle = (TextureObjectMap::value_type*)t;
+        if (!handle || !data || !region.isValid(handle->second.textureDesc))
+        {
+            signalError(__FILE__, __LINE__, "Invalid texture write");
+            return;
+        }
+
+        const TextureDesc& desc = handle->second.textureDesc;
+        TextureRegion box = region.resolve(desc);
+        if (box.width == 0 || box.height == 0 || box.depth == 0)
+            return;
+
+        //3D textures have a single array slice, the region selects the depth slices
+        bool is3D = !desc.isArray && !desc.isCubeMap && desc.depthOrArraySize > 1;
+        UINT subresource = D3D11CalcSubresource(box.mipLevel, is3D ? 0 : box.arraySlice, desc.mipLevels);
+
+        D3D11_BOX destBox;
+        destBox.left = box.x;
+        destBox.right = box.x + box.width;
+        destBox.top = box.y;
+        destBox.bottom = box.y + box.height;
+        destBox.front = box.z;
+        destBox.back = box.z + box.depth;
+
+        context->UpdateSubresource(handle->first.Get(), subresource, &destBox, data, rowPitch, depthPitch);
+    }
+
+    void RendererInterfaceD3D11::copyTexture(TextureHandle dest, const TextureRegion& destRegion, TextureHandle src, const TextureRegion& srcRegion)
+    {
+        TextureObjectMap::value_type* handleDest = (TextureObjectMap::value_type*)dest;
+        TextureObjectMap::value_type* handleSrc = (TextureObjectMap::value_type*)src;
+        if (!handleDest || !handleSrc || !destRegion.isValid(handleDest->second.textureDesc) || !srcRegion.isValid(handleSrc->second.textureDesc))
+        {
+            signalError(__FILE__, __LINE__, "Invalid texture copy");
+            return;
+        }
+
+        const TextureDesc& destDesc = handleDest->second.textureDesc;
+        const TextureDesc& srcDesc = handleSrc->second.textureDesc;
+
+        TextureRegion box = srcRegion.resolve(srcDesc);
+        if (box.width == 0 || box.height == 0 || box.depth == 0)
+            return;
+
+        bool destIs3D = !destDesc.isArray && !destDesc.isCubeMap && destDesc.depthOrArraySize > 1;
+        bool srcIs3D = !srcDesc.isArray && !srcDesc.isCubeMap && srcDesc.depthOrArraySize > 1;
+        UINT destSubresource = D3D11CalcSubresource(destRegion.mipLevel, destIs3D ? 0 : destRegion.arraySlice, destDesc.mipLevels);
+        UINT srcSubresource = D3D11CalcSubresource(box.mipLevel, srcIs3D ? 0 : box.arraySlice, srcDesc.mipLevels);
+
+        D3D11_BOX srcBox;
+        srcBox.left = box.x;
+        srcBox.right = box.x + box.width;
+        srcBox.top = box.y;
+        srcBox.bottom = box.y + box.height;
+        srcBox.front = box.z;
+        srcBox.back = box.z + box.depth;
+
+        //depth-stencil and multisampled resources can only be copied as whole subresources, which is what a NULL box means
+        TextureRegion wholeMip = TextureRegion(box.mipLevel, box.arraySlice).resolve(srcDesc);
+        bool wholeSubresource = box.x == 0 && box.y == 0 && box.z == 0 && box.width == wholeMip.width && box.height == wholeMip.height && box.depth == wholeMip.depth;
+
+        context->CopySubresourceRegion(handleDest->first.Get(), destSubresource, destRegion.x, destRegion.y, destRegion.z,
+            handleSrc->first.Get(), srcSubresource, wholeSubresource ? NULL : &srcBox);
+    }
+
+    void RendererInterfaceD3D11::copyBufferToTexture(TextureHandle, const TextureRegion&, BufferHandle, uint32_t, uint32_t, uint32_t)
+    {
+        //D3D11 cannot copy between buffers and textures on the GPU
+        signalError(__FILE__, __LINE__, "copyBufferToTexture is not supported on D3D11");
+    }
+
+    void RendererInterfaceD3D11::copyTextureToBuffer(BufferHandle, uint32_t, uint32_t, uint32_t, TextureHandle, const TextureRegion&)
+    {
+        signalError(__FILE__, __LINE__, "copyTextureToBuffer is not supported on D3D11");
+    }
+
+    void RendererInterfaceD3D11::resolveTexture(TextureHandle dest, uint32_t destMipLevel, uint32_t destArraySlice, TextureHandle src, uint32_t srcArraySlice)
+    {
+        TextureObjectMap::value_type* handleDest = (TextureObjectMap::value_type*)dest;
+        TextureObjectMap::value_type* handleSrc = (TextureObjectMap::value_type*)src;
+        if (!handleDest || !handleSrc || !TextureRegion(destMipLevel, destArraySlice).isValid(handleDest->second.textureDesc) ||
+            !TextureRegion(0, srcArraySlice).isValid(handleSrc->second.textureDesc) || handleSrc->second.textureDesc.sampleCount <= 1)
+        {
+            signalError(__FILE__, __LINE__, "Invalid texture resolve");
+            return;
+        }
+
+        //the resources may be typeless, so the resolve needs the format of the texture description
+        UINT pixelSize = 0;
+        DXGI_FORMAT format = getTypedTextureFormat(handleSrc->second.textureDesc.format, pixelSize, false);
+
+        UINT destSubresource = D3D11CalcSubresource(destMipLevel, destArraySlice, handleDest->second.textureDesc.mipLevels);
+        UINT srcSubresource = D3D11CalcSubresource(0, srcArraySlice, 1);
+
+        context->ResolveSubresource(handleDest->first.Get(), destSubresource, handleSrc->first.Get(), srcSubresource, format);
+    }
+
     void RendererInterfaceD3D11::destroyTexture(TextureHandle t)
     {
         TextureObjectMap::value_type* handle = (TextureObjectMap::value_type*)t;
@@ -661,6 +899,101 @@ namespace NVRHI
 
     }
 
+    void RendererInterfaceD3D11::writeBufferRange(BufferHandle b, uint32_t offsetBytes, const void* data, size_t dataSize)
+    {
+        BufferObjectMap::value_type* handle = (BufferObjectMap::value_type*)b;
+        if (!handle || offsetBytes >= handle->second.bufferDesc.byteSize)
+        {
+            signalError(__FILE__, __LINE__, "Invalid buffer write range");
+            return;
+        }
+
+        const BufferDesc& desc = handle->second.bufferDesc;
+        dataSize = std::min(dataSize, (size_t)(desc.byteSize - offsetBytes));
+
+        if (desc.isCPUWritable)
+        {
+            //a dynamic buffer can only be discarded as a whole; partial updates of those go through mapBuffer with WRITE_NO_OVERWRITE
+            if (offsetBytes != 0 || dataSize != desc.byteSize)
+            {
+                signalError(__FILE__, __LINE__, "Partial writes to CPU-writable buffers are not supported, use mapBuffer instead");
+                return;
+            }
+
+            writeBuffer(b, data, dataSize);
+            return;
+        }
+
+        D3D11_BOX destBox;
+        destBox.left = offsetBytes;
+        destBox.right = offsetBytes + (UINT)dataSize;
+        destBox.top = 0;
+        destBox.bottom = 1;
+        destBox.front = 0;
+        destBox.back = 1;
+
+        context->UpdateSubresource(handle->first.Get(), 0, &destBox, data, (UINT)dataSize, 0);
+    }
+
+    void* RendererInterfaceD3D11::mapBuffer(BufferHandle b, MapMode::Enum mode, uint32_t offsetBytes, size_t sizeBytes)
+    {
+        BufferObjectMap::value_type* handle = (BufferObjectMap::value_type*)b;
+        if (!handle || handle->second.isMapped || offsetBytes >= handle->second.bufferDesc.byteSize || sizeBytes == 0)
+        {
+            signalError(__FILE__, __LINE__, "Invalid buffer map");
+            return NULL;
+        }
+
+        BufferViewSet& viewSet = handle->second;
+        viewSet.mappedOffset = offsetBytes;
+        viewSet.mappedSize = (UINT)std::min(sizeBytes, (size_t)(viewSet.bufferDesc.byteSize - offsetBytes));
+
+        if (viewSet.bufferDesc.isCPUWritable)
+        {
+            //D3D11_USAGE_DYNAMIC buffers are mapped directly, and the driver renames them on discard
+            D3D11_MAPPED_SUBRESOURCE mappedData;
+            D3D11_MAP mapType = (mode == MapMode::WRITE_DISCARD) ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE;
+            HRESULT hr = context->Map(handle->first.Get(), 0, mapType, 0, &mappedData);
+            CHECK_ERROR(SUCCEEDED(hr), "Map failed");
+            if (FAILED(hr))
+                return NULL;
+
+            viewSet.isMapped = true;
+            return (char*)mappedData.pData + offsetBytes;
+        }
+
+        //other buffers can only be written with UpdateSubresource
+        viewSet.mapScratch.resize(viewSet.mappedSize);
+        viewSet.isMapped = true;
+        return &viewSet.mapScratch[0];
+    }
+
+    void RendererInterfaceD3D11::unmapBuffer(BufferHandle b)
+    {
+        BufferObjectMap::value_type* handle = (BufferObjectMap::value_type*)b;
+        if (!handle || !handle->second.isMapped)
+            return;
+
+        BufferViewSet& viewSet = handle->second;
+        viewSet.isMapped = false;
+
+        if (viewSet.bufferDesc.isCPUWritable)
+        {
+            context->Unmap(handle->first.Get(), 0);
+            return;
+        }
+
+        D3D11_BOX destBox;
+        destBox.left = viewSet.mappedOffset;
+        destBox.right = viewSet.mappedOffset + viewSet.mappedSize;
+        destBox.top = 0;
+        destBox.bottom = 1;
+        destBox.front = 0;
+        destBox.back = 1;
+
+        context->UpdateSubresource(handle->first.Get(), 0, &destBox, &viewSet.mapScratch[0], viewSet.mappedSize, 0);
+    }
+
     void RendererInterfaceD3D11::clearBufferUInt(BufferHandle b, uint32_t clearValue)
     {
         BufferObjectMap::value_type* handle = (BufferObjectMap::value_type*)b;
@@ -670,6 +1003,39 @@ namespace NVRHI
         context->ClearUnorderedAccessViewUint(uav, clearValues);
     }
 
+    void RendererInterfaceD3D11::clearBufferUIntRange(BufferHandle b, uint32_t offsetBytes, size_t sizeBytes, uint32_t clearValue)
+    {
+        BufferObjectMap::value_type* handle = (BufferObjectMap::value_type*)b;
+        if (!handle)
+            return;
+
+        const BufferDesc& desc = handle->second.bufferDesc;
+        UINT elementSize = desc.structStride ? desc.structStride : 4;
+        if (offsetBytes >= desc.byteSize || offsetBytes % elementSize || sizeBytes % elementSize)
+        {
+            signalError(__FILE__, __LINE__, "Invalid buffer clear range");
+            return;
+        }
+
+        sizeBytes = std::min(sizeBytes, (size_t)(desc.byteSize - offsetBytes));
+
+        //ClearUnorderedAccessViewUint always clears the whole view, so clear through a view that only covers the range
+        D3D11_UNORDERED_ACCESS_VIEW_DESC desc11;
+        desc11.ViewDimension = D3D11_UAV_DIMENSION_BUFFER;
+        desc11.Format = desc.structStride ? DXGI_FORMAT_UNKNOWN : DXGI_FORMAT_R32_UINT;
+        desc11.Buffer.FirstElement = offsetBytes / elementSize;
+        desc11.Buffer.NumElements = (UINT)(sizeBytes / elementSize);
+        desc11.Buffer.Flags = 0;
+
+        ComPtr<ID3D11UnorderedAccessView> uav;
+        CHECK_ERROR(SUCCEEDED(device->CreateUnorderedAccessView(handle->first.Get(), &desc11, &uav)), "Creation failed");
+        if (!uav)
+            return;
+
+        UINT clearValues[4] = { clearValue, clearValue, clearValue, clearValue };
+        context->ClearUnorderedAccessViewUint(uav.Get(), clearValues);
+    }
+
     void RendererInterfaceD3D11::copyToBuffer(BufferHandle dest, uint32_t destOffsetBytes, BufferHandle src, uint32_t srcOffsetBytes, size_t dataSizeBytes)
     {
         BufferObjectMap::value_type* handleDest = (BufferObjectMap::value_type*)dest;
@@ -694,40 +1060,416 @@ namespace NVRHI
         size_t bufferSize = *dataSize;
         *dataSize = 0;
 
-        if (!data)
+        if (!data || !bufferSize)
             return;
 
-        BufferObjectMap::value_type* handle = (BufferObjectMap::value_type*)b;
+        //use a recycled staging buffer instead of creating one for every call
+        Readback* readback = beginBufferReadback(b, 0, bufferSize);
+        if (!readback)
+            return;
+
+        const void* pData = mapReadback(readback, NULL, NULL);
+        if (pData)
+        {
+            memcpy(data, pData, readback->size);
+            *dataSize = readback->size;
+        }
 
-        D3D11_BUFFER_DESC desc;
-        handle->first->GetDesc(&desc);
-        desc.BindFlags = 0;
-        desc.MiscFlags = 0;
-        desc.Usage = D3D11_USAGE_STAGING;
-        desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+        releaseReadback(readback);
+    }
 
-        ComPtr<ID3D11Buffer> staging;
-        if (FAILED(device->CreateBuffer(&desc, NULL, &staging)))
-            return;
+    Readback* RendererInterfaceD3D11::allocateReadback(D3D11_RESOURCE_DIMENSION dimension, DXGI_FORMAT format, UINT width, UINT height, UINT depth, UINT pixelSizeBytes)
+    {
+        //buffers are matched by the smallest sufficient capacity, textures by their exact size and format
+        auto best = freeReadbacks.end();
+        for (auto it = freeReadbacks.begin(); it != freeReadbacks.end(); ++it)
+        {
+            Readback* candidate = *it;
+            if (candidate->dimension != dimension)
+                continue;
+
+            if (dimension == D3D11_RESOURCE_DIMENSION_BUFFER)
+            {
+                if (candidate->width >= width && (best == freeReadbacks.end() || candidate->width < (*best)->width))
+                    best = it;
+            }
+            else if (candidate->format == format && candidate->width == width && candidate->height == height && candidate->depth == depth)
+            {
+                best = it;
+                break;
+            }
+        }
+
+        if (best != freeReadbacks.end())
+        {
+            Readback* readback = *best;
+            *best = freeReadbacks.back();
+            freeReadbacks.pop_back();
+            getReadbackStatistics();
+            return readback;
+        }
+
+        Readback* readback = new Readback();
+        readback->dimension = dimension;
+        readback->format = format;
+        readback->width = width;
+        readback->height = height;
+        readback->depth = depth;
 
-        context->CopyResource(staging.Get(), handle->first.Get());
+        HRESULT hr = E_FAIL;
 
-        D3D11_MAPPED_SUBRESOURCE subresource;
-        if (SUCCEEDED(context->Map(staging.Get(), 0, D3D11_MAP_READ, 0, &subresource)))
+        if (dimension == D3D11_RESOURCE_DIMENSION_BUFFER)
+        {
+            //round the capacity up to a power of two so that the buffer can be reused for readbacks of similar size
+            UINT capacity = 256;
+            while (capacity < width)
+                capacity *= 2;
+            readback->width = capacity;
+
+            CD3D11_BUFFER_DESC desc(capacity, 0, D3D11_USAGE_STAGING, D3D11_CPU_ACCESS_READ);
+            ComPtr<ID3D11Buffer> buffer;
+            hr = device->CreateBuffer(&desc, NULL, &buffer);
+            readback->staging = buffer;
+        }
+        else if (dimension == D3D11_RESOURCE_DIMENSION_TEXTURE2D)
         {
-            size_t bytesCopied = std::min((size_t)desc.ByteWidth, bufferSize);
-            memcpy(data, subresource.pData, bytesCopied);
-            *dataSize = bytesCopied;
+            CD3D11_TEXTURE2D_DESC desc(format, width, height, 1, 1, 0, D3D11_USAGE_STAGING, D3D11_CPU_ACCESS_READ);
+            ComPtr<ID3D11Texture2D> texture;
+            hr = device->CreateTexture2D(&desc, NULL, &texture);
+            readback->staging = texture;
+        }
+        else if (dimension == D3D11_RESOURCE_DIMENSION_TEXTURE3D)
+        {
+            CD3D11_TEXTURE3D_DESC desc(format, width, height, depth, 1, 0, D3D11_USAGE_STAGING, D3D11_CPU_ACCESS_READ);
+            ComPtr<ID3D11Texture3D> texture;
+            hr = device->CreateTexture3D(&desc, NULL, &texture);
+            readback->staging = texture;
+        }
+
+        CHECK_ERROR(SUCCEEDED(hr), "Failed to create a readback staging resource");
 
-            context->Unmap(staging.Get(), 0);
+        if (FAILED(hr))
+        {
+            delete readback;
+            return NULL;
         }
+
+        readback->byteSize = UINT64(readback->width) * readback->height * readback->depth * pixelSizeBytes;
+
+        readbacks.push_back(readback);
+        getReadbackStatistics();
+        return readback;
     }
 
-    void RendererInterfaceD3D11::destroyBuffer(BufferHandle b)
+    PoolStatistics RendererInterfaceD3D11::getReadbackStatistics()
     {
-        BufferObjectMap::value_type* handle = (BufferObjectMap::value_type*)b;
-        if (!handle)
-            return;
+        PoolStatistics stats;
+        for (auto readback : readbacks)
+            stats.capacity += readback->byteSize;
+
+        stats.inUse = stats.capacity;
+        for (auto readback : freeReadbacks)
+            stats.inUse -= readback->byteSize;
+
+        readbackPeakBytes = std::max(readbackPeakBytes, stats.inUse);
+        stats.peak = readbackPeakBytes;
+        return stats;
+    }
+
+    ReadbackHandle RendererInterfaceD3D11::beginBufferReadback(BufferHandle b, uint32_t offsetBytes, size_t sizeBytes)
+    {
+        BufferObjectMap::value_type* handle = (BufferObjectMap::value_type*)b;
+        if (!handle || offsetBytes >= handle->second.bufferDesc.byteSize || sizeBytes == 0)
+        {
+            signalError(__FILE__, __LINE__, "Invalid buffer readback range");
+            return NULL;
+        }
+
+        UINT size = (UINT)std::min(sizeBytes, (size_t)(handle->second.bufferDesc.byteSize - offsetBytes));
+
+        Readback* readback = allocateReadback(D3D11_RESOURCE_DIMENSION_BUFFER, DXGI_FORMAT_UNKNOWN, size, 1, 1, 1);
+        if (!readback)
+            return NULL;
+
+        readback->size = size;
+
+        D3D11_BOX box = { offsetBytes, 0, 0, offsetBytes + size, 1, 1 };
+        context->CopySubresourceRegion(readback->staging.Get(), 0, 0, 0, 0, handle->first.Get(), 0, &box);
+
+        return readback;
+    }
+
+    ReadbackHandle RendererInterfaceD3D11::beginTextureReadback(TextureHandle t, const TextureRegion& region)
+    {
+        TextureObjectMap::value_type* handle = (TextureObjectMap::value_type*)t;
+        if (!handle)
+        {
+            signalError(__FILE__, __LINE__, "Invalid texture readback");
+            return NULL;
+        }
+
+        const TextureDesc& textureDesc = handle->second.textureDesc;
+        TextureRegion box = region.resolve(textureDesc);
+        if (!region.isValid(textureDesc) || textureDesc.sampleCount > 1 || box.width == 0 || box.height == 0 || box.depth == 0)
+        {
+            signalError(__FILE__, __LINE__, "Invalid texture readback region");
+            return NULL;
+        }
+
+        ID3D11Resource* resource = handle->first.Get();
+        D3D11_RESOURCE_DIMENSION dimension;
+        resource->GetType(&dimension);
+
+        DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+        if (dimension == D3D11_RESOURCE_DIMENSION_TEXTURE2D)
+        {
+            D3D11_TEXTURE2D_DESC desc;
+            static_cast<ID3D11Texture2D*>(resource)->GetDesc(&desc);
+            format = desc.Format;
+        }
+        else if (dimension == D3D11_RESOURCE_DIMENSION_TEXTURE3D)
+        {
+            D3D11_TEXTURE3D_DESC desc;
+            static_cast<ID3D11Texture3D*>(resource)->GetDesc(&desc);
+            format = desc.Format;
+        }
+        else
+        {
+            signalError(__FILE__, __LINE__, "Readback is only supported for 2D and 3D textures");
+            return NULL;
+        }
+
+        UINT pixelSizeBytes = 0;
+        getUntypedTextureFormat(textureDesc.format, pixelSizeBytes);
+
+        Readback* readback = allocateReadback(dimension, format, box.width, box.height, box.depth, pixelSizeBytes);
+        if (!readback)
+            return NULL;
+
+        UINT subresource = D3D11CalcSubresource(box.mipLevel, box.arraySlice, textureDesc.mipLevels);
+
+        //depth-stencil resources can only be copied as whole subresources, which is what a NULL box means
+        TextureRegion wholeMip = TextureRegion(box.mipLevel, box.arraySlice).resolve(textureDesc);
+        bool wholeSubresource = box.x == 0 && box.y == 0 && box.z == 0 && box.width == wholeMip.width && box.height == wholeMip.height && box.depth == wholeMip.depth;
+
+        D3D11_BOX srcBox = { box.x, box.y, box.z, box.x + box.width, box.y + box.height, box.z + box.depth };
+        context->CopySubresourceRegion(readback->staging.Get(), 0, 0, 0, 0, resource, subresource, wholeSubresource ? NULL : &srcBox);
+
+        return readback;
+    }
+
+    bool RendererInterfaceD3D11::isReadbackReady(ReadbackHandle r)
+    {
+        if (!r)
+            return false;
+
+        if (!r->isMapped)
+        {
+            //the staging resource stays mapped until the readback is released
+            HRESULT hr = context->Map(r->staging.Get(), 0, D3D11_MAP_READ, D3D11_MAP_FLAG_DO_NOT_WAIT, &r->mapped);
+            if (hr == DXGI_ERROR_WAS_STILL_DRAWING)
+                return false;
+
+            CHECK_ERROR(SUCCEEDED(hr), "Failed to map a readback staging resource");
+            r->isMapped = SUCCEEDED(hr);
+        }
+
+        return r->isMapped;
+    }
+
+    const void* RendererInterfaceD3D11::mapReadback(ReadbackHandle r, uint32_t* rowPitch, uint32_t* depthPitch)
+    {
+        if (!r)
+            return NULL;
+
+        if (!r->isMapped)
+        {
+            HRESULT hr = context->Map(r->staging.Get(), 0, D3D11_MAP_READ, 0, &r->mapped);
+            CHECK_ERROR(SUCCEEDED(hr), "Failed to map a readback staging resource");
+            if (FAILED(hr))
+                return NULL;
+
+            r->isMapped = true;
+        }
+
+        bool isBuffer = r->dimension == D3D11_RESOURCE_DIMENSION_BUFFER;
+        if (rowPitch) *rowPitch = isBuffer ? r->size : r->mapped.RowPitch;
+        if (depthPitch) *depthPitch = isBuffer ? r->size : r->mapped.DepthPitch;
+
+        return r->mapped.pData;
+    }
+
+    FenceHandle RendererInterfaceD3D11::createFence()
+    {
+        return new Fence();
+    }
+
+    void RendererInterfaceD3D11::destroyFence(FenceHandle f)
+    {
+        delete f;
+    }
+
+    void RendererInterfaceD3D11::signalFence(FenceHandle f, uint64_t value)
+    {
+        if (!f)
+            return;
+
+        D3D11_QUERY_DESC queryDesc;
+        queryDesc.Query = D3D11_QUERY_EVENT;
+        queryDesc.MiscFlags = 0;
+
+        ComPtr<ID3D11Query> query;
+        CHECK_ERROR(SUCCEEDED(device->CreateQuery(&queryDesc, &query)), "Creating the query failed");
+        if (!query)
+            return;
+
+        context->End(query.Get());
+        f->pendingSignals.push_back(std::make_pair(value, query));
+    }
+
+    uint64_t RendererInterfaceD3D11::getFenceCompletedValue(FenceHandle f)
+    {
+        if (!f)
+            return 0;
+
+        updateFence(f, 0);
+        return f->completedValue;
+    }
+
+    void RendererInterfaceD3D11::waitFence(FenceHandle f, uint64_t value)
+    {
+        if (!f)
+            return;
+
+        updateFence(f, value);
+
+        if (f->completedValue < value)
+            signalError(__FILE__, __LINE__, "waitFence: the value has not been signaled");
+    }
+
+    void RendererInterfaceD3D11::setMaxFramesInFlight(uint32_t maxFrames)
+    {
+        maxFramesInFlight = std::max(maxFrames, 1u);
+    }
+
+    void RendererInterfaceD3D11::beginFrame()
+    {
+        //only block when the GPU is more than the allowed number of frames behind
+        retireCompletedFrames(maxFramesInFlight - 1);
+    }
+
+    void RendererInterfaceD3D11::endFrame()
+    {
+        D3D11_QUERY_DESC queryDesc;
+        queryDesc.Query = D3D11_QUERY_EVENT;
+        queryDesc.MiscFlags = 0;
+
+        ComPtr<ID3D11Query> query;
+        CHECK_ERROR(SUCCEEDED(device->CreateQuery(&queryDesc, &query)), "Creating the query failed");
+        if (query)
+        {
+            context->End(query.Get());
+            frameQueries.push_back(query);
+        }
+
+        frameIndex++;
+
+        retireCompletedFrames(UINT32_MAX);
+    }
+
+    FrameStatistics RendererInterfaceD3D11::getFrameStatistics()
+    {
+        retireCompletedFrames(UINT32_MAX);
+
+        //the driver owns the memory behind uploads and views, only the readback staging resources are visible here
+        FrameStatistics stats;
+        stats.frameIndex = frameIndex;
+        stats.framesInFlight = uint32_t(frameQueries.size());
+        stats.readbackBytes = getReadbackStatistics();
+        AccumulateCacheStatistics(stats.stateObjects, blendStates.GetStatistics());
+        AccumulateCacheStatistics(stats.stateObjects, depthStencilStates.GetStatistics());
+        AccumulateCacheStatistics(stats.stateObjects, rasterizerStates.GetStatistics());
+        return stats;
+    }
+
+    void RendererInterfaceD3D11::setStateCacheLimits(uint32_t maxEntries, uint64_t maxBytes)
+    {
+        //the context and the pipelines hold their own references, so the evicted state objects can be released right away
+        std::vector<ComPtr<ID3D11BlendState>> evictedBlendStates;
+        std::vector<ComPtr<ID3D11DepthStencilState>> evictedDepthStencilStates;
+        std::vector<ComPtr<ID3D11RasterizerState>> evictedRasterizerStates;
+        blendStates.SetLimits(maxEntries, maxBytes, evictedBlendStates);
+        depthStencilStates.SetLimits(maxEntries, maxBytes, evictedDepthStencilStates);
+        rasterizerStates.SetLimits(maxEntries, maxBytes, evictedRasterizerStates);
+    }
+
+    void RendererInterfaceD3D11::retireCompletedFrames(uint32_t maxPendingFrames)
+    {
+        //retire the frames that the GPU has finished, and spin on the oldest ones while there are more than maxPendingFrames left
+        while (!frameQueries.empty())
+        {
+            bool mustWait = frameQueries.size() > maxPendingFrames;
+
+            HRESULT hr = context->GetData(frameQueries.front().Get(), NULL, 0, mustWait ? 0 : D3D11_ASYNC_GETDATA_DONOTFLUSH);
+
+            if (hr == S_FALSE)
+            {
+                if (mustWait)
+                    continue;
+
+                break;
+            }
+
+            CHECK_ERROR(SUCCEEDED(hr), "GetData failed for a frame");
+
+            frameQueries.pop_front();
+        }
+    }
+
+    void RendererInterfaceD3D11::updateFence(Fence* f, uint64_t waitValue)
+    {
+        //retire the signals that the GPU has passed, in order, and spin on the ones up to waitValue
+        while (!f->pendingSignals.empty())
+        {
+            const auto& signal = f->pendingSignals.front();
+            bool mustWait = f->completedValue < waitValue && signal.first <= waitValue;
+
+            HRESULT hr = context->GetData(signal.second.Get(), NULL, 0, mustWait ? 0 : D3D11_ASYNC_GETDATA_DONOTFLUSH);
+
+            if (hr == S_FALSE)
+            {
+                if (mustWait)
+                    continue;
+
+                break;
+            }
+
+            CHECK_ERROR(SUCCEEDED(hr), "GetData failed for a fence");
+
+            f->completedValue = std::max(f->completedValue, signal.first);
+            f->pendingSignals.pop_front();
+        }
+    }
+
+    void RendererInterfaceD3D11::releaseReadback(ReadbackHandle r)
+    {
+        if (!r)
+            return;
+
+        if (r->isMapped)
+        {
+            context->Unmap(r->staging.Get(), 0);
+            r->isMapped = false;
+        }
+
+        freeReadbacks.push_back(r);
+    }
+
+    void RendererInterfaceD3D11::destroyBuffer(BufferHandle b)
+    {
+        BufferObjectMap::value_type* handle = (BufferObjectMap::value_type*)b;
+        if (!handle)
+            return;
 
         //smart pointers will clean up for us
         buffers.erase(handle->first);
@@ -861,110 +1603,555 @@ namespace NVRHI
     SamplerHandle RendererInterfaceD3D11::createSampler(const SamplerDesc& d)
     {
 
-        //convert the sampler dessc
-        D3D11_SAMPLER_DESC desc11;
-        if (d.anisotropy > 1.0f)
+        //convert the sampler dessc
+        D3D11_SAMPLER_DESC desc11;
+        if (d.anisotropy > 1.0f)
+        {
+            desc11.Filter = D3D11_ENCODE_ANISOTROPIC_FILTER(d.shadowCompare ? D3D11_FILTER_REDUCTION_TYPE_COMPARISON : D3D11_FILTER_REDUCTION_TYPE_STANDARD);
+        }
+        else
+        {
+            desc11.Filter = D3D11_ENCODE_BASIC_FILTER(d.minFilter ? D3D11_FILTER_TYPE_LINEAR : D3D11_FILTER_TYPE_POINT, d.magFilter ? D3D11_FILTER_TYPE_LINEAR : D3D11_FILTER_TYPE_POINT, d.mipFilter ? D3D11_FILTER_TYPE_LINEAR : D3D11_FILTER_TYPE_POINT, d.shadowCompare ? D3D11_FILTER_REDUCTION_TYPE_COMPARISON : D3D11_FILTER_REDUCTION_TYPE_STANDARD);
+        }
+        D3D11_TEXTURE_ADDRESS_MODE* dest[] = { &desc11.AddressU, &desc11.AddressV, &desc11.AddressW };
+        for (int i = 0; i < 3; i++)
+        {
+            switch (d.wrapMode[i])
+            {
+            case SamplerDesc::WRAP_MODE_BORDER:
+                *dest[i] = D3D11_TEXTURE_ADDRESS_BORDER;
+                break;
+            case SamplerDesc::WRAP_MODE_CLAMP:
+                *dest[i] = D3D11_TEXTURE_ADDRESS_CLAMP;
+                break;
+            case SamplerDesc::WRAP_MODE_WRAP:
+                *dest[i] = D3D11_TEXTURE_ADDRESS_WRAP;
+                break;
+            }
+        }
+
+        desc11.MipLODBias = d.mipBias;
+        desc11.MaxAnisotropy = std::max((UINT)d.anisotropy, 1U);
+        desc11.ComparisonFunc = D3D11_COMPARISON_LESS;
+        desc11.BorderColor[0] = d.borderColor.r;
+        desc11.BorderColor[1] = d.borderColor.g;
+        desc11.BorderColor[2] = d.borderColor.b;
+        desc11.BorderColor[3] = d.borderColor.a;
+        desc11.MinLOD = 0;
+        desc11.MaxLOD = D3D11_FLOAT32_MAX;
+
+        ID3D11SamplerState* sState = NULL;
+        CHECK_ERROR(SUCCEEDED(device->CreateSamplerState(&desc11, &sState)), "Creating sampler state failed");
+
+        return (SamplerHandle)sState;
+    }
+
+    void RendererInterfaceD3D11::destroySampler(SamplerHandle s)
+    {
+        ID3D11SamplerState* sState = (ID3D11SamplerState*)s;
+        if (!sState)
+            return;
+        sState->Release();
+    }
+        
+    InputLayoutHandle RendererInterfaceD3D11::createInputLayout(const VertexAttributeDesc* d, uint32_t attributeCount, const void* vertexShaderBinary, const size_t binarySize)
+    {
+        uint32_t dontCare;
+        D3D11_INPUT_ELEMENT_DESC elementDesc[DrawCallState::MAX_VERTEX_ATTRIBUTE_COUNT];
+        for (uint32_t i = 0; i < attributeCount; i++)
+        {
+            elementDesc[i].SemanticName = d[i].name;
+            elementDesc[i].SemanticIndex = 0;
+            elementDesc[i].Format = getTypedTextureFormat(d[i].format, dontCare, false);
+            elementDesc[i].InputSlot = d[i].bufferIndex;
+            elementDesc[i].AlignedByteOffset = d[i].offset;
+            elementDesc[i].InputSlotClass = d[i].isInstanced ? D3D11_INPUT_PER_INSTANCE_DATA : D3D11_INPUT_PER_VERTEX_DATA;
+            elementDesc[i].InstanceDataStepRate = d[i].isInstanced ? 1 : 0;
+        }
+
+        ID3D11InputLayout* inputLayout = NULL;
+        CHECK_ERROR(SUCCEEDED(device->CreateInputLayout(elementDesc, attributeCount, vertexShaderBinary, binarySize, &inputLayout)), "CreateInputLayout() failed");
+
+        return (InputLayoutHandle)inputLayout;
+    }
+
+    void RendererInterfaceD3D11::destroyInputLayout(InputLayoutHandle i)
+    {
+        ID3D11InputLayout* inputLayout = (ID3D11InputLayout*)i;
+        if (!inputLayout)
+            return;
+        inputLayout->Release();
+    }
+
+    GraphicsPipelineHandle RendererInterfaceD3D11::createGraphicsPipeline(const GraphicsPipelineDesc& d)
+    {
+        GraphicsPipeline* pipeline = new GraphicsPipeline();
+        pipeline->desc = d;
+        pipeline->primitiveTopology = getPrimType(d.primType);
+        pipeline->inputLayout = (ID3D11InputLayout*)d.inputLayout;
+
+        //Resolve the shader interfaces once. We cast to ID3D11DeviceChild first since that's what the handle is cast to before it was given to the client
+        if (d.VS) ((ID3D11DeviceChild*)d.VS)->QueryInterface<ID3D11VertexShader>(&pipeline->VS);
+        if (d.HS) ((ID3D11DeviceChild*)d.HS)->QueryInterface<ID3D11HullShader>(&pipeline->HS);
+        if (d.DS) ((ID3D11DeviceChild*)d.DS)->QueryInterface<ID3D11DomainShader>(&pipeline->DS);
+        if (d.GS) ((ID3D11DeviceChild*)d.GS)->QueryInterface<ID3D11GeometryShader>(&pipeline->GS);
+        if (d.PS) ((ID3D11DeviceChild*)d.PS)->QueryInterface<ID3D11PixelShader>(&pipeline->PS);
+
+        if ((d.VS && !pipeline->VS) || (d.HS && !pipeline->HS) || (d.DS && !pipeline->DS) || (d.GS && !pipeline->GS) || (d.PS && !pipeline->PS))
+        {
+            signalError(__FILE__, __LINE__, "Shader type doesn't match the pipeline stage it is used for");
+            delete pipeline;
+            return NULL;
+        }
+
+        // Get cached states or create new ones
+        pipeline->rasterizerState = getRasterizerState(d.rasterState);
+        pipeline->blendState = getBlendState(d.blendState);
+        pipeline->depthStencilState = getDepthStencilState(d.depthStencilState);
+
+        pipeline->blendFactor[0] = d.blendState.blendFactor.r;
+        pipeline->blendFactor[1] = d.blendState.blendFactor.g;
+        pipeline->blendFactor[2] = d.blendState.blendFactor.b;
+        pipeline->blendFactor[3] = d.blendState.blendFactor.a;
+
+        return pipeline;
+    }
+
+    void RendererInterfaceD3D11::destroyGraphicsPipeline(GraphicsPipelineHandle p)
+    {
+        if (!p)
+            return;
+        delete p;
+    }
+
+    ComputePipelineHandle RendererInterfaceD3D11::createComputePipeline(const ComputePipelineDesc& d)
+    {
+        ComputePipeline* pipeline = new ComputePipeline();
+        pipeline->desc = d;
+
+        if (d.CS)
+            ((ID3D11DeviceChild*)d.CS)->QueryInterface<ID3D11ComputeShader>(&pipeline->CS);
+
+        if (!pipeline->CS)
+        {
+            signalError(__FILE__, __LINE__, "A compute pipeline requires a compute shader");
+            delete pipeline;
+            return NULL;
+        }
+
+        return pipeline;
+    }
+
+    void RendererInterfaceD3D11::destroyComputePipeline(ComputePipelineHandle p)
+    {
+        if (!p)
+            return;
+        delete p;
+    }
+
+    BindingSetHandle RendererInterfaceD3D11::createBindingSet(const BindingSetDesc& d)
+    {
+        BindingSet* bindingSet = new BindingSet();
+
+        const PipelineStageBindings* graphicsStages[ShaderType::GRAPHIC_SHADERS_NUM] = { &d.VS, &d.HS, &d.DS, &d.GS, &d.PS };
+
+        for (uint32_t stage = 0; stage < ShaderType::GRAPHIC_SHADERS_NUM; stage++)
+        {
+            if (graphicsStages[stage]->shader)
+                bakeStageBindings(*graphicsStages[stage], bindingSet->graphicsStages[stage]);
+        }
+
+        if (d.CS.shader)
+            bakeStageBindings(d.CS, bindingSet->CS);
+
+        return bindingSet;
+    }
+
+    void RendererInterfaceD3D11::destroyBindingSet(BindingSetHandle b)
+    {
+        if (!b)
+            return;
+        delete b;
+    }
+
+    void RendererInterfaceD3D11::bakeStageBindings(const PipelineStageBindings& bindings, StageResourceBindings& resources)
+    {
+        ID3D11ShaderResourceView* shaderResourceViews[D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT] = { 0 };
+        UINT minSRV = D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT, maxSRV = 0;
+
+        ID3D11UnorderedAccessView* unorderedAccessViews[D3D11_PS_CS_UAV_REGISTER_COUNT] = { 0 };
+        UINT minUAV = D3D11_PS_CS_UAV_REGISTER_COUNT, maxUAV = 0;
+
+        ID3D11Buffer* constantBuffers[D3D11_COMMONSHADER_CONSTANT_BUFFER_REGISTER_COUNT] = { 0 };
+        UINT minCB = D3D11_COMMONSHADER_CONSTANT_BUFFER_REGISTER_COUNT, maxCB = 0;
+
+        ID3D11SamplerState* samplers[D3D11_COMMONSHADER_SAMPLER_REGISTER_COUNT] = { 0 };
+        UINT minSS = D3D11_COMMONSHADER_SAMPLER_REGISTER_COUNT, maxSS = 0;
+
+        bool uavsAllowed = bindings.stage == ShaderType::SHADER_PIXEL || bindings.stage == ShaderType::SHADER_COMPUTE;
+
+        //Bind textures
+        for (uint32_t i = 0; i < bindings.textureBindingCount; i++)
+        {
+            DXGI_FORMAT textureFormat = DXGI_FORMAT_UNKNOWN;
+            UINT dontCareSize;
+            UINT slot = (UINT)bindings.textures[i].slot;
+            TextureObjectMap::value_type* resource = (TextureObjectMap::value_type*)bindings.textures[i].texture;
+            switch (bindings.textures[i].format)
+            {
+            case Format::R8_UNORM:  textureFormat = DXGI_FORMAT_R8_UNORM; break;
+            case Format::R32_UINT:  textureFormat = DXGI_FORMAT_R32_UINT; break;
+            case Format::R32_FLOAT:  textureFormat = DXGI_FORMAT_R32_FLOAT; break;
+            case Format::RGBA8_UNORM:  textureFormat = DXGI_FORMAT_R8G8B8A8_UNORM; break;
+            case Format::BGRA8_UNORM:  textureFormat = DXGI_FORMAT_B8G8R8A8_UNORM; break;
+            case Format::RGBA16_FLOAT:  textureFormat = DXGI_FORMAT_R16G16B16A16_FLOAT; break;
+            case Format::X24G8_UINT:  textureFormat = DXGI_FORMAT_X24_TYPELESS_G8_UINT; break;
+            case Format::UNKNOWN:  textureFormat = getTypedTextureFormat(resource->second.textureDesc.format, dontCareSize, true); break;
+            default:
+                CHECK_ERROR(0, "Unknown format");
+            }
+
+            //choose a SRV or UAV
+            if (bindings.textures[i].isWritable)
+            {
+                CHECK_ERROR(uavsAllowed, "UAVs only supported in pixel and compute shaders");
+                unorderedAccessViews[slot] = getUAVForTexture(resource, textureFormat, bindings.textures[i].mipLevel);
+                minUAV = std::min(slot, minUAV);
+                maxUAV = std::max(slot, maxUAV);
+            }
+            else
+            {
+                shaderResourceViews[slot] = getSRVForTexture(resource, textureFormat, bindings.textures[i].mipLevel);
+                minSRV = std::min(slot, minSRV);
+                maxSRV = std::max(slot, maxSRV);
+            }
+        }
+
+        //Bind samplers
+        for (uint32_t i = 0; i < bindings.textureSamplerBindingCount; i++)
+        {
+            UINT slot = (UINT)bindings.textureSamplers[i].slot;
+            ID3D11SamplerState* sampler = (ID3D11SamplerState*)bindings.textureSamplers[i].sampler;
+
+            samplers[slot] = sampler;
+            minSS = std::min(slot, minSS);
+            maxSS = std::max(slot, maxSS);
+        }
+
+        //Bind buffers
+        for (uint32_t i = 0; i < bindings.bufferBindingCount; i++)
+        {
+            UINT slot = (UINT)bindings.buffers[i].slot;
+            BufferObjectMap::value_type* resource = (BufferObjectMap::value_type*)bindings.buffers[i].buffer;
+            //choose a SRV or UAV
+            if (bindings.buffers[i].isWritable)
+            {
+                CHECK_ERROR(uavsAllowed, "UAVs only supported in pixel and compute shaders");
+                unorderedAccessViews[slot] = getUAVForBuffer(resource);
+                minUAV = std::min(slot, minUAV);
+                maxUAV = std::max(slot, maxUAV);
+            }
+            else
+            {
+                shaderResourceViews[slot] = getSRVForBuffer(resource, bindings.buffers[i].format);
+                minSRV = std::min(slot, minSRV);
+                maxSRV = std::max(slot, maxSRV);
+            }
+        }
+
+        //bind Constant buffers
+        for (uint32_t i = 0; i < bindings.constantBufferBindingCount; i++)
+        {
+            UINT slot = (UINT)bindings.constantBuffers[i].slot;
+            ID3D11Buffer* cbuffer = (ID3D11Buffer*)bindings.constantBuffers[i].buffer;
+
+            constantBuffers[slot] = cbuffer;
+            minCB = std::min(slot, minCB);
+            maxCB = std::max(slot, maxCB);
+        }
+
+        //Store only the used ranges
+        resources.shader = bindings.shader;
+
+        if (maxSRV >= minSRV)
+        {
+            resources.minSRV = minSRV;
+            resources.shaderResourceViews.assign(shaderResourceViews + minSRV, shaderResourceViews + maxSRV + 1);
+        }
+
+        if (maxUAV >= minUAV)
+        {
+            resources.minUAV = minUAV;
+            resources.unorderedAccessViews.assign(unorderedAccessViews + minUAV, unorderedAccessViews + maxUAV + 1);
+        }
+
+        if (maxCB >= minCB)
+        {
+            resources.minCB = minCB;
+            resources.constantBuffers.assign(constantBuffers + minCB, constantBuffers + maxCB + 1);
+        }
+
+        if (maxSS >= minSS)
+        {
+            resources.minSS = minSS;
+            resources.samplers.assign(samplers + minSS, samplers + maxSS + 1);
+        }
+    }
+
+    GraphicsAPI::Enum RendererInterfaceD3D11::getGraphicsAPI()
+    {
+        return GraphicsAPI::D3D11;
+    }
+
+    void* RendererInterfaceD3D11::getAPISpecificInterface(APISpecificInterface::Enum interfaceType)
+    {
+        if (interfaceType == APISpecificInterface::D3D11DEVICECONTEXT)
+        {
+            //we only support this interface type
+            ID3D11DeviceContext* d3d11Context = context.Get();
+            return d3d11Context;
+        }
+        else  if (interfaceType == APISpecificInterface::D3D11DEVICE)
+        {
+            //we only support this interface type
+            ID3D11Device* d3d11Device = device.Get();
+            return d3d11Device;
+        }
+        return NULL;
+    }
+
+    void RendererInterfaceD3D11::draw(const DrawCallState& state, const DrawArguments* args, uint32_t numDrawCalls)
+    {
+        clearState();
+        applyState(state);
+
+        for (uint32_t i = 0; i < numDrawCalls; i++)
+            context->DrawInstanced(args[i].vertexCount, args[i].instanceCount, args[i].startVertexLocation, args[i].startInstanceLocation);
+
+        clearState();
+    }
+        
+    void RendererInterfaceD3D11::drawIndexed(const DrawCallState& state, const DrawArguments* args, uint32_t numDrawCalls)
+    {
+        clearState();
+        applyState(state);
+
+        for (uint32_t i = 0; i < numDrawCalls; i++)
+            context->DrawIndexedInstanced(args[i].vertexCount, args[i].instanceCount, args[i].startIndexLocation, args[i].startVertexLocation, args[i].startInstanceLocation);
+
+        clearState();
+    }
+
+    void RendererInterfaceD3D11::drawIndirect(const DrawCallState& state, BufferHandle indirectParams, uint32_t offsetBytes)
+    {
+        clearState();
+        applyState(state);
+
+        BufferObjectMap::value_type* handle = (BufferObjectMap::value_type*)indirectParams;
+        context->DrawInstancedIndirect(handle->first.Get(), offsetBytes);
+
+        clearState();
+    }
+
+    void RendererInterfaceD3D11::drawCompact(const CompactDrawCallState& state, const DrawArguments* args, uint32_t numDrawCalls)
+    {
+        clearState();
+        applyState(state);
+
+        for (uint32_t i = 0; i < numDrawCalls; i++)
+            context->DrawInstanced(args[i].vertexCount, args[i].instanceCount, args[i].startVertexLocation, args[i].startInstanceLocation);
+
+        clearState();
+    }
+
+    void RendererInterfaceD3D11::drawIndexedCompact(const CompactDrawCallState& state, const DrawArguments* args, uint32_t numDrawCalls)
+    {
+        clearState();
+        applyState(state);
+
+        for (uint32_t i = 0; i < numDrawCalls; i++)
+            context->DrawIndexedInstanced(args[i].vertexCount, args[i].instanceCount, args[i].startIndexLocation, args[i].startVertexLocation, args[i].startInstanceLocation);
+
+        clearState();
+    }
+
+    void RendererInterfaceD3D11::drawIndirectCompact(const CompactDrawCallState& state, BufferHandle indirectParams, uint32_t offsetBytes)
+    {
+        clearState();
+        applyState(state);
+
+        BufferObjectMap::value_type* handle = (BufferObjectMap::value_type*)indirectParams;
+        context->DrawInstancedIndirect(handle->first.Get(), offsetBytes);
+
+        clearState();
+    }
+
+    void RendererInterfaceD3D11::drawIndexedIndirect(const DrawCallState& state, BufferHandle indirectParams, uint32_t offsetBytes)
+    {
+        multiDrawIndexedIndirect(state, indirectParams, offsetBytes, 0, 1, NULL, 0);
+    }
+
+    void RendererInterfaceD3D11::multiDrawIndirect(const DrawCallState& state, BufferHandle argsBuffer, uint32_t argsOffsetBytes, uint32_t argsStrideBytes, uint32_t maxDrawCount, BufferHandle countBuffer, uint32_t countOffsetBytes)
+    {
+        clearState();
+        applyState(state);
+
+        issueMultiDrawIndirect(false, 0, argsBuffer, argsOffsetBytes, argsStrideBytes, maxDrawCount, countBuffer, countOffsetBytes);
+
+        clearState();
+    }
+
+    void RendererInterfaceD3D11::multiDrawIndexedIndirect(const DrawCallState& state, BufferHandle argsBuffer, uint32_t argsOffsetBytes, uint32_t argsStrideBytes, uint32_t maxDrawCount, BufferHandle countBuffer, uint32_t countOffsetBytes)
+    {
+        clearState();
+        applyState(state);
+
+        issueMultiDrawIndirect(true, state.indexBufferOffset, argsBuffer, argsOffsetBytes, argsStrideBytes, maxDrawCount, countBuffer, countOffsetBytes);
+
+        clearState();
+    }
+
+    void RendererInterfaceD3D11::drawIndexedIndirectCompact(const CompactDrawCallState& state, BufferHandle indirectParams, uint32_t offsetBytes)
+    {
+        multiDrawIndexedIndirectCompact(state, indirectParams, offsetBytes, 0, 1, NULL, 0);
+    }
+
+    void RendererInterfaceD3D11::multiDrawIndirectCompact(const CompactDrawCallState& state, BufferHandle argsBuffer, uint32_t argsOffsetBytes, uint32_t argsStrideBytes, uint32_t maxDrawCount, BufferHandle countBuffer, uint32_t countOffsetBytes)
+    {
+        clearState();
+        applyState(state);
+
+        issueMultiDrawIndirect(false, 0, argsBuffer, argsOffsetBytes, argsStrideBytes, maxDrawCount, countBuffer, countOffsetBytes);
+
+        clearState();
+    }
+
+    void RendererInterfaceD3D11::multiDrawIndexedIndirectCompact(const CompactDrawCallState& state, BufferHandle argsBuffer, uint32_t argsOffsetBytes, uint32_t argsStrideBytes, uint32_t maxDrawCount, BufferHandle countBuffer, uint32_t countOffsetBytes)
+    {
+        clearState();
+        applyState(state);
+
+        issueMultiDrawIndirect(true, state.indexBufferOffset, argsBuffer, argsOffsetBytes, argsStrideBytes, maxDrawCount, countBuffer, countOffsetBytes);
+
+        clearState();
+    }
+
+    void RendererInterfaceD3D11::issueMultiDrawIndirect(bool indexed, uint32_t indexBufferOffset, BufferHandle argsBuffer, uint32_t argsOffsetBytes, uint32_t argsStrideBytes, uint32_t maxDrawCount, BufferHandle countBuffer, uint32_t countOffsetBytes)
+    {
+        UINT recordSize = indexed ? sizeof(DrawIndexedIndirectArguments) : sizeof(DrawIndirectArguments);
+        UINT stride = argsStrideBytes ? argsStrideBytes : recordSize;
+
+        BufferObjectMap::value_type* handle = (BufferObjectMap::value_type*)argsBuffer;
+        if (!handle || (stride & 3) != 0 || stride < recordSize)
+        {
+            signalError(__FILE__, __LINE__, "Invalid indirect draw arguments");
+            return;
+        }
+
+        //the GL backend can't apply the offset to indirect draws, so it's rejected everywhere to keep the backends interchangeable
+        if (indexed && indexBufferOffset != 0)
         {
-            desc11.Filter = D3D11_ENCODE_ANISOTROPIC_FILTER(d.shadowCompare ? D3D11_FILTER_REDUCTION_TYPE_COMPARISON : D3D11_FILTER_REDUCTION_TYPE_STANDARD);
+            signalError(__FILE__, __LINE__, "Indirect indexed draws do not support a nonzero indexBufferOffset");
+            return;
         }
-        else
+
+        //D3D11 has no way to source the draw count from GPU memory without a CPU readback
+        (void)countOffsetBytes;
+        if (countBuffer)
         {
-            desc11.Filter = D3D11_ENCODE_BASIC_FILTER(d.minFilter ? D3D11_FILTER_TYPE_LINEAR : D3D11_FILTER_TYPE_POINT, d.magFilter ? D3D11_FILTER_TYPE_LINEAR : D3D11_FILTER_TYPE_POINT, d.mipFilter ? D3D11_FILTER_TYPE_LINEAR : D3D11_FILTER_TYPE_POINT, d.shadowCompare ? D3D11_FILTER_REDUCTION_TYPE_COMPARISON : D3D11_FILTER_REDUCTION_TYPE_STANDARD);
+            signalError(__FILE__, __LINE__, "Indirect draws with a count buffer are not supported on D3D11");
+            return;
         }
-        D3D11_TEXTURE_ADDRESS_MODE* dest[] = { &desc11.AddressU, &desc11.AddressV, &desc11.AddressW };
-        for (int i = 0; i < 3; i++)
+
+        for (uint32_t i = 0; i < maxDrawCount; i++)
         {
-            switch (d.wrapMode[i])
-            {
-            case SamplerDesc::WRAP_MODE_BORDER:
-                *dest[i] = D3D11_TEXTURE_ADDRESS_BORDER;
-                break;
-            case SamplerDesc::WRAP_MODE_CLAMP:
-                *dest[i] = D3D11_TEXTURE_ADDRESS_CLAMP;
-                break;
-            case SamplerDesc::WRAP_MODE_WRAP:
-                *dest[i] = D3D11_TEXTURE_ADDRESS_WRAP;
-                break;
-            }
+            UINT offset = argsOffsetBytes + i * stride;
+
+            if (indexed)
+                context->DrawIndexedInstancedIndirect(handle->first.Get(), offset);
+            else
+                context->DrawInstancedIndirect(handle->first.Get(), offset);
         }
+    }
 
-        desc11.MipLODBias = d.mipBias;
-        desc11.MaxAnisotropy = std::max((UINT)d.anisotropy, 1U);
-        desc11.ComparisonFunc = D3D11_COMPARISON_LESS;
-        desc11.BorderColor[0] = d.borderColor.r;
-        desc11.BorderColor[1] = d.borderColor.g;
-        desc11.BorderColor[2] = d.borderColor.b;
-        desc11.BorderColor[3] = d.borderColor.a;
-        desc11.MinLOD = 0;
-        desc11.MaxLOD = D3D11_FLOAT32_MAX;
+    void RendererInterfaceD3D11::dispatch(const DispatchState& state, uint32_t groupsX, uint32_t groupsY, uint32_t groupsZ)
+    {
+        clearState();
+        applyState(state);
 
-        ID3D11SamplerState* sState = NULL;
-        CHECK_ERROR(SUCCEEDED(device->CreateSamplerState(&desc11, &sState)), "Creating sampler state failed");
+        context->Dispatch(groupsX, groupsY, groupsZ);
 
-        return (SamplerHandle)sState;
+        clearState();
     }
 
-    void RendererInterfaceD3D11::destroySampler(SamplerHandle s)
+    void RendererInterfaceD3D11::dispatchIndirect(const DispatchState& state, BufferHandle indirectParams, uint32_t offsetBytes)
     {
-        ID3D11SamplerState* sState = (ID3D11SamplerState*)s;
-        if (!sState)
-            return;
-        sState->Release();
+        clearState();
+        applyState(state);
+
+        BufferObjectMap::value_type* handleArgs = (BufferObjectMap::value_type*)indirectParams;
+        context->DispatchIndirect(handleArgs->first.Get(), (UINT)offsetBytes);
+
+        clearState();
     }
-        
-    InputLayoutHandle RendererInterfaceD3D11::createInputLayout(const VertexAttributeDesc* d, uint32_t attributeCount, const void* vertexShaderBinary, const size_t binarySize)
+
+    bool RendererInterfaceD3D11::validateGraphicsState(const GraphicsState& state)
     {
-        uint32_t dontCare;
-        D3D11_INPUT_ELEMENT_DESC elementDesc[DrawCallState::MAX_VERTEX_ATTRIBUTE_COUNT];
-        for (uint32_t i = 0; i < attributeCount; i++)
+        if (!state.pipeline)
         {
-            elementDesc[i].SemanticName = d[i].name;
-            elementDesc[i].SemanticIndex = 0;
-            elementDesc[i].Format = getTypedTextureFormat(d[i].format, dontCare, false);
-            elementDesc[i].InputSlot = d[i].bufferIndex;
-            elementDesc[i].AlignedByteOffset = d[i].offset;
-            elementDesc[i].InputSlotClass = d[i].isInstanced ? D3D11_INPUT_PER_INSTANCE_DATA : D3D11_INPUT_PER_VERTEX_DATA;
-            elementDesc[i].InstanceDataStepRate = d[i].isInstanced ? 1 : 0;
+            signalError(__FILE__, __LINE__, "No pipeline specified in GraphicsState");
+            return false;
         }
 
-        ID3D11InputLayout* inputLayout = NULL;
-        CHECK_ERROR(SUCCEEDED(device->CreateInputLayout(elementDesc, attributeCount, vertexShaderBinary, binarySize, &inputLayout)), "CreateInputLayout() failed");
+        const GraphicsPipelineDesc& desc = state.pipeline->desc;
 
-        return (InputLayoutHandle)inputLayout;
-    }
+        if (state.bindings)
+        {
+            const ShaderHandle pipelineShaders[ShaderType::GRAPHIC_SHADERS_NUM] = { desc.VS, desc.HS, desc.DS, desc.GS, desc.PS };
 
-    void RendererInterfaceD3D11::destroyInputLayout(InputLayoutHandle i)
-    {
-        ID3D11InputLayout* inputLayout = (ID3D11InputLayout*)i;
-        if (!inputLayout)
-            return;
-        inputLayout->Release();
-    }
+            for (uint32_t stage = 0; stage < ShaderType::GRAPHIC_SHADERS_NUM; stage++)
+            {
+                ShaderHandle shader = state.bindings->graphicsStages[stage].shader;
 
-    GraphicsAPI::Enum RendererInterfaceD3D11::getGraphicsAPI()
-    {
-        return GraphicsAPI::D3D11;
+                if (shader && shader != pipelineShaders[stage])
+                {
+                    signalError(__FILE__, __LINE__, "Binding set was created for a different shader than the one used by the pipeline");
+                    return false;
+                }
+            }
+        }
+
+        if (state.targetCount != desc.renderTargetCount)
+        {
+            signalError(__FILE__, __LINE__, "Number of bound render targets doesn't match the pipeline");
+            return false;
+        }
+
+        return true;
     }
 
-    void* RendererInterfaceD3D11::getAPISpecificInterface(APISpecificInterface::Enum interfaceType)
+    bool RendererInterfaceD3D11::validateComputeState(const ComputeState& state)
     {
-        if (interfaceType == APISpecificInterface::D3D11DEVICECONTEXT)
+        if (!state.pipeline)
         {
-            //we only support this interface type
-            ID3D11DeviceContext* d3d11Context = context.Get();
-            return d3d11Context;
+            signalError(__FILE__, __LINE__, "No pipeline specified in ComputeState");
+            return false;
         }
-        else  if (interfaceType == APISpecificInterface::D3D11DEVICE)
+
+        if (state.bindings && state.bindings->CS.shader && state.bindings->CS.shader != state.pipeline->desc.CS)
         {
-            //we only support this interface type
-            ID3D11Device* d3d11Device = device.Get();
-            return d3d11Device;
+            signalError(__FILE__, __LINE__, "Binding set was created for a different shader than the one used by the pipeline");
+            return false;
         }
-        return NULL;
+
+        return true;
     }
 
-    void RendererInterfaceD3D11::draw(const DrawCallState& state, const DrawArguments* args, uint32_t numDrawCalls)
+    void RendererInterfaceD3D11::drawWithPipeline(const GraphicsState& state, const DrawArguments* args, uint32_t numDrawCalls)
     {
+        if (!validateGraphicsState(state))
+            return;
+
         clearState();
         applyState(state);
 
@@ -973,9 +2160,12 @@ namespace NVRHI
 
         clearState();
     }
-        
-    void RendererInterfaceD3D11::drawIndexed(const DrawCallState& state, const DrawArguments* args, uint32_t numDrawCalls)
+
+    void RendererInterfaceD3D11::drawIndexedWithPipeline(const GraphicsState& state, const DrawArguments* args, uint32_t numDrawCalls)
     {
+        if (!validateGraphicsState(state))
+            return;
+
         clearState();
         applyState(state);
 
@@ -985,8 +2175,11 @@ namespace NVRHI
         clearState();
     }
 
-    void RendererInterfaceD3D11::drawIndirect(const DrawCallState& state, BufferHandle indirectParams, uint32_t offsetBytes)
+    void RendererInterfaceD3D11::drawIndirectWithPipeline(const GraphicsState& state, BufferHandle indirectParams, uint32_t offsetBytes)
     {
+        if (!validateGraphicsState(state))
+            return;
+
         clearState();
         applyState(state);
 
@@ -996,8 +2189,42 @@ namespace NVRHI
         clearState();
     }
 
-    void RendererInterfaceD3D11::dispatch(const DispatchState& state, uint32_t groupsX, uint32_t groupsY, uint32_t groupsZ)
+    void RendererInterfaceD3D11::drawIndexedIndirectWithPipeline(const GraphicsState& state, BufferHandle indirectParams, uint32_t offsetBytes)
+    {
+        multiDrawIndexedIndirectWithPipeline(state, indirectParams, offsetBytes, 0, 1, NULL, 0);
+    }
+
+    void RendererInterfaceD3D11::multiDrawIndirectWithPipeline(const GraphicsState& state, BufferHandle argsBuffer, uint32_t argsOffsetBytes, uint32_t argsStrideBytes, uint32_t maxDrawCount, BufferHandle countBuffer, uint32_t countOffsetBytes)
+    {
+        if (!validateGraphicsState(state))
+            return;
+
+        clearState();
+        applyState(state);
+
+        issueMultiDrawIndirect(false, 0, argsBuffer, argsOffsetBytes, argsStrideBytes, maxDrawCount, countBuffer, countOffsetBytes);
+
+        clearState();
+    }
+
+    void RendererInterfaceD3D11::multiDrawIndexedIndirectWithPipeline(const GraphicsState& state, BufferHandle argsBuffer, uint32_t argsOffsetBytes, uint32_t argsStrideBytes, uint32_t maxDrawCount, BufferHandle countBuffer, uint32_t countOffsetBytes)
+    {
+        if (!validateGraphicsState(state))
+            return;
+
+        clearState();
+        applyState(state);
+
+        issueMultiDrawIndirect(true, state.indexBufferOffset, argsBuffer, argsOffsetBytes, argsStrideBytes, maxDrawCount, countBuffer, countOffsetBytes);
+
+        clearState();
+    }
+
+    void RendererInterfaceD3D11::dispatchWithPipeline(const ComputeState& state, uint32_t groupsX, uint32_t groupsY, uint32_t groupsZ)
     {
+        if (!validateComputeState(state))
+            return;
+
         clearState();
         applyState(state);
 
@@ -1006,8 +2233,11 @@ namespace NVRHI
         clearState();
     }
 
-    void RendererInterfaceD3D11::dispatchIndirect(const DispatchState& state, BufferHandle indirectParams, uint32_t offsetBytes)
+    void RendererInterfaceD3D11::dispatchIndirectWithPipeline(const ComputeState& state, BufferHandle indirectParams, uint32_t offsetBytes)
     {
+        if (!validateComputeState(state))
+            return;
+
         clearState();
         applyState(state);
 
@@ -1048,17 +2278,7 @@ namespace NVRHI
         //Try UAVs first since they are more flexible
         if (textureDesc.isUAV)
         {
-            DXGI_FORMAT format;
-
-            if (asUINT)
-                format = DXGI_FORMAT_R32_UINT;
-            else
-                if (textureDesc.format == Format::RGBA16_FLOAT)
-                    format = DXGI_FORMAT_R16G16B16A16_FLOAT;
-                else if (textureDesc.format == Format::R8_UNORM)
-                    format = DXGI_FORMAT_R8_UNORM;
-                else
-                    format = DXGI_FORMAT_R32_FLOAT;
+            DXGI_FORMAT format = getClearUAVFormat(textureDesc, asUINT);
 
             //we have UAVs;
             if (index < textureDesc.mipLevels)
@@ -1340,6 +2560,19 @@ namespace NVRHI
 
     void RendererInterfaceD3D11::applyState(const DrawCallState& state, uint32_t denyStageMask)
     {
+        applyDrawCallState(state, denyStageMask);
+    }
+
+    void RendererInterfaceD3D11::applyState(const CompactDrawCallState& state, uint32_t denyStageMask)
+    {
+        applyDrawCallState(state, denyStageMask);
+    }
+
+    template<typename TDrawCallState>
+    void RendererInterfaceD3D11::applyDrawCallState(const TDrawCallState& state, uint32_t denyStageMask)
+    {
+        typedef decltype(state.VS) StageBindings;
+
         ID3D11RenderTargetView* renderTargetViews[D3D11_PS_OUTPUT_REGISTER_COUNT] = { 0 };
         UINT rtvCount = 0;
         ID3D11DepthStencilView* depthView = NULL;
@@ -1437,7 +2670,7 @@ namespace NVRHI
             if (denyStageMask & (0x1 << stage))
                 continue; // ignore stage
 
-            const PipelineStageBindings* bindings = NULL;
+            const StageBindings* bindings = NULL;
 
             switch (stage)
             {
@@ -1802,6 +3035,156 @@ namespace NVRHI
             context->CSSetUnorderedAccessViews(minUAV, maxUAV - minUAV + 1, unorderedAccessViews + minUAV, uavCountersUnused);
     }
 
+    void RendererInterfaceD3D11::applyState(const GraphicsState& state)
+    {
+        const GraphicsPipeline* pipeline = state.pipeline;
+
+        context->IASetPrimitiveTopology(pipeline->primitiveTopology);
+        context->IASetInputLayout(pipeline->inputLayout);
+
+        if (state.indexBuffer)
+        {
+            BufferObjectMap::value_type* handle = (BufferObjectMap::value_type*)state.indexBuffer;
+            UINT dontCare = 0;
+            context->IASetIndexBuffer(handle->first.Get(), getTypedTextureFormat(state.indexBufferFormat, dontCare, true), state.indexBufferOffset);
+        }
+
+        for (uint32_t i = 0; i < state.vertexBufferCount; i++)
+        {
+            BufferObjectMap::value_type* handle = (BufferObjectMap::value_type*)state.vertexBuffers[i].buffer;
+            if (!handle)
+                return;
+
+            ID3D11Buffer* pBuffer = (ID3D11Buffer*)handle->first.Get();
+            context->IASetVertexBuffers(state.vertexBuffers[i].slot, 1, &pBuffer, &state.vertexBuffers[i].stride, &state.vertexBuffers[i].offset);
+        }
+
+        ID3D11RenderTargetView* renderTargetViews[D3D11_PS_OUTPUT_REGISTER_COUNT] = { 0 };
+        ID3D11DepthStencilView* depthView = NULL;
+
+        for (uint32_t rt = 0; rt < state.targetCount; rt++)
+            renderTargetViews[rt] = getRTVForTexture((TextureObjectMap::value_type*)state.targets[rt], state.targetIndicies[rt], state.targetMipSlices[rt]);
+
+        if (state.depthTarget)
+            depthView = getDSVForTexture((TextureObjectMap::value_type*)state.depthTarget, state.depthIndex, state.depthMipSlice);
+
+        D3D11_VIEWPORT viewports[D3D11_VIEWPORT_AND_SCISSORRECT_MAX_INDEX] = { 0 };
+        D3D11_RECT scissorRects[D3D11_VIEWPORT_AND_SCISSORRECT_MAX_INDEX] = { 0 };
+
+        for (uint32_t rt = 0; rt < state.viewportCount; rt++)
+        {
+            viewports[rt].TopLeftX = state.viewports[rt].minX;
+            viewports[rt].TopLeftY = state.viewports[rt].minY;
+            viewports[rt].Width = state.viewports[rt].maxX - state.viewports[rt].minX;
+            viewports[rt].Height = state.viewports[rt].maxY - state.viewports[rt].minY;
+            viewports[rt].MinDepth = state.viewports[rt].minZ;
+            viewports[rt].MaxDepth = state.viewports[rt].maxZ;
+
+            scissorRects[rt].left = (LONG)state.scissorRects[rt].minX;
+            scissorRects[rt].top = (LONG)state.scissorRects[rt].minY;
+            scissorRects[rt].right = (LONG)state.scissorRects[rt].maxX;
+            scissorRects[rt].bottom = (LONG)state.scissorRects[rt].maxY;
+        }
+
+        context->RSSetViewports((UINT)state.viewportCount, viewports);
+        context->RSSetScissorRects((UINT)state.viewportCount, scissorRects);
+
+        //The states were resolved when the pipeline was created
+        context->RSSetState(pipeline->rasterizerState.Get());
+        context->OMSetBlendState(pipeline->blendState.Get(), pipeline->blendFactor, D3D11_DEFAULT_SAMPLE_MASK);
+        context->OMSetDepthStencilState(pipeline->depthStencilState.Get(), (UINT)pipeline->desc.depthStencilState.stencilRefValue);
+
+        context->VSSetShader(pipeline->VS.Get(), NULL, 0);
+        context->HSSetShader(pipeline->HS.Get(), NULL, 0);
+        context->DSSetShader(pipeline->DS.Get(), NULL, 0);
+        context->GSSetShader(pipeline->GS.Get(), NULL, 0);
+        context->PSSetShader(pipeline->PS.Get(), NULL, 0);
+
+        const StageResourceBindings* pixelResources = NULL;
+
+        if (state.bindings)
+        {
+            for (uint32_t stage = 0; stage < ShaderType::GRAPHIC_SHADERS_NUM; stage++)
+            {
+                const StageResourceBindings& resources = state.bindings->graphicsStages[stage];
+
+                UINT numCB = (UINT)resources.constantBuffers.size();
+                UINT numSRV = (UINT)resources.shaderResourceViews.size();
+                UINT numSS = (UINT)resources.samplers.size();
+                ID3D11Buffer* const* constantBuffers = numCB ? &resources.constantBuffers[0] : NULL;
+                ID3D11ShaderResourceView* const* shaderResourceViews = numSRV ? &resources.shaderResourceViews[0] : NULL;
+                ID3D11SamplerState* const* samplers = numSS ? &resources.samplers[0] : NULL;
+
+                switch (stage)
+                {
+                case ShaderType::SHADER_VERTEX:
+                    if (numCB) context->VSSetConstantBuffers(resources.minCB, numCB, constantBuffers);
+                    if (numSRV) context->VSSetShaderResources(resources.minSRV, numSRV, shaderResourceViews);
+                    if (numSS) context->VSSetSamplers(resources.minSS, numSS, samplers);
+                    break;
+                case ShaderType::SHADER_HULL:
+                    if (numCB) context->HSSetConstantBuffers(resources.minCB, numCB, constantBuffers);
+                    if (numSRV) context->HSSetShaderResources(resources.minSRV, numSRV, shaderResourceViews);
+                    if (numSS) context->HSSetSamplers(resources.minSS, numSS, samplers);
+                    break;
+                case ShaderType::SHADER_DOMAIN:
+                    if (numCB) context->DSSetConstantBuffers(resources.minCB, numCB, constantBuffers);
+                    if (numSRV) context->DSSetShaderResources(resources.minSRV, numSRV, shaderResourceViews);
+                    if (numSS) context->DSSetSamplers(resources.minSS, numSS, samplers);
+                    break;
+                case ShaderType::SHADER_GEOMETRY:
+                    if (numCB) context->GSSetConstantBuffers(resources.minCB, numCB, constantBuffers);
+                    if (numSRV) context->GSSetShaderResources(resources.minSRV, numSRV, shaderResourceViews);
+                    if (numSS) context->GSSetSamplers(resources.minSS, numSS, samplers);
+                    break;
+                case ShaderType::SHADER_PIXEL:
+                    if (numCB) context->PSSetConstantBuffers(resources.minCB, numCB, constantBuffers);
+                    if (numSRV) context->PSSetShaderResources(resources.minSRV, numSRV, shaderResourceViews);
+                    if (numSS) context->PSSetSamplers(resources.minSS, numSS, samplers);
+                    pixelResources = &resources;
+                    break;
+                }
+            }
+        }
+
+        if (pixelResources && !pixelResources->unorderedAccessViews.empty())
+        {
+            UINT uavCountersUnused[D3D11_PS_CS_UAV_REGISTER_COUNT] = { D3D11_KEEP_UNORDERED_ACCESS_VIEWS };
+
+            context->OMSetRenderTargetsAndUnorderedAccessViews(state.targetCount, renderTargetViews, depthView,
+                pixelResources->minUAV, (UINT)pixelResources->unorderedAccessViews.size(), &pixelResources->unorderedAccessViews[0], uavCountersUnused);
+        }
+        else
+        {
+            context->OMSetRenderTargets(state.targetCount, renderTargetViews, depthView);
+        }
+    }
+
+    void RendererInterfaceD3D11::applyState(const ComputeState& state)
+    {
+        context->CSSetShader(state.pipeline->CS.Get(), NULL, 0);
+
+        if (!state.bindings)
+            return;
+
+        const StageResourceBindings& resources = state.bindings->CS;
+
+        if (!resources.constantBuffers.empty())
+            context->CSSetConstantBuffers(resources.minCB, (UINT)resources.constantBuffers.size(), &resources.constantBuffers[0]);
+
+        if (!resources.shaderResourceViews.empty())
+            context->CSSetShaderResources(resources.minSRV, (UINT)resources.shaderResourceViews.size(), &resources.shaderResourceViews[0]);
+
+        if (!resources.samplers.empty())
+            context->CSSetSamplers(resources.minSS, (UINT)resources.samplers.size(), &resources.samplers[0]);
+
+        if (!resources.unorderedAccessViews.empty())
+        {
+            UINT uavCountersUnused[D3D11_PS_CS_UAV_REGISTER_COUNT] = { D3D11_KEEP_UNORDERED_ACCESS_VIEWS };
+            context->CSSetUnorderedAccessViews(resources.minUAV, (UINT)resources.unorderedAccessViews.size(), &resources.unorderedAccessViews[0], uavCountersUnused);
+        }
+    }
+
     void RendererInterfaceD3D11::clearState()
     {
         //
@@ -2055,14 +3438,29 @@ namespace NVRHI
         textures.clear();
         buffers.clear();
 
-        rasterizerStates.clear();
-        blendStates.clear();
-        depthStencilStates.clear();
+        std::vector<ComPtr<ID3D11RasterizerState>> releasedRasterizerStates;
+        std::vector<ComPtr<ID3D11BlendState>> releasedBlendStates;
+        std::vector<ComPtr<ID3D11DepthStencilState>> releasedDepthStencilStates;
+        rasterizerStates.Clear(releasedRasterizerStates);
+        blendStates.Clear(releasedBlendStates);
+        depthStencilStates.Clear(releasedDepthStencilStates);
 
         for(auto query: perfQueries)
             delete query;
 
         perfQueries.clear();
+
+        for (auto readback : readbacks)
+        {
+            if (readback->isMapped)
+                context->Unmap(readback->staging.Get(), 0);
+            delete readback;
+        }
+
+        readbacks.clear();
+        freeReadbacks.clear();
+
+        frameQueries.clear();
     }
 
     namespace
@@ -2139,13 +3537,12 @@ namespace NVRHI
 
     ID3D11BlendState* RendererInterfaceD3D11::getBlendState(const BlendState& blendState)
     {
-        CrcHash hasher;
-        hasher.Add(blendState);
-        uint32_t hash = hasher.Get();
-        ComPtr<ID3D11BlendState> d3dBlendState = blendStates[hash];
+        ComPtr<ID3D11BlendState>* cached = blendStates.Find(blendState);
 
-        if (d3dBlendState)
-            return d3dBlendState.Get();
+        if (cached)
+            return cached->Get();
+
+        ComPtr<ID3D11BlendState> d3dBlendState;
 
         D3D11_BLEND_DESC desc11New;
         desc11New.AlphaToCoverageEnable = blendState.alphaToCoverage ? TRUE : FALSE;
@@ -2170,19 +3567,23 @@ namespace NVRHI
 
         CHECK_ERROR(SUCCEEDED(device->CreateBlendState(&desc11New, &d3dBlendState)), "Creating blend state failed");
 
-        blendStates[hash] = d3dBlendState;
+        if (d3dBlendState)
+        {
+            std::vector<ComPtr<ID3D11BlendState>> evicted;
+            blendStates.Insert(blendState, d3dBlendState, sizeof(blendState) + sizeof(D3D11_BLEND_DESC), evicted);
+        }
+
         return d3dBlendState.Get();
     }
 
     ID3D11DepthStencilState* RendererInterfaceD3D11::getDepthStencilState(const DepthStencilState& depthState)
     {
-        CrcHash hasher;
-        hasher.Add(depthState);
-        uint32_t hash = hasher.Get();
-        ComPtr<ID3D11DepthStencilState> d3dDepthStencilState = depthStencilStates[hash];
+        ComPtr<ID3D11DepthStencilState>* cached = depthStencilStates.Find(depthState);
 
-        if (d3dDepthStencilState)
-            return d3dDepthStencilState.Get();
+        if (cached)
+            return cached->Get();
+
+        ComPtr<ID3D11DepthStencilState> d3dDepthStencilState;
 
         D3D11_DEPTH_STENCIL_DESC desc11New;
         desc11New.DepthEnable = depthState.depthEnable ? TRUE : FALSE;
@@ -2202,19 +3603,23 @@ namespace NVRHI
 
         CHECK_ERROR(SUCCEEDED(device->CreateDepthStencilState(&desc11New, &d3dDepthStencilState)), "Creating depth-stencil state failed");
 
-        depthStencilStates[hash] = d3dDepthStencilState;
+        if (d3dDepthStencilState)
+        {
+            std::vector<ComPtr<ID3D11DepthStencilState>> evicted;
+            depthStencilStates.Insert(depthState, d3dDepthStencilState, sizeof(depthState) + sizeof(D3D11_DEPTH_STENCIL_DESC), evicted);
+        }
+
         return d3dDepthStencilState.Get();
     }
 
     ID3D11RasterizerState* RendererInterfaceD3D11::getRasterizerState(const RasterState& rasterState)
     {
-        CrcHash hasher;
-        hasher.Add(rasterState);
-        uint32_t hash = hasher.Get();
-        ComPtr<ID3D11RasterizerState> d3dRasterizerState = rasterizerStates[hash];
+        ComPtr<ID3D11RasterizerState>* cached = rasterizerStates.Find(rasterState);
 
-        if (d3dRasterizerState)
-            return d3dRasterizerState.Get();
+        if (cached)
+            return cached->Get();
+
+        ComPtr<ID3D11RasterizerState> d3dRasterizerState;
 
         D3D11_RASTERIZER_DESC desc11New;
         switch (rasterState.fillMode)
@@ -2279,7 +3684,12 @@ namespace NVRHI
             CHECK_ERROR(SUCCEEDED(device->CreateRasterizerState(&desc11New, &d3dRasterizerState)), "Creating rasterizer state failed");
         }
 
-        rasterizerStates[hash] = d3dRasterizerState;
+        if (d3dRasterizerState)
+        {
+            std::vector<ComPtr<ID3D11RasterizerState>> evicted;
+            rasterizerStates.Insert(rasterState, d3dRasterizerState, sizeof(rasterState) + sizeof(D3D11_RASTERIZER_DESC), evicted);
+        }
+
         return d3dRasterizerState.Get();
     }
 
@@ -2405,6 +3815,25 @@ namespace NVRHI
         onCommand->executeAndDispose();
     }
 
+    CommandListHandle RendererInterfaceD3D11::createCommandList()
+    {
+        return new DeferredCommandList();
+    }
+
+    void RendererInterfaceD3D11::destroyCommandList(CommandListHandle commandList)
+    {
+        delete static_cast<DeferredCommandList*>(commandList);
+    }
+
+    void RendererInterfaceD3D11::executeCommandLists(const CommandListHandle* commandLists, uint32_t numCommandLists)
+    {
+        for (uint32_t i = 0; i < numCommandLists; i++)
+        {
+            if (commandLists[i])
+                static_cast<const DeferredCommandList*>(commandLists[i])->execute(this);
+        }
+    }
+
     void RendererInterfaceD3D11::signalError(const char* file, int line, const char* errorDesc)
     {
         if (errorCB)
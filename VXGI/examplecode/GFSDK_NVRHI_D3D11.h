@@ -11,17 +11,21 @@
 #pragma once
 
 #include <GFSDK_NVRHI.h>
+#include "GFSDK_NVRHI_Cache.h"
 #include <d3d11.h>
 #include <d3d11_1.h>
 #include <wrl.h>
 #include <map>
 #include <vector>
 #include <set>
+#include <deque>
 
 namespace NVRHI
 {
   using namespace Microsoft::WRL;
 
+  struct StageResourceBindings;
+
   struct StageMask
   {
       enum Enum
@@ -93,6 +97,7 @@ namespace NVRHI
     IErrorCallback* errorCB;
     bool nvapiIsInitalized;
     ComPtr<ID3DUserDefinedAnnotation> userDefinedAnnotation;
+    ComPtr<ID3D11DeviceContext1> context1;
 
     void signalError(const char* file, int line, const char* errorDesc);
 
@@ -119,16 +124,41 @@ namespace NVRHI
       ComPtr<ID3D11Buffer> stagingBuffer;
       ComPtr<ID3D11ShaderResourceView> shaderResourceView;
       ComPtr<ID3D11UnorderedAccessView> unorderedAccessView;
+
+      //state of mapBuffer. Buffers that are not D3D11_USAGE_DYNAMIC are mapped through mapScratch and updated on unmap
+      bool isMapped;
+      UINT mappedOffset;
+      UINT mappedSize;
+      std::vector<char> mapScratch;
+
+      BufferViewSet() : isMapped(false), mappedOffset(0), mappedSize(0) { }
     };
 
     typedef std::map<ComPtr<ID3D11Buffer>, BufferViewSet> BufferObjectMap;
     BufferObjectMap buffers;
     
-    std::map<uint32_t, ComPtr<ID3D11BlendState>> blendStates;
-    std::map<uint32_t, ComPtr<ID3D11DepthStencilState>> depthStencilStates;
-    std::map<uint32_t, ComPtr<ID3D11RasterizerState>> rasterizerStates;
+    BoundedCache<BlendState, ComPtr<ID3D11BlendState>> blendStates;
+    BoundedCache<DepthStencilState, ComPtr<ID3D11DepthStencilState>> depthStencilStates;
+    BoundedCache<RasterState, ComPtr<ID3D11RasterizerState>> rasterizerStates;
 
     std::set<PerformanceQueryHandle> perfQueries;
+
+    //All readback staging resources, and the ones that are not used by an active readback
+    std::vector<Readback*> readbacks;
+    std::vector<Readback*> freeReadbacks;
+    uint64_t readbackPeakBytes;
+
+    //event queries issued at the end of the frames that the GPU may not have finished yet, oldest first
+    std::deque<ComPtr<ID3D11Query>> frameQueries;
+    uint32_t maxFramesInFlight;
+    uint64_t frameIndex;
+
+    Readback* allocateReadback(D3D11_RESOURCE_DIMENSION dimension, DXGI_FORMAT format, UINT width, UINT height, UINT depth, UINT pixelSizeBytes);
+    PoolStatistics getReadbackStatistics();
+    void updateFence(Fence* f, uint64_t waitValue);
+    void retireCompletedFrames(uint32_t maxPendingFrames);
+    //issues the indirect draws one by one, the state must be applied
+    void issueMultiDrawIndirect(bool indexed, uint32_t indexBufferOffset, BufferHandle argsBuffer, uint32_t argsOffsetBytes, uint32_t argsStrideBytes, uint32_t maxDrawCount, BufferHandle countBuffer, uint32_t countOffsetBytes);
     
     D3D11_BLEND convertBlendValue(BlendState::BlendValue value);
     D3D11_BLEND_OP convertBlendOp(BlendState::BlendOp value);
@@ -143,6 +173,7 @@ namespace NVRHI
     ID3D11DepthStencilView* getDSVForTexture(TextureObjectMap::value_type* resource, uint32_t arrayItem = 0, uint32_t mipLevel = 0);
     ID3D11UnorderedAccessView* getUAVForTexture(TextureObjectMap::value_type* resource, DXGI_FORMAT format, uint32_t mipLevel = 0);
     //if there are multiple views to clear you can keep calling index until you get all null
+    void clearTextureRegion(TextureHandle t, const TextureRegion& region, bool asUINT, const Color& clearColor, uint32_t clearValue);
     void getClearViewForTexture(TextureObjectMap::value_type* resource, uint32_t index, bool asUINT, ID3D11UnorderedAccessView*& outUAV, ID3D11RenderTargetView*& outRTV, ID3D11DepthStencilView*& outDSV);
 
     ID3D11ShaderResourceView* getSRVForBuffer(BufferObjectMap::value_type* resource, Format::Enum format);
@@ -156,6 +187,13 @@ namespace NVRHI
     BufferDesc getBufferDescFromD3D11Buffer(ID3D11Buffer* buffer);
 
     D3D_PRIMITIVE_TOPOLOGY getPrimType(PrimitiveType::Enum pt);
+
+    void bakeStageBindings(const PipelineStageBindings& bindings, StageResourceBindings& resources);
+    bool validateGraphicsState(const GraphicsState& state);
+    bool validateComputeState(const ComputeState& state);
+
+    // Instantiated for both DrawCallState and CompactDrawCallState, which share field names
+    template<typename TDrawCallState> void applyDrawCallState(const TDrawCallState& state, uint32_t denyStageMask);
     
     void disableSLIResouceSync(ID3D11Resource* resource);
   public:
@@ -166,12 +204,23 @@ namespace NVRHI
     virtual TextureDesc describeTexture(TextureHandle t);
     virtual void clearTextureFloat(TextureHandle t, const Color& clearColor);
     virtual void clearTextureUInt(TextureHandle t, uint32_t clearColor);
+    virtual void clearTextureRegionFloat(TextureHandle t, const TextureRegion& region, const Color& clearColor);
+    virtual void clearTextureRegionUInt(TextureHandle t, const TextureRegion& region, uint32_t clearColor);
     virtual void writeTexture(TextureHandle t, uint32_t subresource, const void* data, uint32_t rowPitch, uint32_t depthPitch);
+    virtual void writeTextureRegion(TextureHandle t, const TextureRegion& region, const void* data, uint32_t rowPitch, uint32_t depthPitch);
+    virtual void copyTexture(TextureHandle dest, const TextureRegion& destRegion, TextureHandle src, const TextureRegion& srcRegion);
+    virtual void copyBufferToTexture(TextureHandle dest, const TextureRegion& destRegion, BufferHandle src, uint32_t srcOffsetBytes, uint32_t rowPitch, uint32_t depthPitch);
+    virtual void copyTextureToBuffer(BufferHandle dest, uint32_t destOffsetBytes, uint32_t rowPitch, uint32_t depthPitch, TextureHandle src, const TextureRegion& srcRegion);
+    virtual void resolveTexture(TextureHandle dest, uint32_t destMipLevel, uint32_t destArraySlice, TextureHandle src, uint32_t srcArraySlice);
     virtual void destroyTexture(TextureHandle t);
 
     virtual BufferHandle createBuffer(const BufferDesc& d, const void* data);
     virtual void writeBuffer(BufferHandle b, const void* data, size_t dataSize);
+    virtual void writeBufferRange(BufferHandle b, uint32_t offsetBytes, const void* data, size_t dataSize);
+    virtual void* mapBuffer(BufferHandle b, MapMode::Enum mode, uint32_t offsetBytes, size_t sizeBytes);
+    virtual void unmapBuffer(BufferHandle b);
     virtual void clearBufferUInt(BufferHandle b, uint32_t clearValue);
+    virtual void clearBufferUIntRange(BufferHandle b, uint32_t offsetBytes, size_t sizeBytes, uint32_t clearValue);
     virtual void copyToBuffer(BufferHandle dest, uint32_t destOffsetBytes, BufferHandle src, uint32_t srcOffsetBytes, size_t dataSizeBytes);
     virtual void readBuffer(BufferHandle b, void* data, size_t* dataSize);
     virtual void destroyBuffer(BufferHandle b);
@@ -214,10 +263,68 @@ namespace NVRHI
 
 	virtual void setEnableUavBarriersForTexture(TextureHandle, bool) { }
 	virtual void setEnableUavBarriersForBuffer(BufferHandle, bool) { }
+
+    virtual GraphicsPipelineHandle createGraphicsPipeline(const GraphicsPipelineDesc& d);
+    virtual void destroyGraphicsPipeline(GraphicsPipelineHandle p);
+    virtual ComputePipelineHandle createComputePipeline(const ComputePipelineDesc& d);
+    virtual void destroyComputePipeline(ComputePipelineHandle p);
+    virtual BindingSetHandle createBindingSet(const BindingSetDesc& d);
+    virtual void destroyBindingSet(BindingSetHandle b);
+
+    virtual void drawWithPipeline(const GraphicsState& state, const DrawArguments* args, uint32_t numDrawCalls);
+    virtual void drawIndexedWithPipeline(const GraphicsState& state, const DrawArguments* args, uint32_t numDrawCalls);
+    virtual void drawIndirectWithPipeline(const GraphicsState& state, BufferHandle indirectParams, uint32_t offsetBytes);
+    virtual void dispatchWithPipeline(const ComputeState& state, uint32_t groupsX, uint32_t groupsY, uint32_t groupsZ);
+    virtual void dispatchIndirectWithPipeline(const ComputeState& state, BufferHandle indirectParams, uint32_t offsetBytes);
+
+    virtual void drawCompact(const CompactDrawCallState& state, const DrawArguments* args, uint32_t numDrawCalls);
+    virtual void drawIndexedCompact(const CompactDrawCallState& state, const DrawArguments* args, uint32_t numDrawCalls);
+    virtual void drawIndirectCompact(const CompactDrawCallState& state, BufferHandle indirectParams, uint32_t offsetBytes);
+
+    virtual CommandListHandle createCommandList();
+    virtual void destroyCommandList(CommandListHandle commandList);
+    virtual void executeCommandLists(const CommandListHandle* commandLists, uint32_t numCommandLists);
+
+    virtual ReadbackHandle beginBufferReadback(BufferHandle b, uint32_t offsetBytes, size_t sizeBytes);
+    virtual ReadbackHandle beginTextureReadback(TextureHandle t, const TextureRegion& region);
+    virtual bool isReadbackReady(ReadbackHandle r);
+    virtual const void* mapReadback(ReadbackHandle r, uint32_t* rowPitch, uint32_t* depthPitch);
+    virtual void releaseReadback(ReadbackHandle r);
+    virtual FenceHandle createFence();
+    virtual void destroyFence(FenceHandle f);
+    virtual void signalFence(FenceHandle f, uint64_t value);
+    virtual uint64_t getFenceCompletedValue(FenceHandle f);
+    virtual void waitFence(FenceHandle f, uint64_t value);
+    virtual void setMaxFramesInFlight(uint32_t maxFrames);
+    virtual void beginFrame();
+    virtual void endFrame();
+    virtual FrameStatistics getFrameStatistics();
+    virtual void drawIndexedIndirect(const DrawCallState& state, BufferHandle indirectParams, uint32_t offsetBytes);
+    virtual void multiDrawIndirect(const DrawCallState& state, BufferHandle argsBuffer, uint32_t argsOffsetBytes, uint32_t argsStrideBytes, uint32_t maxDrawCount, BufferHandle countBuffer, uint32_t countOffsetBytes);
+    virtual void multiDrawIndexedIndirect(const DrawCallState& state, BufferHandle argsBuffer, uint32_t argsOffsetBytes, uint32_t argsStrideBytes, uint32_t maxDrawCount, BufferHandle countBuffer, uint32_t countOffsetBytes);
+    virtual void drawIndexedIndirectWithPipeline(const GraphicsState& state, BufferHandle indirectParams, uint32_t offsetBytes);
+    virtual void multiDrawIndirectWithPipeline(const GraphicsState& state, BufferHandle argsBuffer, uint32_t argsOffsetBytes, uint32_t argsStrideBytes, uint32_t maxDrawCount, BufferHandle countBuffer, uint32_t countOffsetBytes);
+    virtual void multiDrawIndexedIndirectWithPipeline(const GraphicsState& state, BufferHandle argsBuffer, uint32_t argsOffsetBytes, uint32_t argsStrideBytes, uint32_t maxDrawCount, BufferHandle countBuffer, uint32_t countOffsetBytes);
+    virtual void drawIndexedIndirectCompact(const CompactDrawCallState& state, BufferHandle indirectParams, uint32_t offsetBytes);
+    virtual void multiDrawIndirectCompact(const CompactDrawCallState& state, BufferHandle argsBuffer, uint32_t argsOffsetBytes, uint32_t argsStrideBytes, uint32_t maxDrawCount, BufferHandle countBuffer, uint32_t countOffsetBytes);
+    virtual void multiDrawIndexedIndirectCompact(const CompactDrawCallState& state, BufferHandle argsBuffer, uint32_t argsOffsetBytes, uint32_t argsStrideBytes, uint32_t maxDrawCount, BufferHandle countBuffer, uint32_t countOffsetBytes);
+    virtual void setStateCacheLimits(uint32_t maxEntries, uint64_t maxBytes);
+
+    using IRendererInterface::draw;
+    using IRendererInterface::drawIndexed;
+    using IRendererInterface::drawIndirect;
+    using IRendererInterface::drawIndexedIndirect;
+    using IRendererInterface::multiDrawIndirect;
+    using IRendererInterface::multiDrawIndexedIndirect;
+    using IRendererInterface::dispatch;
+    using IRendererInterface::dispatchIndirect;
     
     //These do not handle the pre/post commands
     void applyState(const DrawCallState& state, uint32_t denyStageMask = 0);
+    void applyState(const CompactDrawCallState& state, uint32_t denyStageMask = 0);
     void applyState(const DispatchState& state);
+    void applyState(const GraphicsState& state);
+    void applyState(const ComputeState& state);
     void clearState();
   };
 
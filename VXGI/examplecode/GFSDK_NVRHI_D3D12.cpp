@@ -9,6 +9,8 @@
 */
 
 #include "GFSDK_NVRHI_D3D12.h"
+#include "GFSDK_NVRHI_CommandList.h"
+#include "GFSDK_NVRHI_Cache.h"
 #include <d3d12.h>
 #include <vector>
 #include <set>
@@ -147,6 +149,12 @@ namespace NVRHI
         DescriptorIndex unorderedAccessView;
 		D3D12_GPU_VIRTUAL_ADDRESS gpuVA;
 
+        // State of mapBuffer: the mapped range lives in the upload buffer and is copied into the resource on unmap
+        bool isMapped;
+        UINT64 mappedUploadOffset;
+        UINT64 mappedOffset;
+        UINT64 mappedSize;
+
         Buffer() 
             : resource(nullptr)
             , parent(nullptr)
@@ -155,6 +163,10 @@ namespace NVRHI
             , state(D3D12_RESOURCE_STATE_COMMON) 
             , shaderResourceView(INVALID_DESCRIPTOR_INDEX)
             , unorderedAccessView(INVALID_DESCRIPTOR_INDEX)
+            , isMapped(false)
+            , mappedUploadOffset(0)
+            , mappedOffset(0)
+            , mappedSize(0)
         { }
         
         virtual ~Buffer() 
@@ -164,6 +176,57 @@ namespace NVRHI
         }
     };
 
+    // Persistently mapped READBACK buffer used for one readback at a time, recycled through BackendResources::freeReadbacks
+    class Readback
+    {
+    public:
+        ID3D12Resource* resource;
+        UINT64 capacity;
+        UINT64 size;
+        void* cpuVA;
+        UINT64 fenceValue;
+        uint32_t rowPitch;
+        uint32_t depthPitch;
+
+        Readback()
+            : resource(nullptr)
+            , capacity(0)
+            , size(0)
+            , cpuVA(nullptr)
+            , fenceValue(0)
+            , rowPitch(0)
+            , depthPitch(0)
+        { }
+
+        ~Readback()
+        {
+            if (resource && cpuVA)
+                resource->Unmap(0, nullptr);
+
+            SAFE_RELEASE(resource);
+        }
+    };
+
+    class Fence
+    {
+    public:
+        ID3D12Fence* fence;
+        HANDLE event;
+
+        Fence()
+            : fence(nullptr)
+            , event(0)
+        { }
+
+        ~Fence()
+        {
+            SAFE_RELEASE(fence);
+
+            if (event)
+                CloseHandle(event);
+        }
+    };
+
     class ConstantBuffer : public ManagedResource
     {
     public:
@@ -285,20 +348,135 @@ namespace NVRHI
         }
     };
 
-    class CommandList : public ManagedResource
+    // Shaders of a cached root signature and whether it allows the input assembler.
+    // Compute root signatures have the compute shader in the first slot.
+    struct RootSignatureKey
+    {
+        ShaderHandle shaders[5];
+        uint32_t compute;
+        uint32_t allowInputLayout;
+    };
+
+    // Everything that is baked into a cached pipeline state object.
+    // Compute pipeline states only have the compute shader in the first slot and the compute flag set.
+    struct PipelineStateKey
+    {
+        ShaderHandle shaders[5];
+        InputLayoutHandle inputLayout;
+        BlendState blendState;
+        DepthStencilState depthStencilState;
+        RasterState rasterState;
+        uint32_t compute;
+        uint32_t primType;
+        uint32_t setupExtraVoxelizationState;
+        Format::Enum renderTargetFormats[RenderState::MAX_RENDER_TARGETS];
+        Format::Enum depthTargetFormat;
+        uint32_t sampleCount;
+        uint32_t sampleQuality;
+    };
+
+    // Memory charged to a cached pipeline state: the objects, and the bytecode that the driver compiles into it
+    static uint64_t EstimatePipelineStateBytes(const PipelineStateKey& key)
+    {
+        uint64_t bytes = sizeof(PipelineState) + sizeof(PipelineStateKey);
+        for (ShaderHandle shader : key.shaders)
+        {
+            if (shader)
+                bytes += shader->bytecode.size();
+        }
+        return bytes;
+    }
+
+    // Contents of the descriptor tables of one shader stage, in the same layout as bindShaderResources produces them.
+    // Descriptors are stored as indices because the static heaps may be reallocated when they grow.
+    struct StageDescriptorTables
+    {
+        struct RequiredTextureState
+        {
+            TextureHandle texture;
+            uint32_t mipLevel;
+            uint32_t state;
+        };
+
+        struct RequiredBufferState
+        {
+            BufferHandle buffer;
+            uint32_t state;
+        };
+
+        ShaderHandle shader;
+        std::vector<DescriptorIndex> descriptors;   // CBVs, SRVs and UAVs in dhSRVstatic
+        std::vector<DescriptorIndex> samplers;      // in dhSamplerStatic
+        std::vector<ConstantBufferHandle> constantBuffers;
+        std::vector<RequiredTextureState> textureStates;
+        std::vector<RequiredBufferState> bufferStates;
+
+        StageDescriptorTables()
+            : shader(nullptr)
+        { }
+    };
+
+    class GraphicsPipeline : public ManagedResource
+    {
+    public:
+        GraphicsPipelineDesc desc;
+        RootSignatureHandle rootSignature;
+        PipelineStateHandle pipelineState;
+        StageDescriptorTables nullTables[ShaderType::GRAPHIC_SHADERS_NUM];
+
+        GraphicsPipeline()
+            : rootSignature(nullptr)
+            , pipelineState(nullptr)
+        { }
+
+        virtual ~GraphicsPipeline()
+        {
+            delete pipelineState;
+            delete rootSignature;
+        }
+    };
+
+    class ComputePipeline : public ManagedResource
+    {
+    public:
+        ComputePipelineDesc desc;
+        RootSignatureHandle rootSignature;
+        PipelineStateHandle pipelineState;
+        StageDescriptorTables nullTables;
+
+        ComputePipeline()
+            : rootSignature(nullptr)
+            , pipelineState(nullptr)
+        { }
+
+        virtual ~ComputePipeline()
+        {
+            delete pipelineState;
+            delete rootSignature;
+        }
+    };
+
+    class BindingSet
+    {
+    public:
+        StageDescriptorTables graphicsStages[ShaderType::GRAPHIC_SHADERS_NUM];
+        StageDescriptorTables CS;
+    };
+
+    class NativeCommandList : public ManagedResource
     {
     public:
         ID3D12CommandAllocator* allocator;
         ID3D12GraphicsCommandList* commandList;
         uint32_t size;
 
-        CommandList()
+        NativeCommandList()
             : allocator(nullptr)
             , commandList(nullptr)
             , size(0)
         { }
 
-        virtual ~CommandList()
+        virtual ~NativeCommandList()
         {
             SAFE_RELEASE(commandList);
             SAFE_RELEASE(allocator);
@@ -372,104 +550,6 @@ namespace NVRHI
         return mapping;
     }
 
-    bool GetSSE42Support()
-    {
-        int cpui[4];
-        __cpuidex(cpui, 1, 0);
-        return !!(cpui[2] & 0x100000);
-    }
-
-    static const bool CpuSupportsSSE42 = GetSSE42Support();
-
-    static const uint32_t CrcTable[] = {
-        0x00000000, 0x77073096, 0xee0e612c, 0x990951ba, 0x076dc419, 0x706af48f,
-        0xe963a535, 0x9e6495a3, 0x0edb8832, 0x79dcb8a4, 0xe0d5e91e, 0x97d2d988,
-        0x09b64c2b, 0x7eb17cbd, 0xe7b82d07, 0x90bf1d91, 0x1db71064, 0x6ab020f2,
-        0xf3b97148, 0x84be41de, 0x1adad47d, 0x6ddde4eb, 0xf4d4b551, 0x83d385c7,
-        0x136c9856, 0x646ba8c0, 0xfd62f97a, 0x8a65c9ec, 0x14015c4f, 0x63066cd9,
-        0xfa0f3d63, 0x8d080df5, 0x3b6e20c8, 0x4c69105e, 0xd56041e4, 0xa2677172,
-        0x3c03e4d1, 0x4b04d447, 0xd20d85fd, 0xa50ab56b, 0x35b5a8fa, 0x42b2986c,
-        0xdbbbc9d6, 0xacbcf940, 0x32d86ce3, 0x45df5c75, 0xdcd60dcf, 0xabd13d59,
-        0x26d930ac, 0x51de003a, 0xc8d75180, 0xbfd06116, 0x21b4f4b5, 0x56b3c423,
-        0xcfba9599, 0xb8bda50f, 0x2802b89e, 0x5f058808, 0xc60cd9b2, 0xb10be924,
-        0x2f6f7c87, 0x58684c11, 0xc1611dab, 0xb6662d3d, 0x76dc4190, 0x01db7106,
-        0x98d220bc, 0xefd5102a, 0x71b18589, 0x06b6b51f, 0x9fbfe4a5, 0xe8b8d433,
-        0x7807c9a2, 0x0f00f934, 0x9609a88e, 0xe10e9818, 0x7f6a0dbb, 0x086d3d2d,
-        0x91646c97, 0xe6635c01, 0x6b6b51f4, 0x1c6c6162, 0x856530d8, 0xf262004e,
-        0x6c0695ed, 0x1b01a57b, 0x8208f4c1, 0xf50fc457, 0x65b0d9c6, 0x12b7e950,
-        0x8bbeb8ea, 0xfcb9887c, 0x62dd1ddf, 0x15da2d49, 0x8cd37cf3, 0xfbd44c65,
-        0x4db26158, 0x3ab551ce, 0xa3bc0074, 0xd4bb30e2, 0x4adfa541, 0x3dd895d7,
-        0xa4d1c46d, 0xd3d6f4fb, 0x4369e96a, 0x346ed9fc, 0xad678846, 0xda60b8d0,
-        0x44042d73, 0x33031de5, 0xaa0a4c5f, 0xdd0d7cc9, 0x5005713c, 0x270241aa,
-        0xbe0b1010, 0xc90c2086, 0x5768b525, 0x206f85b3, 0xb966d409, 0xce61e49f,
-        0x5edef90e, 0x29d9c998, 0xb0d09822, 0xc7d7a8b4, 0x59b33d17, 0x2eb40d81,
-        0xb7bd5c3b, 0xc0ba6cad, 0xedb88320, 0x9abfb3b6, 0x03b6e20c, 0x74b1d29a,
-        0xead54739, 0x9dd277af, 0x04db2615, 0x73dc1683, 0xe3630b12, 0x94643b84,
-        0x0d6d6a3e, 0x7a6a5aa8, 0xe40ecf0b, 0x9309ff9d, 0x0a00ae27, 0x7d079eb1,
-        0xf00f9344, 0x8708a3d2, 0x1e01f268, 0x6906c2fe, 0xf762575d, 0x806567cb,
-        0x196c3671, 0x6e6b06e7, 0xfed41b76, 0x89d32be0, 0x10da7a5a, 0x67dd4acc,
-        0xf9b9df6f, 0x8ebeeff9, 0x17b7be43, 0x60b08ed5, 0xd6d6a3e8, 0xa1d1937e,
-        0x38d8c2c4, 0x4fdff252, 0xd1bb67f1, 0xa6bc5767, 0x3fb506dd, 0x48b2364b,
-        0xd80d2bda, 0xaf0a1b4c, 0x36034af6, 0x41047a60, 0xdf60efc3, 0xa867df55,
-        0x316e8eef, 0x4669be79, 0xcb61b38c, 0xbc66831a, 0x256fd2a0, 0x5268e236,
-        0xcc0c7795, 0xbb0b4703, 0x220216b9, 0x5505262f, 0xc5ba3bbe, 0xb2bd0b28,
-        0x2bb45a92, 0x5cb36a04, 0xc2d7ffa7, 0xb5d0cf31, 0x2cd99e8b, 0x5bdeae1d,
-        0x9b64c2b0, 0xec63f226, 0x756aa39c, 0x026d930a, 0x9c0906a9, 0xeb0e363f,
-        0x72076785, 0x05005713, 0x95bf4a82, 0xe2b87a14, 0x7bb12bae, 0x0cb61b38,
-        0x92d28e9b, 0xe5d5be0d, 0x7cdcefb7, 0x0bdbdf21, 0x86d3d2d4, 0xf1d4e242,
-        0x68ddb3f8, 0x1fda836e, 0x81be16cd, 0xf6b9265b, 0x6fb077e1, 0x18b74777,
-        0x88085ae6, 0xff0f6a70, 0x66063bca, 0x11010b5c, 0x8f659eff, 0xf862ae69,
-        0x616bffd3, 0x166ccf45, 0xa00ae278, 0xd70dd2ee, 0x4e048354, 0x3903b3c2,
-        0xa7672661, 0xd06016f7, 0x4969474d, 0x3e6e77db, 0xaed16a4a, 0xd9d65adc,
-        0x40df0b66, 0x37d83bf0, 0xa9bcae53, 0xdebb9ec5, 0x47b2cf7f, 0x30b5ffe9,
-        0xbdbdf21c, 0xcabac28a, 0x53b39330, 0x24b4a3a6, 0xbad03605, 0xcdd70693,
-        0x54de5729, 0x23d967bf, 0xb3667a2e, 0xc4614ab8, 0x5d681b02, 0x2a6f2b94,
-        0xb40bbe37, 0xc30c8ea1, 0x5a05df1b, 0x2d02ef8d
-    };
-
-    class CrcHash
-    {
-    private:
-        uint32_t crc;
-    public:
-        CrcHash() 
-            : crc(0) 
-        { 
-        }
-
-        uint32_t Get() 
-        {
-            return crc;
-        }
-
-        template<size_t size> __forceinline void AddBytesSSE42(void* p)
-        {
-            static_assert(size % 4 == 0, "Size of hashable types must be multiple of 4");
-
-            uint32_t* data = (uint32_t*)p;
-
-            const size_t numIterations = size / sizeof(uint32_t);
-            for (size_t i = 0; i < numIterations; i++)
-            {
-                crc = _mm_crc32_u32(crc, data[i]);
-            }
-        }
-
-        __forceinline void AddBytes(char* p, uint32_t size)
-        {
-            for (uint32_t idx = 0; idx < size; idx++)
-                crc = CrcTable[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
-        }
-
-        template<typename T> void Add(const T& value)
-        {
-            if (CpuSupportsSSE42)
-                AddBytesSSE42<sizeof(value)>((void*)&value);
-            else
-                AddBytes((char*)&value, sizeof(value));
-        }
-    };
-
     class DescriptorHeap
     {
     private:
@@ -481,6 +561,7 @@ namespace NVRHI
         uint32_t m_NumDescriptors;
         std::list<std::pair<UINT64, uint32_t>> m_FencePointers;
         uint32_t m_WritePointer;
+        uint32_t m_PeakUsage;
         bool m_Monitored;
         const char* m_TypeString;
 
@@ -491,6 +572,7 @@ namespace NVRHI
             , m_Stride(0)
             , m_NumDescriptors(0)
             , m_WritePointer(0)
+            , m_PeakUsage(0)
             , m_Monitored(false)
         {
         }
@@ -575,9 +657,29 @@ namespace NVRHI
 
             firstIndex = m_WritePointer;
             m_WritePointer += numDescriptors;
+            m_PeakUsage = std::max(m_PeakUsage, GetUsage());
             return true;
         }
 
+        // Number of descriptors between the oldest range that the GPU may still use and the write pointer
+        uint32_t GetUsage() const
+        {
+            if (m_FencePointers.empty())
+                return m_WritePointer;
+
+            uint32_t head = m_FencePointers.front().second;
+            return m_WritePointer >= head ? m_WritePointer - head : m_NumDescriptors - head + m_WritePointer;
+        }
+
+        PoolStatistics GetStatistics() const
+        {
+            PoolStatistics stats;
+            stats.capacity = m_NumDescriptors;
+            stats.inUse = GetUsage();
+            stats.peak = std::max(uint64_t(m_PeakUsage), stats.inUse);
+            return stats;
+        }
+
         D3D12_CPU_DESCRIPTOR_HANDLE GetCpuHandle(uint32_t index)
         {
             D3D12_CPU_DESCRIPTOR_HANDLE handle = m_StartCpuHandle;
@@ -740,8 +842,13 @@ namespace NVRHI
 		D3D12_GPU_VIRTUAL_ADDRESS m_UploadBufferGPUVA;
         UINT64 m_BufferSize;
         UINT64 m_WritePointer;
+        UINT64 m_PeakUsage;
         std::list<std::pair<UINT64, UINT64>> m_FencePointers;
         const std::list<ConstantBufferHandle>& m_ConstantBuffers;
+
+        // Offsets of the allocations that are mapped by the application, in allocation order.
+        // Fence pointers never advance past the oldest one, so it's not recycled before its copy is recorded.
+        std::list<UINT64> m_MappedAllocations;
     public:
         UploadManager(RendererInterfaceD3D12* pParent, const std::list<ConstantBufferHandle>& constantBuffers)
             : m_pParent(pParent)
@@ -750,6 +857,7 @@ namespace NVRHI
             , m_pUploadBufferHostData(NULL)
             , m_BufferSize(0)
             , m_WritePointer(0)
+            , m_PeakUsage(0)
         {
         }
 
@@ -853,9 +961,29 @@ namespace NVRHI
 
             UINT64 bufferOffset = m_WritePointer;
             m_WritePointer += size;
+            m_PeakUsage = std::max(m_PeakUsage, GetUsage());
             return bufferOffset;
         }
 
+        // Number of bytes between the oldest allocation that the GPU may still use and the write pointer
+        UINT64 GetUsage() const
+        {
+            if (m_FencePointers.empty())
+                return m_WritePointer;
+
+            UINT64 head = m_FencePointers.front().second;
+            return m_WritePointer >= head ? m_WritePointer - head : m_BufferSize - head + m_WritePointer;
+        }
+
+        PoolStatistics GetStatistics() const
+        {
+            PoolStatistics stats;
+            stats.capacity = m_BufferSize;
+            stats.inUse = GetUsage();
+            stats.peak = std::max(m_PeakUsage, stats.inUse);
+            return stats;
+        }
+
         void* GetCpuVA(UINT64 bufferOffset)
         {
             return (char*)m_pUploadBufferHostData + bufferOffset;
@@ -873,7 +1001,18 @@ namespace NVRHI
 
         void AddFencePointer(UINT64 fenceValue)
         {
-            m_FencePointers.push_back(std::make_pair(fenceValue, m_WritePointer));
+            UINT64 pointer = m_MappedAllocations.empty() ? m_WritePointer : m_MappedAllocations.front();
+            m_FencePointers.push_back(std::make_pair(fenceValue, pointer));
+        }
+
+        void BeginMappedAllocation(UINT64 bufferOffset)
+        {
+            m_MappedAllocations.push_back(bufferOffset);
+        }
+
+        void EndMappedAllocation(UINT64 bufferOffset)
+        {
+            m_MappedAllocations.remove(bufferOffset);
         }
 
         void ReleaseFences(UINT64 lastCompletedValue)
@@ -927,8 +1066,14 @@ namespace NVRHI
         std::set<SamplerHandle> samplers;
         std::set<InputLayoutHandle> inputLayouts;
         std::set<PerformanceQueryHandle> perfQueries;
+        std::set<GraphicsPipelineHandle> graphicsPipelines;
+        std::set<ComputePipelineHandle> computePipelines;
+        std::set<BindingSetHandle> bindingSets;
         std::set<ManagedResource*> deletedResources;
-        std::list<CommandListHandle> commandLists;
+        std::list<NativeCommandListHandle> commandLists;
+        std::vector<ReadbackHandle> readbacks;
+        std::vector<ReadbackHandle> freeReadbacks;
+        std::set<FenceHandle> fences;
         StaticDescriptorHeap dhRTV;
         StaticDescriptorHeap dhDSV;
         StaticDescriptorHeap dhSRVstatic;
@@ -937,17 +1082,26 @@ namespace NVRHI
         DescriptorHeap dhSamplers;
         UploadManager upload;
 
-        std::map<uint32_t, PipelineStateHandle> psoCache;
-        std::map<uint32_t, RootSignatureHandle> rootsigCache;
+        BoundedCache<PipelineStateKey, PipelineStateHandle> psoCache;
+        BoundedCache<RootSignatureKey, RootSignatureHandle> rootsigCache;
         std::vector<D3D12_RESOURCE_BARRIER> barrier;
 
         ID3D12Fence* fence;
         HANDLE fenceEvent;
         UINT64 fenceCounter;
 
+        // Values of the main fence at the end of the frames that the GPU may not have finished yet, oldest first
+        std::list<UINT64> frameFenceValues;
+        uint32_t maxFramesInFlight;
+        uint64_t frameIndex;
+        UINT64 readbackPeakBytes;
+
         ID3D12CommandSignature* drawIndirectSignature;
         ID3D12CommandSignature* dispatchIndirectSignature;
 
+        // Signatures for multi-draw indirect, by (indexed, stride), because the stride is part of the signature
+        std::map<std::pair<bool, uint32_t>, ID3D12CommandSignature*> multiDrawSignatures;
+
         DescriptorIndex nullCBV;
         DescriptorIndex nullSRV;
         DescriptorIndex nullUAV;
@@ -976,6 +1130,9 @@ namespace NVRHI
             , fence(nullptr)
             , fenceEvent(0)
             , fenceCounter(0)
+            , maxFramesInFlight(2)
+            , frameIndex(0)
+            , readbackPeakBytes(0)
             , drawIndirectSignature(nullptr)
             , dispatchIndirectSignature(nullptr)
             , nullCBV(INVALID_DESCRIPTOR_INDEX)
@@ -1017,15 +1174,30 @@ namespace NVRHI
             for (auto query : perfQueries)
                 delete query;
 
-            for (auto& pair : psoCache)
-                delete pair.second;
+            for (auto pipeline : graphicsPipelines)
+                delete pipeline;
+
+            for (auto pipeline : computePipelines)
+                delete pipeline;
 
-            for (auto& pair : rootsigCache)
-                delete pair.second;
+            for (auto bindingSet : bindingSets)
+                delete bindingSet;
+
+            for (auto& entry : psoCache)
+                delete entry.value;
+
+            for (auto& entry : rootsigCache)
+                delete entry.value;
 
             for (auto list : commandLists)
                 delete list;
 
+            for (auto readback : readbacks)
+                delete readback;
+
+            for (auto f : fences)
+                delete f;
+
             SAFE_RELEASE(fence);
 
             if (fenceEvent)
@@ -1037,6 +1209,9 @@ namespace NVRHI
             SAFE_RELEASE(drawIndirectSignature);
             SAFE_RELEASE(dispatchIndirectSignature);
             SAFE_RELEASE(perfQueryHeap);
+
+            for (auto& it : multiDrawSignatures)
+                SAFE_RELEASE(it.second);
         }
 
         void SetFence()
@@ -1078,6 +1253,12 @@ namespace NVRHI
                 //completed = fence->GetCompletedValue();
             }
 
+            ReleaseCompletedResources(completed);
+        }
+
+        // Returns the ring space and the deleted objects of all work up to the completed fence value
+        void ReleaseCompletedResources(UINT64 completed)
+        {
             dhSRVetc.ReleaseFences(completed);
             dhSamplers.ReleaseFences(completed);
 
@@ -1086,7 +1267,8 @@ namespace NVRHI
             std::set<ManagedResource*> unreferenced;
             for (auto resource : deletedResources)
             {
-                if (resource->fenceCounterAtLastUse <= completed)
+                // Objects are stamped with the fence counter before the signal that follows their last use
+                if (resource->fenceCounterAtLastUse < completed)
                     unreferenced.insert(resource);
             }
 
@@ -1096,6 +1278,21 @@ namespace NVRHI
                 deletedResources.erase(resource);
             }
         }
+
+        PoolStatistics UpdateReadbackStatistics()
+        {
+            PoolStatistics stats;
+            for (auto readback : readbacks)
+                stats.capacity += readback->capacity;
+
+            stats.inUse = stats.capacity;
+            for (auto readback : freeReadbacks)
+                stats.inUse -= readback->capacity;
+
+            readbackPeakBytes = std::max(readbackPeakBytes, stats.inUse);
+            stats.peak = readbackPeakBytes;
+            return stats;
+        }
     };
 
     RendererInterfaceD3D12::RendererInterfaceD3D12(IErrorCallback * errorCB, ID3D12Device * pDevice, ID3D12CommandQueue * pCommandQueue)
@@ -1108,7 +1305,7 @@ namespace NVRHI
         m_pDevice->AddRef();
         m_pCommandQueue->AddRef();
 
-        m_ActiveCommandList = createCommandList();
+        m_ActiveCommandList = createNativeCommandList();
 
         D3D12_DESCRIPTOR_HEAP_DESC descriptorHeapDesc = {};
         descriptorHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_DSV;
@@ -1306,7 +1503,7 @@ namespace NVRHI
             }
             else
             {
-                m_ActiveCommandList = createCommandList();
+                m_ActiveCommandList = createNativeCommandList();
             }
 
 			m_pResources->currentRS = nullptr;
@@ -1341,9 +1538,9 @@ namespace NVRHI
         m_pErrorCallback->signalError(file, line, errorDesc);
     }
 
-    CommandListHandle RendererInterfaceD3D12::createCommandList()
+    NativeCommandListHandle RendererInterfaceD3D12::createNativeCommandList()
     {
-        CommandListHandle commandList = new CommandList();
+        NativeCommandListHandle commandList = new NativeCommandList();
 
         m_pDevice->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&commandList->allocator));
         m_pDevice->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, commandList->allocator, nullptr, IID_PPV_ARGS(&commandList->commandList));
@@ -1351,7 +1548,8 @@ namespace NVRHI
         return commandList;
     }
 
-    DXGI_SAMPLE_DESC getStateSampleDesc(const DrawCallState& state)
+    template<typename TDrawCallState>
+    DXGI_SAMPLE_DESC getStateSampleDesc(const TDrawCallState& state)
     {
         DXGI_SAMPLE_DESC sampleDesc;
         if (state.renderState.depthTarget)
@@ -1373,48 +1571,42 @@ namespace NVRHI
         return sampleDesc;
     }
 
-    uint32_t RendererInterfaceD3D12::getStateHashForRS(const DrawCallState & state)
-    {
-        CrcHash hash;
-
-        hash.Add(state.VS.shader);
-        hash.Add(state.HS.shader);
-        hash.Add(state.DS.shader);
-        hash.Add(state.GS.shader);
-        hash.Add(state.PS.shader);
-
-        return hash.Get();
-    }
-
-    uint32_t RendererInterfaceD3D12::getComputeStateHash(const DispatchState & state)
+    template<typename TDrawCallState>
+    void RendererInterfaceD3D12::getStateKeyForRS(const TDrawCallState & state, RootSignatureKey& key)
     {
-        CrcHash hash;
-
-        hash.Add(state.shader);
-
-        return hash.Get();
+        memset(&key, 0, sizeof(key));
+
+        key.shaders[0] = state.VS.shader;
+        key.shaders[1] = state.HS.shader;
+        key.shaders[2] = state.DS.shader;
+        key.shaders[3] = state.GS.shader;
+        key.shaders[4] = state.PS.shader;
+        key.allowInputLayout = state.inputLayout != nullptr;
     }
 
-    uint32_t RendererInterfaceD3D12::getStateHashForPSO(const DrawCallState & state)
+    template<typename TDrawCallState>
+    void RendererInterfaceD3D12::getStateKeyForPSO(const TDrawCallState & state, PipelineStateKey& key)
     {
-        CrcHash hash;
-
-        hash.Add(state.VS.shader);
-        hash.Add(state.HS.shader);
-        hash.Add(state.DS.shader);
-        hash.Add(state.GS.shader);
-        hash.Add(state.PS.shader);
-        hash.Add(state.renderState.blendState);
-        hash.Add(state.renderState.depthStencilState);
-        hash.Add(state.renderState.rasterState);
-        hash.Add(state.primType);
-        hash.Add(state.inputLayout);
-        hash.Add(state.renderState.depthTarget ? state.renderState.depthTarget->desc.format : Format::UNKNOWN);
-        for (uint32_t target = 0; target < 8; target++)
-            hash.Add(state.renderState.targets[target] ? state.renderState.targets[target]->desc.format : Format::UNKNOWN);
-        hash.Add(getStateSampleDesc(state));
-
-        return hash.Get();
+        memset(&key, 0, sizeof(key));
+
+        key.shaders[0] = state.VS.shader;
+        key.shaders[1] = state.HS.shader;
+        key.shaders[2] = state.DS.shader;
+        key.shaders[3] = state.GS.shader;
+        key.shaders[4] = state.PS.shader;
+        key.inputLayout = state.inputLayout;
+        key.blendState = state.renderState.blendState;
+        key.depthStencilState = state.renderState.depthStencilState;
+        key.rasterState = state.renderState.rasterState;
+        key.primType = state.primType;
+        key.setupExtraVoxelizationState = state.renderState.setupExtraVoxelizationState;
+        key.depthTargetFormat = state.renderState.depthTarget ? state.renderState.depthTarget->desc.format : Format::UNKNOWN;
+        for (uint32_t target = 0; target < RenderState::MAX_RENDER_TARGETS; target++)
+            key.renderTargetFormats[target] = state.renderState.targets[target] ? state.renderState.targets[target]->desc.format : Format::UNKNOWN;
+
+        DXGI_SAMPLE_DESC sampleDesc = getStateSampleDesc(state);
+        key.sampleCount = sampleDesc.Count;
+        key.sampleQuality = sampleDesc.Quality;
     }
 
     D3D12_SHADER_VISIBILITY convertShaderStage(ShaderType::Enum s)
@@ -1532,14 +1724,16 @@ namespace NVRHI
         return rootsig;
     }
 
-    RootSignatureHandle RendererInterfaceD3D12::getRootSignature(const DrawCallState & state)
+    template<typename TDrawCallState>
+    RootSignatureHandle RendererInterfaceD3D12::getRootSignature(const TDrawCallState & state)
     {
-        uint32_t hash = getStateHashForRS(state);
+        RootSignatureKey key;
+        getStateKeyForRS(state, key);
 
-        RootSignatureHandle rootsig = m_pResources->rootsigCache[hash];
+        RootSignatureHandle* cached = m_pResources->rootsigCache.Find(key);
             
-        if (rootsig)
-            return rootsig;
+        if (cached)
+            return *cached;
 
         ShaderHandle shaders[5] = { 
             state.VS.shader, 
@@ -1548,22 +1742,33 @@ namespace NVRHI
             state.GS.shader, 
             state.PS.shader
         };
-        rootsig = buildRootSignature(5, shaders, state.inputLayout != nullptr);
+        RootSignatureHandle rootsig = buildRootSignature(5, shaders, state.inputLayout != nullptr);
 
-        m_pResources->rootsigCache[hash] = rootsig;
+        std::vector<RootSignatureHandle> evicted;
+        std::vector<PipelineStateHandle> evictedPSOs;
+        m_pResources->rootsigCache.Insert(key, rootsig, sizeof(RootSignature) + sizeof(RootSignatureKey), evicted);
+        releaseCachedObjects(evicted, evictedPSOs);
         return rootsig;
     }
 
-    RootSignatureHandle RendererInterfaceD3D12::getRootSignature(const DispatchState & state, uint32_t hash)
+    RootSignatureHandle RendererInterfaceD3D12::getRootSignature(const DispatchState & state)
     {
-        RootSignatureHandle rootsig = m_pResources->rootsigCache[hash];
+        RootSignatureKey key;
+        memset(&key, 0, sizeof(key));
+        key.shaders[0] = state.shader;
+        key.compute = 1;
+
+        RootSignatureHandle* cached = m_pResources->rootsigCache.Find(key);
 
-        if (rootsig)
-            return rootsig;
+        if (cached)
+            return *cached;
 
-        rootsig = buildRootSignature(1, &state.shader, false);
+        RootSignatureHandle rootsig = buildRootSignature(1, &state.shader, false);
 
-        m_pResources->rootsigCache[hash] = rootsig;
+        std::vector<RootSignatureHandle> evicted;
+        std::vector<PipelineStateHandle> evictedPSOs;
+        m_pResources->rootsigCache.Insert(key, rootsig, sizeof(RootSignature) + sizeof(RootSignatureKey), evicted);
+        releaseCachedObjects(evicted, evictedPSOs);
         return rootsig;
     }
 
@@ -1705,44 +1910,84 @@ namespace NVRHI
         }
     }
 
-    PipelineStateHandle RendererInterfaceD3D12::getPipelineState(const DrawCallState & state, RootSignatureHandle pRS)
+    template<typename TDrawCallState>
+    PipelineStateHandle RendererInterfaceD3D12::getPipelineState(const TDrawCallState & state, RootSignatureHandle pRS)
     {
-        uint32_t hash = getStateHashForPSO(state);
+        PipelineStateKey key;
+        getStateKeyForPSO(state, key);
+
+        PipelineStateHandle* cached = m_pResources->psoCache.Find(key);
+
+        if (cached)
+            return *cached;
+
+        GraphicsPipelineDesc pipelineDesc;
+        pipelineDesc.primType = state.primType;
+        pipelineDesc.inputLayout = state.inputLayout;
+        pipelineDesc.VS = state.VS.shader;
+        pipelineDesc.HS = state.HS.shader;
+        pipelineDesc.DS = state.DS.shader;
+        pipelineDesc.GS = state.GS.shader;
+        pipelineDesc.PS = state.PS.shader;
+        pipelineDesc.blendState = state.renderState.blendState;
+        pipelineDesc.depthStencilState = state.renderState.depthStencilState;
+        pipelineDesc.rasterState = state.renderState.rasterState;
+        pipelineDesc.setupExtraVoxelizationState = state.renderState.setupExtraVoxelizationState;
+
+        pipelineDesc.renderTargetCount = state.renderState.targetCount;
+        for (uint32_t i = 0; i < state.renderState.targetCount; i++)
+            pipelineDesc.renderTargetFormats[i] = state.renderState.targets[i]->desc.format;
+
+        if (state.renderState.depthTarget)
+            pipelineDesc.depthTargetFormat = state.renderState.depthTarget->desc.format;
+
+        DXGI_SAMPLE_DESC sampleDesc = getStateSampleDesc(state);
+        pipelineDesc.sampleCount = sampleDesc.Count;
+        pipelineDesc.sampleQuality = sampleDesc.Quality;
 
-        PipelineStateHandle pipelineState = m_pResources->psoCache[hash];
+        PipelineStateHandle pipelineState = createPipelineState(pipelineDesc, pRS);
 
         if (pipelineState)
-            return pipelineState;
+        {
+            std::vector<PipelineStateHandle> evicted;
+            m_pResources->psoCache.Insert(key, pipelineState, EstimatePipelineStateBytes(key), evicted);
+            releaseCachedObjects(std::vector<RootSignatureHandle>(), evicted);
+        }
+
+        return pipelineState;
+    }
 
-        pipelineState = new PipelineState();
+    PipelineStateHandle RendererInterfaceD3D12::createPipelineState(const GraphicsPipelineDesc & pipelineDesc, RootSignatureHandle pRS)
+    {
+        PipelineStateHandle pipelineState = new PipelineState();
         pipelineState->rootSignature = pRS;
 
         D3D12_GRAPHICS_PIPELINE_STATE_DESC desc = {};
         desc.pRootSignature = pRS->handle;
 
         ShaderHandle shader;
-        shader = state.VS.shader;
+        shader = pipelineDesc.VS;
         if (shader) desc.VS = { &shader->bytecode[0], shader->bytecode.size() };
 
-        shader = state.HS.shader;
+        shader = pipelineDesc.HS;
         if (shader) desc.HS = { &shader->bytecode[0], shader->bytecode.size() };
 
-        shader = state.DS.shader;
+        shader = pipelineDesc.DS;
         if (shader) desc.DS = { &shader->bytecode[0], shader->bytecode.size() };
 
-        shader = state.GS.shader;
+        shader = pipelineDesc.GS;
         if (shader) desc.GS = { &shader->bytecode[0], shader->bytecode.size() };
 
-        shader = state.PS.shader;
+        shader = pipelineDesc.PS;
         if (shader) desc.PS = { &shader->bytecode[0], shader->bytecode.size() };
             
 
-        const BlendState& blendState = state.renderState.blendState;
+        const BlendState& blendState = pipelineDesc.blendState;
 
         desc.BlendState.AlphaToCoverageEnable = blendState.alphaToCoverage;
         desc.BlendState.IndependentBlendEnable = true;
 
-        for (uint32_t i = 0; i < state.renderState.targetCount; i++)
+        for (uint32_t i = 0; i < pipelineDesc.renderTargetCount; i++)
         {
             desc.BlendState.RenderTarget[i].BlendEnable = blendState.blendEnable[i] ? TRUE : FALSE;
             desc.BlendState.RenderTarget[i].SrcBlend = convertBlendValue(blendState.srcBlend[i]);
@@ -1759,7 +2004,7 @@ namespace NVRHI
         }
 
             
-        const DepthStencilState& depthState = state.renderState.depthStencilState;
+        const DepthStencilState& depthState = pipelineDesc.depthStencilState;
 
         desc.DepthStencilState.DepthEnable = depthState.depthEnable ? TRUE : FALSE;
         desc.DepthStencilState.DepthWriteMask = depthState.depthWriteMask == DepthStencilState::DEPTH_WRITE_MASK_ALL ? D3D12_DEPTH_WRITE_MASK_ALL : D3D12_DEPTH_WRITE_MASK_ZERO;
@@ -1776,14 +2021,14 @@ namespace NVRHI
         desc.DepthStencilState.BackFace.StencilPassOp = convertStencilOp(depthState.backFace.stencilPassOp);
         desc.DepthStencilState.BackFace.StencilFunc = convertComparisonFunc(depthState.backFace.stencilFunc);
 
-        if ((depthState.depthEnable || depthState.stencilEnable) && state.renderState.depthTarget == nullptr)
+        if ((depthState.depthEnable || depthState.stencilEnable) && pipelineDesc.depthTargetFormat == Format::UNKNOWN)
         {
             desc.DepthStencilState.DepthEnable = FALSE;
             desc.DepthStencilState.StencilEnable = FALSE;
             OutputDebugStringA("WARNING: depthEnable or stencilEnable is true, but no depth target is bound\n");
         }
 
-        const RasterState& rasterState = state.renderState.rasterState;
+        const RasterState& rasterState = pipelineDesc.rasterState;
 
         switch (rasterState.fillMode)
         {
@@ -1822,7 +2067,7 @@ namespace NVRHI
         desc.RasterizerState.ConservativeRaster = rasterState.conservativeRasterEnable ? D3D12_CONSERVATIVE_RASTERIZATION_MODE_ON : D3D12_CONSERVATIVE_RASTERIZATION_MODE_OFF;
         desc.RasterizerState.ForcedSampleCount = rasterState.forcedSampleCount;
 
-        switch (state.primType)
+        switch (pipelineDesc.primType)
         {
         case PrimitiveType::POINT_LIST:
             desc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_POINT;
@@ -1837,33 +2082,34 @@ namespace NVRHI
             break;
         }
 
-        if (state.renderState.depthTarget)
-            desc.DSVFormat = GetFormatMapping(state.renderState.depthTarget->desc.format).rtvFormat;
+        if (pipelineDesc.depthTargetFormat != Format::UNKNOWN)
+            desc.DSVFormat = GetFormatMapping(pipelineDesc.depthTargetFormat).rtvFormat;
 
-        desc.SampleDesc = getStateSampleDesc(state);
+        desc.SampleDesc.Count = pipelineDesc.sampleCount;
+        desc.SampleDesc.Quality = pipelineDesc.sampleQuality;
             
-        for (uint32_t i = 0; i < state.renderState.targetCount; i++)
+        for (uint32_t i = 0; i < pipelineDesc.renderTargetCount; i++)
         {
-            desc.RTVFormats[i] = GetFormatMapping(state.renderState.targets[i]->desc.format).rtvFormat;
+            desc.RTVFormats[i] = GetFormatMapping(pipelineDesc.renderTargetFormats[i]).rtvFormat;
         }
 
-        if (state.inputLayout && !state.inputLayout->inputElements.empty())
+        if (pipelineDesc.inputLayout && !pipelineDesc.inputLayout->inputElements.empty())
         {
-            desc.InputLayout.NumElements = uint32_t(state.inputLayout->inputElements.size());
-            desc.InputLayout.pInputElementDescs = &(state.inputLayout->inputElements[0]);
+            desc.InputLayout.NumElements = uint32_t(pipelineDesc.inputLayout->inputElements.size());
+            desc.InputLayout.pInputElementDescs = &(pipelineDesc.inputLayout->inputElements[0]);
         }
 
-        desc.NumRenderTargets = state.renderState.targetCount;
+        desc.NumRenderTargets = pipelineDesc.renderTargetCount;
         desc.SampleMask = ~0u;
             
 #if NVRHI_D3D12_WITH_NVAPI
         std::vector<const NVAPI_D3D12_PSO_EXTENSION_DESC*> extensions;
 
-        shader = state.VS.shader; if (shader) extensions.insert(extensions.end(), shader->extensions.begin(), shader->extensions.end());
-        shader = state.HS.shader; if (shader) extensions.insert(extensions.end(), shader->extensions.begin(), shader->extensions.end());
-        shader = state.DS.shader; if (shader) extensions.insert(extensions.end(), shader->extensions.begin(), shader->extensions.end());
-        shader = state.GS.shader; if (shader) extensions.insert(extensions.end(), shader->extensions.begin(), shader->extensions.end());
-        shader = state.PS.shader; if (shader) extensions.insert(extensions.end(), shader->extensions.begin(), shader->extensions.end());
+        shader = pipelineDesc.VS; if (shader) extensions.insert(extensions.end(), shader->extensions.begin(), shader->extensions.end());
+        shader = pipelineDesc.HS; if (shader) extensions.insert(extensions.end(), shader->extensions.begin(), shader->extensions.end());
+        shader = pipelineDesc.DS; if (shader) extensions.insert(extensions.end(), shader->extensions.begin(), shader->extensions.end());
+        shader = pipelineDesc.GS; if (shader) extensions.insert(extensions.end(), shader->extensions.begin(), shader->extensions.end());
+        shader = pipelineDesc.PS; if (shader) extensions.insert(extensions.end(), shader->extensions.begin(), shader->extensions.end());
 
         if (extensions.size() > 0)
         {
@@ -1872,10 +2118,10 @@ namespace NVRHI
             if (status != NVAPI_OK || pipelineState->handle == nullptr)
             {
                 SIGNAL_ERROR("Failed to create a graphics pipeline state object with NVAPI extensions");
+                delete pipelineState;
                 return nullptr;
             }
 
-            m_pResources->psoCache[hash] = pipelineState;
             return pipelineState;
         }
 #endif
@@ -1886,40 +2132,59 @@ namespace NVRHI
         if (FAILED(hr))
         {
             SIGNAL_ERROR("Failed to create a graphics pipeline state object");
+            delete pipelineState;
             return nullptr;
         }
 
-        m_pResources->psoCache[hash] = pipelineState;
         return pipelineState;
     }
 
-    PipelineStateHandle RendererInterfaceD3D12::getPipelineState(const DispatchState & state, RootSignatureHandle pRS, uint32_t hash)
+    PipelineStateHandle RendererInterfaceD3D12::getPipelineState(const DispatchState & state, RootSignatureHandle pRS)
     {
-        PipelineStateHandle pipelineState = m_pResources->psoCache[hash];
+        PipelineStateKey key;
+        memset(&key, 0, sizeof(key));
+        key.shaders[0] = state.shader;
+        key.compute = 1;
+
+        PipelineStateHandle* cached = m_pResources->psoCache.Find(key);
+
+        if (cached)
+            return *cached;
+
+        PipelineStateHandle pipelineState = createPipelineState(state.shader, pRS);
 
         if (pipelineState)
-            return pipelineState;
+        {
+            std::vector<PipelineStateHandle> evicted;
+            m_pResources->psoCache.Insert(key, pipelineState, EstimatePipelineStateBytes(key), evicted);
+            releaseCachedObjects(std::vector<RootSignatureHandle>(), evicted);
+        }
 
-        pipelineState = new PipelineState();
+        return pipelineState;
+    }
+
+    PipelineStateHandle RendererInterfaceD3D12::createPipelineState(ShaderHandle computeShader, RootSignatureHandle pRS)
+    {
+        PipelineStateHandle pipelineState = new PipelineState();
         pipelineState->rootSignature = pRS;
 
         D3D12_COMPUTE_PIPELINE_STATE_DESC desc = {};
 
         desc.pRootSignature = pRS->handle;
-        desc.CS = { &state.shader->bytecode[0], state.shader->bytecode.size() };
+        desc.CS = { &computeShader->bytecode[0], computeShader->bytecode.size() };
 
 #if NVRHI_D3D12_WITH_NVAPI
-        if (state.shader->extensions.size() > 0)
+        if (computeShader->extensions.size() > 0)
         {
-            NvAPI_Status status = NVAPI_NOT_SUPPORTED;// NvAPI_D3D12_CreateComputePipelineState(m_pDevice, &desc, NvU32(state.shader->extensions.size()), &state.shader->extensions[0], &pipelineState->handle);
+            NvAPI_Status status = NVAPI_NOT_SUPPORTED;// NvAPI_D3D12_CreateComputePipelineState(m_pDevice, &desc, NvU32(computeShader->extensions.size()), &computeShader->extensions[0], &pipelineState->handle);
 
             if (status != NVAPI_OK || pipelineState->handle == nullptr)
             {
                 SIGNAL_ERROR("Failed to create a compute pipeline state object with NVAPI extensions");
+                delete pipelineState;
                 return nullptr;
             }
 
-            m_pResources->psoCache[hash] = pipelineState;
             return pipelineState;
         }
 #endif
@@ -1930,10 +2195,10 @@ namespace NVRHI
         if (FAILED(hr))
         {
             SIGNAL_ERROR("Failed to create a compute pipeline state object");
+            delete pipelineState;
             return nullptr;
         }
 
-        m_pResources->psoCache[hash] = pipelineState;
         return pipelineState;
     }
 
@@ -2467,7 +2732,8 @@ namespace NVRHI
         m_pResources->barrier.clear();
     }
 
-    void RendererInterfaceD3D12::bindShaderResources(uint32_t & rootIndex, void* rootDescriptorTableHandles, const PipelineStageBindings& stage)
+    template<typename TStageBindings>
+    void RendererInterfaceD3D12::bindShaderResources(uint32_t & rootIndex, void* rootDescriptorTableHandles, const TStageBindings& stage)
     {
         D3D12_CPU_DESCRIPTOR_HANDLE nullDescriptor;
         D3D12_CPU_DESCRIPTOR_HANDLE copySources[256];
@@ -2652,94 +2918,323 @@ namespace NVRHI
         }
     }
 
-    void RendererInterfaceD3D12::syncWithGPU(const char* reason)
-    {
-        flushCommandList();
-        m_pResources->WaitForFence(m_pResources->fenceCounter, reason);
-    }
-
-    void RendererInterfaceD3D12::waitForFence(unsigned long long fenceValue, const char* reason)
-    {
-        flushCommandList();
-        m_pResources->WaitForFence(fenceValue, reason);
-    }
-
-    TextureHandle RendererInterfaceD3D12::createTexture(const TextureDesc & d, const void * data)
+    void RendererInterfaceD3D12::bakeDescriptorTables(const PipelineStageBindings& stage, StageDescriptorTables& tables)
     {
-        TextureHandle texture = new Texture();
-        texture->desc = d;
-        texture->isManaged = true;
-        texture->parent = this;
-        texture->desc.depthOrArraySize = std::max(d.depthOrArraySize, 1u);
-
-        const auto& formatMapping = GetFormatMapping(d.format);
+        ShaderHandle shader = stage.shader;
+        tables.shader = shader;
 
-        D3D12_RESOURCE_DESC desc = {};
-        desc.Width = d.width;
-        desc.Height = d.height;
-        desc.DepthOrArraySize = UINT16(texture->desc.depthOrArraySize);
-        desc.MipLevels = UINT16(d.mipLevels);
-        desc.Format = formatMapping.resourceFormat;
-        desc.SampleDesc.Count = d.sampleCount;
-        desc.SampleDesc.Quality = d.sampleQuality;
+        const uint32_t offsetSRV = shader->numCB;
+        const uint32_t offsetUAV = shader->numCB + shader->numSRV;
 
-        if (d.depthOrArraySize > 1 && !d.isArray && !d.isCubeMap)
-            desc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE3D;
-        else
-            desc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+        tables.descriptors.resize(shader->numBindings);
+        std::fill(tables.descriptors.begin(), tables.descriptors.begin() + offsetSRV, m_pResources->nullCBV);
+        std::fill(tables.descriptors.begin() + offsetSRV, tables.descriptors.begin() + offsetUAV, m_pResources->nullSRV);
+        std::fill(tables.descriptors.begin() + offsetUAV, tables.descriptors.end(), m_pResources->nullUAV);
+        tables.samplers.assign(shader->numSamplers, m_pResources->nullSampler);
 
-        if (d.isRenderTarget)
+        for (uint32_t i = 0; i < stage.constantBufferBindingCount; i++)
         {
-            if (formatMapping.isDepthStencil)
-                desc.Flags |= D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
+            const ConstantBufferBinding& binding = stage.constantBuffers[i];
+            if (!binding.buffer)
+                continue;
+
+            if (shader->slotsCB[binding.slot])
+            {
+                tables.descriptors[binding.slot - shader->minCB] = getCBV(binding.buffer);
+                tables.constantBuffers.push_back(binding.buffer);
+            }
             else
-                desc.Flags |= D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET;
+                DEBUG_PRINT("WARNING: attempted CB binding to a slot unused by shader\n");
         }
 
-        if (d.isUAV)
-            desc.Flags |= D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
-
-        D3D12_HEAP_PROPERTIES heapProps = {};
-        heapProps.Type = D3D12_HEAP_TYPE_DEFAULT;
-
-        D3D12_CLEAR_VALUE clearValue = {};
-        clearValue.Format = formatMapping.rtvFormat;
-        if (formatMapping.isDepthStencil)
-        {
-            clearValue.DepthStencil.Depth = d.clearValue.r;
-            clearValue.DepthStencil.Stencil = UINT8(d.clearValue.g);
-        }
-        else
+        for (uint32_t i = 0; i < stage.textureBindingCount; i++)
         {
-            clearValue.Color[0] = d.clearValue.r;
-            clearValue.Color[1] = d.clearValue.g;
-            clearValue.Color[2] = d.clearValue.b;
-            clearValue.Color[3] = d.clearValue.a;
-        }
+            const TextureBinding& binding = stage.textures[i];
+            if (!binding.texture)
+                continue;
 
-        HRESULT hr = m_pDevice->CreateCommittedResource(
-            &heapProps, 
-            D3D12_HEAP_FLAG_NONE, 
-            &desc, 
-            D3D12_RESOURCE_STATE_COMMON, 
-            d.useClearValue ? &clearValue : nullptr, 
-            IID_PPV_ARGS(&texture->resource));
+            StageDescriptorTables::RequiredTextureState required = { binding.texture, binding.mipLevel, 0 };
 
-        CHECK_ERROR(SUCCEEDED(hr), "Failed to create a texture");
+            if (binding.isWritable && shader->slotsUAV[binding.slot])
+            {
+                tables.descriptors[offsetUAV + binding.slot - shader->minUAV] = getTextureUAV(binding);
+                required.state = D3D12_RESOURCE_STATE_UNORDERED_ACCESS;
+            }
+            else if (!binding.isWritable && shader->slotsSRV[binding.slot])
+            {
+                tables.descriptors[offsetSRV + binding.slot - shader->minSRV] = getTextureSRV(binding);
+                required.state = shader->type == ShaderType::SHADER_PIXEL
+                    ? D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE
+                    : D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
+            }
+            else
+            {
+                DEBUG_PRINT("WARNING: attempted texture binding to a slot unused by shader\n");
+                continue;
+            }
 
-        if (FAILED(hr))
-        {
-            delete texture;
-            return nullptr;
+            tables.textureStates.push_back(required);
         }
 
-        if (d.debugName)
-            D3D_SET_OBJECT_NAME_N_A(texture->resource, uint32_t(strlen(d.debugName)), d.debugName);
+        for (uint32_t i = 0; i < stage.bufferBindingCount; i++)
+        {
+            const BufferBinding& binding = stage.buffers[i];
+            if (!binding.buffer)
+                continue;
 
-        uint32_t numSubresources = d.mipLevels;
-        if (d.isArray || d.isCubeMap)
-            numSubresources *= texture->desc.depthOrArraySize;
-        texture->subresourceStates.resize(numSubresources, D3D12_RESOURCE_STATE_COMMON);
+            StageDescriptorTables::RequiredBufferState required = { binding.buffer, 0 };
+
+            if (binding.isWritable && shader->slotsUAV[binding.slot])
+            {
+                tables.descriptors[offsetUAV + binding.slot - shader->minUAV] = getBufferUAV(binding);
+                required.state = D3D12_RESOURCE_STATE_UNORDERED_ACCESS;
+            }
+            else if (!binding.isWritable && shader->slotsSRV[binding.slot])
+            {
+                tables.descriptors[offsetSRV + binding.slot - shader->minSRV] = getBufferSRV(binding);
+                required.state = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
+            }
+            else
+            {
+                DEBUG_PRINT("WARNING: attempted buffer binding to a slot unused by shader\n");
+                continue;
+            }
+
+            tables.bufferStates.push_back(required);
+        }
+
+        for (uint32_t i = 0; i < stage.textureSamplerBindingCount; i++)
+        {
+            const SamplerBinding& binding = stage.textureSamplers[i];
+            if (!binding.sampler)
+                continue;
+
+            if (shader->slotsSampler[binding.slot])
+                tables.samplers[binding.slot - shader->minSampler] = getSamplerView(binding.sampler);
+            else
+                DEBUG_PRINT("WARNING: attempted sampler binding to a slot unused by shader\n");
+        }
+    }
+
+    void RendererInterfaceD3D12::bindDescriptorTables(uint32_t& rootIndex, void* rootDescriptorTableHandles, const StageDescriptorTables& tables)
+    {
+        D3D12_CPU_DESCRIPTOR_HANDLE copySources[256];
+        ShaderHandle shader = tables.shader;
+
+        // Upload the constant buffers that were written since the last use; their descriptor indices do not change
+        for (auto cbuffer : tables.constantBuffers)
+            getCBV(cbuffer);
+
+        for (const auto& required : tables.textureStates)
+            requireTextureState(required.texture, ~0u, required.mipLevel, required.state);
+
+        for (const auto& required : tables.bufferStates)
+            requireBufferState(required.buffer, required.state);
+
+        if (shader->numBindings > 0)
+        {
+            for (uint32_t i = 0; i < shader->numBindings; i++)
+                copySources[i] = m_pResources->dhSRVstatic.GetCpuHandle(tables.descriptors[i]);
+
+            DescriptorIndex baseDescriptorIndex;
+            m_pResources->dhSRVetc.AllocateDescriptors(shader->numBindings, baseDescriptorIndex);
+            D3D12_CPU_DESCRIPTOR_HANDLE baseDescriptor = m_pResources->dhSRVetc.GetCpuHandle(baseDescriptorIndex);
+
+            m_pDevice->CopyDescriptors(1, &baseDescriptor, &shader->numBindings, shader->numBindings, copySources, nullptr, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+
+            ((D3D12_GPU_DESCRIPTOR_HANDLE*)rootDescriptorTableHandles)[rootIndex] = m_pResources->dhSRVetc.GetGpuHandle(baseDescriptorIndex);
+            rootIndex++;
+        }
+
+        if (shader->numSamplers > 0)
+        {
+            for (uint32_t i = 0; i < shader->numSamplers; i++)
+                copySources[i] = m_pResources->dhSamplerStatic.GetCpuHandle(tables.samplers[i]);
+
+            DescriptorIndex baseDescriptorIndex;
+            m_pResources->dhSamplers.AllocateDescriptors(shader->numSamplers, baseDescriptorIndex);
+            D3D12_CPU_DESCRIPTOR_HANDLE baseDescriptor = m_pResources->dhSamplers.GetCpuHandle(baseDescriptorIndex);
+
+            m_pDevice->CopyDescriptors(1, &baseDescriptor, &shader->numSamplers, shader->numSamplers, copySources, nullptr, D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER);
+
+            ((D3D12_GPU_DESCRIPTOR_HANDLE*)rootDescriptorTableHandles)[rootIndex] = m_pResources->dhSamplers.GetGpuHandle(baseDescriptorIndex);
+            rootIndex++;
+        }
+    }
+
+    void RendererInterfaceD3D12::syncWithGPU(const char* reason)
+    {
+        flushCommandList();
+        m_pResources->WaitForFence(m_pResources->fenceCounter, reason);
+    }
+
+    void RendererInterfaceD3D12::waitForFence(unsigned long long fenceValue, const char* reason)
+    {
+        flushCommandList();
+        m_pResources->WaitForFence(fenceValue, reason);
+    }
+
+    void RendererInterfaceD3D12::retireCompletedFrames()
+    {
+        // Nothing has been submitted yet, and the rings have no fence pointers to release
+        if (m_pResources->fenceCounter == 0)
+            return;
+
+        UINT64 completed = m_pResources->fence->GetCompletedValue();
+
+        auto& frames = m_pResources->frameFenceValues;
+        while (!frames.empty() && frames.front() <= completed)
+            frames.pop_front();
+
+        m_pResources->ReleaseCompletedResources(completed);
+    }
+
+    void RendererInterfaceD3D12::setMaxFramesInFlight(uint32_t maxFrames)
+    {
+        m_pResources->maxFramesInFlight = std::max(maxFrames, 1u);
+    }
+
+    void RendererInterfaceD3D12::beginFrame()
+    {
+        // Only block when the GPU is more than the allowed number of frames behind
+        auto& frames = m_pResources->frameFenceValues;
+        while (frames.size() >= m_pResources->maxFramesInFlight)
+        {
+            UINT64 fenceValue = frames.front();
+            frames.pop_front();
+            waitForFence(fenceValue, "FrameLatency");
+        }
+
+        retireCompletedFrames();
+    }
+
+    void RendererInterfaceD3D12::endFrame()
+    {
+        flushCommandList();
+
+        m_pResources->frameFenceValues.push_back(m_pResources->fenceCounter);
+        m_pResources->frameIndex++;
+
+        retireCompletedFrames();
+    }
+
+    FrameStatistics RendererInterfaceD3D12::getFrameStatistics()
+    {
+        UINT64 completed = m_pResources->fence->GetCompletedValue();
+
+        FrameStatistics stats;
+        stats.frameIndex = m_pResources->frameIndex;
+        stats.framesInFlight = uint32_t(std::count_if(m_pResources->frameFenceValues.begin(), m_pResources->frameFenceValues.end(),
+            [completed](UINT64 value) { return value > completed; }));
+        stats.pendingDeletions = uint32_t(m_pResources->deletedResources.size());
+        stats.uploadBytes = m_pResources->upload.GetStatistics();
+        stats.viewDescriptors = m_pResources->dhSRVetc.GetStatistics();
+        stats.samplerDescriptors = m_pResources->dhSamplers.GetStatistics();
+        stats.readbackBytes = m_pResources->UpdateReadbackStatistics();
+        AccumulateCacheStatistics(stats.stateObjects, m_pResources->psoCache.GetStatistics());
+        AccumulateCacheStatistics(stats.stateObjects, m_pResources->rootsigCache.GetStatistics());
+        return stats;
+    }
+
+    void RendererInterfaceD3D12::setStateCacheLimits(uint32_t maxEntries, uint64_t maxBytes)
+    {
+        std::vector<RootSignatureHandle> evictedRootsigs;
+        std::vector<PipelineStateHandle> evictedPSOs;
+        m_pResources->rootsigCache.SetLimits(maxEntries, maxBytes, evictedRootsigs);
+        m_pResources->psoCache.SetLimits(maxEntries, maxBytes, evictedPSOs);
+        releaseCachedObjects(evictedRootsigs, evictedPSOs);
+    }
+
+    void RendererInterfaceD3D12::releaseCachedObjects(const std::vector<RootSignatureHandle>& rootsigs, std::vector<PipelineStateHandle>& psos)
+    {
+        // Pipeline states only hold a weak reference to their root signature, so they go together with it.
+        // The deleted pool keeps the objects until the GPU has passed their last use.
+        for (auto rootsig : rootsigs)
+        {
+            m_pResources->psoCache.EraseIf([rootsig](PipelineStateHandle pso) { return pso->rootSignature == rootsig; }, psos);
+            m_pResources->deletedResources.insert(rootsig);
+        }
+
+        for (auto pso : psos)
+            m_pResources->deletedResources.insert(pso);
+    }
+
+    TextureHandle RendererInterfaceD3D12::createTexture(const TextureDesc & d, const void * data)
+    {
+        TextureHandle texture = new Texture();
+        texture->desc = d;
+        texture->isManaged = true;
+        texture->parent = this;
+        texture->desc.depthOrArraySize = std::max(d.depthOrArraySize, 1u);
+
+        const auto& formatMapping = GetFormatMapping(d.format);
+
+        D3D12_RESOURCE_DESC desc = {};
+        desc.Width = d.width;
+        desc.Height = d.height;
+        desc.DepthOrArraySize = UINT16(texture->desc.depthOrArraySize);
+        desc.MipLevels = UINT16(d.mipLevels);
+        desc.Format = formatMapping.resourceFormat;
+        desc.SampleDesc.Count = d.sampleCount;
+        desc.SampleDesc.Quality = d.sampleQuality;
+
+        if (d.depthOrArraySize > 1 && !d.isArray && !d.isCubeMap)
+            desc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE3D;
+        else
+            desc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+
+        if (d.isRenderTarget)
+        {
+            if (formatMapping.isDepthStencil)
+                desc.Flags |= D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
+            else
+                desc.Flags |= D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET;
+        }
+
+        if (d.isUAV)
+            desc.Flags |= D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
+
+        D3D12_HEAP_PROPERTIES heapProps = {};
+        heapProps.Type = D3D12_HEAP_TYPE_DEFAULT;
+
+        D3D12_CLEAR_VALUE clearValue = {};
+        clearValue.Format = formatMapping.rtvFormat;
+        if (formatMapping.isDepthStencil)
+        {
+            clearValue.DepthStencil.Depth = d.clearValue.r;
+            clearValue.DepthStencil.Stencil = UINT8(d.clearValue.g);
+        }
+        else
+        {
+            clearValue.Color[0] = d.clearValue.r;
+            clearValue.Color[1] = d.clearValue.g;
+            clearValue.Color[2] = d.clearValue.b;
+            clearValue.Color[3] = d.clearValue.a;
+        }
+
+        HRESULT hr = m_pDevice->CreateCommittedResource(
+            &heapProps, 
+            D3D12_HEAP_FLAG_NONE, 
+            &desc, 
+            D3D12_RESOURCE_STATE_COMMON, 
+            d.useClearValue ? &clearValue : nullptr, 
+            IID_PPV_ARGS(&texture->resource));
+
+        CHECK_ERROR(SUCCEEDED(hr), "Failed to create a texture");
+
+        if (FAILED(hr))
+        {
+            delete texture;
+            return nullptr;
+        }
+
+        if (d.debugName)
+            D3D_SET_OBJECT_NAME_N_A(texture->resource, uint32_t(strlen(d.debugName)), d.debugName);
+
+        uint32_t numSubresources = d.mipLevels;
+        if (d.isArray || d.isCubeMap)
+            numSubresources *= texture->desc.depthOrArraySize;
+        texture->subresourceStates.resize(numSubresources, D3D12_RESOURCE_STATE_COMMON);
 
         m_pResources->textures.insert(texture);
 
@@ -2859,8 +3354,139 @@ namespace NVRHI
         loadBalanceCommandList();
     }
 
+    void RendererInterfaceD3D12::clearTextureRegionFloat(TextureHandle t, const TextureRegion& region, const Color& clearColor)
+    {
+        clearTextureRegion(t, region, false, clearColor, 0);
+    }
+
+    void RendererInterfaceD3D12::clearTextureRegionUInt(TextureHandle t, const TextureRegion& region, uint32_t clearColor)
+    {
+        clearTextureRegion(t, region, true, Color(float(clearColor)), clearColor);
+    }
+
+    void RendererInterfaceD3D12::clearTextureRegion(TextureHandle t, const TextureRegion& region, bool asUINT, const Color& clearColor, uint32_t clearValue)
+    {
+        if (!t || !region.isValid(t->desc))
+        {
+            SIGNAL_ERROR("Invalid texture clear region");
+            return;
+        }
+
+        TextureRegion box = region.resolve(t->desc);
+        if (box.width == 0 || box.height == 0 || box.depth == 0)
+            return;
+
+        const auto& formatMapping = GetFormatMapping(t->desc.format);
+        bool is3D = t->resource->GetDesc().Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D;
+        uint32_t arraySlice = is3D ? 0 : box.arraySlice;
+
+        // The rectangle limits the clear in X and Y, the view limits it to the mip level and the slices
+        D3D12_RECT rect = { LONG(box.x), LONG(box.y), LONG(box.x + box.width), LONG(box.y + box.height) };
+
+        if (!asUINT && t->desc.isRenderTarget)
+        {
+            // RTVs and DSVs of 3D textures are not supported by getRTV and getDSV
+            if (is3D)
+            {
+                SIGNAL_ERROR("Region clears of 3D render targets are not supported, create the texture as a UAV");
+                return;
+            }
+
+            if (formatMapping.isDepthStencil)
+            {
+                requireTextureState(t, arraySlice, box.mipLevel, D3D12_RESOURCE_STATE_DEPTH_WRITE);
+                commitBarriers();
+
+                DescriptorIndex index = getDSV(t, arraySlice, box.mipLevel);
+
+                m_ActiveCommandList->commandList->ClearDepthStencilView(
+                    m_pResources->dhDSV.GetCpuHandle(index),
+                    D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL,
+                    clearColor.r, UINT8(clearColor.g),
+                    1, &rect);
+            }
+            else
+            {
+                requireTextureState(t, arraySlice, box.mipLevel, D3D12_RESOURCE_STATE_RENDER_TARGET);
+                commitBarriers();
+
+                DescriptorIndex index = getRTV(t, arraySlice, box.mipLevel);
+
+                m_ActiveCommandList->commandList->ClearRenderTargetView(
+                    m_pResources->dhRTV.GetCpuHandle(index),
+                    &clearColor.r,
+                    1, &rect);
+            }
+        }
+        else
+        {
+            CHECK_ERROR(t->desc.isUAV, "cannot clear a non-UAV texture as uint");
+            if (!t->desc.isUAV)
+                return;
+
+            requireTextureState(t, arraySlice, box.mipLevel, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+            commitBarriers();
+
+            // A temporary view that covers exactly the mip level and the slices of the region
+            D3D12_UNORDERED_ACCESS_VIEW_DESC desc = {};
+            desc.Format = GetFormatMapping(asUINT && formatMapping.bytesPerPixel == 4 ? Format::R32_UINT : t->desc.format).srvFormat;
+
+            if (t->desc.isArray || t->desc.isCubeMap)
+            {
+                desc.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2DARRAY;
+                desc.Texture2DArray.FirstArraySlice = box.arraySlice;
+                desc.Texture2DArray.ArraySize = 1;
+                desc.Texture2DArray.MipSlice = box.mipLevel;
+            }
+            else if (is3D)
+            {
+                desc.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE3D;
+                desc.Texture3D.FirstWSlice = box.z;
+                desc.Texture3D.WSize = box.depth;
+                desc.Texture3D.MipSlice = box.mipLevel;
+            }
+            else
+            {
+                desc.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D;
+                desc.Texture2D.MipSlice = box.mipLevel;
+            }
+
+            DescriptorIndex indexCpu = m_pResources->dhSRVstatic.AllocateDescriptor();
+            D3D12_CPU_DESCRIPTOR_HANDLE descriptorCpu = m_pResources->dhSRVstatic.GetCpuHandle(indexCpu);
+            m_pDevice->CreateUnorderedAccessView(t->resource, nullptr, &desc, descriptorCpu);
+
+            DescriptorIndex indexGpu;
+            m_pResources->dhSRVetc.AllocateDescriptors(1, indexGpu);
+
+            m_pDevice->CopyDescriptorsSimple(1, m_pResources->dhSRVetc.GetCpuHandle(indexGpu), descriptorCpu, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+
+            if (asUINT)
+            {
+                uint32_t clearValues[4] = { clearValue, clearValue, clearValue, clearValue };
+                m_ActiveCommandList->commandList->ClearUnorderedAccessViewUint(m_pResources->dhSRVetc.GetGpuHandle(indexGpu), descriptorCpu, t->resource, clearValues, 1, &rect);
+            }
+            else
+            {
+                m_ActiveCommandList->commandList->ClearUnorderedAccessViewFloat(m_pResources->dhSRVetc.GetGpuHandle(indexGpu), descriptorCpu, t->resource, &clearColor.r, 1, &rect);
+            }
+
+            // The CPU descriptor is only read while the clear is recorded
+            m_pResources->dhSRVstatic.ReleaseDescriptor(indexCpu);
+        }
+
+        m_ActiveCommandList->size++;
+        loadBalanceCommandList();
+    }
+
     void RendererInterfaceD3D12::writeTexture(TextureHandle t, uint32_t subresource, const void * data, uint32_t rowPitch, uint32_t depthPitch)
     {
+        uint32_t mipLevels = t ? std::max(1u, t->desc.mipLevels) : 1;
+        if (!t || !data || !TextureRegion(subresource % mipLevels, subresource / mipLevels).isValid(t->desc))
+        {
+            SIGNAL_ERROR("Invalid texture write");
+            return;
+        }
+
         D3D12_RESOURCE_DESC desc = t->resource->GetDesc();
         D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint;
             
@@ -2893,26 +3519,240 @@ namespace NVRHI
         loadBalanceCommandList();
     }
 
-    void RendererInterfaceD3D12::destroyTexture(TextureHandle t)
+    void RendererInterfaceD3D12::writeTextureRegion(TextureHandle t, const TextureRegion& region, const void* data, uint32_t rowPitch, uint32_t depthPitch)
     {
-        if (t == nullptr)
+        if (!t || !data || !region.isValid(t->desc) || t->desc.sampleCount > 1)
+        {
+            SIGNAL_ERROR("Invalid texture write");
             return;
+        }
 
-        m_pResources->textures.erase(t);
-        m_pResources->deletedResources.insert(t);
-    }
+        TextureRegion box = region.resolve(t->desc);
+        if (box.width == 0 || box.height == 0 || box.depth == 0)
+            return;
 
-    BufferHandle RendererInterfaceD3D12::createBuffer(const BufferDesc & d, const void * data)
-    {
-        BufferHandle buffer = new Buffer();
-        buffer->desc = d;
-        buffer->parent = this;
+        D3D12_RESOURCE_DESC desc = t->resource->GetDesc();
+        bool is3D = desc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D;
 
-        D3D12_RESOURCE_DESC desc = {};
-        desc.Width = d.byteSize;
-        desc.Height = 1;
-        desc.DepthOrArraySize = 1;
-        desc.MipLevels = 1;
+        // Get the footprint of a texture that is exactly as large as the region, so only the region goes through the upload buffer
+        D3D12_RESOURCE_DESC regionDesc = desc;
+        regionDesc.Width = box.width;
+        regionDesc.Height = box.height;
+        regionDesc.DepthOrArraySize = UINT16(is3D ? box.depth : 1);
+        regionDesc.MipLevels = 1;
+        regionDesc.Alignment = 0;
+
+        D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint;
+        UINT numRows;
+        UINT64 rowSizeInBytes;
+        UINT64 footprintBytes;
+        m_pDevice->GetCopyableFootprints(&regionDesc, 0, 1, 0, &footprint, &numRows, &rowSizeInBytes, &footprintBytes);
+        footprint.Offset = m_pResources->upload.SuballocateBuffer(footprintBytes, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+
+        for (uint32_t plane = 0; plane < footprint.Footprint.Depth; plane++)
+        {
+            for (uint32_t row = 0; row < numRows; row++)
+            {
+                void* destAddress = m_pResources->upload.GetCpuVA(footprint.Offset + footprint.Footprint.RowPitch * (row + plane * numRows));
+                void* srcAddress = (char*)data + rowPitch * row + depthPitch * plane;
+                memcpy(destAddress, srcAddress, std::min(UINT64(rowPitch), rowSizeInBytes));
+            }
+        }
+
+        requireTextureState(t, is3D ? 0 : box.arraySlice, box.mipLevel, D3D12_RESOURCE_STATE_COPY_DEST);
+        commitBarriers();
+
+        D3D12_TEXTURE_COPY_LOCATION dest = {};
+        dest.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+        dest.SubresourceIndex = (is3D ? 0 : box.arraySlice) * t->desc.mipLevels + box.mipLevel;
+        dest.pResource = t->resource;
+
+        D3D12_TEXTURE_COPY_LOCATION src = {};
+        src.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+        src.PlacedFootprint = footprint;
+        src.pResource = m_pResources->upload.GetBuffer();
+
+        m_ActiveCommandList->commandList->CopyTextureRegion(&dest, box.x, box.y, box.z, &src, nullptr);
+        m_ActiveCommandList->size++;
+        loadBalanceCommandList();
+    }
+
+    void RendererInterfaceD3D12::copyTexture(TextureHandle dest, const TextureRegion& destRegion, TextureHandle src, const TextureRegion& srcRegion)
+    {
+        if (!dest || !src || !destRegion.isValid(dest->desc) || !srcRegion.isValid(src->desc))
+        {
+            SIGNAL_ERROR("Invalid texture copy");
+            return;
+        }
+
+        TextureRegion box = srcRegion.resolve(src->desc);
+        if (box.width == 0 || box.height == 0 || box.depth == 0)
+            return;
+
+        uint32_t destArraySlice = dest->resource->GetDesc().Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D ? 0 : destRegion.arraySlice;
+        uint32_t srcArraySlice = src->resource->GetDesc().Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D ? 0 : box.arraySlice;
+
+        requireTextureState(dest, destArraySlice, destRegion.mipLevel, D3D12_RESOURCE_STATE_COPY_DEST);
+        requireTextureState(src, srcArraySlice, box.mipLevel, D3D12_RESOURCE_STATE_COPY_SOURCE);
+        commitBarriers();
+
+        D3D12_TEXTURE_COPY_LOCATION destLocation = {};
+        destLocation.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+        destLocation.SubresourceIndex = destArraySlice * dest->desc.mipLevels + destRegion.mipLevel;
+        destLocation.pResource = dest->resource;
+
+        D3D12_TEXTURE_COPY_LOCATION srcLocation = {};
+        srcLocation.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+        srcLocation.SubresourceIndex = srcArraySlice * src->desc.mipLevels + box.mipLevel;
+        srcLocation.pResource = src->resource;
+
+        // Depth-stencil and multisampled resources can only be copied as whole subresources, which is what a null box means
+        TextureRegion wholeMip = TextureRegion(box.mipLevel, box.arraySlice).resolve(src->desc);
+        bool wholeSubresource = box.x == 0 && box.y == 0 && box.z == 0 && box.width == wholeMip.width && box.height == wholeMip.height && box.depth == wholeMip.depth;
+
+        D3D12_BOX srcBox = { box.x, box.y, box.z, box.x + box.width, box.y + box.height, box.z + box.depth };
+
+        m_ActiveCommandList->commandList->CopyTextureRegion(&destLocation, destRegion.x, destRegion.y, destRegion.z, &srcLocation, wholeSubresource ? nullptr : &srcBox);
+        m_ActiveCommandList->size++;
+        loadBalanceCommandList();
+    }
+
+    // Describes a region of a texture stored in a buffer with the application's pitches
+    static D3D12_PLACED_SUBRESOURCE_FOOTPRINT GetBufferFootprint(DXGI_FORMAT format, const TextureRegion& box, uint32_t offsetBytes, uint32_t rowPitch, uint32_t depthPitch)
+    {
+        D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint = {};
+        footprint.Offset = offsetBytes;
+        footprint.Footprint.Format = format;
+        footprint.Footprint.Width = box.width;
+        footprint.Footprint.Height = (box.depth > 1 && rowPitch) ? std::max(box.height, depthPitch / rowPitch) : box.height;
+        footprint.Footprint.Depth = box.depth;
+        footprint.Footprint.RowPitch = rowPitch;
+        return footprint;
+    }
+
+    void RendererInterfaceD3D12::copyBufferToTexture(TextureHandle dest, const TextureRegion& destRegion, BufferHandle src, uint32_t srcOffsetBytes, uint32_t rowPitch, uint32_t depthPitch)
+    {
+        if (!dest || !src || !destRegion.isValid(dest->desc) || dest->desc.sampleCount > 1 ||
+            (srcOffsetBytes % D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT) || (rowPitch % D3D12_TEXTURE_DATA_PITCH_ALIGNMENT))
+        {
+            SIGNAL_ERROR("Invalid buffer to texture copy");
+            return;
+        }
+
+        TextureRegion box = destRegion.resolve(dest->desc);
+        if (box.width == 0 || box.height == 0 || box.depth == 0)
+            return;
+
+        D3D12_RESOURCE_DESC desc = dest->resource->GetDesc();
+        uint32_t arraySlice = desc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D ? 0 : box.arraySlice;
+
+        requireTextureState(dest, arraySlice, box.mipLevel, D3D12_RESOURCE_STATE_COPY_DEST);
+        requireBufferState(src, D3D12_RESOURCE_STATE_COPY_SOURCE);
+        commitBarriers();
+
+        D3D12_TEXTURE_COPY_LOCATION destLocation = {};
+        destLocation.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+        destLocation.SubresourceIndex = arraySlice * dest->desc.mipLevels + box.mipLevel;
+        destLocation.pResource = dest->resource;
+
+        D3D12_TEXTURE_COPY_LOCATION srcLocation = {};
+        srcLocation.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+        srcLocation.PlacedFootprint = GetBufferFootprint(desc.Format, box, srcOffsetBytes, rowPitch, depthPitch);
+        srcLocation.pResource = src->resource;
+
+        // The footprint may have more rows per slice than the region, so the box limits the copy to the region
+        D3D12_BOX srcBox = { 0, 0, 0, box.width, box.height, box.depth };
+
+        m_ActiveCommandList->commandList->CopyTextureRegion(&destLocation, box.x, box.y, box.z, &srcLocation, &srcBox);
+        m_ActiveCommandList->size++;
+        loadBalanceCommandList();
+    }
+
+    void RendererInterfaceD3D12::copyTextureToBuffer(BufferHandle dest, uint32_t destOffsetBytes, uint32_t rowPitch, uint32_t depthPitch, TextureHandle src, const TextureRegion& srcRegion)
+    {
+        if (!dest || !src || !srcRegion.isValid(src->desc) || src->desc.sampleCount > 1 ||
+            (destOffsetBytes % D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT) || (rowPitch % D3D12_TEXTURE_DATA_PITCH_ALIGNMENT))
+        {
+            SIGNAL_ERROR("Invalid texture to buffer copy");
+            return;
+        }
+
+        TextureRegion box = srcRegion.resolve(src->desc);
+        if (box.width == 0 || box.height == 0 || box.depth == 0)
+            return;
+
+        D3D12_RESOURCE_DESC desc = src->resource->GetDesc();
+        uint32_t arraySlice = desc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D ? 0 : box.arraySlice;
+
+        requireBufferState(dest, D3D12_RESOURCE_STATE_COPY_DEST);
+        requireTextureState(src, arraySlice, box.mipLevel, D3D12_RESOURCE_STATE_COPY_SOURCE);
+        commitBarriers();
+
+        D3D12_TEXTURE_COPY_LOCATION destLocation = {};
+        destLocation.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+        destLocation.PlacedFootprint = GetBufferFootprint(desc.Format, box, destOffsetBytes, rowPitch, depthPitch);
+        destLocation.pResource = dest->resource;
+
+        D3D12_TEXTURE_COPY_LOCATION srcLocation = {};
+        srcLocation.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+        srcLocation.SubresourceIndex = arraySlice * src->desc.mipLevels + box.mipLevel;
+        srcLocation.pResource = src->resource;
+
+        TextureRegion wholeMip = TextureRegion(box.mipLevel, box.arraySlice).resolve(src->desc);
+        bool wholeSubresource = box.x == 0 && box.y == 0 && box.z == 0 && box.width == wholeMip.width && box.height == wholeMip.height && box.depth == wholeMip.depth;
+
+        D3D12_BOX srcBox = { box.x, box.y, box.z, box.x + box.width, box.y + box.height, box.z + box.depth };
+
+        m_ActiveCommandList->commandList->CopyTextureRegion(&destLocation, 0, 0, 0, &srcLocation, wholeSubresource ? nullptr : &srcBox);
+        m_ActiveCommandList->size++;
+        loadBalanceCommandList();
+    }
+
+    void RendererInterfaceD3D12::resolveTexture(TextureHandle dest, uint32_t destMipLevel, uint32_t destArraySlice, TextureHandle src, uint32_t srcArraySlice)
+    {
+        const FormatMapping& formatMapping = GetFormatMapping(src ? src->desc.format : Format::UNKNOWN);
+
+        if (!dest || !src || !TextureRegion(destMipLevel, destArraySlice).isValid(dest->desc) || !TextureRegion(0, srcArraySlice).isValid(src->desc) ||
+            src->desc.sampleCount <= 1 || formatMapping.isDepthStencil)
+        {
+            SIGNAL_ERROR("Invalid texture resolve");
+            return;
+        }
+
+        requireTextureState(dest, destArraySlice, destMipLevel, D3D12_RESOURCE_STATE_RESOLVE_DEST);
+        requireTextureState(src, srcArraySlice, 0, D3D12_RESOURCE_STATE_RESOLVE_SOURCE);
+        commitBarriers();
+
+        // The resources are typeless, the resolve needs a typed format
+        m_ActiveCommandList->commandList->ResolveSubresource(
+            dest->resource, destArraySlice * dest->desc.mipLevels + destMipLevel,
+            src->resource, srcArraySlice,
+            formatMapping.rtvFormat);
+
+        m_ActiveCommandList->size++;
+        loadBalanceCommandList();
+    }
+
+    void RendererInterfaceD3D12::destroyTexture(TextureHandle t)
+    {
+        if (t == nullptr)
+            return;
+
+        m_pResources->textures.erase(t);
+        m_pResources->deletedResources.insert(t);
+    }
+
+    BufferHandle RendererInterfaceD3D12::createBuffer(const BufferDesc & d, const void * data)
+    {
+        BufferHandle buffer = new Buffer();
+        buffer->desc = d;
+        buffer->parent = this;
+
+        D3D12_RESOURCE_DESC desc = {};
+        desc.Width = d.byteSize;
+        desc.Height = 1;
+        desc.DepthOrArraySize = 1;
+        desc.MipLevels = 1;
         desc.Format = DXGI_FORMAT_UNKNOWN;
         desc.SampleDesc.Count = 1;
         desc.SampleDesc.Quality = 0;
@@ -2965,6 +3805,63 @@ namespace NVRHI
         loadBalanceCommandList();
     }
 
+    void RendererInterfaceD3D12::writeBufferRange(BufferHandle b, uint32_t offsetBytes, const void* data, size_t dataSize)
+    {
+        if (!b || offsetBytes >= b->desc.byteSize || dataSize == 0)
+        {
+            SIGNAL_ERROR("Invalid buffer write range");
+            return;
+        }
+
+        dataSize = std::min(dataSize, size_t(b->desc.byteSize - offsetBytes));
+
+        UINT64 uploadOffset = m_pResources->upload.SuballocateBuffer(dataSize);
+        memcpy(m_pResources->upload.GetCpuVA(uploadOffset), data, dataSize);
+        requireBufferState(b, D3D12_RESOURCE_STATE_COPY_DEST);
+        commitBarriers();
+        m_ActiveCommandList->commandList->CopyBufferRegion(b->resource, offsetBytes, m_pResources->upload.GetBuffer(), uploadOffset, dataSize);
+        m_ActiveCommandList->size++;
+        loadBalanceCommandList();
+    }
+
+    void* RendererInterfaceD3D12::mapBuffer(BufferHandle b, MapMode::Enum mode, uint32_t offsetBytes, size_t sizeBytes)
+    {
+        (void)mode; // the copy on unmap only touches the mapped range, which satisfies both modes
+
+        if (!b || b->isMapped || offsetBytes >= b->desc.byteSize || sizeBytes == 0)
+        {
+            SIGNAL_ERROR("Invalid buffer map");
+            return nullptr;
+        }
+
+        b->mappedOffset = offsetBytes;
+        b->mappedSize = std::min(sizeBytes, size_t(b->desc.byteSize - offsetBytes));
+        b->mappedUploadOffset = m_pResources->upload.SuballocateBuffer(b->mappedSize);
+        b->isMapped = true;
+
+        m_pResources->upload.BeginMappedAllocation(b->mappedUploadOffset);
+
+        return m_pResources->upload.GetCpuVA(b->mappedUploadOffset);
+    }
+
+    void RendererInterfaceD3D12::unmapBuffer(BufferHandle b)
+    {
+        if (!b || !b->isMapped)
+            return;
+
+        b->isMapped = false;
+
+        requireBufferState(b, D3D12_RESOURCE_STATE_COPY_DEST);
+        commitBarriers();
+        m_ActiveCommandList->commandList->CopyBufferRegion(b->resource, b->mappedOffset, m_pResources->upload.GetBuffer(), b->mappedUploadOffset, b->mappedSize);
+        m_ActiveCommandList->size++;
+
+        // The allocation is now protected by the fence of the active command list, like any other upload
+        m_pResources->upload.EndMappedAllocation(b->mappedUploadOffset);
+
+        loadBalanceCommandList();
+    }
+
     void RendererInterfaceD3D12::clearBufferUInt(BufferHandle b, uint32_t clearValue)
     {
         requireBufferState(b, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
@@ -2987,6 +3884,47 @@ namespace NVRHI
         loadBalanceCommandList();
     }
 
+    void RendererInterfaceD3D12::clearBufferUIntRange(BufferHandle b, uint32_t offsetBytes, size_t sizeBytes, uint32_t clearValue)
+    {
+        uint32_t elementSize = (b && b->desc.structStride) ? b->desc.structStride : 4;
+        if (!b || !b->desc.canHaveUAVs || offsetBytes >= b->desc.byteSize || offsetBytes % elementSize || sizeBytes % elementSize)
+        {
+            SIGNAL_ERROR("Invalid buffer clear range");
+            return;
+        }
+
+        sizeBytes = std::min(sizeBytes, size_t(b->desc.byteSize - offsetBytes));
+
+        requireBufferState(b, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+        commitBarriers();
+
+        // ClearUnorderedAccessViewUint clears the whole view, so create a temporary one that only covers the range
+        D3D12_UNORDERED_ACCESS_VIEW_DESC desc = {};
+        desc.ViewDimension = D3D12_UAV_DIMENSION_BUFFER;
+        desc.Format = b->desc.structStride ? DXGI_FORMAT_UNKNOWN : DXGI_FORMAT_R32_UINT;
+        desc.Buffer.FirstElement = offsetBytes / elementSize;
+        desc.Buffer.NumElements = UINT(sizeBytes / elementSize);
+        desc.Buffer.StructureByteStride = b->desc.structStride;
+
+        DescriptorIndex indexCpu = m_pResources->dhSRVstatic.AllocateDescriptor();
+        D3D12_CPU_DESCRIPTOR_HANDLE descriptorCpu = m_pResources->dhSRVstatic.GetCpuHandle(indexCpu);
+        m_pDevice->CreateUnorderedAccessView(b->resource, nullptr, &desc, descriptorCpu);
+
+        DescriptorIndex indexGpu;
+        m_pResources->dhSRVetc.AllocateDescriptors(1, indexGpu);
+
+        m_pDevice->CopyDescriptorsSimple(1, m_pResources->dhSRVetc.GetCpuHandle(indexGpu), descriptorCpu, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+
+        const uint32_t values[4] = { clearValue, clearValue, clearValue, clearValue };
+        m_ActiveCommandList->commandList->ClearUnorderedAccessViewUint(m_pResources->dhSRVetc.GetGpuHandle(indexGpu), descriptorCpu, b->resource, values, 0, nullptr);
+        m_ActiveCommandList->size++;
+
+        // The CPU descriptor is only read while the clear is recorded, the shader-visible copy is retired with the command list
+        m_pResources->dhSRVstatic.ReleaseDescriptor(indexCpu);
+
+        loadBalanceCommandList();
+    }
+
     void RendererInterfaceD3D12::copyToBuffer(BufferHandle dest, uint32_t destOffsetBytes, BufferHandle src, uint32_t srcOffsetBytes, size_t dataSizeBytes)
     {
         requireBufferState(dest, D3D12_RESOURCE_STATE_COPY_DEST);
@@ -3000,8 +3938,56 @@ namespace NVRHI
 
     void RendererInterfaceD3D12::readBuffer(BufferHandle b, void * data, size_t * dataSize)
     {
+        size_t bytesToRead = std::min(*dataSize, size_t(b->desc.byteSize));
+        *dataSize = 0;
+
+        if (bytesToRead == 0)
+            return;
+
+        // This still waits for the GPU, but only up to the copy, and the staging buffer is recycled
+        ReadbackHandle readback = beginBufferReadback(b, 0, bytesToRead);
+        if (!readback)
+            return;
+
+        const void* pData = mapReadback(readback, nullptr, nullptr);
+        if (pData)
+        {
+            memcpy(data, pData, bytesToRead);
+            *dataSize = bytesToRead;
+        }
+
+        releaseReadback(readback);
+    }
+
+    ReadbackHandle RendererInterfaceD3D12::allocateReadback(uint64_t size)
+    {
+        // Take the smallest free staging buffer that is large enough
+        auto& freeReadbacks = m_pResources->freeReadbacks;
+        auto best = freeReadbacks.end();
+        for (auto it = freeReadbacks.begin(); it != freeReadbacks.end(); ++it)
+        {
+            if ((*it)->capacity >= size && (best == freeReadbacks.end() || (*it)->capacity < (*best)->capacity))
+                best = it;
+        }
+
+        if (best != freeReadbacks.end())
+        {
+            ReadbackHandle readback = *best;
+            *best = freeReadbacks.back();
+            freeReadbacks.pop_back();
+
+            readback->size = size;
+            m_pResources->UpdateReadbackStatistics();
+            return readback;
+        }
+
+        // Committed resources are allocated in 64 KB pages anyway; round up to a power of two for better reuse
+        UINT64 capacity = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+        while (capacity < size)
+            capacity *= 2;
+
         D3D12_RESOURCE_DESC desc = {};
-        desc.Width = b->desc.byteSize;
+        desc.Width = capacity;
         desc.Height = 1;
         desc.DepthOrArraySize = 1;
         desc.MipLevels = 1;
@@ -3014,7 +4000,9 @@ namespace NVRHI
         D3D12_HEAP_PROPERTIES heapProps = {};
         heapProps.Type = D3D12_HEAP_TYPE_READBACK;
 
-        ID3D12Resource* pReadbackBuffer = nullptr;
+        ReadbackHandle readback = new Readback();
+        readback->capacity = capacity;
+        readback->size = size;
 
         HRESULT hr = m_pDevice->CreateCommittedResource(
             &heapProps,
@@ -3022,35 +4010,213 @@ namespace NVRHI
             &desc,
             D3D12_RESOURCE_STATE_COPY_DEST,
             nullptr,
-            IID_PPV_ARGS(&pReadbackBuffer));
+            IID_PPV_ARGS(&readback->resource));
 
         CHECK_ERROR(SUCCEEDED(hr), "Failed to create a readback buffer");
 
+        if (SUCCEEDED(hr))
+        {
+            // Readback heap resources can stay mapped; the CPU only reads them after the fence of the copy has completed
+            hr = readback->resource->Map(0, nullptr, &readback->cpuVA);
+            CHECK_ERROR(SUCCEEDED(hr), "Failed to map a readback buffer");
+        }
+
         if (FAILED(hr))
         {
-            *dataSize = 0;
-            return;
+            delete readback;
+            return nullptr;
+        }
+
+        m_pResources->readbacks.push_back(readback);
+        m_pResources->UpdateReadbackStatistics();
+        return readback;
+    }
+
+    ReadbackHandle RendererInterfaceD3D12::beginBufferReadback(BufferHandle b, uint32_t offsetBytes, size_t sizeBytes)
+    {
+        if (!b || offsetBytes >= b->desc.byteSize || sizeBytes == 0)
+        {
+            SIGNAL_ERROR("Invalid buffer readback range");
+            return nullptr;
         }
 
+        sizeBytes = std::min(sizeBytes, size_t(b->desc.byteSize - offsetBytes));
+
+        ReadbackHandle readback = allocateReadback(sizeBytes);
+        if (!readback)
+            return nullptr;
+
+        readback->rowPitch = uint32_t(sizeBytes);
+        readback->depthPitch = uint32_t(sizeBytes);
+
         requireBufferState(b, D3D12_RESOURCE_STATE_COPY_SOURCE);
         commitBarriers();
-        m_ActiveCommandList->commandList->CopyBufferRegion(pReadbackBuffer, 0, b->resource, 0, b->desc.byteSize);
+
+        m_ActiveCommandList->commandList->CopyBufferRegion(readback->resource, 0, b->resource, offsetBytes, sizeBytes);
         m_ActiveCommandList->size++;
 
-        syncWithGPU("ReadBuffer");
+        // The active command list is followed by this fence value when it's flushed
+        readback->fenceValue = m_pResources->fenceCounter + 1;
+
+        loadBalanceCommandList();
 
-        D3D12_RANGE range;
-        range.Begin = 0;
-        range.End = b->desc.byteSize;
-        void* pData = nullptr;
-        hr = pReadbackBuffer->Map(0, &range, &pData);
+        return readback;
+    }
 
-        CHECK_ERROR(SUCCEEDED(hr), "Failed to Map a readback buffer");
+    ReadbackHandle RendererInterfaceD3D12::beginTextureReadback(TextureHandle t, const TextureRegion& region)
+    {
+        if (!t || !region.isValid(t->desc) || t->desc.sampleCount > 1)
+        {
+            SIGNAL_ERROR("Invalid texture readback");
+            return nullptr;
+        }
 
-        memcpy(data, pData, *dataSize);
+        TextureRegion box = region.resolve(t->desc);
+        if (box.width == 0 || box.height == 0 || box.depth == 0)
+        {
+            SIGNAL_ERROR("Empty texture readback region");
+            return nullptr;
+        }
+
+        D3D12_RESOURCE_DESC desc = t->resource->GetDesc();
+        bool is3D = desc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D;
+
+        // Get the footprint of a texture that is exactly as large as the region
+        D3D12_RESOURCE_DESC regionDesc = desc;
+        regionDesc.Width = box.width;
+        regionDesc.Height = box.height;
+        regionDesc.DepthOrArraySize = UINT16(is3D ? box.depth : 1);
+        regionDesc.MipLevels = 1;
+        regionDesc.Alignment = 0;
+
+        D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint;
+        UINT64 footprintBytes;
+        m_pDevice->GetCopyableFootprints(&regionDesc, 0, 1, 0, &footprint, nullptr, nullptr, &footprintBytes);
 
-        pReadbackBuffer->Unmap(0, nullptr);
-        pReadbackBuffer->Release();
+        ReadbackHandle readback = allocateReadback(footprintBytes);
+        if (!readback)
+            return nullptr;
+
+        readback->rowPitch = footprint.Footprint.RowPitch;
+        readback->depthPitch = footprint.Footprint.RowPitch * footprint.Footprint.Height;
+
+        requireTextureState(t, box.arraySlice, box.mipLevel, D3D12_RESOURCE_STATE_COPY_SOURCE);
+        commitBarriers();
+
+        D3D12_TEXTURE_COPY_LOCATION dest = {};
+        dest.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+        dest.PlacedFootprint = footprint;
+        dest.pResource = readback->resource;
+
+        D3D12_TEXTURE_COPY_LOCATION src = {};
+        src.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+        src.SubresourceIndex = (is3D ? 0 : box.arraySlice) * t->desc.mipLevels + box.mipLevel;
+        src.pResource = t->resource;
+
+        // Depth-stencil resources can only be copied as whole subresources, which is what a null box means
+        TextureRegion wholeMip = TextureRegion(box.mipLevel, box.arraySlice).resolve(t->desc);
+        bool wholeSubresource = box.x == 0 && box.y == 0 && box.z == 0 && box.width == wholeMip.width && box.height == wholeMip.height && box.depth == wholeMip.depth;
+
+        D3D12_BOX srcBox = { box.x, box.y, box.z, box.x + box.width, box.y + box.height, box.z + box.depth };
+
+        m_ActiveCommandList->commandList->CopyTextureRegion(&dest, 0, 0, 0, &src, wholeSubresource ? nullptr : &srcBox);
+        m_ActiveCommandList->size++;
+
+        readback->fenceValue = m_pResources->fenceCounter + 1;
+
+        loadBalanceCommandList();
+
+        return readback;
+    }
+
+    bool RendererInterfaceD3D12::isReadbackReady(ReadbackHandle r)
+    {
+        if (!r)
+            return false;
+
+        // Submit the copy if it is still in the active command list, or polling would never see it complete
+        if (r->fenceValue > m_pResources->fenceCounter)
+            flushCommandList();
+
+        return r->fenceValue <= m_pResources->fence->GetCompletedValue();
+    }
+
+    const void* RendererInterfaceD3D12::mapReadback(ReadbackHandle r, uint32_t* rowPitch, uint32_t* depthPitch)
+    {
+        if (!r)
+            return nullptr;
+
+        // This flushes the active command list if the copy has not been submitted yet
+        if (r->fenceValue > m_pResources->fence->GetCompletedValue())
+            waitForFence(r->fenceValue, "Readback");
+
+        if (rowPitch) *rowPitch = r->rowPitch;
+        if (depthPitch) *depthPitch = r->depthPitch;
+
+        return r->cpuVA;
+    }
+
+    void RendererInterfaceD3D12::releaseReadback(ReadbackHandle r)
+    {
+        if (!r)
+            return;
+
+        m_pResources->freeReadbacks.push_back(r);
+    }
+
+    FenceHandle RendererInterfaceD3D12::createFence()
+    {
+        FenceHandle f = new Fence();
+
+        HRESULT hr = m_pDevice->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&f->fence));
+        CHECK_ERROR(SUCCEEDED(hr), "Failed to create a fence");
+
+        if (FAILED(hr))
+        {
+            delete f;
+            return nullptr;
+        }
+
+        f->event = CreateEvent(nullptr, false, false, nullptr);
+
+        m_pResources->fences.insert(f);
+        return f;
+    }
+
+    void RendererInterfaceD3D12::destroyFence(FenceHandle f)
+    {
+        if (!f)
+            return;
+
+        m_pResources->fences.erase(f);
+        delete f;
+    }
+
+    void RendererInterfaceD3D12::signalFence(FenceHandle f, uint64_t value)
+    {
+        if (!f)
+            return;
+
+        // The signal goes into the queue, so the commands recorded so far have to be submitted first
+        flushCommandList();
+        m_pCommandQueue->Signal(f->fence, value);
+    }
+
+    uint64_t RendererInterfaceD3D12::getFenceCompletedValue(FenceHandle f)
+    {
+        if (!f)
+            return 0;
+
+        return f->fence->GetCompletedValue();
+    }
+
+    void RendererInterfaceD3D12::waitFence(FenceHandle f, uint64_t value)
+    {
+        if (!f || f->fence->GetCompletedValue() >= value)
+            return;
+
+        f->fence->SetEventOnCompletion(value, f->event);
+        WaitForSingleObject(f->event, INFINITE);
     }
 
     void RendererInterfaceD3D12::destroyBuffer(BufferHandle b)
@@ -3301,41 +4467,14 @@ namespace NVRHI
         if (s == nullptr)
             return;
 
-        m_pResources->shaders.erase(s);
-
-        // Step 1 - find the root signatures that reference this shader
-
-        std::set<uint32_t> rootsigHashesToDelete;
-
-        for (auto pair : m_pResources->rootsigCache)
-        {
-            if (pair.second->shaders.count(s))
-                rootsigHashesToDelete.insert(pair.first);
-        }
-
-        // Step 2 - move the found root signatured to the deleted pool, find the pipeline states that reference the root signatures
-
-        std::set<uint32_t> psoHashesToDelete;
-
-        for (auto hash : rootsigHashesToDelete)
-        {
-            auto rootsig = m_pResources->rootsigCache[hash];
-            m_pResources->rootsigCache.erase(hash);
-            m_pResources->deletedResources.insert(rootsig);
-
-            for (auto pair : m_pResources->psoCache)
-                if (pair.second != nullptr && pair.second->rootSignature == rootsig)
-                    psoHashesToDelete.insert(pair.first);
-        }
+        m_pResources->shaders.erase(s);
 
-        // Step 3 - move the pipeline states to the deleted pool
+        // Move the root signatures that reference this shader and the pipeline states that use them to the deleted pool
 
-        for (auto hash : psoHashesToDelete)
-        {
-            auto pso = m_pResources->psoCache[hash];
-            m_pResources->psoCache.erase(hash);
-            m_pResources->deletedResources.insert(pso);
-        }
+        std::vector<RootSignatureHandle> rootsigs;
+        std::vector<PipelineStateHandle> psos;
+        m_pResources->rootsigCache.EraseIf([s](RootSignatureHandle rootsig) { return rootsig->shaders.count(s) != 0; }, rootsigs);
+        releaseCachedObjects(rootsigs, psos);
 
         // no need to put shaders into the deleted resources pool: they do not have actual D3D resource associated
         delete s;
@@ -3476,77 +4615,441 @@ namespace NVRHI
         }
     }
 
-    float RendererInterfaceD3D12::getPerformanceQueryTimeMS(PerformanceQueryHandle query)
+    float RendererInterfaceD3D12::getPerformanceQueryTimeMS(PerformanceQueryHandle query)
+    {
+        CHECK_ERROR(query->state != PerformanceQuery::STARTED, "Query is in progress, can't get time");
+        CHECK_ERROR(query->state != PerformanceQuery::NEW, "Query has never been started, can't get time");
+
+        if (query->state == PerformanceQuery::RESOLVED)
+            return query->time;
+
+        m_pDevice->SetStablePowerState(false);
+
+        requireBufferState(m_pResources->perfQueryResolveBuffer, D3D12_RESOURCE_STATE_COPY_DEST);
+
+        for (auto q : m_pResources->perfQueries)
+        {
+            if (q->state == PerformanceQuery::FINISHED)
+            {
+                m_ActiveCommandList->commandList->ResolveQueryData(
+                    m_pResources->perfQueryHeap, 
+                    D3D12_QUERY_TYPE_TIMESTAMP, 
+                    q->beginIndex,      // StartIndex
+                    2,                  // NumQueries
+                    m_pResources->perfQueryResolveBuffer->resource, 
+                    q->beginIndex * 8   // AlignedDestinationBufferOffset
+                ); 
+            }
+        }
+            
+        uint64_t* data = new uint64_t[m_pResources->nextQueryIndex];
+        size_t dataSize = m_pResources->nextQueryIndex * 8;
+        readBuffer(m_pResources->perfQueryResolveBuffer, data, &dataSize);
+
+        uint64_t frequency;
+        m_pCommandQueue->GetTimestampFrequency(&frequency);
+
+        for (auto q : m_pResources->perfQueries)
+        {
+            if (q->state == PerformanceQuery::FINISHED)
+            {
+                q->time = float(1000.0 * double(data[q->endIndex] - data[q->beginIndex]) / double(frequency));
+                q->state = PerformanceQuery::RESOLVED;
+            }
+        }
+
+        return query->time;
+    }
+
+    GraphicsPipelineHandle RendererInterfaceD3D12::createGraphicsPipeline(const GraphicsPipelineDesc & d)
+    {
+        const ShaderHandle shaders[ShaderType::GRAPHIC_SHADERS_NUM] = { d.VS, d.HS, d.DS, d.GS, d.PS };
+
+        for (uint32_t stage = 0; stage < ShaderType::GRAPHIC_SHADERS_NUM; stage++)
+        {
+            if (shaders[stage] && shaders[stage]->type != ShaderType::Enum(stage))
+            {
+                SIGNAL_ERROR("Shader type doesn't match the pipeline stage it is used for");
+                return nullptr;
+            }
+        }
+
+        if (d.renderTargetCount > RenderState::MAX_RENDER_TARGETS)
+        {
+            SIGNAL_ERROR("Too many render targets in a graphics pipeline");
+            return nullptr;
+        }
+
+        GraphicsPipelineHandle pipeline = new GraphicsPipeline();
+        pipeline->desc = d;
+
+        pipeline->rootSignature = buildRootSignature(ShaderType::GRAPHIC_SHADERS_NUM, shaders, d.inputLayout != nullptr);
+        if (pipeline->rootSignature)
+            pipeline->pipelineState = createPipelineState(d, pipeline->rootSignature);
+
+        if (pipeline->pipelineState == nullptr)
+        {
+            delete pipeline;
+            return nullptr;
+        }
+
+        pipeline->pipelineState->rootSignature = pipeline->rootSignature;
+
+        // Stages that have no bindings in the binding set still need their descriptor tables filled with null descriptors
+        for (uint32_t stage = 0; stage < ShaderType::GRAPHIC_SHADERS_NUM; stage++)
+        {
+            if (shaders[stage])
+            {
+                PipelineStageBindings emptyBindings((ShaderType::Enum)stage);
+                emptyBindings.shader = shaders[stage];
+                bakeDescriptorTables(emptyBindings, pipeline->nullTables[stage]);
+            }
+        }
+
+        m_pResources->graphicsPipelines.insert(pipeline);
+        return pipeline;
+    }
+
+    void RendererInterfaceD3D12::destroyGraphicsPipeline(GraphicsPipelineHandle p)
+    {
+        if (p == nullptr)
+            return;
+
+        m_pResources->graphicsPipelines.erase(p);
+        deferredDestroyResource(p);
+    }
+
+    ComputePipelineHandle RendererInterfaceD3D12::createComputePipeline(const ComputePipelineDesc & d)
+    {
+        if (d.CS == nullptr || d.CS->type != ShaderType::SHADER_COMPUTE)
+        {
+            SIGNAL_ERROR("A compute pipeline requires a compute shader");
+            return nullptr;
+        }
+
+        ComputePipelineHandle pipeline = new ComputePipeline();
+        pipeline->desc = d;
+
+        pipeline->rootSignature = buildRootSignature(1, &d.CS, false);
+        if (pipeline->rootSignature)
+            pipeline->pipelineState = createPipelineState(d.CS, pipeline->rootSignature);
+
+        if (pipeline->pipelineState == nullptr)
+        {
+            delete pipeline;
+            return nullptr;
+        }
+
+        pipeline->pipelineState->rootSignature = pipeline->rootSignature;
+
+        PipelineStageBindings emptyBindings(ShaderType::SHADER_COMPUTE);
+        emptyBindings.shader = d.CS;
+        bakeDescriptorTables(emptyBindings, pipeline->nullTables);
+
+        m_pResources->computePipelines.insert(pipeline);
+        return pipeline;
+    }
+
+    void RendererInterfaceD3D12::destroyComputePipeline(ComputePipelineHandle p)
+    {
+        if (p == nullptr)
+            return;
+
+        m_pResources->computePipelines.erase(p);
+        deferredDestroyResource(p);
+    }
+
+    BindingSetHandle RendererInterfaceD3D12::createBindingSet(const BindingSetDesc & d)
+    {
+        const PipelineStageBindings* graphicsStages[ShaderType::GRAPHIC_SHADERS_NUM] = { &d.VS, &d.HS, &d.DS, &d.GS, &d.PS };
+
+        BindingSetHandle bindingSet = new BindingSet();
+
+        for (uint32_t stage = 0; stage < ShaderType::GRAPHIC_SHADERS_NUM; stage++)
+        {
+            if (graphicsStages[stage]->shader)
+                bakeDescriptorTables(*graphicsStages[stage], bindingSet->graphicsStages[stage]);
+        }
+
+        if (d.CS.shader)
+            bakeDescriptorTables(d.CS, bindingSet->CS);
+
+        m_pResources->bindingSets.insert(bindingSet);
+        return bindingSet;
+    }
+
+    void RendererInterfaceD3D12::destroyBindingSet(BindingSetHandle b)
+    {
+        if (b == nullptr)
+            return;
+
+        // Binding sets only reference descriptors in the static heaps, which are copied into the ring heaps on every draw
+        m_pResources->bindingSets.erase(b);
+        delete b;
+    }
+
+    GraphicsAPI::Enum RendererInterfaceD3D12::getGraphicsAPI()
+    {
+        return GraphicsAPI::D3D12;
+    }
+
+    void * RendererInterfaceD3D12::getAPISpecificInterface(APISpecificInterface::Enum interfaceType)
+    {
+        if (interfaceType == APISpecificInterface::D3D12DEVICE)
+            return m_pDevice;
+
+        return nullptr;
+    }
+
+    bool RendererInterfaceD3D12::isOpenGLExtensionSupported(const char *)
+    {
+        return false;
+    }
+
+    void * RendererInterfaceD3D12::getOpenGLProcAddress(const char *)
+    {
+        return nullptr;
+    }
+
+    void RendererInterfaceD3D12::draw(const DrawCallState & state, const DrawArguments* args, uint32_t numDrawCalls)
+    {
+        applyState(state);
+        commitBarriers();
+
+        for (uint32_t i = 0; i < numDrawCalls; i++)
+            m_ActiveCommandList->commandList->DrawInstanced(args[i].vertexCount, args[i].instanceCount, args[i].startVertexLocation, args[i].startInstanceLocation);
+
+        m_ActiveCommandList->size += numDrawCalls;
+        loadBalanceCommandList();
+    }
+
+    void RendererInterfaceD3D12::drawIndexed(const DrawCallState & state, const DrawArguments* args, uint32_t numDrawCalls)
+    {
+        applyState(state);
+        commitBarriers();
+
+        for (uint32_t i = 0; i < numDrawCalls; i++)
+            m_ActiveCommandList->commandList->DrawIndexedInstanced(args[i].vertexCount, args[i].instanceCount, args[i].startIndexLocation, args[i].startVertexLocation, args[i].startInstanceLocation);
+
+        m_ActiveCommandList->size += numDrawCalls;
+        loadBalanceCommandList();
+    }
+
+    void RendererInterfaceD3D12::drawIndirect(const DrawCallState & state, BufferHandle indirectParams, uint32_t offsetBytes)
+    {
+        applyState(state);
+        requireBufferState(indirectParams, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
+        commitBarriers();
+
+        m_ActiveCommandList->commandList->ExecuteIndirect(m_pResources->drawIndirectSignature, 1, indirectParams->resource, offsetBytes, nullptr, 0);
+        m_ActiveCommandList->size++;
+        loadBalanceCommandList();
+    }
+
+    void RendererInterfaceD3D12::drawCompact(const CompactDrawCallState & state, const DrawArguments* args, uint32_t numDrawCalls)
+    {
+        applyState(state);
+        commitBarriers();
+
+        for (uint32_t i = 0; i < numDrawCalls; i++)
+            m_ActiveCommandList->commandList->DrawInstanced(args[i].vertexCount, args[i].instanceCount, args[i].startVertexLocation, args[i].startInstanceLocation);
+
+        m_ActiveCommandList->size += numDrawCalls;
+        loadBalanceCommandList();
+    }
+
+    void RendererInterfaceD3D12::drawIndexedCompact(const CompactDrawCallState & state, const DrawArguments* args, uint32_t numDrawCalls)
+    {
+        applyState(state);
+        commitBarriers();
+
+        for (uint32_t i = 0; i < numDrawCalls; i++)
+            m_ActiveCommandList->commandList->DrawIndexedInstanced(args[i].vertexCount, args[i].instanceCount, args[i].startIndexLocation, args[i].startVertexLocation, args[i].startInstanceLocation);
+
+        m_ActiveCommandList->size += numDrawCalls;
+        loadBalanceCommandList();
+    }
+
+    void RendererInterfaceD3D12::drawIndirectCompact(const CompactDrawCallState & state, BufferHandle indirectParams, uint32_t offsetBytes)
+    {
+        applyState(state);
+        requireBufferState(indirectParams, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
+        commitBarriers();
+
+        m_ActiveCommandList->commandList->ExecuteIndirect(m_pResources->drawIndirectSignature, 1, indirectParams->resource, offsetBytes, nullptr, 0);
+        m_ActiveCommandList->size++;
+        loadBalanceCommandList();
+    }
+
+    ID3D12CommandSignature* RendererInterfaceD3D12::getDrawIndirectSignature(bool indexed, uint32_t stride)
+    {
+        ID3D12CommandSignature*& signature = m_pResources->multiDrawSignatures[std::make_pair(indexed, stride)];
+
+        if (!signature)
+        {
+            D3D12_INDIRECT_ARGUMENT_DESC argDesc = {};
+            argDesc.Type = indexed ? D3D12_INDIRECT_ARGUMENT_TYPE_DRAW_INDEXED : D3D12_INDIRECT_ARGUMENT_TYPE_DRAW;
+
+            D3D12_COMMAND_SIGNATURE_DESC csDesc = {};
+            csDesc.NumArgumentDescs = 1;
+            csDesc.pArgumentDescs = &argDesc;
+            csDesc.ByteStride = stride;
+
+            CHECK_ERROR(SUCCEEDED(m_pDevice->CreateCommandSignature(&csDesc, nullptr, IID_PPV_ARGS(&signature))), "Failed to create a command signature");
+        }
+
+        return signature;
+    }
+
+    void RendererInterfaceD3D12::executeIndirectDraws(bool indexed, uint32_t indexBufferOffset, BufferHandle argsBuffer, uint32_t argsOffsetBytes, uint32_t argsStrideBytes, uint32_t maxDrawCount, BufferHandle countBuffer, uint32_t countOffsetBytes)
+    {
+        uint32_t recordSize = indexed ? sizeof(DrawIndexedIndirectArguments) : sizeof(DrawIndirectArguments);
+        uint32_t stride = argsStrideBytes ? argsStrideBytes : recordSize;
+
+        if (!argsBuffer || (stride & 3) != 0 || stride < recordSize || (countOffsetBytes & 3) != 0)
+        {
+            SIGNAL_ERROR("Invalid indirect draw arguments");
+            return;
+        }
+
+        // The index buffer view could apply the offset, but the GL backend can't, so it's rejected on every backend
+        if (indexed && indexBufferOffset != 0)
+        {
+            SIGNAL_ERROR("Indirect indexed draws do not support a nonzero indexBufferOffset");
+            return;
+        }
+
+        if (maxDrawCount == 0)
+            return;
+
+        ID3D12CommandSignature* signature = getDrawIndirectSignature(indexed, stride);
+        if (!signature)
+            return;
+
+        requireBufferState(argsBuffer, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
+        if (countBuffer)
+            requireBufferState(countBuffer, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
+        commitBarriers();
+
+        m_ActiveCommandList->commandList->ExecuteIndirect(signature, maxDrawCount, argsBuffer->resource, argsOffsetBytes,
+            countBuffer ? countBuffer->resource : nullptr, countOffsetBytes);
+
+        m_ActiveCommandList->size += maxDrawCount;
+        loadBalanceCommandList();
+    }
+
+    void RendererInterfaceD3D12::drawIndexedIndirect(const DrawCallState & state, BufferHandle indirectParams, uint32_t offsetBytes)
+    {
+        multiDrawIndexedIndirect(state, indirectParams, offsetBytes, 0, 1, nullptr, 0);
+    }
+
+    void RendererInterfaceD3D12::multiDrawIndirect(const DrawCallState & state, BufferHandle argsBuffer, uint32_t argsOffsetBytes, uint32_t argsStrideBytes, uint32_t maxDrawCount, BufferHandle countBuffer, uint32_t countOffsetBytes)
+    {
+        applyState(state);
+        executeIndirectDraws(false, 0, argsBuffer, argsOffsetBytes, argsStrideBytes, maxDrawCount, countBuffer, countOffsetBytes);
+    }
+
+    void RendererInterfaceD3D12::multiDrawIndexedIndirect(const DrawCallState & state, BufferHandle argsBuffer, uint32_t argsOffsetBytes, uint32_t argsStrideBytes, uint32_t maxDrawCount, BufferHandle countBuffer, uint32_t countOffsetBytes)
+    {
+        applyState(state);
+        executeIndirectDraws(true, state.indexBufferOffset, argsBuffer, argsOffsetBytes, argsStrideBytes, maxDrawCount, countBuffer, countOffsetBytes);
+    }
+
+    void RendererInterfaceD3D12::drawIndexedIndirectCompact(const CompactDrawCallState & state, BufferHandle indirectParams, uint32_t offsetBytes)
+    {
+        multiDrawIndexedIndirectCompact(state, indirectParams, offsetBytes, 0, 1, nullptr, 0);
+    }
+
+    void RendererInterfaceD3D12::multiDrawIndirectCompact(const CompactDrawCallState & state, BufferHandle argsBuffer, uint32_t argsOffsetBytes, uint32_t argsStrideBytes, uint32_t maxDrawCount, BufferHandle countBuffer, uint32_t countOffsetBytes)
+    {
+        applyState(state);
+        executeIndirectDraws(false, 0, argsBuffer, argsOffsetBytes, argsStrideBytes, maxDrawCount, countBuffer, countOffsetBytes);
+    }
+
+    void RendererInterfaceD3D12::multiDrawIndexedIndirectCompact(const CompactDrawCallState & state, BufferHandle argsBuffer, uint32_t argsOffsetBytes, uint32_t argsStrideBytes, uint32_t maxDrawCount, BufferHandle countBuffer, uint32_t countOffsetBytes)
     {
-        CHECK_ERROR(query->state != PerformanceQuery::STARTED, "Query is in progress, can't get time");
-        CHECK_ERROR(query->state != PerformanceQuery::NEW, "Query has never been started, can't get time");
+        applyState(state);
+        executeIndirectDraws(true, state.indexBufferOffset, argsBuffer, argsOffsetBytes, argsStrideBytes, maxDrawCount, countBuffer, countOffsetBytes);
+    }
 
-        if (query->state == PerformanceQuery::RESOLVED)
-            return query->time;
+    void RendererInterfaceD3D12::dispatch(const DispatchState & state, uint32_t groupsX, uint32_t groupsY, uint32_t groupsZ)
+    {
+        applyState(state);
+        commitBarriers();
 
-        m_pDevice->SetStablePowerState(false);
+        m_ActiveCommandList->commandList->Dispatch(groupsX, groupsY, groupsZ);
+        m_ActiveCommandList->size++;
+        loadBalanceCommandList();
+    }
 
-        requireBufferState(m_pResources->perfQueryResolveBuffer, D3D12_RESOURCE_STATE_COPY_DEST);
+    void RendererInterfaceD3D12::dispatchIndirect(const DispatchState & state, BufferHandle indirectParams, uint32_t offsetBytes)
+    {
+        applyState(state);
+        requireBufferState(indirectParams, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
+        commitBarriers();
 
-        for (auto q : m_pResources->perfQueries)
+        m_ActiveCommandList->commandList->ExecuteIndirect(m_pResources->dispatchIndirectSignature, 1, indirectParams->resource, offsetBytes, nullptr, 0);
+        m_ActiveCommandList->size++;
+        loadBalanceCommandList();
+    }
+
+    bool RendererInterfaceD3D12::validateGraphicsState(const GraphicsState & state)
+    {
+        if (state.pipeline == nullptr)
         {
-            if (q->state == PerformanceQuery::FINISHED)
-            {
-                m_ActiveCommandList->commandList->ResolveQueryData(
-                    m_pResources->perfQueryHeap, 
-                    D3D12_QUERY_TYPE_TIMESTAMP, 
-                    q->beginIndex,      // StartIndex
-                    2,                  // NumQueries
-                    m_pResources->perfQueryResolveBuffer->resource, 
-                    q->beginIndex * 8   // AlignedDestinationBufferOffset
-                ); 
-            }
+            SIGNAL_ERROR("No pipeline specified in GraphicsState");
+            return false;
         }
-            
-        uint64_t* data = new uint64_t[m_pResources->nextQueryIndex];
-        size_t dataSize = m_pResources->nextQueryIndex * 8;
-        readBuffer(m_pResources->perfQueryResolveBuffer, data, &dataSize);
 
-        uint64_t frequency;
-        m_pCommandQueue->GetTimestampFrequency(&frequency);
+        const GraphicsPipelineDesc& desc = state.pipeline->desc;
 
-        for (auto q : m_pResources->perfQueries)
+        if (state.bindings)
         {
-            if (q->state == PerformanceQuery::FINISHED)
+            const ShaderHandle pipelineShaders[ShaderType::GRAPHIC_SHADERS_NUM] = { desc.VS, desc.HS, desc.DS, desc.GS, desc.PS };
+
+            for (uint32_t stage = 0; stage < ShaderType::GRAPHIC_SHADERS_NUM; stage++)
             {
-                q->time = float(1000.0 * double(data[q->endIndex] - data[q->beginIndex]) / double(frequency));
-                q->state = PerformanceQuery::RESOLVED;
+                ShaderHandle shader = state.bindings->graphicsStages[stage].shader;
+
+                if (shader && shader != pipelineShaders[stage])
+                {
+                    SIGNAL_ERROR("Binding set was created for a different shader than the one used by the pipeline");
+                    return false;
+                }
             }
         }
 
-        return query->time;
-    }
+        if (state.targetCount != desc.renderTargetCount)
+        {
+            SIGNAL_ERROR("Number of bound render targets doesn't match the pipeline");
+            return false;
+        }
 
-    GraphicsAPI::Enum RendererInterfaceD3D12::getGraphicsAPI()
-    {
-        return GraphicsAPI::D3D12;
+        return true;
     }
 
-    void * RendererInterfaceD3D12::getAPISpecificInterface(APISpecificInterface::Enum interfaceType)
+    bool RendererInterfaceD3D12::validateComputeState(const ComputeState & state)
     {
-        if (interfaceType == APISpecificInterface::D3D12DEVICE)
-            return m_pDevice;
+        if (state.pipeline == nullptr)
+        {
+            SIGNAL_ERROR("No pipeline specified in ComputeState");
+            return false;
+        }
 
-        return nullptr;
-    }
+        if (state.bindings && state.bindings->CS.shader && state.bindings->CS.shader != state.pipeline->desc.CS)
+        {
+            SIGNAL_ERROR("Binding set was created for a different shader than the one used by the pipeline");
+            return false;
+        }
 
-    bool RendererInterfaceD3D12::isOpenGLExtensionSupported(const char *)
-    {
-        return false;
+        return true;
     }
 
-    void * RendererInterfaceD3D12::getOpenGLProcAddress(const char *)
+    void RendererInterfaceD3D12::drawWithPipeline(const GraphicsState & state, const DrawArguments* args, uint32_t numDrawCalls)
     {
-        return nullptr;
-    }
+        if (!validateGraphicsState(state))
+            return;
 
-    void RendererInterfaceD3D12::draw(const DrawCallState & state, const DrawArguments* args, uint32_t numDrawCalls)
-    {
         applyState(state);
         commitBarriers();
 
@@ -3557,8 +5060,11 @@ namespace NVRHI
         loadBalanceCommandList();
     }
 
-    void RendererInterfaceD3D12::drawIndexed(const DrawCallState & state, const DrawArguments* args, uint32_t numDrawCalls)
+    void RendererInterfaceD3D12::drawIndexedWithPipeline(const GraphicsState & state, const DrawArguments* args, uint32_t numDrawCalls)
     {
+        if (!validateGraphicsState(state))
+            return;
+
         applyState(state);
         commitBarriers();
 
@@ -3569,8 +5075,11 @@ namespace NVRHI
         loadBalanceCommandList();
     }
 
-    void RendererInterfaceD3D12::drawIndirect(const DrawCallState & state, BufferHandle indirectParams, uint32_t offsetBytes)
+    void RendererInterfaceD3D12::drawIndirectWithPipeline(const GraphicsState & state, BufferHandle indirectParams, uint32_t offsetBytes)
     {
+        if (!validateGraphicsState(state))
+            return;
+
         applyState(state);
         requireBufferState(indirectParams, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
         commitBarriers();
@@ -3580,8 +5089,34 @@ namespace NVRHI
         loadBalanceCommandList();
     }
 
-    void RendererInterfaceD3D12::dispatch(const DispatchState & state, uint32_t groupsX, uint32_t groupsY, uint32_t groupsZ)
+    void RendererInterfaceD3D12::drawIndexedIndirectWithPipeline(const GraphicsState & state, BufferHandle indirectParams, uint32_t offsetBytes)
+    {
+        multiDrawIndexedIndirectWithPipeline(state, indirectParams, offsetBytes, 0, 1, nullptr, 0);
+    }
+
+    void RendererInterfaceD3D12::multiDrawIndirectWithPipeline(const GraphicsState & state, BufferHandle argsBuffer, uint32_t argsOffsetBytes, uint32_t argsStrideBytes, uint32_t maxDrawCount, BufferHandle countBuffer, uint32_t countOffsetBytes)
+    {
+        if (!validateGraphicsState(state))
+            return;
+
+        applyState(state);
+        executeIndirectDraws(false, 0, argsBuffer, argsOffsetBytes, argsStrideBytes, maxDrawCount, countBuffer, countOffsetBytes);
+    }
+
+    void RendererInterfaceD3D12::multiDrawIndexedIndirectWithPipeline(const GraphicsState & state, BufferHandle argsBuffer, uint32_t argsOffsetBytes, uint32_t argsStrideBytes, uint32_t maxDrawCount, BufferHandle countBuffer, uint32_t countOffsetBytes)
+    {
+        if (!validateGraphicsState(state))
+            return;
+
+        applyState(state);
+        executeIndirectDraws(true, state.indexBufferOffset, argsBuffer, argsOffsetBytes, argsStrideBytes, maxDrawCount, countBuffer, countOffsetBytes);
+    }
+
+    void RendererInterfaceD3D12::dispatchWithPipeline(const ComputeState & state, uint32_t groupsX, uint32_t groupsY, uint32_t groupsZ)
     {
+        if (!validateComputeState(state))
+            return;
+
         applyState(state);
         commitBarriers();
 
@@ -3590,8 +5125,11 @@ namespace NVRHI
         loadBalanceCommandList();
     }
 
-    void RendererInterfaceD3D12::dispatchIndirect(const DispatchState & state, BufferHandle indirectParams, uint32_t offsetBytes)
+    void RendererInterfaceD3D12::dispatchIndirectWithPipeline(const ComputeState & state, BufferHandle indirectParams, uint32_t offsetBytes)
     {
+        if (!validateComputeState(state))
+            return;
+
         applyState(state);
         requireBufferState(indirectParams, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
         commitBarriers();
@@ -3606,6 +5144,25 @@ namespace NVRHI
         onCommand->executeAndDispose();
     }
 
+    CommandListHandle RendererInterfaceD3D12::createCommandList()
+    {
+        return new DeferredCommandList();
+    }
+
+    void RendererInterfaceD3D12::destroyCommandList(CommandListHandle commandList)
+    {
+        delete static_cast<DeferredCommandList*>(commandList);
+    }
+
+    void RendererInterfaceD3D12::executeCommandLists(const CommandListHandle* commandLists, uint32_t numCommandLists)
+    {
+        for (uint32_t i = 0; i < numCommandLists; i++)
+        {
+            if (commandLists[i])
+                static_cast<const DeferredCommandList*>(commandLists[i])->execute(this);
+        }
+    }
+
     uint32_t RendererInterfaceD3D12::getNumberOfAFRGroups()
     {
         return 1;
@@ -3630,6 +5187,17 @@ namespace NVRHI
 	}
 
     void RendererInterfaceD3D12::applyState(const DrawCallState & state)
+    {
+        applyDrawCallState(state);
+    }
+
+    void RendererInterfaceD3D12::applyState(const CompactDrawCallState & state)
+    {
+        applyDrawCallState(state);
+    }
+
+    template<typename TDrawCallState>
+    void RendererInterfaceD3D12::applyDrawCallState(const TDrawCallState & state)
     {
 		RootSignatureHandle pRS = getRootSignature(state);
         PipelineStateHandle pPSO = getPipelineState(state, pRS);
@@ -3844,9 +5412,8 @@ namespace NVRHI
 
     void RendererInterfaceD3D12::applyState(const DispatchState & state)
     {
-		uint32_t hash = getComputeStateHash(state);
-        RootSignatureHandle pRS = getRootSignature(state, hash);
-        PipelineStateHandle pPSO = getPipelineState(state, pRS, hash);
+        RootSignatureHandle pRS = getRootSignature(state);
+        PipelineStateHandle pPSO = getPipelineState(state, pRS);
 
         if (pPSO == nullptr)
             return;
@@ -3881,4 +5448,222 @@ namespace NVRHI
 
         m_ActiveCommandList->size++;
     }
+
+    void RendererInterfaceD3D12::applyState(const GraphicsState & state)
+    {
+        GraphicsPipelineHandle pipeline = state.pipeline;
+        const GraphicsPipelineDesc& pipelineDesc = pipeline->desc;
+        RootSignatureHandle pRS = pipeline->rootSignature;
+        PipelineStateHandle pPSO = pipeline->pipelineState;
+
+        // Copy the baked descriptor tables first because that may reset the command list
+
+        uint32_t rootIndex = 0;
+        D3D12_GPU_DESCRIPTOR_HANDLE rootDescriptorTables[10];
+
+        for (uint32_t stage = 0; stage < ShaderType::GRAPHIC_SHADERS_NUM; stage++)
+        {
+            const StageDescriptorTables& tables = (state.bindings && state.bindings->graphicsStages[stage].shader)
+                ? state.bindings->graphicsStages[stage]
+                : pipeline->nullTables[stage];
+
+            if (tables.shader)
+                bindDescriptorTables(rootIndex, rootDescriptorTables, tables);
+        }
+
+        // Create the RTVs and DSVs - this may also reset the command list
+
+        D3D12_CPU_DESCRIPTOR_HANDLE RTVs[8] = {};
+        D3D12_CPU_DESCRIPTOR_HANDLE DSV = {};
+
+        for (uint32_t rt = 0; rt < state.targetCount; rt++)
+        {
+            TextureHandle target = state.targets[rt];
+
+            RTVs[rt] = m_pResources->dhRTV.GetCpuHandle(getRTV(target, state.targetIndicies[rt], state.targetMipSlices[rt]));
+
+            requireTextureState(target, state.targetIndicies[rt], state.targetMipSlices[rt], D3D12_RESOURCE_STATE_RENDER_TARGET);
+        }
+
+        TextureHandle depth = state.depthTarget;
+        if (depth)
+        {
+            DSV = m_pResources->dhDSV.GetCpuHandle(getDSV(depth, state.depthIndex, state.depthMipSlice));
+
+            D3D12_RESOURCE_STATES resourceState = D3D12_RESOURCE_STATE_DEPTH_READ;
+            if (pipelineDesc.depthStencilState.depthWriteMask == DepthStencilState::DEPTH_WRITE_MASK_ALL ||
+                pipelineDesc.depthStencilState.stencilWriteMask != 0)
+                resourceState = D3D12_RESOURCE_STATE_DEPTH_WRITE;
+
+            requireTextureState(depth, state.depthIndex, state.depthMipSlice, resourceState);
+        }
+
+        // Setup the graphics state
+
+        pipeline->fenceCounterAtLastUse = m_pResources->fenceCounter;
+
+        if (m_pResources->currentPSO != pPSO->handle)
+        {
+            m_ActiveCommandList->commandList->SetPipelineState(pPSO->handle);
+            m_pResources->currentPSO = pPSO->handle;
+        }
+
+        if (m_pResources->currentRS != pRS->handle)
+        {
+            m_ActiveCommandList->commandList->SetGraphicsRootSignature(pRS->handle);
+            m_pResources->currentRS = pRS->handle;
+        }
+
+        if (state.indexBuffer)
+            requireBufferState(state.indexBuffer, D3D12_RESOURCE_STATE_INDEX_BUFFER);
+
+        for (uint32_t i = 0; i < state.vertexBufferCount; i++)
+        {
+            requireBufferState(state.vertexBuffers[i].buffer, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER);
+        }
+
+        commitBarriers();
+
+        D3D12_INDEX_BUFFER_VIEW IBV = {};
+
+        if (state.indexBuffer)
+        {
+            IBV.BufferLocation = state.indexBuffer->gpuVA + state.indexBufferOffset;
+            IBV.Format = GetFormatMapping(state.indexBufferFormat).srvFormat;
+            IBV.SizeInBytes = state.indexBuffer->desc.byteSize - state.indexBufferOffset;
+        }
+
+        if (memcmp(&IBV, &m_pResources->currentIBV, sizeof(IBV)) != 0)
+        {
+            m_ActiveCommandList->commandList->IASetIndexBuffer(&IBV);
+            m_pResources->currentIBV = IBV;
+        }
+
+        D3D12_VERTEX_BUFFER_VIEW VBVs[16] = {};
+
+        for (uint32_t i = 0; i < state.vertexBufferCount; i++)
+        {
+            const VertexBufferBinding& binding = state.vertexBuffers[i];
+            VBVs[binding.slot].BufferLocation = binding.buffer->gpuVA + binding.offset;
+            VBVs[binding.slot].StrideInBytes = binding.stride;
+            VBVs[binding.slot].SizeInBytes = binding.buffer->desc.byteSize - binding.offset;
+        }
+        for (uint32_t i = 0; i < ARRAYSIZE(VBVs); i++)
+        {
+            if (memcmp(&VBVs[i], &m_pResources->currentVBVs[i], sizeof(VBVs[i])) != 0)
+            {
+                m_ActiveCommandList->commandList->IASetVertexBuffers(i, 1, VBVs[i].BufferLocation != 0 ? &VBVs[i] : nullptr);
+            }
+        }
+        memcpy(m_pResources->currentVBVs, VBVs, sizeof(VBVs));
+
+        m_ActiveCommandList->commandList->IASetPrimitiveTopology(convertPrimitiveType(pipelineDesc.primType));
+
+        for (uint32_t i = 0; i < rootIndex; i++)
+            m_ActiveCommandList->commandList->SetGraphicsRootDescriptorTable(i, rootDescriptorTables[i]);
+
+        uint32_t rtWidth = 0, rtHeight = 0;
+        if (state.depthTarget)
+        {
+            rtWidth = state.depthTarget->desc.width;
+            rtHeight = state.depthTarget->desc.height;
+        }
+        else if (state.targetCount > 0)
+        {
+            rtWidth = state.targets[0]->desc.width;
+            rtHeight = state.targets[0]->desc.height;
+        }
+
+        D3D12_VIEWPORT viewports[16];
+        D3D12_RECT scissorRects[16];
+
+        for (uint32_t rt = 0; rt < state.viewportCount; rt++)
+        {
+            viewports[rt].TopLeftX = state.viewports[rt].minX;
+            viewports[rt].TopLeftY = state.viewports[rt].minY;
+            viewports[rt].Width = state.viewports[rt].maxX - state.viewports[rt].minX;
+            viewports[rt].Height = state.viewports[rt].maxY - state.viewports[rt].minY;
+            viewports[rt].MinDepth = state.viewports[rt].minZ;
+            viewports[rt].MaxDepth = state.viewports[rt].maxZ;
+
+            if (pipelineDesc.rasterState.scissorEnable)
+            {
+                scissorRects[rt].left = (LONG)state.scissorRects[rt].minX;
+                scissorRects[rt].top = (LONG)state.scissorRects[rt].minY;
+                scissorRects[rt].right = (LONG)state.scissorRects[rt].maxX;
+                scissorRects[rt].bottom = (LONG)state.scissorRects[rt].maxY;
+            }
+            else
+            {
+                scissorRects[rt].left = (LONG)state.viewports[rt].minX;
+                scissorRects[rt].top = (LONG)state.viewports[rt].minY;
+                scissorRects[rt].right = (LONG)state.viewports[rt].maxX;
+                scissorRects[rt].bottom = (LONG)state.viewports[rt].maxY;
+
+                if (rtWidth > 0)
+                {
+                    scissorRects[rt].left = std::max(scissorRects[rt].left, LONG(0));
+                    scissorRects[rt].top = std::max(scissorRects[rt].top, LONG(0));
+                    scissorRects[rt].right = std::min(scissorRects[rt].right, LONG(rtWidth));
+                    scissorRects[rt].bottom = std::min(scissorRects[rt].bottom, LONG(rtHeight));
+                }
+            }
+        }
+
+        m_ActiveCommandList->commandList->RSSetViewports(state.viewportCount, viewports);
+        m_ActiveCommandList->commandList->RSSetScissorRects(state.viewportCount, scissorRects);
+
+        if (memcmp(RTVs, m_pResources->currentRTVs, sizeof(RTVs)) != 0 || DSV.ptr != m_pResources->currentDSV.ptr)
+        {
+            m_ActiveCommandList->commandList->OMSetRenderTargets(state.targetCount, RTVs, false, state.depthTarget ? &DSV : nullptr);
+            memcpy(m_pResources->currentRTVs, RTVs, sizeof(RTVs));
+            m_pResources->currentDSV = DSV;
+        }
+
+        if (pipelineDesc.depthStencilState.stencilEnable)
+        {
+            m_ActiveCommandList->commandList->OMSetStencilRef(pipelineDesc.depthStencilState.stencilRefValue);
+        }
+
+        m_ActiveCommandList->size++;
+    }
+
+    void RendererInterfaceD3D12::applyState(const ComputeState & state)
+    {
+        ComputePipelineHandle pipeline = state.pipeline;
+        RootSignatureHandle pRS = pipeline->rootSignature;
+        PipelineStateHandle pPSO = pipeline->pipelineState;
+
+        // Copy the baked descriptor tables first because that may reset the command list
+
+        uint32_t rootIndex = 0;
+        D3D12_GPU_DESCRIPTOR_HANDLE rootDescriptorTables[2];
+
+        const StageDescriptorTables& tables = (state.bindings && state.bindings->CS.shader)
+            ? state.bindings->CS
+            : pipeline->nullTables;
+
+        bindDescriptorTables(rootIndex, rootDescriptorTables, tables);
+
+        // Setup the state
+
+        pipeline->fenceCounterAtLastUse = m_pResources->fenceCounter;
+
+        if (m_pResources->currentPSO != pPSO->handle)
+        {
+            m_ActiveCommandList->commandList->SetPipelineState(pPSO->handle);
+            m_pResources->currentPSO = pPSO->handle;
+        }
+
+        if (m_pResources->currentRS != pRS->handle)
+        {
+            m_ActiveCommandList->commandList->SetComputeRootSignature(pRS->handle);
+            m_pResources->currentRS = pRS->handle;
+        }
+
+        for (uint32_t i = 0; i < rootIndex; i++)
+            m_ActiveCommandList->commandList->SetComputeRootDescriptorTable(i, rootDescriptorTables[i]);
+
+        m_ActiveCommandList->size++;
+    }
 }
@@ -11,28 +11,33 @@
 #pragma once
 
 #include <GFSDK_NVRHI.h>
+#include <vector>
 
 struct ID3D12Device;
 struct ID3D12CommandQueue;
 struct ID3D12Resource;
 struct ID3D12GraphicsCommandList;
 struct ID3D12CommandAllocator;
+struct ID3D12CommandSignature;
 
 namespace NVRHI
 {
     class PipelineState;
     class RootSignature;
-    class CommandList;
+    class NativeCommandList;
     class ManagedResource;
     typedef PipelineState* PipelineStateHandle;
     typedef RootSignature* RootSignatureHandle;
-    typedef CommandList* CommandListHandle;
+    typedef NativeCommandList* NativeCommandListHandle;
 
     typedef uint32_t ArrayIndex;
     typedef uint32_t MipLevel;
     typedef uint32_t DescriptorIndex;
 
     struct BackendResources;
+    struct StageDescriptorTables;
+    struct RootSignatureKey;
+    struct PipelineStateKey;
 
     class RendererInterfaceD3D12 : public IRendererInterface
     {
@@ -60,19 +65,21 @@ namespace NVRHI
         IErrorCallback* m_pErrorCallback;
         ID3D12Device* m_pDevice;
         ID3D12CommandQueue* m_pCommandQueue;
-        CommandListHandle m_ActiveCommandList;
+        NativeCommandListHandle m_ActiveCommandList;
 
         RendererInterfaceD3D12& operator=(const RendererInterfaceD3D12& other); //undefined
         void signalError(const char* file, int line, const char* errorDesc);
-        CommandListHandle createCommandList();
-        uint32_t getStateHashForRS(const DrawCallState& state);
-        uint32_t getStateHashForPSO(const DrawCallState& state);
-        uint32_t getComputeStateHash(const DispatchState& state);
+        NativeCommandListHandle createNativeCommandList();
+        template<typename TDrawCallState> void getStateKeyForRS(const TDrawCallState& state, RootSignatureKey& key);
+        template<typename TDrawCallState> void getStateKeyForPSO(const TDrawCallState& state, PipelineStateKey& key);
         RootSignatureHandle buildRootSignature(uint32_t numShaders, const ShaderHandle* shaders, bool allowInputLayout);
-        RootSignatureHandle getRootSignature(const DrawCallState& state);
-        RootSignatureHandle getRootSignature(const DispatchState& state, uint32_t hash);
-        PipelineStateHandle getPipelineState(const DrawCallState& state, RootSignatureHandle pRS);
-        PipelineStateHandle getPipelineState(const DispatchState& state, RootSignatureHandle pRS, uint32_t hash);
+        template<typename TDrawCallState> RootSignatureHandle getRootSignature(const TDrawCallState& state);
+        RootSignatureHandle getRootSignature(const DispatchState& state);
+        template<typename TDrawCallState> PipelineStateHandle getPipelineState(const TDrawCallState& state, RootSignatureHandle pRS);
+        PipelineStateHandle getPipelineState(const DispatchState& state, RootSignatureHandle pRS);
+        void releaseCachedObjects(const std::vector<RootSignatureHandle>& rootsigs, std::vector<PipelineStateHandle>& psos);
+        PipelineStateHandle createPipelineState(const GraphicsPipelineDesc& pipelineDesc, RootSignatureHandle pRS);
+        PipelineStateHandle createPipelineState(ShaderHandle computeShader, RootSignatureHandle pRS);
         DescriptorIndex getCBV(ConstantBufferHandle cbuffer);
         DescriptorIndex getTextureSRV(const TextureBinding& binding);
         DescriptorIndex getTextureUAV(const TextureBinding& binding);
@@ -90,23 +97,45 @@ namespace NVRHI
         void requireTextureState(TextureHandle texture, uint32_t arrayIndex, uint32_t mipLevel, uint32_t state);
         void requireBufferState(BufferHandle buffer, uint32_t state);
         void commitBarriers();
+        void clearTextureRegion(TextureHandle t, const TextureRegion& region, bool asUINT, const Color& clearColor, uint32_t clearValue);
 
-        void bindShaderResources(uint32_t& rootIndex, void* rootDescriptorTableHandles, const PipelineStageBindings& stage);
+        template<typename TStageBindings> void bindShaderResources(uint32_t& rootIndex, void* rootDescriptorTableHandles, const TStageBindings& stage);
+        template<typename TDrawCallState> void applyDrawCallState(const TDrawCallState& state);
+        void bakeDescriptorTables(const PipelineStageBindings& stage, StageDescriptorTables& tables);
+        void bindDescriptorTables(uint32_t& rootIndex, void* rootDescriptorTableHandles, const StageDescriptorTables& tables);
+        bool validateGraphicsState(const GraphicsState& state);
+        bool validateComputeState(const ComputeState& state);
+        ID3D12CommandSignature* getDrawIndirectSignature(bool indexed, uint32_t stride);
+        void executeIndirectDraws(bool indexed, uint32_t indexBufferOffset, BufferHandle argsBuffer, uint32_t argsOffsetBytes, uint32_t argsStrideBytes, uint32_t maxDrawCount, BufferHandle countBuffer, uint32_t countOffsetBytes);
 
         void syncWithGPU(const char* reason);
         void waitForFence(unsigned long long fenceValue, const char* reason);
+        void retireCompletedFrames();
+
+        ReadbackHandle allocateReadback(uint64_t size);
 
     public:
         virtual TextureHandle createTexture(const TextureDesc& d, const void* data);
         virtual TextureDesc describeTexture(TextureHandle t);
         virtual void clearTextureFloat(TextureHandle t, const Color& clearColor);
         virtual void clearTextureUInt(TextureHandle t, uint32_t clearColor);
+        virtual void clearTextureRegionFloat(TextureHandle t, const TextureRegion& region, const Color& clearColor);
+        virtual void clearTextureRegionUInt(TextureHandle t, const TextureRegion& region, uint32_t clearColor);
         virtual void writeTexture(TextureHandle t, uint32_t subresource, const void* data, uint32_t rowPitch, uint32_t depthPitch);
+        virtual void writeTextureRegion(TextureHandle t, const TextureRegion& region, const void* data, uint32_t rowPitch, uint32_t depthPitch);
+        virtual void copyTexture(TextureHandle dest, const TextureRegion& destRegion, TextureHandle src, const TextureRegion& srcRegion);
+        virtual void copyBufferToTexture(TextureHandle dest, const TextureRegion& destRegion, BufferHandle src, uint32_t srcOffsetBytes, uint32_t rowPitch, uint32_t depthPitch);
+        virtual void copyTextureToBuffer(BufferHandle dest, uint32_t destOffsetBytes, uint32_t rowPitch, uint32_t depthPitch, TextureHandle src, const TextureRegion& srcRegion);
+        virtual void resolveTexture(TextureHandle dest, uint32_t destMipLevel, uint32_t destArraySlice, TextureHandle src, uint32_t srcArraySlice);
         virtual void destroyTexture(TextureHandle t);
 
         virtual BufferHandle createBuffer(const BufferDesc& d, const void* data);
         virtual void writeBuffer(BufferHandle b, const void* data, size_t dataSize);
+        virtual void writeBufferRange(BufferHandle b, uint32_t offsetBytes, const void* data, size_t dataSize);
+        virtual void* mapBuffer(BufferHandle b, MapMode::Enum mode, uint32_t offsetBytes, size_t sizeBytes);
+        virtual void unmapBuffer(BufferHandle b);
         virtual void clearBufferUInt(BufferHandle b, uint32_t clearValue);
+        virtual void clearBufferUIntRange(BufferHandle b, uint32_t offsetBytes, size_t sizeBytes, uint32_t clearValue);
         virtual void copyToBuffer(BufferHandle dest, uint32_t destOffsetBytes, BufferHandle src, uint32_t srcOffsetBytes, size_t dataSizeBytes);
         virtual void readBuffer(BufferHandle b, void* data, size_t* dataSize);
         virtual void destroyBuffer(BufferHandle b);
@@ -150,7 +179,65 @@ namespace NVRHI
 		virtual void setEnableUavBarriersForTexture(TextureHandle texture, bool enableBarriers);
 		virtual void setEnableUavBarriersForBuffer(BufferHandle buffer, bool enableBarriers);
 
+        virtual GraphicsPipelineHandle createGraphicsPipeline(const GraphicsPipelineDesc& d);
+        virtual void destroyGraphicsPipeline(GraphicsPipelineHandle p);
+        virtual ComputePipelineHandle createComputePipeline(const ComputePipelineDesc& d);
+        virtual void destroyComputePipeline(ComputePipelineHandle p);
+        virtual BindingSetHandle createBindingSet(const BindingSetDesc& d);
+        virtual void destroyBindingSet(BindingSetHandle b);
+
+        virtual void drawWithPipeline(const GraphicsState& state, const DrawArguments* args, uint32_t numDrawCalls);
+        virtual void drawIndexedWithPipeline(const GraphicsState& state, const DrawArguments* args, uint32_t numDrawCalls);
+        virtual void drawIndirectWithPipeline(const GraphicsState& state, BufferHandle indirectParams, uint32_t offsetBytes);
+        virtual void dispatchWithPipeline(const ComputeState& state, uint32_t groupsX, uint32_t groupsY, uint32_t groupsZ);
+        virtual void dispatchIndirectWithPipeline(const ComputeState& state, BufferHandle indirectParams, uint32_t offsetBytes);
+
+        virtual void drawCompact(const CompactDrawCallState& state, const DrawArguments* args, uint32_t numDrawCalls);
+        virtual void drawIndexedCompact(const CompactDrawCallState& state, const DrawArguments* args, uint32_t numDrawCalls);
+        virtual void drawIndirectCompact(const CompactDrawCallState& state, BufferHandle indirectParams, uint32_t offsetBytes);
+
+        virtual CommandListHandle createCommandList();
+        virtual void destroyCommandList(CommandListHandle commandList);
+        virtual void executeCommandLists(const CommandListHandle* commandLists, uint32_t numCommandLists);
+
+        virtual ReadbackHandle beginBufferReadback(BufferHandle b, uint32_t offsetBytes, size_t sizeBytes);
+        virtual ReadbackHandle beginTextureReadback(TextureHandle t, const TextureRegion& region);
+        virtual bool isReadbackReady(ReadbackHandle r);
+        virtual const void* mapReadback(ReadbackHandle r, uint32_t* rowPitch, uint32_t* depthPitch);
+        virtual void releaseReadback(ReadbackHandle r);
+        virtual FenceHandle createFence();
+        virtual void destroyFence(FenceHandle f);
+        virtual void signalFence(FenceHandle f, uint64_t value);
+        virtual uint64_t getFenceCompletedValue(FenceHandle f);
+        virtual void waitFence(FenceHandle f, uint64_t value);
+        virtual void setMaxFramesInFlight(uint32_t maxFrames);
+        virtual void beginFrame();
+        virtual void endFrame();
+        virtual FrameStatistics getFrameStatistics();
+        virtual void drawIndexedIndirect(const DrawCallState& state, BufferHandle indirectParams, uint32_t offsetBytes);
+        virtual void multiDrawIndirect(const DrawCallState& state, BufferHandle argsBuffer, uint32_t argsOffsetBytes, uint32_t argsStrideBytes, uint32_t maxDrawCount, BufferHandle countBuffer, uint32_t countOffsetBytes);
+        virtual void multiDrawIndexedIndirect(const DrawCallState& state, BufferHandle argsBuffer, uint32_t argsOffsetBytes, uint32_t argsStrideBytes, uint32_t maxDrawCount, BufferHandle countBuffer, uint32_t countOffsetBytes);
+        virtual void drawIndexedIndirectWithPipeline(const GraphicsState& state, BufferHandle indirectParams, uint32_t offsetBytes);
+        virtual void multiDrawIndirectWithPipeline(const GraphicsState& state, BufferHandle argsBuffer, uint32_t argsOffsetBytes, uint32_t argsStrideBytes, uint32_t maxDrawCount, BufferHandle countBuffer, uint32_t countOffsetBytes);
+        virtual void multiDrawIndexedIndirectWithPipeline(const GraphicsState& state, BufferHandle argsBuffer, uint32_t argsOffsetBytes, uint32_t argsStrideBytes, uint32_t maxDrawCount, BufferHandle countBuffer, uint32_t countOffsetBytes);
+        virtual void drawIndexedIndirectCompact(const CompactDrawCallState& state, BufferHandle indirectParams, uint32_t offsetBytes);
+        virtual void multiDrawIndirectCompact(const CompactDrawCallState& state, BufferHandle argsBuffer, uint32_t argsOffsetBytes, uint32_t argsStrideBytes, uint32_t maxDrawCount, BufferHandle countBuffer, uint32_t countOffsetBytes);
+        virtual void multiDrawIndexedIndirectCompact(const CompactDrawCallState& state, BufferHandle argsBuffer, uint32_t argsOffsetBytes, uint32_t argsStrideBytes, uint32_t maxDrawCount, BufferHandle countBuffer, uint32_t countOffsetBytes);
+        virtual void setStateCacheLimits(uint32_t maxEntries, uint64_t maxBytes);
+
+        using IRendererInterface::draw;
+        using IRendererInterface::drawIndexed;
+        using IRendererInterface::drawIndirect;
+        using IRendererInterface::drawIndexedIndirect;
+        using IRendererInterface::multiDrawIndirect;
+        using IRendererInterface::multiDrawIndexedIndirect;
+        using IRendererInterface::dispatch;
+        using IRendererInterface::dispatchIndirect;
+
         void applyState(const DrawCallState& state);
+        void applyState(const CompactDrawCallState& state);
         void applyState(const DispatchState& state);
+        void applyState(const GraphicsState& state);
+        void applyState(const ComputeState& state);
     };
 }
@@ -0,0 +1,127 @@
+/*
+* Copyright (c) 2012-2016, NVIDIA CORPORATION. All rights reserved.
+*
+* NVIDIA CORPORATION and its licensors retain all intellectual property
+* and proprietary rights in and to this software, related documentation
+* and any modifications thereto. Any use, reproduction, disclosure or
+* distribution of this software and related documentation without an express
+* license agreement from NVIDIA CORPORATION is strictly prohibited.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+namespace NVRHI
+{
+    // 64-bit hash of the state objects that the backends use as cache keys.
+    // Values are consumed in 16 byte blocks by two independent accumulators with the xxHash64 round, which only needs
+    // 64-bit multiplies and rotates, so there is no CPU feature detection or instruction set specific code path,
+    // and the two multiply chains run in parallel. The remaining 8, 4 and 1 byte pieces go through the same round.
+    // The hash only selects a bucket. The caches store the whole key and compare it on lookup, so two keys
+    // with the same hash never share a cached object.
+    class StateHash
+    {
+    private:
+        static const uint64_t Prime1 = 0x9E3779B185EBCA87ull;
+        static const uint64_t Prime2 = 0xC2B2AE3D27D4EB4Full;
+        static const uint64_t Prime3 = 0x165667B19E3779F9ull;
+
+        uint64_t hash[2];
+        uint64_t length;
+
+        static uint64_t Rotl(uint64_t x, int r)
+        {
+            return (x << r) | (x >> (64 - r));
+        }
+
+        static uint64_t Round(uint64_t acc, uint64_t lane)
+        {
+            acc += lane * Prime2;
+            acc = Rotl(acc, 31);
+            return acc * Prime1;
+        }
+
+    public:
+        StateHash(uint64_t seed = 0)
+            : length(0)
+        {
+            hash[0] = seed + Prime1 + Prime2;
+            hash[1] = seed - Prime1;
+        }
+
+        uint64_t Get() const
+        {
+            uint64_t h = Rotl(hash[0], 1) + Rotl(hash[1], 7) + length;
+            h ^= h >> 33;
+            h *= Prime2;
+            h ^= h >> 29;
+            h *= Prime3;
+            h ^= h >> 32;
+            return h;
+        }
+
+        void AddBytes(const void* p, size_t size)
+        {
+            const uint8_t* data = static_cast<const uint8_t*>(p);
+            length += size;
+
+            for (; size >= 16; data += 16, size -= 16)
+            {
+                uint64_t lanes[2];
+                memcpy(lanes, data, 16);
+                hash[0] = Round(hash[0], lanes[0]);
+                hash[1] = Round(hash[1], lanes[1]);
+            }
+
+            if (size >= 8)
+            {
+                uint64_t lane;
+                memcpy(&lane, data, 8);
+                hash[0] = Round(hash[0], lane);
+                data += 8;
+                size -= 8;
+            }
+
+            if (size >= 4)
+            {
+                uint32_t lane;
+                memcpy(&lane, data, 4);
+                hash[1] = Round(hash[1], lane);
+                data += 4;
+                size -= 4;
+            }
+
+            for (; size > 0; data++, size--)
+                hash[1] = Round(hash[1], *data);
+        }
+
+        // The whole object representation is hashed, so T must not have uninitialized padding
+        template<typename T> void Add(const T& value)
+        {
+            AddBytes(&value, sizeof(value));
+        }
+    };
+
+    // Hash and equality functors for unordered containers whose keys are compared byte by byte.
+    // The key types are plain structures without implicit padding, or ones that clear it in their constructors.
+    template<typename T> struct BytewiseHash
+    {
+        size_t operator()(const T& value) const
+        {
+            StateHash hasher;
+            hasher.Add(value);
+            return size_t(hasher.Get());
+        }
+    };
+
+    template<typename T> struct BytewiseEqual
+    {
+        bool operator()(const T& a, const T& b) const
+        {
+            return memcmp(&a, &b, sizeof(T)) == 0;
+        }
+    };
+}
@@ -9,6 +9,7 @@
 */
 
 #include "GFSDK_NVRHI_OpenGL4.h"
+#include "GFSDK_NVRHI_CommandList.h"
 
 #ifdef _WIN32
 #include <Windows.h>
@@ -18,15 +19,42 @@
 #include <gl/glew.h>
 
 #include <assert.h>
+#include <stdio.h>
 #include <utility>
+#include <algorithm>
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Debug builds check glGetError after GL calls, or get the errors from KHR_debug when it is available.
+// Release builds make no glGetError calls. Define NVRHI_GL_CHECK_ERRORS to 0 or 1 to override the default.
+#ifndef NVRHI_GL_CHECK_ERRORS
+#ifdef _DEBUG
+#define NVRHI_GL_CHECK_ERRORS 1
+#else
+#define NVRHI_GL_CHECK_ERRORS 0
+#endif
+#endif
+
+#if NVRHI_GL_CHECK_ERRORS
 #define CHECK_GL_ERROR() checkGLError(__FILE__, __LINE__)
+#else
+#define CHECK_GL_ERROR() ((void)0)
+#endif
 #define SIGNAL_ERROR(msg) m_pErrorCallback->signalError(__FILE__, __LINE__, msg)
 #define SIGNAL_ERROR_FMT(...) { char __error_buf[4096]; sprintf_s(__error_buf, __VA_ARGS__); m_pErrorCallback->signalError(__FILE__, __LINE__, __error_buf); }
 
 
 namespace NVRHI
 {
+    // Barrier after every dispatch, for the consumers of buffers that a compute shader wrote: shader reads, buffer updates and readbacks,
+    // and the parameters of indirect draws, indirect dispatches and draw counts, which the culling stage produces
+    static const GLbitfield DispatchBarrierBits = GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT;
+
     struct FormatMapping
     {
         Format::Enum abstractFormat;
@@ -80,104 +108,6 @@ namespace NVRHI
         return mapping;
     }
 
-    bool GetSSE42Support()
-    {
-        int cpui[4];
-        __cpuidex(cpui, 1, 0);
-        return !!(cpui[2] & 0x100000);
-    }
-
-    static const bool CpuSupportsSSE42 = GetSSE42Support();
-
-    static const uint32_t CrcTable[] = {
-        0x00000000, 0x77073096, 0xee0e612c, 0x990951ba, 0x076dc419, 0x706af48f,
-        0xe963a535, 0x9e6495a3, 0x0edb8832, 0x79dcb8a4, 0xe0d5e91e, 0x97d2d988,
-        0x09b64c2b, 0x7eb17cbd, 0xe7b82d07, 0x90bf1d91, 0x1db71064, 0x6ab020f2,
-        0xf3b97148, 0x84be41de, 0x1adad47d, 0x6ddde4eb, 0xf4d4b551, 0x83d385c7,
-        0x136c9856, 0x646ba8c0, 0xfd62f97a, 0x8a65c9ec, 0x14015c4f, 0x63066cd9,
-        0xfa0f3d63, 0x8d080df5, 0x3b6e20c8, 0x4c69105e, 0xd56041e4, 0xa2677172,
-        0x3c03e4d1, 0x4b04d447, 0xd20d85fd, 0xa50ab56b, 0x35b5a8fa, 0x42b2986c,
-        0xdbbbc9d6, 0xacbcf940, 0x32d86ce3, 0x45df5c75, 0xdcd60dcf, 0xabd13d59,
-        0x26d930ac, 0x51de003a, 0xc8d75180, 0xbfd06116, 0x21b4f4b5, 0x56b3c423,
-        0xcfba9599, 0xb8bda50f, 0x2802b89e, 0x5f058808, 0xc60cd9b2, 0xb10be924,
-        0x2f6f7c87, 0x58684c11, 0xc1611dab, 0xb6662d3d, 0x76dc4190, 0x01db7106,
-        0x98d220bc, 0xefd5102a, 0x71b18589, 0x06b6b51f, 0x9fbfe4a5, 0xe8b8d433,
-        0x7807c9a2, 0x0f00f934, 0x9609a88e, 0xe10e9818, 0x7f6a0dbb, 0x086d3d2d,
-        0x91646c97, 0xe6635c01, 0x6b6b51f4, 0x1c6c6162, 0x856530d8, 0xf262004e,
-        0x6c0695ed, 0x1b01a57b, 0x8208f4c1, 0xf50fc457, 0x65b0d9c6, 0x12b7e950,
-        0x8bbeb8ea, 0xfcb9887c, 0x62dd1ddf, 0x15da2d49, 0x8cd37cf3, 0xfbd44c65,
-        0x4db26158, 0x3ab551ce, 0xa3bc0074, 0xd4bb30e2, 0x4adfa541, 0x3dd895d7,
-        0xa4d1c46d, 0xd3d6f4fb, 0x4369e96a, 0x346ed9fc, 0xad678846, 0xda60b8d0,
-        0x44042d73, 0x33031de5, 0xaa0a4c5f, 0xdd0d7cc9, 0x5005713c, 0x270241aa,
-        0xbe0b1010, 0xc90c2086, 0x5768b525, 0x206f85b3, 0xb966d409, 0xce61e49f,
-        0x5edef90e, 0x29d9c998, 0xb0d09822, 0xc7d7a8b4, 0x59b33d17, 0x2eb40d81,
-        0xb7bd5c3b, 0xc0ba6cad, 0xedb88320, 0x9abfb3b6, 0x03b6e20c, 0x74b1d29a,
-        0xead54739, 0x9dd277af, 0x04db2615, 0x73dc1683, 0xe3630b12, 0x94643b84,
-        0x0d6d6a3e, 0x7a6a5aa8, 0xe40ecf0b, 0x9309ff9d, 0x0a00ae27, 0x7d079eb1,
-        0xf00f9344, 0x8708a3d2, 0x1e01f268, 0x6906c2fe, 0xf762575d, 0x806567cb,
-        0x196c3671, 0x6e6b06e7, 0xfed41b76, 0x89d32be0, 0x10da7a5a, 0x67dd4acc,
-        0xf9b9df6f, 0x8ebeeff9, 0x17b7be43, 0x60b08ed5, 0xd6d6a3e8, 0xa1d1937e,
-        0x38d8c2c4, 0x4fdff252, 0xd1bb67f1, 0xa6bc5767, 0x3fb506dd, 0x48b2364b,
-        0xd80d2bda, 0xaf0a1b4c, 0x36034af6, 0x41047a60, 0xdf60efc3, 0xa867df55,
-        0x316e8eef, 0x4669be79, 0xcb61b38c, 0xbc66831a, 0x256fd2a0, 0x5268e236,
-        0xcc0c7795, 0xbb0b4703, 0x220216b9, 0x5505262f, 0xc5ba3bbe, 0xb2bd0b28,
-        0x2bb45a92, 0x5cb36a04, 0xc2d7ffa7, 0xb5d0cf31, 0x2cd99e8b, 0x5bdeae1d,
-        0x9b64c2b0, 0xec63f226, 0x756aa39c, 0x026d930a, 0x9c0906a9, 0xeb0e363f,
-        0x72076785, 0x05005713, 0x95bf4a82, 0xe2b87a14, 0x7bb12bae, 0x0cb61b38,
-        0x92d28e9b, 0xe5d5be0d, 0x7cdcefb7, 0x0bdbdf21, 0x86d3d2d4, 0xf1d4e242,
-        0x68ddb3f8, 0x1fda836e, 0x81be16cd, 0xf6b9265b, 0x6fb077e1, 0x18b74777,
-        0x88085ae6, 0xff0f6a70, 0x66063bca, 0x11010b5c, 0x8f659eff, 0xf862ae69,
-        0x616bffd3, 0x166ccf45, 0xa00ae278, 0xd70dd2ee, 0x4e048354, 0x3903b3c2,
-        0xa7672661, 0xd06016f7, 0x4969474d, 0x3e6e77db, 0xaed16a4a, 0xd9d65adc,
-        0x40df0b66, 0x37d83bf0, 0xa9bcae53, 0xdebb9ec5, 0x47b2cf7f, 0x30b5ffe9,
-        0xbdbdf21c, 0xcabac28a, 0x53b39330, 0x24b4a3a6, 0xbad03605, 0xcdd70693,
-        0x54de5729, 0x23d967bf, 0xb3667a2e, 0xc4614ab8, 0x5d681b02, 0x2a6f2b94,
-        0xb40bbe37, 0xc30c8ea1, 0x5a05df1b, 0x2d02ef8d
-    };
-
-    class CrcHash
-    {
-    private:
-        uint32_t crc;
-    public:
-        CrcHash() 
-            : crc(0) 
-        { 
-        }
-
-        uint32_t Get() 
-        {
-            return crc;
-        }
-
-        template<size_t size> __forceinline void AddBytesSSE42(void* p)
-        {
-            static_assert(size % 4 == 0, "Size of hashable types must be multiple of 4");
-
-            uint32_t* data = (uint32_t*)p;
-
-            const size_t numIterations = size / sizeof(uint32_t);
-            for (size_t i = 0; i < numIterations; i++)
-            {
-                crc = _mm_crc32_u32(crc, data[i]);
-            }
-        }
-
-        __forceinline void AddBytes(char* p, uint32_t size)
-        {
-            for (uint32_t idx = 0; idx < size; idx++)
-                crc = CrcTable[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
-        }
-
-        template<typename T> void Add(const T& value)
-        {
-            if (CpuSupportsSSE42)
-                AddBytesSSE42<sizeof(value)>((void*)&value);
-            else
-                AddBytes((char*)&value, sizeof(value));
-        }
-    };
-
     class Texture
     {
     public:
@@ -186,13 +116,12 @@ namespace NVRHI
         GLuint handle;
         GLenum bindTarget;
         GLuint srgbView;
-        bool usedInFrameBuffers;
+        std::vector<FrameBuffer*> frameBuffers; // cached framebuffers that have this texture attached
 
         Texture()
             : handle(0)
             , bindTarget(0)
             , srgbView(0)
-            , usedInFrameBuffers(false)
         { }
 
         ~Texture()
@@ -210,10 +139,20 @@ namespace NVRHI
         GLuint ssboHandle;
         GLenum bindTarget;
 
+        // State of mapBuffer; mappedRingPosition is ~0 when the range is mapped directly instead of through the upload ring
+        bool isMapped;
+        uint32_t mappedOffset;
+        uint32_t mappedSize;
+        uint64_t mappedRingPosition;
+
         Buffer()
             : bufferHandle(0)
             , ssboHandle(0)
             , bindTarget(0)
+            , isMapped(false)
+            , mappedOffset(0)
+            , mappedSize(0)
+            , mappedRingPosition(~0ull)
         { }
 
         ~Buffer()
@@ -226,14 +165,92 @@ namespace NVRHI
         }
     };
 
+    // Staging buffer used for one readback at a time, recycled through RendererInterfaceOGL::m_FreeReadbacks
+    class Readback
+    {
+    public:
+        GLuint buffer;
+        size_t capacity;
+        size_t size;
+        uint32_t rowPitch;
+        uint32_t depthPitch;
+        GLsync fence;
+        const void* mappedData;
+
+        Readback()
+            : buffer(0)
+            , capacity(0)
+            , size(0)
+            , rowPitch(0)
+            , depthPitch(0)
+            , fence(nullptr)
+            , mappedData(nullptr)
+        { }
+
+        ~Readback()
+        {
+            if (fence)
+                glDeleteSync(fence);
+
+            if (buffer)
+                glDeleteBuffers(1, &buffer);
+        }
+    };
+
+    // Timestamps are read without blocking, so every begin/end pair stays in flight until its results are available.
+    // The time reported is the one from the most recent pair that has completed.
+    class PerformanceQuery
+    {
+    public:
+        enum State { NEW, STARTED, ANNOTATION, FINISHED };
+
+        // Pairs beyond this many in flight are recycled without being read, for queries that are never asked for their time
+        enum { MAX_PENDING_PAIRS = 8 };
+
+        std::string name;
+        std::deque<std::pair<GLuint, GLuint>> pendingPairs;
+        std::pair<GLuint, GLuint> currentPair;
+        State state;
+        float time;
+
+        PerformanceQuery()
+            : currentPair(0, 0)
+            , state(NEW)
+            , time(0.f)
+        { }
+    };
+
+    // GL has no timeline objects, so a fence is a chain of sync objects, one per signaled value
+    class Fence
+    {
+    public:
+        uint64_t completedValue;
+        std::deque<std::pair<uint64_t, GLsync>> pendingSignals;
+
+        Fence()
+            : completedValue(0)
+        { }
+
+        ~Fence()
+        {
+            for (auto& signal : pendingSignals)
+                glDeleteSync(signal.second);
+        }
+    };
+
     class ConstantBuffer
     {
     public:
         ConstantBufferDesc desc;
-        GLuint handle;
+        GLuint handle;                  // only used without the upload ring
+        std::vector<uint8_t> data;      // contents that are copied into the upload ring on the first use after a write
+        uint64_t ringPosition;
+        bool uploadedDataValid;
 
         ConstantBuffer()
             : handle(0)
+            , ringPosition(0)
+            , uploadedDataValid(false)
         { }
 
         ~ConstantBuffer()
@@ -280,1229 +297,4215 @@ namespace NVRHI
         }
     };
 
-    class FrameBuffer
+    // Separable programs of one shader combination, indexed by ShaderType with the compute shader last
+    class ProgramPipeline
     {
     public:
+        ShaderHandle shaders[ShaderType::GRAPHIC_SHADERS_NUM + 1];
         GLuint handle;
-        GLenum drawBuffers[8];
-        uint32_t numBuffers;
-        TextureHandle depthTarget;
-        TextureHandle renderTargets[8];
 
-        FrameBuffer() 
-            : handle(0) 
-            , numBuffers(0)
-            , depthTarget(nullptr)
-        { 
-            memset(renderTargets, 0, sizeof(renderTargets));
+        ProgramPipeline()
+            : handle(0)
+        {
+            memset(shaders, 0, sizeof(shaders));
         }
 
-        ~FrameBuffer()
+        ~ProgramPipeline()
         {
             if (handle)
-                glDeleteFramebuffers(1, &handle);
+                glDeleteProgramPipelines(1, &handle);
         }
     };
 
-    class InputLayout
+    // Read-only mapping of a whole file
+    class MappedFile
     {
     public:
-        std::vector<VertexAttributeDesc> attributes;
-    };
-
-    RendererInterfaceOGL::RendererInterfaceOGL(IErrorCallback* pErrorCallback) 
-        : m_pErrorCallback(pErrorCallback)
-        , m_nGraphicsPipeline(0)
-        , m_nComputePipeline(0)
-        , m_nVAO(0)
-        , m_bConservativeRasterEnabled(false)
-        , m_bForcedSampleCountEnabled(false)
-        , m_pCurrentFrameBuffer(nullptr)
-    { 
-        m_DefaultBackBuffer = new Texture();
-    }
+        const uint8_t* data;
+        size_t size;
 
+        MappedFile()
+            : data(nullptr)
+            , size(0)
+#ifdef _WIN32
+            , file(INVALID_HANDLE_VALUE)
+            , mapping(nullptr)
+#else
+            , file(-1)
+#endif
+        { }
 
-    RendererInterfaceOGL::~RendererInterfaceOGL()
-    {
-        for (auto& pair : m_CachedFrameBuffers)
-        {
-            delete pair.second;
-        }
-    
-        if (m_nGraphicsPipeline)
+        ~MappedFile()
         {
-            glDeleteProgramPipelines(1, &m_nGraphicsPipeline);
+            Close();
         }
 
-        if (m_nComputePipeline)
+        bool Open(const char* fileName)
         {
-            glDeleteProgramPipelines(1, &m_nComputePipeline);
-        }
+            Close();
 
-        if (m_nVAO)
-        {
-            glDeleteVertexArrays(1, &m_nVAO);
-        }
+#ifdef _WIN32
+            file = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (file == INVALID_HANDLE_VALUE)
+                return false;
 
-        delete m_DefaultBackBuffer;
-    }
+            LARGE_INTEGER fileSize;
+            if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0 || uint64_t(fileSize.QuadPart) > SIZE_MAX)
+            {
+                Close();
+                return false;
+            }
 
+            mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            const void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+            if (!view)
+            {
+                Close();
+                return false;
+            }
 
-    void RendererInterfaceOGL::init()
-    {
-        glGenProgramPipelines(1, &m_nGraphicsPipeline);
-        glGenProgramPipelines(1, &m_nComputePipeline);
-    }
+            size = size_t(fileSize.QuadPart);
+#else
+            file = open(fileName, O_RDONLY);
+            if (file < 0)
+                return false;
 
-    bool RendererInterfaceOGL::isOpenGLExtensionSupported(const char* name)
-    {
-        int n = 0;
-		int max = 0;
-		glGetIntegerv(GL_NUM_EXTENSIONS, &max);
+            struct stat fileStat;
+            if (fstat(file, &fileStat) != 0 || fileStat.st_size <= 0)
+            {
+                Close();
+                return false;
+            }
 
-		const char* glext = NULL;
-		bool bFound = false;
+            void* view = mmap(nullptr, size_t(fileStat.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+            if (view == MAP_FAILED)
+            {
+                Close();
+                return false;
+            }
 
-		while (!bFound && n < max)
-		{
-			glext = (const char*)glGetStringi(GL_EXTENSIONS, n++);
-			bFound = (strcmp(glext, name) == 0);
+            size = size_t(fileStat.st_size);
+#endif
+            data = static_cast<const uint8_t*>(view);
+            return true;
+        }
 
-			//char pDebugStr[255];
-			//sprintf_s(pDebugStr, "%d. %s\n", n, glext);
-			//OutputDebugStringA(pDebugStr);
-		}
+        void Close()
+        {
+#ifdef _WIN32
+            if (data)
+                UnmapViewOfFile(data);
+            if (mapping)
+                CloseHandle(mapping);
+            if (file != INVALID_HANDLE_VALUE)
+                CloseHandle(file);
+
+            file = INVALID_HANDLE_VALUE;
+            mapping = nullptr;
+#else
+            if (data)
+                munmap(const_cast<uint8_t*>(data), size);
+            if (file >= 0)
+                close(file);
+
+            file = -1;
+#endif
+            data = nullptr;
+            size = 0;
+        }
 
-        return bFound;
-    }
+    private:
+#ifdef _WIN32
+        HANDLE file;
+        HANDLE mapping;
+#else
+        int file;
+#endif
+    };
 
-    void* RendererInterfaceOGL::getOpenGLProcAddress(const char* procname)
+    // Identifies the source of a program in the binary archive. The archive doesn't keep the sources to compare them,
+    // so the key has two 64-bit hashes with different seeds besides the size.
+    struct ProgramBinaryKey
     {
-    #ifdef _WIN32
-        return wglGetProcAddress(procname);
-    #else
-        return nullptr;
-    #endif
-    }
+        uint64_t sourceHash[2];
+        uint32_t sourceSize;
+        uint32_t shaderType;
+    };
 
-    TextureHandle RendererInterfaceOGL::createTexture(const TextureDesc& d, const void* data)
+    // Layout of the archive file: the header, the GL_RENDERER and GL_VERSION strings of the device that created it,
+    // the entry table, then the binaries. All parts start at multiples of 8 bytes, and everything is in native byte order.
+    struct ProgramArchiveHeader
     {
-        const FormatMapping& formatMapping = GetFormatMapping(d.format);
-
-        TextureHandle texture = new Texture();
-        texture->desc = d;
-        texture->formatMapping = formatMapping;
-        glGenTextures(1, &texture->handle);
-
-        uint32_t numlayers = 1;
-    
-        if (d.isCubeMap)
-        {
-            texture->bindTarget = GL_TEXTURE_CUBE_MAP;
-            glBindTexture(texture->bindTarget, texture->handle);
+        uint32_t magic;
+        uint32_t version;
+        uint32_t deviceStringSize;
+        uint32_t entryCount;
+        uint64_t checksum;      // of the header with this field zero, the device string and the entry table
+    };
 
-            glTexStorage2D(
-                texture->bindTarget,
-                d.mipLevels,
-                formatMapping.internalFormat,
-                d.width,
-                d.height);
+    struct ProgramArchiveEntry
+    {
+        ProgramBinaryKey key;
+        uint32_t binaryFormat;
+        uint32_t binarySize;
+        uint64_t offset;
+        uint64_t checksum;      // of the binary, checked when the program is first loaded
+    };
 
-            numlayers = 6;
+    // Program binaries from the archive file and from the programs compiled since it was opened.
+    // Anything in the file that doesn't check out is dropped rather than reported: a different device or a damaged header or table
+    // discards the whole file, and a damaged binary or one that the driver rejects discards that entry. The programs are then
+    // compiled from source, and the next save replaces the file.
+    class ProgramBinaryArchive
+    {
+    public:
+        enum { MAGIC = 0x4252504E, VERSION = 1 }; // "NPRB"
 
-            CHECK_GL_ERROR();
-        }
-        else if (d.isArray)
+        struct Binary
         {
-            texture->bindTarget = GL_TEXTURE_2D_ARRAY;
-            glBindTexture(texture->bindTarget, texture->handle);
-
-            glTexStorage3D(texture->bindTarget,
-                d.mipLevels,
-                formatMapping.internalFormat,
-                d.width,
-                d.height,
-                d.depthOrArraySize);
-
-            numlayers = d.depthOrArraySize;
+            uint32_t format;
+            uint32_t size;
+            const uint8_t* data;        // in the mapped file or in storage
+            uint64_t checksum;
+            bool verified;
+            bool used;
+            std::vector<uint8_t> storage;
+        };
+
+        std::string fileName;
+        std::string deviceString;
+        std::vector<GLint> formats;
+        CacheStatistics statistics;
+
+        ProgramBinaryArchive()
+            : modified(false)
+        { }
 
-            CHECK_GL_ERROR();
-        }
-        else if (d.depthOrArraySize > 0)
+        static ProgramBinaryKey GetKey(ShaderType::Enum shaderType, const char* source)
         {
-            texture->bindTarget = GL_TEXTURE_3D;
-            glBindTexture(texture->bindTarget, texture->handle);
-
-            glTexStorage3D(texture->bindTarget,
-                d.mipLevels,
-                formatMapping.internalFormat,
-                d.width,
-                d.height,
-                d.depthOrArraySize);
-
-            CHECK_GL_ERROR();
+            ProgramBinaryKey key;
+            size_t size = strlen(source);
+            StateHash first(0), second(~0ull);
+            first.AddBytes(source, size);
+            second.AddBytes(source, size);
+            key.sourceHash[0] = first.Get();
+            key.sourceHash[1] = second.Get();
+            key.sourceSize = uint32_t(size);
+            key.shaderType = uint32_t(shaderType);
+            return key;
         }
-        else if (d.sampleCount > 1)
-        {
-            texture->bindTarget = GL_TEXTURE_2D_MULTISAMPLE;
-            glBindTexture(texture->bindTarget, texture->handle);
-
-            glTexStorage2DMultisample(texture->bindTarget,
-                d.sampleCount,
-                formatMapping.internalFormat,
-                d.width,
-                d.height,
-                GL_FALSE);
 
-            CHECK_GL_ERROR();
-        }
-        else
+        static uint64_t GetChecksum(const void* data, size_t size)
         {
-            texture->bindTarget = GL_TEXTURE_2D;
-            glBindTexture(texture->bindTarget, texture->handle);
-
-            glTexStorage2D(
-                texture->bindTarget,
-                d.mipLevels,
-                formatMapping.internalFormat,
-                d.width,
-                d.height);
-
-            CHECK_GL_ERROR();
+            StateHash hash;
+            hash.AddBytes(data, size);
+            return hash.Get();
         }
 
-        if (d.sampleCount == 1)
+        static uint64_t AlignSize(uint64_t size)
         {
-            glTexParameteri(texture->bindTarget, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-            glTexParameteri(texture->bindTarget, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-            CHECK_GL_ERROR();
+            return (size + 7) & ~uint64_t(7);
         }
 
-        glBindTexture(texture->bindTarget, 0);
-
-        if (formatMapping.abstractFormat == Format::SRGBA8_UNORM)
+        void Load()
         {
-            glGenTextures(1, &texture->srgbView);
+            binaries.clear();
+            modified = false;
 
-            glTextureView(
-                texture->srgbView, 
-                texture->bindTarget, 
-                texture->handle, 
-                GL_SRGB8_ALPHA8, 
-                0, 
-                texture->desc.mipLevels, 
-                0, 
-                numlayers);
+            if (!file.Open(fileName.c_str()))
+                return;
 
-            CHECK_GL_ERROR();
+            ProgramArchiveHeader header;
+            bool valid = file.size >= sizeof(header);
 
-            if (d.sampleCount == 1)
+            if (valid)
             {
-                glBindTexture(texture->bindTarget, texture->srgbView);
-                glTexParameteri(texture->bindTarget, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-                glTexParameteri(texture->bindTarget, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-                glBindTexture(texture->bindTarget, 0);
-                CHECK_GL_ERROR();
+                memcpy(&header, file.data, sizeof(header));
+                valid = header.magic == MAGIC && header.version == VERSION && header.deviceStringSize == deviceString.size() &&
+                    memcmp(file.data + sizeof(header), deviceString.data(), deviceString.size()) == 0;
             }
-        }
 
+            uint64_t tableOffset = sizeof(header) + AlignSize(deviceString.size());
+            valid = valid && tableOffset <= file.size && header.entryCount <= (file.size - tableOffset) / sizeof(ProgramArchiveEntry);
 
-        if (data && d.mipLevels == 1)
-        {
-            uint32_t numSubresources = 1;
-            if (d.isArray || d.isCubeMap)
-                numSubresources *= texture->desc.depthOrArraySize;
+            if (valid)
+            {
+                uint64_t checksum = header.checksum;
+                header.checksum = 0;
 
-            uint32_t rowPitch = formatMapping.bytesPerPixel * d.width;
-            uint32_t slicePitch = rowPitch * d.height;
-            uint32_t subresourcePitch = slicePitch * (d.isArray ? 1 : d.depthOrArraySize);
+                StateHash hash;
+                hash.Add(header);
+                hash.AddBytes(file.data + sizeof(header), size_t(tableOffset - sizeof(header) + header.entryCount * sizeof(ProgramArchiveEntry)));
+                valid = hash.Get() == checksum;
+            }
 
-            for (uint32_t subresource = 0; subresource < numSubresources; subresource++)
-            { 
-                writeTexture(texture, subresource, (char*)data + subresourcePitch * subresource, rowPitch, slicePitch);
+            if (!valid)
+            {
+                // Written for another device or damaged
+                modified = true;
+                file.Close();
+                return;
             }
-        }
 
-        return texture;
-    }
+            for (uint32_t index = 0; index < header.entryCount; index++)
+            {
+                ProgramArchiveEntry entry;
+                memcpy(&entry, file.data + tableOffset + index * sizeof(entry), sizeof(entry));
 
+                if (entry.offset > file.size || entry.binarySize > file.size - entry.offset ||
+                    std::find(formats.begin(), formats.end(), GLint(entry.binaryFormat)) == formats.end())
+                {
+                    modified = true;
+                    statistics.evictions++;
+                    continue;
+                }
 
-    TextureDesc RendererInterfaceOGL::describeTexture(TextureHandle t)
-    {
-        return t->desc;
-    }
-
+                Binary& binary = binaries[entry.key];
+                binary.format = entry.binaryFormat;
+                binary.size = entry.binarySize;
+                binary.data = file.data + entry.offset;
+                binary.checksum = entry.checksum;
+                binary.verified = false;
+                binary.used = false;
+            }
+        }
 
-    void RendererInterfaceOGL::clearTextureFloat(TextureHandle t, const Color& clearColor)
-    {
-        for (uint32_t nMipLevel = 0; nMipLevel < t->desc.mipLevels; ++nMipLevel)
+        // Returns a linked program, or 0 if the archive has no usable binary for the key
+        GLuint LoadProgram(const ProgramBinaryKey& key)
         {
-            glClearTexImage(t->handle, nMipLevel, t->formatMapping.baseFormat, GL_FLOAT, &clearColor);
-            CHECK_GL_ERROR();
-        }
-    }
+            auto it = binaries.find(key);
+            if (it == binaries.end())
+            {
+                statistics.misses++;
+                return 0;
+            }
 
+            Binary& binary = it->second;
+            GLuint program = 0;
 
-    void RendererInterfaceOGL::clearTextureUInt(TextureHandle t, const uint32_t clearColor)
-    {
-        uint32_t colors[4] = { clearColor, clearColor, clearColor, clearColor };
+            if (binary.verified || GetChecksum(binary.data, binary.size) == binary.checksum)
+            {
+                binary.verified = true;
 
-        for (uint32_t nMipLevel = 0; nMipLevel < t->desc.mipLevels; ++nMipLevel)
-        {
-            glClearTexImage(t->handle, nMipLevel, t->formatMapping.baseFormat, GL_UNSIGNED_INT, colors);
-            CHECK_GL_ERROR();
-        }
-    }
+                program = glCreateProgram();
+                glProgramParameteri(program, GL_PROGRAM_SEPARABLE, GL_TRUE);
+                glProgramBinary(program, binary.format, binary.data, binary.size);
 
+                // Drivers reject binaries from other driver versions by failing the link
+                GLint linked = 0;
+                glGetProgramiv(program, GL_LINK_STATUS, &linked);
+                if (!linked)
+                {
+                    glDeleteProgram(program);
+                    program = 0;
+                }
+            }
 
-    void RendererInterfaceOGL::writeTexture(TextureHandle t, uint32_t subresource, const void* data, uint32_t rowPitch, uint32_t depthPitch)
-    {
-        (void)rowPitch;
-        (void)depthPitch;
+            if (!program)
+            {
+                binaries.erase(it);
+                modified = true;
+                statistics.evictions++;
+                statistics.misses++;
+                return 0;
+            }
 
-        glBindTexture(t->bindTarget, t->handle);
+            binary.used = true;
+            statistics.hits++;
+            return program;
+        }
 
-        if (t->desc.isArray || t->desc.depthOrArraySize > 0)
+        void StoreProgram(const ProgramBinaryKey& key, GLuint program)
         {
-            glTexSubImage3D(t->bindTarget, 0, 0, 0, subresource, t->desc.width, t->desc.height, 1, t->formatMapping.baseFormat, t->formatMapping.type, data);
-            CHECK_GL_ERROR();
+            GLint length = 0;
+            glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+            if (length <= 0)
+                return;
+
+            Binary& binary = binaries[key];
+            binary.storage.resize(length);
+
+            GLenum format = 0;
+            glGetProgramBinary(program, length, &length, &format, binary.storage.data());
+
+            binary.format = format;
+            binary.size = uint32_t(length);
+            binary.data = binary.storage.data();
+            binary.checksum = GetChecksum(binary.data, binary.size);
+            binary.verified = true;
+            binary.used = true;
+            modified = true;
         }
-        else
+
+        // Writes the binaries to a temporary file that replaces the archive file, then maps the new file
+        bool Save(bool discardUnused)
         {
-            uint32_t width = __max(1, t->desc.width >> subresource);
-            uint32_t height = __max(1, t->desc.height >> subresource);
-            glTexSubImage2D(t->bindTarget, subresource, 0, 0, width, height, t->formatMapping.baseFormat, t->formatMapping.type, data);
-            CHECK_GL_ERROR();
-        }
+            std::vector<std::pair<const ProgramBinaryKey, Binary>*> saved;
+            saved.reserve(binaries.size());
 
-        glBindTexture(t->bindTarget, 0);
-    }
+            for (auto& pair : binaries)
+            {
+                Binary& binary = pair.second;
+
+                // Don't carry damaged binaries over into the new file
+                if (!binary.verified && GetChecksum(binary.data, binary.size) != binary.checksum)
+                    modified = true;
+                else if (discardUnused && !binary.used)
+                    modified = true;
+                else
+                    saved.push_back(&pair);
+            }
 
+            if (!modified)
+                return true;
 
-    void RendererInterfaceOGL::destroyTexture(TextureHandle t)
-    {
-        if (!t) return;
+            ProgramArchiveHeader header;
+            header.magic = MAGIC;
+            header.version = VERSION;
+            header.deviceStringSize = uint32_t(deviceString.size());
+            header.entryCount = uint32_t(saved.size());
+            header.checksum = 0;
 
-        if (t->usedInFrameBuffers)
-        {
-            std::vector<std::pair<uint32_t, FrameBuffer*>> fbToDelete;
-            for (auto it : m_CachedFrameBuffers)
+            std::vector<uint8_t> table(size_t(AlignSize(deviceString.size())) + saved.size() * sizeof(ProgramArchiveEntry), 0);
+            memcpy(table.data(), deviceString.data(), deviceString.size());
+
+            uint64_t offset = sizeof(header) + table.size();
+            uint8_t* entries = table.data() + AlignSize(deviceString.size());
+
+            for (size_t index = 0; index < saved.size(); index++)
             {
-                if (it.second->depthTarget == t)
-                    fbToDelete.push_back(it);
+                const Binary& binary = saved[index]->second;
 
-                for (uint32_t rt = 0; rt < 8; rt++)
-                    if (it.second->renderTargets[rt] == t)
-                    {
-                        fbToDelete.push_back(it);
-                        break;
-                    }
+                ProgramArchiveEntry entry;
+                entry.key = saved[index]->first;
+                entry.binaryFormat = binary.format;
+                entry.binarySize = binary.size;
+                entry.offset = offset;
+                entry.checksum = binary.checksum;
+                memcpy(entries + index * sizeof(entry), &entry, sizeof(entry));
+
+                offset += AlignSize(binary.size);
             }
 
-            for (auto it : fbToDelete)
+            StateHash hash;
+            hash.Add(header);
+            hash.AddBytes(table.data(), table.size());
+            header.checksum = hash.Get();
+
+            std::string tempFileName = fileName + ".tmp";
+            FILE* output = fopen(tempFileName.c_str(), "wb");
+            if (!output)
+                return false;
+
+            static const uint8_t padding[8] = { };
+            bool written = fwrite(&header, sizeof(header), 1, output) == 1 && fwrite(table.data(), table.size(), 1, output) == 1;
+
+            for (size_t index = 0; written && index < saved.size(); index++)
             {
-                m_CachedFrameBuffers.erase(it.first);
-                delete it.second;
+                const Binary& binary = saved[index]->second;
+                written = fwrite(binary.data, 1, binary.size, output) == binary.size &&
+                    fwrite(padding, 1, size_t(AlignSize(binary.size) - binary.size), output) == AlignSize(binary.size) - binary.size;
             }
+
+            written = fclose(output) == 0 && written;
+
+            // The mapping has to go before the file is replaced on Windows. The binaries compiled since the last save are lost
+            // if the replacement fails, which only means that they are compiled again next time.
+            file.Close();
+
+#ifdef _WIN32
+            bool replaced = written && MoveFileExA(tempFileName.c_str(), fileName.c_str(), MOVEFILE_REPLACE_EXISTING);
+#else
+            bool replaced = written && rename(tempFileName.c_str(), fileName.c_str()) == 0;
+#endif
+            if (!replaced)
+                remove(tempFileName.c_str());
+
+            Load();
+            return replaced;
         }
 
-        delete t;
-    }
+        CacheStatistics GetStatistics() const
+        {
+            CacheStatistics result = statistics;
+            result.entries = binaries.size();
+            for (auto& pair : binaries)
+                result.bytes += pair.second.size;
+            return result;
+        }
 
+    private:
+        MappedFile file;
+        std::unordered_map<ProgramBinaryKey, Binary, BytewiseHash<ProgramBinaryKey>, BytewiseEqual<ProgramBinaryKey>> binaries;
+        bool modified;  // the file differs from the binaries
+    };
 
-    BufferHandle RendererInterfaceOGL::createBuffer(const BufferDesc& d, const void* data)
+    class FrameBuffer
     {
-        BufferHandle buffer = new Buffer();
+    public:
+        GLuint handle;
+        GLenum drawBuffers[8];
+        uint32_t numBuffers;
+        TextureHandle depthTarget;
+        TextureHandle renderTargets[8];
+        FrameBufferKey key;
 
-        buffer->desc = d;
-        buffer->bindTarget = d.canHaveUAVs || d.structStride ? GL_SHADER_STORAGE_BUFFER : GL_TEXTURE_BUFFER;
-    
-        GLenum usage = d.canHaveUAVs ? GL_STREAM_COPY : GL_STREAM_DRAW;
+        FrameBuffer() 
+            : handle(0) 
+            , numBuffers(0)
+            , depthTarget(nullptr)
+        { 
+            memset(renderTargets, 0, sizeof(renderTargets));
+        }
 
-        glGenBuffers(1, &buffer->bufferHandle);
-        glBindBuffer(buffer->bindTarget, buffer->bufferHandle);
+        ~FrameBuffer()
+        {
+            if (handle)
+                glDeleteFramebuffers(1, &handle);
+        }
 
-        glBufferData(buffer->bindTarget, d.byteSize, data, usage);
-        CHECK_GL_ERROR();
+        // Adds this framebuffer to the list of dependents of an attached texture. The attachments of one framebuffer
+        // are linked one after another, so a texture attached several times is already at the back of the list.
+        void LinkTexture(TextureHandle texture)
+        {
+            if (texture->frameBuffers.empty() || texture->frameBuffers.back() != this)
+                texture->frameBuffers.push_back(this);
+        }
 
-        glBindBuffer(buffer->bindTarget, GL_NONE);
+        void UnlinkTextures()
+        {
+            for (TextureHandle texture : renderTargets)
+                if (texture) UnlinkTexture(texture);
 
+            if (depthTarget)
+                UnlinkTexture(depthTarget);
+        }
 
-        glGenTextures(1, &buffer->ssboHandle);
-        glBindTexture(GL_TEXTURE_BUFFER, buffer->ssboHandle);
+    private:
+        void UnlinkTexture(TextureHandle texture)
+        {
+            auto& list = texture->frameBuffers;
+            auto it = std::find(list.begin(), list.end(), this);
+            if (it != list.end())
+            {
+                *it = list.back();
+                list.pop_back();
+            }
+        }
+    };
 
-        glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, buffer->bufferHandle);
-        CHECK_GL_ERROR();
+    struct VertexBufferSlot
+    {
+        GLuint buffer;
+        GLintptr offset;
+        GLsizei stride;
 
-        glBindTexture(GL_TEXTURE_BUFFER, GL_NONE);
+        bool operator==(const VertexBufferSlot& other) const { return buffer == other.buffer && offset == other.offset && stride == other.stride; }
+    };
 
-        return buffer;
-    }
+    // Attribute formats are baked into the VAO, draws only bind vertex buffers to it
+    class InputLayout
+    {
+    public:
+        std::vector<VertexAttributeDesc> attributes;
+        GLuint vao;
 
+        // Binding indices that the attributes read from, and the stride used when a vertex buffer is bound with stride 0
+        std::vector<uint32_t> bufferSlots;
+        uint32_t packedStrides[DrawCallState::MAX_VERTEX_ATTRIBUTE_COUNT];
 
-    void RendererInterfaceOGL::writeBuffer(BufferHandle b, const void* data, size_t dataSize)
-    {
-        glBindBuffer(b->bindTarget, b->bufferHandle);
+        // Vertex buffers that are currently attached to the VAO
+        VertexBufferSlot boundBuffers[DrawCallState::MAX_VERTEX_ATTRIBUTE_COUNT];
 
-        if (dataSize > b->desc.byteSize)
-            dataSize = b->desc.byteSize;
+        InputLayout()
+            : vao(0)
+        {
+            memset(packedStrides, 0, sizeof(packedStrides));
+            memset(boundBuffers, 0, sizeof(boundBuffers));
+        }
 
-        glBufferSubData(b->bindTarget, 0, dataSize, data);
-        CHECK_GL_ERROR();
+        ~InputLayout()
+        {
+            if (vao)
+                glDeleteVertexArrays(1, &vao);
+        }
+    };
 
-        glBindBuffer(b->bindTarget, GL_NONE);
-    }
+    class GraphicsPipeline
+    {
+    public:
+        GraphicsPipelineDesc desc;
+        GLuint programPipeline;
+        GLenum primType;
 
+        GraphicsPipeline()
+            : programPipeline(0)
+            , primType(GL_TRIANGLES)
+        { }
 
-    void RendererInterfaceOGL::clearBufferUInt(BufferHandle b, uint32_t clearValue)
+        ~GraphicsPipeline()
+        {
+            if (programPipeline)
+                glDeleteProgramPipelines(1, &programPipeline);
+        }
+    };
+
+    class ComputePipeline
     {
-        glBindBuffer(b->bindTarget, b->bufferHandle);
+    public:
+        ComputePipelineDesc desc;
+        GLuint programPipeline;
 
-        glClearBufferData(b->bindTarget, GL_R32UI, GL_RED, GL_UNSIGNED_INT, &clearValue);
-        CHECK_GL_ERROR();
+        ComputePipeline()
+            : programPipeline(0)
+        { }
 
-        glBindBuffer(b->bindTarget, GL_NONE);
-    }
+        ~ComputePipeline()
+        {
+            if (programPipeline)
+                glDeleteProgramPipelines(1, &programPipeline);
+        }
+    };
 
+    // All bindings of a set, resolved to GL object names and flattened across stages
+    struct BindingList
+    {
+        struct TextureBind { GLuint slot; GLenum target; GLuint handle; };
+        struct ImageBind { GLuint slot; GLuint handle; GLint level; GLenum format; bool defaultView; };
+        struct ObjectBind { GLuint slot; GLuint handle; };
+        struct ConstantBufferBind { GLuint slot; ConstantBufferHandle buffer; };
+
+        std::vector<TextureBind> textures;
+        std::vector<ImageBind> images;
+        std::vector<ObjectBind> samplers;
+        std::vector<ConstantBufferBind> constantBuffers;
+        std::vector<ObjectBind> storageBuffers;
+    };
 
-    void RendererInterfaceOGL::copyToBuffer(BufferHandle dest, uint32_t destOffsetBytes, BufferHandle src, uint32_t srcOffsetBytes, size_t dataSizeBytes)
+    class BindingSet
     {
-        glBindBuffer(GL_COPY_WRITE_BUFFER, dest->bufferHandle);
-        glBindBuffer(GL_COPY_READ_BUFFER, src->bufferHandle);
+    public:
+        ShaderHandle graphicsShaders[ShaderType::GRAPHIC_SHADERS_NUM];
+        ShaderHandle computeShader;
+        BindingList graphicsBindings;
+        BindingList computeBindings;
 
-        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, srcOffsetBytes, destOffsetBytes, dataSizeBytes);
+        BindingSet()
+            : computeShader(nullptr)
+        {
+            memset(graphicsShaders, 0, sizeof(graphicsShaders));
+        }
+    };
 
-        CHECK_GL_ERROR();
+    RendererInterfaceOGL::RendererInterfaceOGL(IErrorCallback* pErrorCallback) 
+        : m_pErrorCallback(pErrorCallback)
+        , m_nCurrentProgramPipeline(0)
+        , m_nVAO(0)
+        , m_nCurrentVAO(0)
+        , m_nResolveFramebuffers()
+        , m_bIndirectParametersSupported(false)
+        , m_bCapabilitiesValid(false)
+        , m_bDebugOutputEnabled(false)
+        , m_bDebugGroupsSupported(false)
+        , m_bMultiBindSupported(false)
+        , m_bConservativeRasterEnabled(false)
+        , m_bForcedSampleCountEnabled(false)
+        , m_StateCallStatistics()
+        , m_pCurrentFrameBuffer(nullptr)
+        , m_ReadbackPeakBytes(0)
+        , m_MaxFramesInFlight(2)
+        , m_FrameIndex(0)
+        , m_bBufferStorageSupported(false)
+        , m_nUploadRing(0)
+        , m_pUploadRingData(nullptr)
+        , m_UploadRingSize(0)
+        , m_UploadRingHead(0)
+        , m_UploadRingTail(0)
+        , m_UploadRingFenced(0)
+        , m_UploadPeakBytes(0)
+        , m_pProgramBinaryArchive(nullptr)
+    { 
+        m_DefaultBackBuffer = new Texture();
 
-        glBindBuffer(GL_COPY_READ_BUFFER, GL_NONE);
-        glBindBuffer(GL_COPY_WRITE_BUFFER, GL_NONE);
-        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
-    }
+        m_TextureBindings.reset(PipelineStageBindings::MAX_TEXTURE_BINDINGS);
+        m_ImageBindings.reset(PipelineStageBindings::MAX_TEXTURE_BINDINGS);
+        m_SamplerBindings.reset(PipelineStageBindings::MAX_SAMPLER_BINDINGS);
+        m_UniformBufferBindings.reset(PipelineStageBindings::MAX_CB_BINDINGS);
+        m_StorageBufferBindings.reset(PipelineStageBindings::MAX_BUFFER_BINDINGS);
 
+        InvalidateState();
+    }
 
 
-    void RendererInterfaceOGL::readBuffer(BufferHandle b, void* data, size_t* dataSize)
+    RendererInterfaceOGL::~RendererInterfaceOGL()
     {
-        uint32_t nBytesToRead = uint32_t(*dataSize);
-        if (nBytesToRead > b->desc.byteSize)
+        for (auto& entry : m_CachedFrameBuffers)
         {
-            nBytesToRead = b->desc.byteSize;
+            delete entry.value;
         }
 
-        glBindBuffer(GL_COPY_READ_BUFFER, b->bufferHandle);
+        for (auto readback : m_Readbacks)
+        {
+            delete readback;
+        }
 
-        void* pMappedData = glMapBufferRange(GL_COPY_READ_BUFFER, 0, nBytesToRead, GL_MAP_READ_BIT);
-        if (pMappedData)
+        for (auto sync : m_FrameSyncs)
         {
-            memcpy(data, pMappedData, nBytesToRead);
-            *dataSize = nBytesToRead;
+            glDeleteSync(sync);
         }
-        else
+
+        for (auto& fence : m_UploadRingFences)
         {
-            *dataSize = 0;
+            glDeleteSync(fence.first);
         }
 
-        glUnmapBuffer(GL_COPY_READ_BUFFER);
-        glBindBuffer(GL_COPY_READ_BUFFER, GL_NONE);
-    }
+        for (auto& pair : m_FreeTimerQueries)
+        {
+            glDeleteQueries(1, &pair.first);
+            glDeleteQueries(1, &pair.second);
+        }
+
+        if (m_nUploadRing)
+        {
+            glDeleteBuffers(1, &m_nUploadRing);
+        }
+    
+        for (auto& pair : m_CachedProgramPipelines)
+        {
+            delete pair.second;
+        }
 
+        if (m_nVAO)
+        {
+            glDeleteVertexArrays(1, &m_nVAO);
+        }
 
+        if (m_nResolveFramebuffers[0])
+        {
+            glDeleteFramebuffers(2, m_nResolveFramebuffers);
+        }
 
-    void RendererInterfaceOGL::destroyBuffer(BufferHandle b)
-    {
-        if (!b) return;
-        delete b;
+        delete m_DefaultBackBuffer;
+        delete m_pProgramBinaryArchive;
     }
 
 
-    ConstantBufferHandle RendererInterfaceOGL::createConstantBuffer(const ConstantBufferDesc& d, const void* data)
+#if NVRHI_GL_CHECK_ERRORS
+    static void GLAPIENTRY DebugMessageCallback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* userParam)
     {
-        ConstantBufferHandle buffer = new ConstantBuffer();
+        (void)source;
+        (void)id;
+        (void)length;
 
-        buffer->desc = d;
+        if (type == GL_DEBUG_TYPE_ERROR || severity == GL_DEBUG_SEVERITY_HIGH)
+            ((IErrorCallback*)userParam)->signalError(__FILE__, __LINE__, message);
+    }
+#endif
 
-        glGenBuffers(1, &buffer->handle);
-        glBindBuffer(GL_UNIFORM_BUFFER, buffer->handle);
-        glBufferData(GL_UNIFORM_BUFFER, d.byteSize, nullptr, GL_DYNAMIC_DRAW);
-        CHECK_GL_ERROR();
+    void RendererInterfaceOGL::init()
+    {
+        QueryCapabilities();
 
-        glBindBuffer(GL_UNIFORM_BUFFER, GL_NONE);
+        m_bIndirectParametersSupported = isOpenGLExtensionSupported("GL_ARB_indirect_parameters");
+        m_bMultiBindSupported = isOpenGLExtensionSupported("GL_ARB_multi_bind");
+        m_bBufferStorageSupported = isOpenGLExtensionSupported("GL_ARB_buffer_storage");
+        m_bDebugGroupsSupported = isOpenGLExtensionSupported("GL_KHR_debug");
 
-        if (data)
-            writeConstantBuffer(buffer, data, d.byteSize);
+#if NVRHI_GL_CHECK_ERRORS
+        // Synchronous output reports the errors from inside the failing call, which replaces the glGetError checks.
+        // A callback that the application has installed is left alone.
+        void* pCurrentCallback = nullptr;
+        if (m_bDebugGroupsSupported)
+            glGetPointerv(GL_DEBUG_CALLBACK_FUNCTION, &pCurrentCallback);
 
-        return buffer;
-    }
+        if (m_bDebugGroupsSupported && !pCurrentCallback)
+        {
+            glDebugMessageCallback(DebugMessageCallback, m_pErrorCallback);
+            glEnable(GL_DEBUG_OUTPUT);
+            glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+            m_bDebugOutputEnabled = true;
+        }
+#endif
 
+        if (m_bBufferStorageSupported)
+            CreateUploadRing(32 * 1024 * 1024);
+    }
 
-    void RendererInterfaceOGL::writeConstantBuffer(ConstantBufferHandle b, const void* data, size_t dataSize)
+    void RendererInterfaceOGL::QueryCapabilities()
     {
-        glBindBuffer(GL_UNIFORM_BUFFER, b->handle);
+        GLint numExtensions = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &numExtensions);
 
-        glBufferSubData(GL_UNIFORM_BUFFER, 0, dataSize, data);
-        CHECK_GL_ERROR();
+        m_Capabilities.extensions.clear();
+        for (GLint n = 0; n < numExtensions; n++)
+        {
+            const char* name = (const char*)glGetStringi(GL_EXTENSIONS, GLuint(n));
+            if (name)
+                m_Capabilities.extensions.insert(name);
+        }
 
-        glBindBuffer(GL_UNIFORM_BUFFER, GL_NONE);
-    }
+        struct { GLenum pname; uint32_t* value; } limits[] = {
+            { GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT,   &m_Capabilities.uniformBufferOffsetAlignment },
+            { GL_MAX_UNIFORM_BLOCK_SIZE,            &m_Capabilities.maxUniformBlockSize },
+            { GL_MAX_VERTEX_ATTRIBS,                &m_Capabilities.maxVertexAttribs },
+            { GL_MAX_VERTEX_ATTRIB_BINDINGS,        &m_Capabilities.maxVertexAttribBindings },
+            { GL_MAX_VIEWPORTS,                     &m_Capabilities.maxViewports },
+        };
+
+        // Limits that the driver doesn't report keep their defaults
+        for (auto& limit : limits)
+        {
+            GLint value = 0;
+            glGetIntegerv(limit.pname, &value);
+            if (value > 0)
+                *limit.value = uint32_t(value);
+        }
 
+        m_bCapabilitiesValid = true;
+    }
 
-    void RendererInterfaceOGL::destroyConstantBuffer(ConstantBufferHandle b)
+    bool RendererInterfaceOGL::isOpenGLExtensionSupported(const char* name)
     {
-        if (!b) return;
-        delete b;
+        // VXGI can ask before init
+        if (!m_bCapabilitiesValid)
+            QueryCapabilities();
+
+        return m_Capabilities.extensions.count(name) != 0;
     }
 
+    void* RendererInterfaceOGL::getOpenGLProcAddress(const char* procname)
+    {
+    #ifdef _WIN32
+        return wglGetProcAddress(procname);
+    #else
+        return nullptr;
+    #endif
+    }
 
-    ShaderHandle RendererInterfaceOGL::createShader(const ShaderDesc& d, const void* binary, const size_t binarySize)
+    TextureHandle RendererInterfaceOGL::createTexture(const TextureDesc& d, const void* data)
     {
-        (void)binarySize;
+        const FormatMapping& formatMapping = GetFormatMapping(d.format);
 
-        if (d.preCreationCommand)
+        TextureHandle texture = new Texture();
+        texture->desc = d;
+        texture->formatMapping = formatMapping;
+        glGenTextures(1, &texture->handle);
+
+        uint32_t numlayers = 1;
+    
+        if (d.isCubeMap)
+        {
+            texture->bindTarget = GL_TEXTURE_CUBE_MAP;
+            glBindTexture(texture->bindTarget, texture->handle);
+
+            glTexStorage2D(
+                texture->bindTarget,
+                d.mipLevels,
+                formatMapping.internalFormat,
+                d.width,
+                d.height);
+
+            numlayers = 6;
+
+            CHECK_GL_ERROR();
+        }
+        else if (d.isArray)
+        {
+            texture->bindTarget = GL_TEXTURE_2D_ARRAY;
+            glBindTexture(texture->bindTarget, texture->handle);
+
+            glTexStorage3D(texture->bindTarget,
+                d.mipLevels,
+                formatMapping.internalFormat,
+                d.width,
+                d.height,
+                d.depthOrArraySize);
+
+            numlayers = d.depthOrArraySize;
+
+            CHECK_GL_ERROR();
+        }
+        else if (d.depthOrArraySize > 0)
+        {
+            texture->bindTarget = GL_TEXTURE_3D;
+            glBindTexture(texture->bindTarget, texture->handle);
+
+            glTexStorage3D(texture->bindTarget,
+                d.mipLevels,
+                formatMapping.internalFormat,
+                d.width,
+                d.height,
+                d.depthOrArraySize);
+
+            CHECK_GL_ERROR();
+        }
+        else if (d.sampleCount > 1)
+        {
+            texture->bindTarget = GL_TEXTURE_2D_MULTISAMPLE;
+            glBindTexture(texture->bindTarget, texture->handle);
+
+            glTexStorage2DMultisample(texture->bindTarget,
+                d.sampleCount,
+                formatMapping.internalFormat,
+                d.width,
+                d.height,
+                GL_FALSE);
+
+            CHECK_GL_ERROR();
+        }
+        else
+        {
+            texture->bindTarget = GL_TEXTURE_2D;
+            glBindTexture(texture->bindTarget, texture->handle);
+
+            glTexStorage2D(
+                texture->bindTarget,
+                d.mipLevels,
+                formatMapping.internalFormat,
+                d.width,
+                d.height);
+
+            CHECK_GL_ERROR();
+        }
+
+        if (d.sampleCount == 1)
+        {
+            glTexParameteri(texture->bindTarget, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(texture->bindTarget, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            CHECK_GL_ERROR();
+        }
+
+        glBindTexture(texture->bindTarget, 0);
+        TrackTextureUnitZero(texture->bindTarget, 0);
+
+        if (formatMapping.abstractFormat == Format::SRGBA8_UNORM)
+        {
+            glGenTextures(1, &texture->srgbView);
+
+            glTextureView(
+                texture->srgbView, 
+                texture->bindTarget, 
+                texture->handle, 
+                GL_SRGB8_ALPHA8, 
+                0, 
+                texture->desc.mipLevels, 
+                0, 
+                numlayers);
+
+            CHECK_GL_ERROR();
+
+            if (d.sampleCount == 1)
+            {
+                glBindTexture(texture->bindTarget, texture->srgbView);
+                glTexParameteri(texture->bindTarget, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+                glTexParameteri(texture->bindTarget, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+                glBindTexture(texture->bindTarget, 0);
+                CHECK_GL_ERROR();
+            }
+        }
+
+
+        if (data)
+        {
+            // The initial data is tightly packed and ordered like D3D subresources: all mip levels of the first array slice, then the next slice
+            uint32_t numSlices = (d.isArray || d.isCubeMap) ? d.depthOrArraySize : 1;
+            const char* pixels = (const char*)data;
+
+            for (uint32_t slice = 0; slice < numSlices; slice++)
+            {
+                for (uint32_t mipLevel = 0; mipLevel < d.mipLevels; mipLevel++)
+                {
+                    TextureRegion box = TextureRegion(mipLevel, slice).resolve(d);
+                    uint32_t rowPitch = formatMapping.bytesPerPixel * box.width;
+                    uint32_t slicePitch = rowPitch * box.height;
+
+                    writeTextureRegion(texture, box, pixels, rowPitch, slicePitch);
+                    pixels += slicePitch * box.depth;
+                }
+            }
+        }
+
+        return texture;
+    }
+
+
+    TextureDesc RendererInterfaceOGL::describeTexture(TextureHandle t)
+    {
+        return t->desc;
+    }
+
+
+    void RendererInterfaceOGL::clearTextureFloat(TextureHandle t, const Color& clearColor)
+    {
+        for (uint32_t nMipLevel = 0; nMipLevel < t->desc.mipLevels; ++nMipLevel)
+        {
+            glClearTexImage(t->handle, nMipLevel, t->formatMapping.baseFormat, GL_FLOAT, &clearColor);
+            CHECK_GL_ERROR();
+        }
+    }
+
+
+    void RendererInterfaceOGL::clearTextureUInt(TextureHandle t, const uint32_t clearColor)
+    {
+        uint32_t colors[4] = { clearColor, clearColor, clearColor, clearColor };
+
+        for (uint32_t nMipLevel = 0; nMipLevel < t->desc.mipLevels; ++nMipLevel)
+        {
+            glClearTexImage(t->handle, nMipLevel, t->formatMapping.baseFormat, GL_UNSIGNED_INT, colors);
+            CHECK_GL_ERROR();
+        }
+    }
+
+
+    void RendererInterfaceOGL::clearTextureRegionFloat(TextureHandle t, const TextureRegion& region, const Color& clearColor)
+    {
+        if (!t || !region.isValid(t->desc))
+        {
+            SIGNAL_ERROR("Invalid texture clear region");
+            return;
+        }
+
+        TextureRegion box = region.resolve(t->desc);
+        if (box.width == 0 || box.height == 0 || box.depth == 0)
+            return;
+
+        // Array slices and cube faces are addressed through zoffset, just like the slices of a 3D texture
+        glClearTexSubImage(t->handle, box.mipLevel, box.x, box.y, box.z + box.arraySlice, box.width, box.height, box.depth,
+            t->formatMapping.baseFormat, GL_FLOAT, &clearColor);
+        CHECK_GL_ERROR();
+    }
+
+
+    void RendererInterfaceOGL::clearTextureRegionUInt(TextureHandle t, const TextureRegion& region, uint32_t clearColor)
+    {
+        if (!t || !region.isValid(t->desc))
+        {
+            SIGNAL_ERROR("Invalid texture clear region");
+            return;
+        }
+
+        TextureRegion box = region.resolve(t->desc);
+        if (box.width == 0 || box.height == 0 || box.depth == 0)
+            return;
+
+        uint32_t colors[4] = { clearColor, clearColor, clearColor, clearColor };
+
+        glClearTexSubImage(t->handle, box.mipLevel, box.x, box.y, box.z + box.arraySlice, box.width, box.height, box.depth,
+            t->formatMapping.baseFormat, GL_UNSIGNED_INT, colors);
+        CHECK_GL_ERROR();
+    }
+
+
+    void RendererInterfaceOGL::writeTexture(TextureHandle t, uint32_t subresource, const void* data, uint32_t rowPitch, uint32_t depthPitch)
+    {
+        // Subresources are numbered like in D3D: all mip levels of the first array slice, then the next slice
+        uint32_t mipLevels = t ? __max(1u, t->desc.mipLevels) : 1;
+
+        writeTextureRegion(t, TextureRegion(subresource % mipLevels, subresource / mipLevels), data, rowPitch, depthPitch);
+    }
+
+
+    void RendererInterfaceOGL::writeTextureRegion(TextureHandle t, const TextureRegion& region, const void* data, uint32_t rowPitch, uint32_t depthPitch)
+    {
+        if (!t || !data || !region.isValid(t->desc) || t->formatMapping.bytesPerPixel == 0 || t->bindTarget == GL_TEXTURE_2D_MULTISAMPLE)
+        {
+            SIGNAL_ERROR("Invalid texture write");
+            return;
+        }
+
+        TextureRegion box = region.resolve(t->desc);
+        if (box.width == 0 || box.height == 0 || box.depth == 0)
+            return;
+
+        if (m_pUploadRingData)
+            UploadTextureData(t, box, data, rowPitch, depthPitch);
+        else
+            TexSubImage(t, box, data, rowPitch, depthPitch);
+    }
+
+
+    void RendererInterfaceOGL::UploadTextureData(TextureHandle t, const TextureRegion& box, const void* data, uint32_t rowPitch, uint32_t depthPitch)
+    {
+        // The data is repacked into the upload ring and the transfer is sourced from there as a pixel unpack buffer,
+        // so it runs on the GPU timeline and the caller doesn't wait for it
+        uint32_t packedRowPitch = box.width * t->formatMapping.bytesPerPixel;
+        uint32_t packedSlicePitch = packedRowPitch * box.height;
+
+        if (rowPitch == 0)
+            rowPitch = packedRowPitch;
+        if (depthPitch == 0)
+            depthPitch = rowPitch * box.height;
+
+        // Large images go in pieces of at most a quarter of the ring, so that they don't wait for all of it to be retired
+        uint64_t maxChunkSize = m_UploadRingSize / 4;
+        uint32_t slicesPerChunk = uint32_t(__max(1ull, __min(uint64_t(box.depth), maxChunkSize / packedSlicePitch)));
+        uint32_t rowsPerChunk = packedSlicePitch <= maxChunkSize ? box.height : uint32_t(__max(1ull, maxChunkSize / packedRowPitch));
+
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_nUploadRing);
+
+        for (uint32_t z = 0; z < box.depth; z += slicesPerChunk)
+        {
+            for (uint32_t y = 0; y < box.height; y += rowsPerChunk)
+            {
+                TextureRegion chunk = box;
+                chunk.z += z;
+                chunk.y += y;
+                chunk.depth = __min(slicesPerChunk, box.depth - z);
+                chunk.height = __min(rowsPerChunk, box.height - y);
+
+                uint64_t ringOffset = 0;
+                uint8_t* dest = (uint8_t*)AllocateUploadSpace(uint64_t(packedRowPitch) * chunk.height * chunk.depth, 16, ringOffset);
+
+                if (!dest)
+                {
+                    // The ring is held by a mapped buffer, the chunk goes straight from the caller's memory
+                    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, GL_NONE);
+                    TexSubImage(t, chunk, (const uint8_t*)data + size_t(depthPitch) * z + size_t(rowPitch) * y, rowPitch, depthPitch);
+                    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_nUploadRing);
+                    continue;
+                }
+
+                for (uint32_t slice = 0; slice < chunk.depth; slice++)
+                {
+                    const uint8_t* src = (const uint8_t*)data + size_t(depthPitch) * (z + slice) + size_t(rowPitch) * y;
+
+                    if (rowPitch == packedRowPitch)
+                    {
+                        memcpy(dest, src, size_t(packedRowPitch) * chunk.height);
+                        dest += size_t(packedRowPitch) * chunk.height;
+                        continue;
+                    }
+
+                    for (uint32_t row = 0; row < chunk.height; row++)
+                    {
+                        memcpy(dest, src + size_t(rowPitch) * row, packedRowPitch);
+                        dest += packedRowPitch;
+                    }
+                }
+
+                TexSubImage(t, chunk, (const void*)size_t(ringOffset), packedRowPitch, packedRowPitch * chunk.height);
+            }
+        }
+
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, GL_NONE);
+    }
+
+
+    void RendererInterfaceOGL::TexSubImage(TextureHandle t, const TextureRegion& box, const void* pixels, uint32_t rowPitch, uint32_t depthPitch)
+    {
+        // GL takes the source pitches in pixels and rows
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, rowPitch / t->formatMapping.bytesPerPixel);
+        glPixelStorei(GL_UNPACK_IMAGE_HEIGHT, rowPitch ? depthPitch / rowPitch : 0);
+
+        if (t->bindTarget == GL_TEXTURE_2D)
+        {
+            glTextureSubImage2D(t->handle, box.mipLevel, box.x, box.y, box.width, box.height, t->formatMapping.baseFormat, t->formatMapping.type, pixels);
+        }
+        else
+        {
+            // Array slices and cube faces are addressed through zoffset, just like the slices of a 3D texture
+            glTextureSubImage3D(t->handle, box.mipLevel, box.x, box.y, box.z + box.arraySlice, box.width, box.height, box.depth,
+                t->formatMapping.baseFormat, t->formatMapping.type, pixels);
+        }
+
+        CHECK_GL_ERROR();
+
+        glPixelStorei(GL_UNPACK_IMAGE_HEIGHT, 0);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    }
+
+
+    void RendererInterfaceOGL::copyTexture(TextureHandle dest, const TextureRegion& destRegion, TextureHandle src, const TextureRegion& srcRegion)
+    {
+        if (!dest || !src || !destRegion.isValid(dest->desc) || !srcRegion.isValid(src->desc))
+        {
+            SIGNAL_ERROR("Invalid texture copy");
+            return;
+        }
+
+        TextureRegion box = srcRegion.resolve(src->desc);
+        if (box.width == 0 || box.height == 0 || box.depth == 0)
+            return;
+
+        // Array slices and cube faces are addressed through the Z coordinate, like in glTextureSubImage3D
+        glCopyImageSubData(
+            src->handle, src->bindTarget, box.mipLevel, box.x, box.y, box.z + box.arraySlice,
+            dest->handle, dest->bindTarget, destRegion.mipLevel, destRegion.x, destRegion.y, destRegion.z + destRegion.arraySlice,
+            box.width, box.height, box.depth);
+
+        CHECK_GL_ERROR();
+    }
+
+
+    void RendererInterfaceOGL::copyBufferToTexture(TextureHandle dest, const TextureRegion& destRegion, BufferHandle src, uint32_t srcOffsetBytes, uint32_t rowPitch, uint32_t depthPitch)
+    {
+        if (!dest || !src || !destRegion.isValid(dest->desc) || dest->formatMapping.bytesPerPixel == 0 || dest->bindTarget == GL_TEXTURE_2D_MULTISAMPLE)
+        {
+            SIGNAL_ERROR("Invalid buffer to texture copy");
+            return;
+        }
+
+        TextureRegion box = destRegion.resolve(dest->desc);
+        if (box.width == 0 || box.height == 0 || box.depth == 0)
+            return;
+
+        // Shader writes to the buffer must land before the pixel transfer reads it
+        glMemoryBarrier(GL_PIXEL_BUFFER_BARRIER_BIT);
+
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, src->bufferHandle);
+        TexSubImage(dest, box, (const void*)size_t(srcOffsetBytes), rowPitch, depthPitch);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, GL_NONE);
+    }
+
+
+    void RendererInterfaceOGL::copyTextureToBuffer(BufferHandle dest, uint32_t destOffsetBytes, uint32_t rowPitch, uint32_t depthPitch, TextureHandle src, const TextureRegion& srcRegion)
+    {
+        if (!dest || !src || !srcRegion.isValid(src->desc) || src->formatMapping.bytesPerPixel == 0 || destOffsetBytes >= dest->desc.byteSize)
+        {
+            SIGNAL_ERROR("Invalid texture to buffer copy");
+            return;
+        }
+
+        TextureRegion box = srcRegion.resolve(src->desc);
+        if (box.width == 0 || box.height == 0 || box.depth == 0)
+            return;
+
+        glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT | GL_PIXEL_BUFFER_BARRIER_BIT);
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, dest->bufferHandle);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glPixelStorei(GL_PACK_ROW_LENGTH, rowPitch / src->formatMapping.bytesPerPixel);
+        glPixelStorei(GL_PACK_IMAGE_HEIGHT, rowPitch ? depthPitch / rowPitch : 0);
+
+        glGetTextureSubImage(src->handle, box.mipLevel, box.x, box.y, box.z + box.arraySlice, box.width, box.height, box.depth,
+            src->formatMapping.baseFormat, src->formatMapping.type, GLsizei(dest->desc.byteSize - destOffsetBytes), (void*)size_t(destOffsetBytes));
+
+        CHECK_GL_ERROR();
+
+        glPixelStorei(GL_PACK_IMAGE_HEIGHT, 0);
+        glPixelStorei(GL_PACK_ROW_LENGTH, 0);
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, GL_NONE);
+
+        // Make the data visible to shaders that read the buffer next
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+    }
+
+
+    void RendererInterfaceOGL::resolveTexture(TextureHandle dest, uint32_t destMipLevel, uint32_t destArraySlice, TextureHandle src, uint32_t srcArraySlice)
+    {
+        if (!dest || !src || !TextureRegion(destMipLevel, destArraySlice).isValid(dest->desc) || !TextureRegion(0, srcArraySlice).isValid(src->desc) || src->desc.sampleCount <= 1)
+        {
+            SIGNAL_ERROR("Invalid texture resolve");
+            return;
+        }
+
+        if (!m_nResolveFramebuffers[0])
+        {
+            glCreateFramebuffers(2, m_nResolveFramebuffers);
+            CHECK_GL_ERROR();
+        }
+
+        GLuint readFramebuffer = m_nResolveFramebuffers[0];
+        GLuint drawFramebuffer = m_nResolveFramebuffers[1];
+
+        GLenum attachment = src->formatMapping.isDepthStencil ? GL_DEPTH_ATTACHMENT : GL_COLOR_ATTACHMENT0;
+        GLbitfield mask = src->formatMapping.isDepthStencil ? GL_DEPTH_BUFFER_BIT : GL_COLOR_BUFFER_BIT;
+
+        if (src->bindTarget == GL_TEXTURE_2D_MULTISAMPLE)
+            glNamedFramebufferTexture(readFramebuffer, attachment, src->handle, 0);
+        else
+            glNamedFramebufferTextureLayer(readFramebuffer, attachment, src->handle, 0, srcArraySlice);
+
+        if (dest->bindTarget == GL_TEXTURE_2D)
+            glNamedFramebufferTexture(drawFramebuffer, attachment, dest->handle, destMipLevel);
+        else
+            glNamedFramebufferTextureLayer(drawFramebuffer, attachment, dest->handle, destMipLevel, destArraySlice);
+
+        if (!src->formatMapping.isDepthStencil)
+        {
+            glNamedFramebufferReadBuffer(readFramebuffer, GL_COLOR_ATTACHMENT0);
+            glNamedFramebufferDrawBuffer(drawFramebuffer, GL_COLOR_ATTACHMENT0);
+        }
+
+        // A blit between framebuffers of the same size with different sample counts is a resolve, and it is scissored
+        SetCapability(GL_SCISSOR_TEST, m_FixedFunctionState.scissorTestEnable, false);
+
+        uint32_t width = __max(1u, dest->desc.width >> destMipLevel);
+        uint32_t height = __max(1u, dest->desc.height >> destMipLevel);
+        glBlitNamedFramebuffer(readFramebuffer, drawFramebuffer, 0, 0, width, height, 0, 0, width, height, mask, GL_NEAREST);
+        CHECK_GL_ERROR();
+
+        // Don't keep the textures referenced by the framebuffers after they are destroyed
+        glNamedFramebufferTexture(readFramebuffer, attachment, 0, 0);
+        glNamedFramebufferTexture(drawFramebuffer, attachment, 0, 0);
+    }
+
+
+    void RendererInterfaceOGL::destroyTexture(TextureHandle t)
+    {
+        if (!t) return;
+
+        ForgetTextureName(t->handle);
+        ForgetTextureName(t->srgbView);
+
+        if (!t->frameBuffers.empty())
+        {
+            // Take the list first so that releasing the framebuffers doesn't search it
+            std::vector<FrameBuffer*> dependents;
+            dependents.swap(t->frameBuffers);
+
+            std::vector<FrameBuffer*> fbToDelete;
+            for (FrameBuffer* framebuffer : dependents)
+                m_CachedFrameBuffers.Erase(framebuffer->key, fbToDelete);
+
+            ReleaseFrameBuffers(fbToDelete);
+        }
+
+        delete t;
+    }
+
+
+    BufferHandle RendererInterfaceOGL::createBuffer(const BufferDesc& d, const void* data)
+    {
+        BufferHandle buffer = new Buffer();
+
+        buffer->desc = d;
+        buffer->bindTarget = d.canHaveUAVs || d.structStride ? GL_SHADER_STORAGE_BUFFER : GL_TEXTURE_BUFFER;
+
+        glGenBuffers(1, &buffer->bufferHandle);
+        glBindBuffer(buffer->bindTarget, buffer->bufferHandle);
+
+        if (m_bBufferStorageSupported)
+        {
+            // Writes are copied from the upload ring on the GPU. Dynamic storage is kept for the ones that don't fit into the ring,
+            // and the map bits for mapBuffer and readBuffer.
+            glBufferStorage(buffer->bindTarget, d.byteSize, data, GL_DYNAMIC_STORAGE_BIT | GL_MAP_READ_BIT | GL_MAP_WRITE_BIT);
+        }
+        else
+        {
+            GLenum usage = d.canHaveUAVs ? GL_STREAM_COPY : GL_STREAM_DRAW;
+            glBufferData(buffer->bindTarget, d.byteSize, data, usage);
+        }
+        CHECK_GL_ERROR();
+
+        glBindBuffer(buffer->bindTarget, GL_NONE);
+
+
+        glGenTextures(1, &buffer->ssboHandle);
+        glBindTexture(GL_TEXTURE_BUFFER, buffer->ssboHandle);
+
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, buffer->bufferHandle);
+        CHECK_GL_ERROR();
+
+        glBindTexture(GL_TEXTURE_BUFFER, GL_NONE);
+        TrackTextureUnitZero(GL_TEXTURE_BUFFER, 0);
+
+        return buffer;
+    }
+
+
+    void RendererInterfaceOGL::writeBuffer(BufferHandle b, const void* data, size_t dataSize)
+    {
+        if (dataSize > b->desc.byteSize)
+            dataSize = b->desc.byteSize;
+
+        WriteBufferData(b, 0, data, dataSize);
+    }
+
+    void RendererInterfaceOGL::writeBufferRange(BufferHandle b, uint32_t offsetBytes, const void* data, size_t dataSize)
+    {
+        if (!b || offsetBytes >= b->desc.byteSize)
+        {
+            SIGNAL_ERROR("Invalid buffer write range");
+            return;
+        }
+
+        dataSize = __min(dataSize, size_t(b->desc.byteSize - offsetBytes));
+
+        WriteBufferData(b, offsetBytes, data, dataSize);
+    }
+
+    void RendererInterfaceOGL::WriteBufferData(BufferHandle b, uint32_t offsetBytes, const void* data, size_t dataSize)
+    {
+        // glBufferSubData stalls when the GPU still uses the buffer, a copy from the ring is ordered with the draws instead
+        uint64_t ringOffset = 0;
+        void* pUploadData = m_pUploadRingData ? AllocateUploadSpace(dataSize, 16, ringOffset) : nullptr;
+
+        if (pUploadData)
+        {
+            memcpy(pUploadData, data, dataSize);
+            glCopyNamedBufferSubData(m_nUploadRing, b->bufferHandle, GLintptr(ringOffset), offsetBytes, dataSize);
+        }
+        else
+        {
+            glBindBuffer(GL_COPY_WRITE_BUFFER, b->bufferHandle);
+            glBufferSubData(GL_COPY_WRITE_BUFFER, offsetBytes, dataSize, data);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, GL_NONE);
+        }
+
+        CHECK_GL_ERROR();
+    }
+
+    void* RendererInterfaceOGL::mapBuffer(BufferHandle b, MapMode::Enum mode, uint32_t offsetBytes, size_t sizeBytes)
+    {
+        if (!b || b->isMapped || offsetBytes >= b->desc.byteSize || sizeBytes == 0)
+        {
+            SIGNAL_ERROR("Invalid buffer map");
+            return nullptr;
+        }
+
+        b->mappedOffset = offsetBytes;
+        b->mappedSize = uint32_t(__min(sizeBytes, size_t(b->desc.byteSize - offsetBytes)));
+        b->mappedRingPosition = ~0ull;
+
+        // The range is written into the upload ring and copied into the buffer on unmap, like in D3D12. The copy only touches
+        // the mapped range and is ordered with the other commands, which satisfies both modes without waiting for the GPU.
+        // Large ranges are mapped directly, so that a mapping never holds more than a quarter of the ring.
+        uint64_t ringOffset = 0;
+        void* pMappedData = (m_pUploadRingData && b->mappedSize <= m_UploadRingSize / 4) ? AllocateUploadSpace(b->mappedSize, 16, ringOffset) : nullptr;
+
+        if (pMappedData)
+        {
+            b->mappedRingPosition = m_UploadRingHead - b->mappedSize;
+            m_UploadRingMapped.push_back(b->mappedRingPosition);
+        }
+        else
+        {
+            // Invalidating the range lets the driver hand out fresh memory for it instead of waiting for the GPU
+            GLbitfield access = GL_MAP_WRITE_BIT;
+            access |= (mode == MapMode::WRITE_DISCARD) ? GL_MAP_INVALIDATE_RANGE_BIT : GL_MAP_UNSYNCHRONIZED_BIT;
+
+            glBindBuffer(GL_COPY_WRITE_BUFFER, b->bufferHandle);
+            pMappedData = glMapBufferRange(GL_COPY_WRITE_BUFFER, b->mappedOffset, b->mappedSize, access);
+            CHECK_GL_ERROR();
+            glBindBuffer(GL_COPY_WRITE_BUFFER, GL_NONE);
+
+            if (!pMappedData)
+                return nullptr;
+        }
+
+        b->isMapped = true;
+        return pMappedData;
+    }
+
+    void RendererInterfaceOGL::unmapBuffer(BufferHandle b)
+    {
+        if (!b || !b->isMapped)
+            return;
+
+        b->isMapped = false;
+
+        if (b->mappedRingPosition == ~0ull)
+        {
+            glBindBuffer(GL_COPY_WRITE_BUFFER, b->bufferHandle);
+            glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+            CHECK_GL_ERROR();
+            glBindBuffer(GL_COPY_WRITE_BUFFER, GL_NONE);
+            return;
+        }
+
+        glCopyNamedBufferSubData(m_nUploadRing, b->bufferHandle, GLintptr(b->mappedRingPosition % m_UploadRingSize), b->mappedOffset, b->mappedSize);
+        CHECK_GL_ERROR();
+
+        ReleaseMappedUploadSpace(b->mappedRingPosition);
+    }
+
+    void RendererInterfaceOGL::ReleaseMappedUploadSpace(uint64_t position)
+    {
+        m_UploadRingMapped.remove(position);
+
+        // The next fence protects the allocation until the GPU has read it, just like the ones written since the last fence
+        m_UploadRingFenced = __min(m_UploadRingFenced, position);
+    }
+
+
+    void RendererInterfaceOGL::clearBufferUInt(BufferHandle b, uint32_t clearValue)
+    {
+        glBindBuffer(b->bindTarget, b->bufferHandle);
+
+        glClearBufferData(b->bindTarget, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &clearValue);
+        CHECK_GL_ERROR();
+
+        glBindBuffer(b->bindTarget, GL_NONE);
+    }
+
+    void RendererInterfaceOGL::clearBufferUIntRange(BufferHandle b, uint32_t offsetBytes, size_t sizeBytes, uint32_t clearValue)
+    {
+        if (!b || offsetBytes >= b->desc.byteSize || (offsetBytes & 3) || (sizeBytes & 3))
+        {
+            SIGNAL_ERROR("Invalid buffer clear range");
+            return;
+        }
+
+        sizeBytes = __min(sizeBytes, size_t(b->desc.byteSize - offsetBytes));
+
+        glBindBuffer(b->bindTarget, b->bufferHandle);
+
+        glClearBufferSubData(b->bindTarget, GL_R32UI, offsetBytes, sizeBytes, GL_RED_INTEGER, GL_UNSIGNED_INT, &clearValue);
+        CHECK_GL_ERROR();
+
+        glBindBuffer(b->bindTarget, GL_NONE);
+    }
+
+
+    void RendererInterfaceOGL::copyToBuffer(BufferHandle dest, uint32_t destOffsetBytes, BufferHandle src, uint32_t srcOffsetBytes, size_t dataSizeBytes)
+    {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, dest->bufferHandle);
+        glBindBuffer(GL_COPY_READ_BUFFER, src->bufferHandle);
+
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, srcOffsetBytes, destOffsetBytes, dataSizeBytes);
+
+        CHECK_GL_ERROR();
+
+        glBindBuffer(GL_COPY_READ_BUFFER, GL_NONE);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, GL_NONE);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+
+
+
+    void RendererInterfaceOGL::readBuffer(BufferHandle b, void* data, size_t* dataSize)
+    {
+        uint32_t nBytesToRead = uint32_t(*dataSize);
+        if (nBytesToRead > b->desc.byteSize)
+        {
+            nBytesToRead = b->desc.byteSize;
+        }
+
+        glBindBuffer(GL_COPY_READ_BUFFER, b->bufferHandle);
+
+        void* pMappedData = glMapBufferRange(GL_COPY_READ_BUFFER, 0, nBytesToRead, GL_MAP_READ_BIT);
+        if (pMappedData)
+        {
+            memcpy(data, pMappedData, nBytesToRead);
+            *dataSize = nBytesToRead;
+        }
+        else
+        {
+            *dataSize = 0;
+        }
+
+        glUnmapBuffer(GL_COPY_READ_BUFFER);
+        glBindBuffer(GL_COPY_READ_BUFFER, GL_NONE);
+    }
+
+    Readback* RendererInterfaceOGL::AllocateReadback(size_t size)
+    {
+        // Take the smallest free staging buffer that is large enough
+        auto best = m_FreeReadbacks.end();
+        for (auto it = m_FreeReadbacks.begin(); it != m_FreeReadbacks.end(); ++it)
+        {
+            if ((*it)->capacity >= size && (best == m_FreeReadbacks.end() || (*it)->capacity < (*best)->capacity))
+                best = it;
+        }
+
+        Readback* readback = nullptr;
+
+        if (best != m_FreeReadbacks.end())
+        {
+            readback = *best;
+            *best = m_FreeReadbacks.back();
+            m_FreeReadbacks.pop_back();
+        }
+        else
+        {
+            // Round the capacity up to a power of two so that the buffer can be reused for readbacks of similar size
+            size_t capacity = 256;
+            while (capacity < size)
+                capacity *= 2;
+
+            readback = new Readback();
+            readback->capacity = capacity;
+
+            glGenBuffers(1, &readback->buffer);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, readback->buffer);
+            glBufferData(GL_COPY_WRITE_BUFFER, capacity, nullptr, GL_STREAM_READ);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, GL_NONE);
+            CHECK_GL_ERROR();
+
+            m_Readbacks.push_back(readback);
+        }
+
+        readback->size = size;
+        GetReadbackStatistics();
+        return readback;
+    }
+
+    PoolStatistics RendererInterfaceOGL::GetReadbackStatistics()
+    {
+        PoolStatistics stats;
+        for (auto readback : m_Readbacks)
+            stats.capacity += readback->capacity;
+
+        stats.inUse = stats.capacity;
+        for (auto readback : m_FreeReadbacks)
+            stats.inUse -= readback->capacity;
+
+        m_ReadbackPeakBytes = __max(m_ReadbackPeakBytes, stats.inUse);
+        stats.peak = m_ReadbackPeakBytes;
+        return stats;
+    }
+
+    bool RendererInterfaceOGL::WaitForReadback(Readback* r, uint64_t timeout)
+    {
+        if (!r->fence)
+            return true;
+
+        GLenum result = glClientWaitSync(r->fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+
+        if (result == GL_TIMEOUT_EXPIRED)
+            return false;
+
+        if (result == GL_WAIT_FAILED)
+            SIGNAL_ERROR("glClientWaitSync failed for a readback");
+
+        glDeleteSync(r->fence);
+        r->fence = nullptr;
+        return true;
+    }
+
+    FenceHandle RendererInterfaceOGL::createFence()
+    {
+        return new Fence();
+    }
+
+    void RendererInterfaceOGL::destroyFence(FenceHandle f)
+    {
+        delete f;
+    }
+
+    void RendererInterfaceOGL::signalFence(FenceHandle f, uint64_t value)
+    {
+        if (!f)
+            return;
+
+        GLsync sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        CHECK_GL_ERROR();
+
+        f->pendingSignals.push_back(std::make_pair(value, sync));
+    }
+
+    uint64_t RendererInterfaceOGL::getFenceCompletedValue(FenceHandle f)
+    {
+        if (!f)
+            return 0;
+
+        UpdateFence(f, 0);
+        return f->completedValue;
+    }
+
+    void RendererInterfaceOGL::waitFence(FenceHandle f, uint64_t value)
+    {
+        if (!f)
+            return;
+
+        UpdateFence(f, value);
+
+        if (f->completedValue < value)
+            SIGNAL_ERROR("waitFence: the value has not been signaled");
+    }
+
+    void RendererInterfaceOGL::setMaxFramesInFlight(uint32_t maxFrames)
+    {
+        m_MaxFramesInFlight = __max(maxFrames, 1u);
+    }
+
+    void RendererInterfaceOGL::beginFrame()
+    {
+        // The application may have changed GL state between frames
+        InvalidateState();
+
+        // Only block when the GPU is more than the allowed number of frames behind
+        RetireCompletedFrames(m_MaxFramesInFlight - 1);
+        RetireUploads(0);
+    }
+
+    void RendererInterfaceOGL::endFrame()
+    {
+        RestoreDefaultState();
+
+        FenceUploads();
+
+        m_FrameSyncs.push_back(glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+        CHECK_GL_ERROR();
+
+        m_FrameIndex++;
+
+        RetireCompletedFrames(UINT32_MAX);
+    }
+
+    FrameStatistics RendererInterfaceOGL::getFrameStatistics()
+    {
+        RetireCompletedFrames(UINT32_MAX);
+        RetireUploads(0);
+
+        // The driver owns the memory behind descriptors, and behind uploads when there is no upload ring
+        FrameStatistics stats;
+        stats.frameIndex = m_FrameIndex;
+        stats.framesInFlight = uint32_t(m_FrameSyncs.size());
+        stats.uploadBytes.capacity = m_UploadRingSize;
+        stats.uploadBytes.inUse = m_UploadRingHead - m_UploadRingTail;
+        stats.uploadBytes.peak = m_UploadPeakBytes;
+        stats.readbackBytes = GetReadbackStatistics();
+        AccumulateCacheStatistics(stats.stateObjects, m_CachedFrameBuffers.GetStatistics());
+        return stats;
+    }
+
+    void RendererInterfaceOGL::setStateCacheLimits(uint32_t maxEntries, uint64_t maxBytes)
+    {
+        std::vector<FrameBuffer*> evicted;
+        m_CachedFrameBuffers.SetLimits(maxEntries, maxBytes, evicted);
+        ReleaseFrameBuffers(evicted);
+    }
+
+    void RendererInterfaceOGL::RetireCompletedFrames(uint32_t maxPendingFrames)
+    {
+        // Retire the frames that the GPU has finished, and block on the oldest ones while there are more than maxPendingFrames left
+        while (!m_FrameSyncs.empty())
+        {
+            bool mustWait = m_FrameSyncs.size() > maxPendingFrames;
+
+            GLenum result = glClientWaitSync(m_FrameSyncs.front(), GL_SYNC_FLUSH_COMMANDS_BIT, mustWait ? 1000000000ull : 0);
+
+            if (result == GL_TIMEOUT_EXPIRED)
+            {
+                if (mustWait)
+                    continue;
+
+                break;
+            }
+
+            if (result == GL_WAIT_FAILED)
+                SIGNAL_ERROR("glClientWaitSync failed for a frame");
+
+            glDeleteSync(m_FrameSyncs.front());
+            m_FrameSyncs.pop_front();
+        }
+    }
+
+    void RendererInterfaceOGL::CreateUploadRing(uint64_t size)
+    {
+        // Coherent mapping makes the CPU writes visible to the commands issued after them without a flush or a barrier
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+        glCreateBuffers(1, &m_nUploadRing);
+        glNamedBufferStorage(m_nUploadRing, GLsizeiptr(size), nullptr, flags);
+        m_pUploadRingData = (uint8_t*)glMapNamedBufferRange(m_nUploadRing, 0, GLsizeiptr(size), flags);
+        CHECK_GL_ERROR();
+
+        if (!m_pUploadRingData)
+        {
+            SIGNAL_ERROR("Failed to map the upload ring, falling back to glBufferSubData");
+            glDeleteBuffers(1, &m_nUploadRing);
+            m_nUploadRing = 0;
+            return;
+        }
+
+        m_UploadRingSize = size;
+    }
+
+    void* RendererInterfaceOGL::AllocateUploadSpace(uint64_t size, uint32_t alignment, uint64_t& ringOffset)
+    {
+        if (size == 0 || size > m_UploadRingSize)
+            return nullptr;
+
+        uint64_t position = (m_UploadRingHead + alignment - 1) / alignment * alignment;
+
+        // Allocations don't wrap around the end of the buffer, the rest of it is skipped
+        uint64_t offset = position % m_UploadRingSize;
+        if (offset + size > m_UploadRingSize)
+            position += m_UploadRingSize - offset;
+
+        if (position + size > m_UploadRingTail + m_UploadRingSize)
+        {
+            FenceUploads();
+            RetireUploads(position + size - m_UploadRingSize);
+
+            // Once everything written so far has been retired, only the skipped bytes can be in the way
+            if (m_UploadRingFences.empty())
+                m_UploadRingTail = __min(position, GetUploadRingTailLimit());
+
+            // The space is held by a buffer that has been mapped since before the ring wrapped around
+            if (position + size > m_UploadRingTail + m_UploadRingSize)
+                return nullptr;
+        }
+
+        m_UploadRingHead = position + size;
+        m_UploadPeakBytes = __max(m_UploadPeakBytes, m_UploadRingHead - m_UploadRingTail);
+
+        ringOffset = position % m_UploadRingSize;
+        return m_pUploadRingData + ringOffset;
+    }
+
+    void RendererInterfaceOGL::FenceUploads()
+    {
+        if (m_UploadRingFenced == m_UploadRingHead)
+            return;
+
+        m_UploadRingFences.push_back(std::make_pair(glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), m_UploadRingHead));
+        m_UploadRingFenced = m_UploadRingHead;
+    }
+
+    void RendererInterfaceOGL::RetireUploads(uint64_t requiredTail)
+    {
+        // Retire the regions that the GPU has finished reading, and block on the ones that end before requiredTail.
+        // Waiting doesn't help past a mapped allocation, the tail stops there.
+        uint64_t tailLimit = GetUploadRingTailLimit();
+        requiredTail = __min(requiredTail, tailLimit);
+
+        while (!m_UploadRingFences.empty())
+        {
+            bool mustWait = m_UploadRingTail < requiredTail;
+
+            GLenum result = glClientWaitSync(m_UploadRingFences.front().first, GL_SYNC_FLUSH_COMMANDS_BIT, mustWait ? 1000000000ull : 0);
+
+            if (result == GL_TIMEOUT_EXPIRED)
+            {
+                if (mustWait)
+                    continue;
+
+                break;
+            }
+
+            if (result == GL_WAIT_FAILED)
+                SIGNAL_ERROR("glClientWaitSync failed for the upload ring");
+
+            m_UploadRingTail = __min(m_UploadRingFences.front().second, tailLimit);
+            glDeleteSync(m_UploadRingFences.front().first);
+            m_UploadRingFences.pop_front();
+        }
+    }
+
+    void RendererInterfaceOGL::UpdateFence(Fence* f, uint64_t waitValue)
+    {
+        // Retire the signals that the GPU has passed, in order, and block on the ones up to waitValue
+        while (!f->pendingSignals.empty())
+        {
+            const auto& signal = f->pendingSignals.front();
+            bool mustWait = f->completedValue < waitValue && signal.first <= waitValue;
+
+            GLenum result = glClientWaitSync(signal.second, GL_SYNC_FLUSH_COMMANDS_BIT, mustWait ? 1000000000ull : 0);
+
+            if (result == GL_TIMEOUT_EXPIRED)
+            {
+                if (mustWait)
+                    continue;
+
+                break;
+            }
+
+            if (result == GL_WAIT_FAILED)
+                SIGNAL_ERROR("glClientWaitSync failed for a fence");
+
+            f->completedValue = __max(f->completedValue, signal.first);
+            glDeleteSync(signal.second);
+            f->pendingSignals.pop_front();
+        }
+    }
+
+    ReadbackHandle RendererInterfaceOGL::beginBufferReadback(BufferHandle b, uint32_t offsetBytes, size_t sizeBytes)
+    {
+        if (!b || offsetBytes >= b->desc.byteSize || sizeBytes == 0)
+        {
+            SIGNAL_ERROR("Invalid buffer readback range");
+            return nullptr;
+        }
+
+        sizeBytes = __min(sizeBytes, size_t(b->desc.byteSize - offsetBytes));
+
+        Readback* readback = AllocateReadback(sizeBytes);
+        readback->rowPitch = uint32_t(sizeBytes);
+        readback->depthPitch = uint32_t(sizeBytes);
+
+        glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+        glBindBuffer(GL_COPY_READ_BUFFER, b->bufferHandle);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, readback->buffer);
+
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, offsetBytes, 0, sizeBytes);
+
+        CHECK_GL_ERROR();
+
+        glBindBuffer(GL_COPY_READ_BUFFER, GL_NONE);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, GL_NONE);
+
+        readback->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+        return readback;
+    }
+
+    ReadbackHandle RendererInterfaceOGL::beginTextureReadback(TextureHandle t, const TextureRegion& region)
+    {
+        if (!t || !region.isValid(t->desc) || t->formatMapping.bytesPerPixel == 0)
+        {
+            SIGNAL_ERROR("Invalid texture readback");
+            return nullptr;
+        }
+
+        TextureRegion box = region.resolve(t->desc);
+        if (box.width == 0 || box.height == 0 || box.depth == 0)
+        {
+            SIGNAL_ERROR("Empty texture readback region");
+            return nullptr;
+        }
+
+        uint32_t rowPitch = box.width * t->formatMapping.bytesPerPixel;
+        uint32_t depthPitch = rowPitch * box.height;
+        size_t size = size_t(depthPitch) * box.depth;
+
+        Readback* readback = AllocateReadback(size);
+        readback->rowPitch = rowPitch;
+        readback->depthPitch = depthPitch;
+
+        glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT | GL_PIXEL_BUFFER_BARRIER_BIT);
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, readback->buffer);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+        // Array slices and cube faces are addressed through zoffset, just like the slices of a 3D texture
+        glGetTextureSubImage(t->handle, box.mipLevel, box.x, box.y, box.z + box.arraySlice, box.width, box.height, box.depth,
+            t->formatMapping.baseFormat, t->formatMapping.type, GLsizei(size), nullptr);
+
+        CHECK_GL_ERROR();
+
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, GL_NONE);
+
+        readback->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+        return readback;
+    }
+
+    bool RendererInterfaceOGL::isReadbackReady(ReadbackHandle r)
+    {
+        if (!r)
+            return false;
+
+        return WaitForReadback(r, 0);
+    }
+
+    const void* RendererInterfaceOGL::mapReadback(ReadbackHandle r, uint32_t* rowPitch, uint32_t* depthPitch)
+    {
+        if (!r)
+            return nullptr;
+
+        while (!WaitForReadback(r, 1000000000ull))
+            ;
+
+        if (!r->mappedData)
+        {
+            glBindBuffer(GL_COPY_READ_BUFFER, r->buffer);
+            r->mappedData = glMapBufferRange(GL_COPY_READ_BUFFER, 0, r->size, GL_MAP_READ_BIT);
+            glBindBuffer(GL_COPY_READ_BUFFER, GL_NONE);
+            CHECK_GL_ERROR();
+        }
+
+        if (rowPitch) *rowPitch = r->rowPitch;
+        if (depthPitch) *depthPitch = r->depthPitch;
+
+        return r->mappedData;
+    }
+
+    void RendererInterfaceOGL::releaseReadback(ReadbackHandle r)
+    {
+        if (!r)
+            return;
+
+        if (r->mappedData)
+        {
+            glBindBuffer(GL_COPY_READ_BUFFER, r->buffer);
+            glUnmapBuffer(GL_COPY_READ_BUFFER);
+            glBindBuffer(GL_COPY_READ_BUFFER, GL_NONE);
+            r->mappedData = nullptr;
+        }
+
+        if (r->fence)
+        {
+            glDeleteSync(r->fence);
+            r->fence = nullptr;
+        }
+
+        m_FreeReadbacks.push_back(r);
+    }
+
+
+
+    void RendererInterfaceOGL::destroyBuffer(BufferHandle b)
+    {
+        if (!b) return;
+        if (b->isMapped && b->mappedRingPosition != ~0ull)
+            ReleaseMappedUploadSpace(b->mappedRingPosition);
+        ForgetBufferName(b->bufferHandle);
+        ForgetTextureName(b->ssboHandle);
+        delete b;
+    }
+
+
+    ConstantBufferHandle RendererInterfaceOGL::createConstantBuffer(const ConstantBufferDesc& d, const void* data)
+    {
+        if (d.byteSize > m_Capabilities.maxUniformBlockSize)
+        {
+            SIGNAL_ERROR_FMT("Constant buffer size %d exceeds the uniform block size limit %d", d.byteSize, m_Capabilities.maxUniformBlockSize);
+            return nullptr;
+        }
+
+        ConstantBufferHandle buffer = new ConstantBuffer();
+
+        buffer->desc = d;
+
+        if (m_pUploadRingData)
+        {
+            // The contents live in the upload ring and are bound with glBindBufferRange, there is no buffer object to create
+            buffer->data.resize(d.byteSize, 0);
+        }
+        else
+        {
+            glGenBuffers(1, &buffer->handle);
+            glBindBuffer(GL_UNIFORM_BUFFER, buffer->handle);
+            glBufferData(GL_UNIFORM_BUFFER, d.byteSize, nullptr, GL_DYNAMIC_DRAW);
+            CHECK_GL_ERROR();
+
+            glBindBuffer(GL_UNIFORM_BUFFER, GL_NONE);
+        }
+
+        if (data)
+            writeConstantBuffer(buffer, data, d.byteSize);
+
+        return buffer;
+    }
+
+
+    void RendererInterfaceOGL::writeConstantBuffer(ConstantBufferHandle b, const void* data, size_t dataSize)
+    {
+        if (!b || !data || dataSize > b->desc.byteSize)
+        {
+            SIGNAL_ERROR("Invalid constant buffer write");
+            return;
+        }
+
+        if (!b->data.empty())
+        {
+            if (b->uploadedDataValid && memcmp(b->data.data(), data, dataSize) == 0)
+                return;
+
+            memcpy(b->data.data(), data, dataSize);
+            b->uploadedDataValid = false;
+            return;
+        }
+
+        glBindBuffer(GL_UNIFORM_BUFFER, b->handle);
+
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, dataSize, data);
+        CHECK_GL_ERROR();
+
+        glBindBuffer(GL_UNIFORM_BUFFER, GL_NONE);
+    }
+
+
+    BufferRangeSlot RendererInterfaceOGL::GetConstantBufferSlot(ConstantBufferHandle b)
+    {
+        if (b->data.empty())
+        {
+            BufferRangeSlot slot = { b->handle, 0, b->desc.byteSize };
+            return slot;
+        }
+
+        // Once a fence covers the last copy, the ring may retire it and hand the space out again while later draws still read it.
+        // Unfenced copies can't be retired, so they are reused until the next fence.
+        if (!b->uploadedDataValid || b->ringPosition + b->data.size() <= m_UploadRingFenced)
+        {
+            uint64_t ringOffset = 0;
+            void* pUploadData = AllocateUploadSpace(b->data.size(), m_Capabilities.uniformBufferOffsetAlignment, ringOffset);
+            if (!pUploadData)
+            {
+                SIGNAL_ERROR("The upload ring is held by a mapped buffer, constant buffer contents are stale");
+                BufferRangeSlot slot = { m_nUploadRing, uint32_t(b->ringPosition % m_UploadRingSize), b->desc.byteSize };
+                return slot;
+            }
+
+            memcpy(pUploadData, b->data.data(), b->data.size());
+
+            b->ringPosition = m_UploadRingHead - b->data.size();
+            b->uploadedDataValid = true;
+        }
+
+        BufferRangeSlot slot = { m_nUploadRing, uint32_t(b->ringPosition % m_UploadRingSize), b->desc.byteSize };
+        return slot;
+    }
+
+    void RendererInterfaceOGL::destroyConstantBuffer(ConstantBufferHandle b)
+    {
+        if (!b) return;
+        ForgetBufferName(b->handle);
+        delete b;
+    }
+
+
+    ShaderHandle RendererInterfaceOGL::createShader(const ShaderDesc& d, const void* binary, const size_t binarySize)
+    {
+        (void)binarySize;
+
+        if (d.preCreationCommand)
             d.preCreationCommand->executeAndDispose();
 
-        ShaderHandle shader = new Shader(d);
-        shader->source = (const char*)binary;
+        ShaderHandle shader = new Shader(d);
+        shader->source = (const char*)binary;
+
+    
+        GLenum programType;
+        switch (d.shaderType)
+        {
+        case ShaderType::SHADER_VERTEX:     programType = GL_VERTEX_SHADER; break;
+        case ShaderType::SHADER_HULL:       programType = GL_TESS_CONTROL_SHADER; break;
+        case ShaderType::SHADER_DOMAIN:     programType = GL_TESS_EVALUATION_SHADER; break;
+        case ShaderType::SHADER_GEOMETRY:   programType = GL_GEOMETRY_SHADER; break;
+        case ShaderType::SHADER_PIXEL:      programType = GL_FRAGMENT_SHADER; break;
+        case ShaderType::SHADER_COMPUTE:    programType = GL_COMPUTE_SHADER; break;
+        default:
+            SIGNAL_ERROR_FMT("Unrecognized shader type %d", d.shaderType);
+            return nullptr;
+        }
+
+        bool success = false;
+        bool compiled = false;
+        ProgramBinaryKey binaryKey;
+
+        if (m_pProgramBinaryArchive)
+        {
+            binaryKey = ProgramBinaryArchive::GetKey(d.shaderType, shader->source);
+            shader->handle = m_pProgramBinaryArchive->LoadProgram(binaryKey);
+
+            if (!shader->handle)
+            {
+                shader->handle = CreateRetrievableProgram(programType, shader->source);
+                compiled = true;
+            }
+        }
+        else
+        {
+            shader->handle = glCreateShaderProgramv(programType, 1, (const char**)&binary);
+        }
+        CHECK_GL_ERROR();
+
+        if (shader->handle)
+        {
+            int32_t iRes = 0;
+            glGetProgramiv(shader->handle, GL_LINK_STATUS, &iRes);
+
+            if (!iRes)
+            {
+                int32_t infoLen = 0;
+                glGetProgramiv(shader->handle, GL_INFO_LOG_LENGTH, &infoLen);
+
+                if (infoLen > 1)
+                {
+                    char* infoLog = new char[infoLen];
+                    glGetProgramInfoLog(shader->handle, infoLen, nullptr, infoLog);
+
+                    SIGNAL_ERROR_FMT("Failed to compile shader:\n%s", infoLog);
+
+                    delete[] infoLog;
+                }
+                else
+                {
+                    SIGNAL_ERROR("Failed to compile shader and get the info log");
+                }
+            }
+            else
+            {
+                success = true;
+
+                if (compiled)
+                    m_pProgramBinaryArchive->StoreProgram(binaryKey, shader->handle);
+            }
+        }
+
+        if (d.postCreationCommand)
+            d.postCreationCommand->executeAndDispose();
+
+        if (!success)
+        {
+            delete shader;
+            return nullptr;
+        }
+
+        return shader;
+    }
+
+
+    // Same steps as glCreateShaderProgramv, with the hint that the program binary is going to be retrieved
+    uint32_t RendererInterfaceOGL::CreateRetrievableProgram(uint32_t programType, const char* source)
+    {
+        GLuint shader = glCreateShader(programType);
+        glShaderSource(shader, 1, &source, nullptr);
+        glCompileShader(shader);
+
+        GLint compiled = 0;
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+
+        if (!compiled)
+        {
+            int32_t infoLen = 0;
+            glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &infoLen);
+
+            std::vector<char> infoLog(std::max(infoLen, 1), 0);
+            glGetShaderInfoLog(shader, infoLen, nullptr, infoLog.data());
+            SIGNAL_ERROR_FMT("Failed to compile shader:\n%s", infoLog.data());
+
+            glDeleteShader(shader);
+            return 0;
+        }
+
+        GLuint program = glCreateProgram();
+        glProgramParameteri(program, GL_PROGRAM_SEPARABLE, GL_TRUE);
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        glAttachShader(program, shader);
+        glLinkProgram(program);
+        glDetachShader(program, shader);
+        glDeleteShader(shader);
+
+        return program;
+    }
+
+
+    bool RendererInterfaceOGL::openProgramBinaryArchive(const char* fileName)
+    {
+        closeProgramBinaryArchive();
+
+        GLint numFormats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+        if (numFormats <= 0)
+            return false;
+
+        ProgramBinaryArchive* archive = new ProgramBinaryArchive();
+        archive->fileName = fileName;
+        archive->formats.resize(numFormats);
+        glGetIntegerv(GL_PROGRAM_BINARY_FORMATS, archive->formats.data());
+
+        // Binaries are only valid for the same renderer and driver version
+        archive->deviceString = std::string((const char*)glGetString(GL_RENDERER)) + "\n" + (const char*)glGetString(GL_VERSION);
+
+        archive->Load();
+        m_pProgramBinaryArchive = archive;
+        return true;
+    }
+
+
+    bool RendererInterfaceOGL::saveProgramBinaryArchive(bool discardUnused)
+    {
+        if (!m_pProgramBinaryArchive)
+            return false;
+
+        return m_pProgramBinaryArchive->Save(discardUnused);
+    }
+
+
+    void RendererInterfaceOGL::closeProgramBinaryArchive()
+    {
+        delete m_pProgramBinaryArchive;
+        m_pProgramBinaryArchive = nullptr;
+    }
+
+
+    CacheStatistics RendererInterfaceOGL::getProgramBinaryArchiveStatistics() const
+    {
+        if (!m_pProgramBinaryArchive)
+            return CacheStatistics();
+
+        return m_pProgramBinaryArchive->GetStatistics();
+    }
+
+
+    void RendererInterfaceOGL::destroyShader(ShaderHandle s)
+    {
+        if (!s) return;
+
+        for (auto it = m_CachedProgramPipelines.begin(); it != m_CachedProgramPipelines.end(); )
+        {
+            ProgramPipeline* pipeline = it->second;
+
+            if (std::find(pipeline->shaders, pipeline->shaders + _countof(pipeline->shaders), s) != pipeline->shaders + _countof(pipeline->shaders))
+            {
+                // Deleting the bound pipeline reverts the binding to zero
+                if (m_nCurrentProgramPipeline == pipeline->handle)
+                    m_nCurrentProgramPipeline = 0;
+
+                delete pipeline;
+                it = m_CachedProgramPipelines.erase(it);
+            }
+            else
+                ++it;
+        }
+
+        delete s;
+    }
+
+
+    SamplerHandle RendererInterfaceOGL::createSampler(const SamplerDesc& d)
+    {
+        SamplerHandle sampler = new Sampler();
+
+        glGenSamplers(1, &sampler->handle);
+
+        glSamplerParameteri(sampler->handle, GL_TEXTURE_WRAP_S, convertWrapMode(d.wrapMode[0]));
+        glSamplerParameteri(sampler->handle, GL_TEXTURE_WRAP_T, convertWrapMode(d.wrapMode[1]));
+        glSamplerParameteri(sampler->handle, GL_TEXTURE_WRAP_R, convertWrapMode(d.wrapMode[2]));
+        glSamplerParameterfv(sampler->handle, GL_TEXTURE_BORDER_COLOR, (const float*)&d.borderColor);
+        glSamplerParameterf(sampler->handle, GL_TEXTURE_LOD_BIAS, d.mipBias);
+
+        if (d.anisotropy > 1.f)
+        {
+            glSamplerParameterf(sampler->handle, GL_TEXTURE_MAX_ANISOTROPY_EXT, d.anisotropy);
+        }
+        
+        if (d.shadowCompare)
+        {
+            glSamplerParameteri(sampler->handle, GL_TEXTURE_COMPARE_FUNC, GL_LESS);
+            glSamplerParameteri(sampler->handle, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+            glSamplerParameteri(sampler->handle, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glSamplerParameteri(sampler->handle, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        }
+        else
+        {
+            glSamplerParameteri(sampler->handle, GL_TEXTURE_MIN_FILTER, d.mipFilter ? GL_LINEAR_MIPMAP_LINEAR : (d.minFilter ? GL_LINEAR : GL_NEAREST));
+            glSamplerParameteri(sampler->handle, GL_TEXTURE_MAG_FILTER, d.magFilter ? GL_LINEAR : GL_NEAREST);
+        }
+    
+        return sampler;
+    }
+
+
+    void RendererInterfaceOGL::destroySampler(SamplerHandle s)
+    {
+        if (!s) return;
+        ForgetSamplerName(s->handle);
+        delete s;
+    }
+
+    InputLayoutHandle RendererInterfaceOGL::createInputLayout(const VertexAttributeDesc * d, uint32_t attributeCount, const void * vertexShaderBinary, const size_t binarySize)
+    {
+        (void)vertexShaderBinary;
+        (void)binarySize;
+
+        bool slotUsed[DrawCallState::MAX_VERTEX_ATTRIBUTE_COUNT] = { };
+        bool slotInstanced[DrawCallState::MAX_VERTEX_ATTRIBUTE_COUNT] = { };
+
+        if (attributeCount > m_Capabilities.maxVertexAttribs)
+        {
+            SIGNAL_ERROR_FMT("Input layout has %d attributes, the limit is %d", attributeCount, m_Capabilities.maxVertexAttribs);
+            return nullptr;
+        }
+
+        for (uint32_t attr = 0; attr < attributeCount; attr++)
+        {
+            const VertexAttributeDesc& desc = d[attr];
+
+            if (desc.bufferIndex >= DrawCallState::MAX_VERTEX_ATTRIBUTE_COUNT || desc.bufferIndex >= m_Capabilities.maxVertexAttribBindings)
+            {
+                SIGNAL_ERROR_FMT("Vertex attribute %s uses buffer slot %d, which is out of range", desc.name, desc.bufferIndex);
+                return nullptr;
+            }
+
+            // The instancing divisor belongs to the buffer binding, not to the attribute
+            if (slotUsed[desc.bufferIndex] && slotInstanced[desc.bufferIndex] != desc.isInstanced)
+            {
+                SIGNAL_ERROR_FMT("Vertex attributes in buffer slot %d mix per-vertex and per-instance data", desc.bufferIndex);
+                return nullptr;
+            }
+
+            slotUsed[desc.bufferIndex] = true;
+            slotInstanced[desc.bufferIndex] = desc.isInstanced;
+        }
+
+        InputLayoutHandle i = new InputLayout();
+
+        i->attributes.resize(attributeCount);
+
+        for (uint32_t attr = 0; attr < attributeCount; attr++)
+            i->attributes[attr] = d[attr];
+
+        glCreateVertexArrays(1, &i->vao);
+
+        for (uint32_t attr = 0; attr < attributeCount; attr++)
+        {
+            const VertexAttributeDesc& desc = d[attr];
+            const FormatMapping& formatMapping = GetFormatMapping(desc.format);
+
+            if (formatMapping.type == GL_INT || formatMapping.type == GL_UNSIGNED_INT)
+                glVertexArrayAttribIFormat(i->vao, attr, GLint(formatMapping.components), formatMapping.type, desc.offset);
+            else
+                glVertexArrayAttribFormat(i->vao, attr, GLint(formatMapping.components), formatMapping.type, GL_TRUE, desc.offset);
+
+            glVertexArrayAttribBinding(i->vao, attr, desc.bufferIndex);
+            glEnableVertexArrayAttrib(i->vao, attr);
+
+            i->packedStrides[desc.bufferIndex] = __max(i->packedStrides[desc.bufferIndex], desc.offset + formatMapping.bytesPerPixel);
+        }
+
+        for (uint32_t slot = 0; slot < DrawCallState::MAX_VERTEX_ATTRIBUTE_COUNT; slot++)
+        {
+            if (slotUsed[slot])
+            {
+                glVertexArrayBindingDivisor(i->vao, slot, slotInstanced[slot] ? 1 : 0);
+                i->bufferSlots.push_back(slot);
+            }
+        }
+
+        CHECK_GL_ERROR();
+
+        m_InputLayouts.push_back(i);
+
+        return i;
+    }
+
+    void RendererInterfaceOGL::destroyInputLayout(InputLayoutHandle i)
+    {
+        if (!i) return;
+
+        // Deleting a bound VAO reverts the binding to zero
+        if (m_nCurrentVAO == i->vao)
+            m_nCurrentVAO = 0;
+
+        m_InputLayouts.erase(std::find(m_InputLayouts.begin(), m_InputLayouts.end(), i));
+
+        delete i;
+    }
+
+    PerformanceQueryHandle RendererInterfaceOGL::createPerformanceQuery(const char* name)
+    {
+        PerformanceQueryHandle query = new PerformanceQuery();
+
+        if (name)
+            query->name = name;
+
+        return query;
+    }
+
+    void RendererInterfaceOGL::destroyPerformanceQuery(PerformanceQueryHandle query)
+    {
+        if (!query)
+            return;
+
+        // An open query is ended first, so that its debug group doesn't stay pushed and its timestamps are recycled below
+        if (query->state == PerformanceQuery::STARTED || query->state == PerformanceQuery::ANNOTATION)
+            endPerformanceQuery(query);
+
+        // A query object that is still in flight can be reused, the next result replaces the one that was not read
+        for (auto& pair : query->pendingPairs)
+            m_FreeTimerQueries.push_back(pair);
+
+        delete query;
+    }
+
+    void RendererInterfaceOGL::beginPerformanceQuery(PerformanceQueryHandle query, bool onlyAnnotation)
+    {
+        if (!query || query->state == PerformanceQuery::STARTED || query->state == PerformanceQuery::ANNOTATION)
+        {
+            SIGNAL_ERROR("Query is already started");
+            return;
+        }
+
+        if (m_bDebugGroupsSupported && !query->name.empty())
+            glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, query->name.c_str());
+
+        if (onlyAnnotation)
+        {
+            query->state = PerformanceQuery::ANNOTATION;
+            return;
+        }
+
+        ResolvePerformanceQuery(query);
+
+        if (query->pendingPairs.size() >= PerformanceQuery::MAX_PENDING_PAIRS)
+        {
+            m_FreeTimerQueries.push_back(query->pendingPairs.front());
+            query->pendingPairs.pop_front();
+        }
+
+        if (m_FreeTimerQueries.empty())
+        {
+            GLuint handles[2];
+            glGenQueries(2, handles);
+            m_FreeTimerQueries.push_back(std::make_pair(handles[0], handles[1]));
+        }
+
+        query->currentPair = m_FreeTimerQueries.back();
+        m_FreeTimerQueries.pop_back();
+
+        glQueryCounter(query->currentPair.first, GL_TIMESTAMP);
+        CHECK_GL_ERROR();
+
+        query->state = PerformanceQuery::STARTED;
+    }
+
+    void RendererInterfaceOGL::endPerformanceQuery(PerformanceQueryHandle query)
+    {
+        if (!query || (query->state != PerformanceQuery::STARTED && query->state != PerformanceQuery::ANNOTATION))
+        {
+            SIGNAL_ERROR("Query is not started");
+            return;
+        }
+
+        if (query->state == PerformanceQuery::STARTED)
+        {
+            glQueryCounter(query->currentPair.second, GL_TIMESTAMP);
+            CHECK_GL_ERROR();
+
+            query->pendingPairs.push_back(query->currentPair);
+        }
+
+        if (m_bDebugGroupsSupported && !query->name.empty())
+            glPopDebugGroup();
+
+        query->state = PerformanceQuery::FINISHED;
+    }
+
+    float RendererInterfaceOGL::getPerformanceQueryTimeMS(PerformanceQueryHandle query)
+    {
+        if (!query || query->state == PerformanceQuery::STARTED)
+        {
+            SIGNAL_ERROR("Query is in progress, can't get time");
+            return query ? query->time : 0.f;
+        }
+
+        ResolvePerformanceQuery(query);
+
+        return query->time;
+    }
+
+    void RendererInterfaceOGL::ResolvePerformanceQuery(PerformanceQueryHandle query)
+    {
+        // Timestamps complete in order, so the pairs are checked from the oldest one and the first pending pair ends the search
+        while (!query->pendingPairs.empty())
+        {
+            std::pair<GLuint, GLuint> pair = query->pendingPairs.front();
+
+            GLuint available = GL_FALSE;
+            glGetQueryObjectuiv(pair.second, GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available)
+                break;
+
+            GLuint64 beginTime = 0;
+            GLuint64 endTime = 0;
+            glGetQueryObjectui64v(pair.first, GL_QUERY_RESULT, &beginTime);
+            glGetQueryObjectui64v(pair.second, GL_QUERY_RESULT, &endTime);
+
+            query->time = endTime > beginTime ? float(double(endTime - beginTime) * 1e-6) : 0.f;
+
+            m_FreeTimerQueries.push_back(pair);
+            query->pendingPairs.pop_front();
+        }
+    }
+
+    GraphicsPipelineHandle RendererInterfaceOGL::createGraphicsPipeline(const GraphicsPipelineDesc& d)
+    {
+        if (d.renderTargetCount > RenderState::MAX_RENDER_TARGETS)
+        {
+            SIGNAL_ERROR("Too many render targets specified for a graphics pipeline");
+            return nullptr;
+        }
+
+        if ((d.VS && d.VS->desc.shaderType != ShaderType::SHADER_VERTEX) ||
+            (d.HS && d.HS->desc.shaderType != ShaderType::SHADER_HULL) ||
+            (d.DS && d.DS->desc.shaderType != ShaderType::SHADER_DOMAIN) ||
+            (d.GS && d.GS->desc.shaderType != ShaderType::SHADER_GEOMETRY) ||
+            (d.PS && d.PS->desc.shaderType != ShaderType::SHADER_PIXEL))
+        {
+            SIGNAL_ERROR("Shader type doesn't match the pipeline stage it is used for");
+            return nullptr;
+        }
+
+        GraphicsPipeline* pipeline = new GraphicsPipeline();
+        pipeline->desc = d;
+        pipeline->primType = convertPrimType(d.primType);
+
+        glGenProgramPipelines(1, &pipeline->programPipeline);
+        glUseProgramStages(pipeline->programPipeline, GL_VERTEX_SHADER_BIT,           d.VS ? d.VS->handle : GL_NONE);
+        glUseProgramStages(pipeline->programPipeline, GL_TESS_CONTROL_SHADER_BIT,     d.HS ? d.HS->handle : GL_NONE);
+        glUseProgramStages(pipeline->programPipeline, GL_TESS_EVALUATION_SHADER_BIT,  d.DS ? d.DS->handle : GL_NONE);
+        glUseProgramStages(pipeline->programPipeline, GL_GEOMETRY_SHADER_BIT,         d.GS ? d.GS->handle : GL_NONE);
+        glUseProgramStages(pipeline->programPipeline, GL_FRAGMENT_SHADER_BIT,         d.PS ? d.PS->handle : GL_NONE);
+        CHECK_GL_ERROR();
+
+        return pipeline;
+    }
+
+    void RendererInterfaceOGL::destroyGraphicsPipeline(GraphicsPipelineHandle p)
+    {
+        if (!p) return;
+
+        if (m_nCurrentProgramPipeline == p->programPipeline)
+            m_nCurrentProgramPipeline = 0;
+
+        delete p;
+    }
+
+    ComputePipelineHandle RendererInterfaceOGL::createComputePipeline(const ComputePipelineDesc& d)
+    {
+        if (!d.CS || d.CS->desc.shaderType != ShaderType::SHADER_COMPUTE)
+        {
+            SIGNAL_ERROR("A compute pipeline requires a compute shader");
+            return nullptr;
+        }
+
+        ComputePipeline* pipeline = new ComputePipeline();
+        pipeline->desc = d;
+
+        glGenProgramPipelines(1, &pipeline->programPipeline);
+        glUseProgramStages(pipeline->programPipeline, GL_COMPUTE_SHADER_BIT, d.CS->handle);
+        CHECK_GL_ERROR();
+
+        return pipeline;
+    }
+
+    void RendererInterfaceOGL::destroyComputePipeline(ComputePipelineHandle p)
+    {
+        if (!p) return;
+
+        if (m_nCurrentProgramPipeline == p->programPipeline)
+            m_nCurrentProgramPipeline = 0;
+
+        delete p;
+    }
+
+    BindingSetHandle RendererInterfaceOGL::createBindingSet(const BindingSetDesc& d)
+    {
+        BindingSet* bindingSet = new BindingSet();
+
+        const PipelineStageBindings* graphicsStages[ShaderType::GRAPHIC_SHADERS_NUM] = { &d.VS, &d.HS, &d.DS, &d.GS, &d.PS };
+
+        for (uint32_t stage = 0; stage < ShaderType::GRAPHIC_SHADERS_NUM; stage++)
+        {
+            bindingSet->graphicsShaders[stage] = graphicsStages[stage]->shader;
+
+            if (graphicsStages[stage]->shader)
+                BakeBindings(*graphicsStages[stage], bindingSet->graphicsBindings);
+        }
+
+        bindingSet->computeShader = d.CS.shader;
+
+        if (d.CS.shader)
+            BakeBindings(d.CS, bindingSet->computeBindings);
+
+        return bindingSet;
+    }
+
+    void RendererInterfaceOGL::destroyBindingSet(BindingSetHandle b)
+    {
+        if (!b) return;
+        delete b;
+    }
+
+    void RendererInterfaceOGL::BakeBindings(const PipelineStageBindings& stage, BindingList& list)
+    {
+        for (uint32_t nBinding = 0; nBinding < stage.textureBindingCount; ++nBinding)
+        {
+            const TextureBinding& binding = stage.textures[nBinding];
+
+            if (binding.texture == m_DefaultBackBuffer)
+            {
+                SIGNAL_ERROR("Cannot bind the default back buffer as a texture or image");
+            }
+            else if (binding.texture)
+            {
+                if (binding.isWritable)
+                {
+                    GLenum format = binding.texture->formatMapping.internalFormat;
+                    if (binding.format != Format::UNKNOWN)
+                        format = GetFormatMapping(binding.format).internalFormat;
+
+                    bool defaultView = binding.mipLevel == 0 && format == binding.texture->formatMapping.internalFormat;
+                    BindingList::ImageBind image = { binding.slot, binding.texture->handle, GLint(binding.mipLevel), format, defaultView };
+                    list.images.push_back(image);
+                }
+                else
+                {
+                    GLuint handle = binding.texture->handle;
+                    if (binding.texture->formatMapping.abstractFormat == Format::SRGBA8_UNORM)
+                        handle = binding.texture->srgbView;
+
+                    BindingList::TextureBind texture = { binding.slot, binding.texture->bindTarget, handle };
+                    list.textures.push_back(texture);
+                }
+            }
+        }
+
+        for (uint32_t nSampler = 0; nSampler < stage.textureSamplerBindingCount; ++nSampler)
+        {
+            const SamplerBinding& binding = stage.textureSamplers[nSampler];
+
+            BindingList::ObjectBind sampler = { binding.slot, binding.sampler->handle };
+            list.samplers.push_back(sampler);
+        }
+
+        for (uint32_t i = 0; i < stage.constantBufferBindingCount; i++)
+        {
+            const ConstantBufferBinding& binding = stage.constantBuffers[i];
+
+            BindingList::ConstantBufferBind cbuffer = { binding.slot, binding.buffer };
+            list.constantBuffers.push_back(cbuffer);
+        }
+
+        for (uint32_t nBuffer = 0; nBuffer < stage.bufferBindingCount; ++nBuffer)
+        {
+            const BufferBinding& binding = stage.buffers[nBuffer];
+
+            if (binding.isWritable || binding.buffer->desc.structStride > 0)
+            {
+                BindingList::ObjectBind buffer = { binding.slot, binding.buffer->bufferHandle };
+                list.storageBuffers.push_back(buffer);
+            }
+            else
+            {
+                BindingList::TextureBind texture = { binding.slot, GL_TEXTURE_BUFFER, binding.buffer->ssboHandle };
+                list.textures.push_back(texture);
+            }
+        }
+    }
+
+    void RendererInterfaceOGL::ApplyState(const DrawCallState& state)
+    {
+        ApplyDrawCallState(state);
+    }
+
+    void RendererInterfaceOGL::ApplyState(const CompactDrawCallState& state)
+    {
+        ApplyDrawCallState(state);
+    }
+
+    template<typename TDrawCallState>
+    void RendererInterfaceOGL::ApplyDrawCallState(const TDrawCallState& state)
+    {
+        CHECK_GL_ERROR();
+        
+        SetVertexAttributes(state.inputLayout, state.vertexBuffers, state.vertexBufferCount);
+
+        const RenderState& renderState = state.renderState;
+
+        CHECK_GL_ERROR();
+
+        SetShaders(state);
+        BindShaderResources(state);
+        BindRenderTargets(renderState);
+
+        SetRasterState(renderState.rasterState); // requires a bound framebuffer for programmable sample positions
+        SetBlendState(renderState.blendState, state.renderState.targetCount);
+        SetDepthStencilState(renderState.depthStencilState);
+
+        ClearRenderTargets(renderState); // requires the correct depth and maybe blend state
+    }
+
+
+    void RendererInterfaceOGL::SetVertexAttributes(InputLayoutHandle inputLayout, const VertexBufferBinding* vertexBuffers, uint32_t vertexBufferCount)
+    {
+        BindVAO(inputLayout);
+
+        if (!inputLayout)
+            return;
+
+        uint32_t firstChanged = DrawCallState::MAX_VERTEX_ATTRIBUTE_COUNT;
+        uint32_t lastChanged = 0;
+        bool changed[DrawCallState::MAX_VERTEX_ATTRIBUTE_COUNT] = { };
+
+        for (uint32_t slot : inputLayout->bufferSlots)
+        {
+            const VertexBufferBinding* binding = nullptr;
+
+            for (uint32_t buf = 0; buf < vertexBufferCount; buf++)
+            {
+                if (vertexBuffers[buf].slot == slot)
+                {
+                    binding = &vertexBuffers[buf];
+                    break;
+                }
+            }
+
+            if (binding == nullptr)
+            {
+                SIGNAL_ERROR_FMT("Vertex buffer for slot %d is not bound", slot);
+                continue;
+            }
+
+            VertexBufferSlot value;
+            value.buffer = binding->buffer->bufferHandle;
+            value.offset = GLintptr(binding->offset);
+            value.stride = GLsizei(binding->stride ? binding->stride : inputLayout->packedStrides[slot]);
+
+            if (value == inputLayout->boundBuffers[slot])
+            {
+                m_StateCallStatistics.skippedBindings++;
+                continue;
+            }
+
+            inputLayout->boundBuffers[slot] = value;
+            changed[slot] = true;
+            firstChanged = __min(firstChanged, slot);
+            lastChanged = __max(lastChanged, slot);
+        }
+
+        if (firstChanged > lastChanged)
+            return;
+
+        if (m_bMultiBindSupported)
+        {
+            // One call for the whole changed span, the slots in between are bound again with their current values
+            GLuint buffers[DrawCallState::MAX_VERTEX_ATTRIBUTE_COUNT];
+            GLintptr offsets[DrawCallState::MAX_VERTEX_ATTRIBUTE_COUNT];
+            GLsizei strides[DrawCallState::MAX_VERTEX_ATTRIBUTE_COUNT];
+
+            for (uint32_t slot = firstChanged; slot <= lastChanged; slot++)
+            {
+                buffers[slot] = inputLayout->boundBuffers[slot].buffer;
+                offsets[slot] = inputLayout->boundBuffers[slot].offset;
+                strides[slot] = inputLayout->boundBuffers[slot].stride;
+            }
+
+            uint32_t count = lastChanged - firstChanged + 1;
+            glBindVertexBuffers(firstChanged, count, buffers + firstChanged, offsets + firstChanged, strides + firstChanged);
+            m_StateCallStatistics.emittedBindingCalls++;
+        }
+        else
+        {
+            for (uint32_t slot = firstChanged; slot <= lastChanged; slot++)
+            {
+                if (changed[slot])
+                {
+                    const VertexBufferSlot& value = inputLayout->boundBuffers[slot];
+                    glBindVertexBuffer(slot, value.buffer, value.offset, value.stride);
+                    m_StateCallStatistics.emittedBindingCalls++;
+                }
+            }
+        }
+
+        CHECK_GL_ERROR();
+    }
+
+
+    void RendererInterfaceOGL::BindVAO(InputLayoutHandle inputLayout)
+    {
+        if (!m_nVAO)
+        {
+            glCreateVertexArrays(1, &m_nVAO);
+        }
+
+        GLuint vao = inputLayout ? inputLayout->vao : m_nVAO;
+
+        if (vao == m_nCurrentVAO)
+        {
+            m_StateCallStatistics.skippedBindings++;
+            return;
+        }
+
+        glBindVertexArray(vao);
+        m_nCurrentVAO = vao;
+        m_StateCallStatistics.emittedBindingCalls++;
+    }
+
+
+    void RendererInterfaceOGL::BindRenderTargets(const RenderState& renderState)
+    {
+        FrameBuffer* framebuffer = GetCachedFrameBuffer(renderState.targetCount, renderState.targets, renderState.targetIndicies, renderState.targetMipSlices,
+            renderState.depthTarget, renderState.depthIndex, renderState.depthMipSlice);
+
+        BindFrameBuffer(framebuffer);
+        SetViewports(renderState.viewportCount, renderState.viewports, renderState.scissorRects);
+    }
+
+    void RendererInterfaceOGL::BindFrameBuffer(FrameBuffer* framebuffer)
+    {
+        if (framebuffer != m_pCurrentFrameBuffer)
+        {
+            if (framebuffer)
+            {
+                glBindFramebuffer(GL_FRAMEBUFFER, framebuffer->handle);
+                glDrawBuffers(framebuffer->numBuffers, framebuffer->drawBuffers);
+            }
+            else
+            {
+                glBindFramebuffer(GL_FRAMEBUFFER, GL_NONE);
+            }
+
+            m_pCurrentFrameBuffer = framebuffer;
+        }
+    }
+
+    void RendererInterfaceOGL::SetViewports(uint32_t viewportCount, const Viewport* viewports, const Rect* scissorRects)
+    {
+        if (viewportCount > m_Capabilities.maxViewports)
+        {
+            SIGNAL_ERROR_FMT("%d viewports are set, the limit is %d", viewportCount, m_Capabilities.maxViewports);
+            viewportCount = m_Capabilities.maxViewports;
+        }
+
+        // setting scissor and viewports
+        if (!m_bCurrentViewportsValid 
+            || memcmp(m_vCurrentViewports, viewports, viewportCount * sizeof(NVRHI::Viewport)) != 0 
+            || memcmp(m_vCurrentScissorRects, scissorRects, viewportCount * sizeof(NVRHI::Rect)) != 0)
+        {
+            m_bCurrentViewportsValid = true;
+            memcpy(m_vCurrentViewports, viewports, viewportCount * sizeof(NVRHI::Viewport));
+            memcpy(m_vCurrentScissorRects, scissorRects, viewportCount * sizeof(NVRHI::Rect));
+
+            for (uint32_t rt = 0; rt < viewportCount; rt++)
+            {
+                float vx = viewports[rt].minX;
+                float vy = viewports[rt].minY;
+                float vw = viewports[rt].maxX - viewports[rt].minX;
+                float vh = viewports[rt].maxY - viewports[rt].minY;
+
+                int32_t sx = scissorRects[rt].minX;
+                int32_t sy = scissorRects[rt].minY;
+                int32_t sw = scissorRects[rt].maxX - scissorRects[rt].minX;
+                int32_t sh = scissorRects[rt].maxY - scissorRects[rt].minY;
+
+                glViewportIndexedf(rt, vx, vy, vw, vh);
+                glDepthRangeIndexed(rt, viewports[rt].minZ, viewports[rt].maxZ);
+                glScissorIndexed(rt, sx, sy, sw, sh);
+           }
+        }
+    }
+
+    void RendererInterfaceOGL::ClearRenderTargets(const RenderState& renderState)
+    {
+        uint32_t nClearBitField = 0;
+        if (renderState.clearColorTarget)
+        {
+            nClearBitField = GL_COLOR_BUFFER_BIT;
+            glClearColor(renderState.clearColor.r, renderState.clearColor.g, renderState.clearColor.b, renderState.clearColor.a);
+        }
+
+        if (renderState.clearDepthTarget)
+        {
+            nClearBitField |= GL_DEPTH_BUFFER_BIT;
+            glClearDepthf(renderState.clearDepth);
+        }
+
+        if (renderState.clearStencilTarget)
+        {
+            nClearBitField |= GL_STENCIL_BUFFER_BIT;
+            glClearStencil(renderState.clearStencil);
+        }
+
+        if (nClearBitField)
+        {
+            glClear(nClearBitField);
+        }
+    }
+
+    FrameBuffer* RendererInterfaceOGL::GetCachedFrameBuffer(uint32_t targetCount, const TextureHandle* targets, const uint32_t* targetIndicies, const uint32_t* targetMipSlices,
+        TextureHandle depthTarget, uint32_t depthIndex, uint32_t depthMipSlice)
+    {
+        if (targetCount == 1 && targets[0] == m_DefaultBackBuffer && depthTarget == nullptr)
+        {
+            // Special case: back buffer rendering
+            return nullptr;
+        }
+
+        // Fast path: the same targets as the last framebuffer that was looked up or created
+        FrameBuffer** cached = m_CachedFrameBuffers.FindFront([&](const FrameBufferKey& last)
+        {
+            if (last.depthTarget != depthTarget || last.depthIndex != depthIndex || last.depthMipSlice != depthMipSlice)
+                return false;
+
+            for (uint32_t rt = 0; rt < 8; rt++)
+            {
+                bool used = rt < targetCount;
+                if (last.renderTargets[rt] != (used ? targets[rt] : nullptr) ||
+                    last.renderTargetIndices[rt] != (used ? targetIndicies[rt] : 0) ||
+                    last.renderTargetMipSlices[rt] != (used ? targetMipSlices[rt] : 0))
+                    return false;
+            }
+
+            return true;
+        });
+
+        if (cached)
+            return *cached;
+
+        FrameBufferKey key;
+        memset(&key, 0, sizeof(key));
+        for (uint32_t rt = 0; rt < targetCount; rt++)
+        {
+            key.renderTargets[rt] = targets[rt];
+            key.renderTargetIndices[rt] = targetIndicies[rt];
+            key.renderTargetMipSlices[rt] = targetMipSlices[rt];
+        }
+        key.depthTarget = depthTarget;
+        key.depthIndex = depthIndex;
+        key.depthMipSlice = depthMipSlice;
+
+        cached = m_CachedFrameBuffers.Find(key);
+        if (cached)
+            return *cached;
+
+        FrameBuffer* framebuffer = new FrameBuffer();
+        framebuffer->key = key;
+
+        glGenFramebuffers(1, &framebuffer->handle);
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer->handle);
+
+        for (uint32_t rt = 0; rt < targetCount; rt++)
+        {
+            if (targets[rt] == m_DefaultBackBuffer)
+            {
+                SIGNAL_ERROR("Cannot bind the default back buffer unless it's the only render target bound, no depth");
+            }
+            else if (targets[rt] != nullptr)
+            {
+                framebuffer->renderTargets[rt] = targets[rt];
+                framebuffer->LinkTexture(targets[rt]);
+
+                if (targetIndicies[rt] == ~0u || targets[rt]->desc.depthOrArraySize == 0)
+                    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + rt, targets[rt]->bindTarget, targets[rt]->handle, targetMipSlices[rt]);
+                else
+                    glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + rt, targets[rt]->handle, targetMipSlices[rt], targetIndicies[rt]);
+
+                framebuffer->drawBuffers[(framebuffer->numBuffers)++] = GL_COLOR_ATTACHMENT0 + rt;
+            }
+        }
+
+        if (depthTarget)
+        {
+            framebuffer->depthTarget = depthTarget;
+            framebuffer->LinkTexture(depthTarget);
+
+            GLenum attachment;
+
+            if (depthTarget->desc.format == Format::D24S8)
+                attachment = GL_DEPTH_STENCIL_ATTACHMENT;
+            else
+                attachment = GL_DEPTH_ATTACHMENT;
+
+            if (depthIndex == ~0u || depthTarget->desc.depthOrArraySize == 0)
+                glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, depthTarget->bindTarget, depthTarget->handle, depthMipSlice);
+            else
+                glFramebufferTextureLayer(GL_FRAMEBUFFER, attachment, depthTarget->handle, depthMipSlice, depthIndex);
+        }
+
+        CHECK_GL_ERROR();
+
+        uint32_t status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+        if (status != GL_FRAMEBUFFER_COMPLETE)
+            SIGNAL_ERROR("Incomplete framebuffer!");
+
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+        std::vector<FrameBuffer*> evicted;
+        m_CachedFrameBuffers.Insert(key, framebuffer, sizeof(FrameBufferKey) + sizeof(FrameBuffer), evicted);
+        ReleaseFrameBuffers(evicted);
+
+        return framebuffer;
+    }
+
+    void RendererInterfaceOGL::ReleaseFrameBuffers(const std::vector<FrameBuffer*>& framebuffers)
+    {
+        // GL keeps the attachments of a deleted framebuffer alive for the commands that were already issued,
+        // so there is no need to wait for the GPU. Deleting the bound framebuffer reverts the binding to zero.
+        for (FrameBuffer* framebuffer : framebuffers)
+        {
+            if (m_pCurrentFrameBuffer == framebuffer)
+                m_pCurrentFrameBuffer = nullptr;
+
+            framebuffer->UnlinkTextures();
+            delete framebuffer;
+        }
+    }
+
+
+    template<typename TDrawCallState>
+    void RendererInterfaceOGL::SetShaders(const TDrawCallState& state)
+    {
+        const ShaderHandle shaders[ShaderType::GRAPHIC_SHADERS_NUM + 1] = { state.VS.shader, state.HS.shader, state.DS.shader, state.GS.shader, state.PS.shader, nullptr };
+
+        BindProgramPipeline(GetCachedProgramPipeline(shaders)->handle);
+    }
+
+    ProgramPipeline* RendererInterfaceOGL::GetCachedProgramPipeline(const ShaderHandle* shaders)
+    {
+        const uint32_t numShaders = ShaderType::GRAPHIC_SHADERS_NUM + 1;
+
+        ProgramPipelineKey key;
+        memcpy(key.shaders, shaders, sizeof(key.shaders));
+
+        auto it = m_CachedProgramPipelines.find(key);
+        if (it != m_CachedProgramPipelines.end())
+            return it->second;
+
+        ProgramPipeline* pipeline = new ProgramPipeline();
+        memcpy(pipeline->shaders, shaders, sizeof(pipeline->shaders));
 
-    
-        GLenum programType;
-        switch (d.shaderType)
+        static const GLbitfield stageBits[numShaders] = {
+            GL_VERTEX_SHADER_BIT, GL_TESS_CONTROL_SHADER_BIT, GL_TESS_EVALUATION_SHADER_BIT, GL_GEOMETRY_SHADER_BIT, GL_FRAGMENT_SHADER_BIT, GL_COMPUTE_SHADER_BIT };
+
+        glGenProgramPipelines(1, &pipeline->handle);
+
+        for (uint32_t stage = 0; stage < numShaders; stage++)
         {
-        case ShaderType::SHADER_VERTEX:     programType = GL_VERTEX_SHADER; break;
-        case ShaderType::SHADER_HULL:       programType = GL_TESS_CONTROL_SHADER; break;
-        case ShaderType::SHADER_DOMAIN:     programType = GL_TESS_EVALUATION_SHADER; break;
-        case ShaderType::SHADER_GEOMETRY:   programType = GL_GEOMETRY_SHADER; break;
-        case ShaderType::SHADER_PIXEL:      programType = GL_FRAGMENT_SHADER; break;
-        case ShaderType::SHADER_COMPUTE:    programType = GL_COMPUTE_SHADER; break;
-        default:
-            SIGNAL_ERROR_FMT("Unrecognized shader type %d", d.shaderType);
-            return nullptr;
+            if (shaders[stage])
+                glUseProgramStages(pipeline->handle, stageBits[stage], shaders[stage]->handle);
         }
 
-        bool success = false;
-        shader->handle = glCreateShaderProgramv(programType, 1, (const char**)&binary);
         CHECK_GL_ERROR();
 
-        if (shader->handle)
+        // Validated once here instead of by the driver whenever the stages of a shared pipeline change
+        GLint valid = 0;
+        glValidateProgramPipeline(pipeline->handle);
+        glGetProgramPipelineiv(pipeline->handle, GL_VALIDATE_STATUS, &valid);
+
+        if (!valid)
         {
-            int32_t iRes = 0;
-            glGetProgramiv(shader->handle, GL_LINK_STATUS, &iRes);
+            GLint infoLen = 0;
+            glGetProgramPipelineiv(pipeline->handle, GL_INFO_LOG_LENGTH, &infoLen);
 
-            if (!iRes)
+            if (infoLen > 1)
             {
-                int32_t infoLen = 0;
-                glGetProgramiv(shader->handle, GL_INFO_LOG_LENGTH, &infoLen);
+                char* infoLog = new char[infoLen];
+                glGetProgramPipelineInfoLog(pipeline->handle, infoLen, nullptr, infoLog);
 
-                if (infoLen > 1)
-                {
-                    char* infoLog = new char[infoLen];
-                    glGetProgramInfoLog(shader->handle, infoLen, nullptr, infoLog);
+                SIGNAL_ERROR_FMT("Program pipeline validation failed:\n%s", infoLog);
 
-                    SIGNAL_ERROR_FMT("Failed to compile shader:\n%s", infoLog);
+                delete[] infoLog;
+            }
+            else
+            {
+                SIGNAL_ERROR("Program pipeline validation failed");
+            }
+        }
 
-                    delete[] infoLog;
+        m_CachedProgramPipelines[key] = pipeline;
+
+        return pipeline;
+    }
+
+    void RendererInterfaceOGL::BindProgramPipeline(uint32_t programPipeline)
+    {
+        if (programPipeline == m_nCurrentProgramPipeline)
+        {
+            m_StateCallStatistics.skippedBindings++;
+            return;
+        }
+
+        glBindProgramPipeline(programPipeline);
+        m_nCurrentProgramPipeline = programPipeline;
+        m_StateCallStatistics.emittedBindingCalls++;
+    }
+
+    template<typename TStageBindings>
+    void RendererInterfaceOGL::BindStageResources(const TStageBindings& state)
+    {
+        CHECK_GL_ERROR();
+
+        // requesting textures and images
+        for (uint32_t nBinding = 0; nBinding < state.textureBindingCount; ++nBinding)
+        {
+            const TextureBinding& binding = state.textures[nBinding];
+
+            if (binding.texture == m_DefaultBackBuffer)
+            {
+                SIGNAL_ERROR("Cannot bind the default back buffer as a texture or image");
+            }
+            else if (binding.texture)
+            {
+                if (binding.isWritable)
+                {
+                    GLenum format = binding.texture->formatMapping.internalFormat;
+                    if (binding.format != Format::UNKNOWN)
+                        format = GetFormatMapping(binding.format).internalFormat;
+
+                    bool defaultView = binding.mipLevel == 0 && format == binding.texture->formatMapping.internalFormat;
+                    ImageSlot image = { binding.texture->handle, int32_t(binding.mipLevel), format, defaultView };
+                    RequestBinding(m_ImageBindings, binding.slot, image);
                 }
                 else
                 {
-                    SIGNAL_ERROR("Failed to compile shader and get the info log");
+                    TextureSlot texture = { binding.texture->bindTarget, binding.texture->handle };
+                    if (binding.texture->formatMapping.abstractFormat == Format::SRGBA8_UNORM)
+                        texture.handle = binding.texture->srgbView;
+
+                    RequestBinding(m_TextureBindings, binding.slot, texture);
                 }
             }
+        }
+
+        // requesting samplers
+        for (uint32_t nSampler = 0; nSampler < state.textureSamplerBindingCount; ++nSampler)
+        {
+            const SamplerBinding& binding = state.textureSamplers[nSampler];
+
+            RequestBinding(m_SamplerBindings, binding.slot, uint32_t(binding.sampler->handle));
+        }
+
+        // requesting constant buffers
+        for (uint32_t i = 0; i < state.constantBufferBindingCount; i++)
+        {
+            const ConstantBufferBinding& binding = state.constantBuffers[i];
+
+            RequestBinding(m_UniformBufferBindings, binding.slot, GetConstantBufferSlot(binding.buffer));
+        }
+
+        // requesting ssbo`s and buffer textures
+        for (uint32_t nBuffer = 0; nBuffer < state.bufferBindingCount; ++nBuffer)
+        {
+            const BufferBinding& binding = state.buffers[nBuffer];
+
+            if (binding.isWritable || binding.buffer->desc.structStride > 0)
+            {
+                RequestBinding(m_StorageBufferBindings, binding.slot, uint32_t(binding.buffer->bufferHandle));
+            }
             else
             {
-                success = true;
+                TextureSlot texture = { GL_TEXTURE_BUFFER, binding.buffer->ssboHandle };
+                RequestBinding(m_TextureBindings, binding.slot, texture);
             }
         }
+    }
 
-        if (d.postCreationCommand)
-            d.postCreationCommand->executeAndDispose();
+    template<typename TDrawCallState>
+    void RendererInterfaceOGL::BindShaderResources(const TDrawCallState& state)
+    {
+        BindStageResources(state.VS);
+        BindStageResources(state.HS);
+        BindStageResources(state.DS);
+        BindStageResources(state.GS);
+        BindStageResources(state.PS);
 
-        if (!success)
+        FlushBindings();
+    }
+
+
+    template<typename T>
+    bool RendererInterfaceOGL::UpdateShadowState(T& shadow, const T& value)
+    {
+        if (memcmp(&shadow, &value, sizeof(T)) == 0)
         {
-            delete shader;
-            return nullptr;
+            m_StateCallStatistics.skippedCalls++;
+            return false;
         }
 
-        return shader;
+        memcpy(&shadow, &value, sizeof(T));
+        m_StateCallStatistics.emittedCalls++;
+        return true;
     }
 
+    void RendererInterfaceOGL::SetCapability(uint32_t cap, uint8_t& shadow, bool enable)
+    {
+        if (UpdateShadowState(shadow, uint8_t(enable)))
+        {
+            if (enable)
+                glEnable(cap);
+            else
+                glDisable(cap);
+        }
+    }
 
-    void RendererInterfaceOGL::destroyShader(ShaderHandle s)
+    void RendererInterfaceOGL::SetStencilFunc(uint32_t face, uint32_t func, uint32_t ref, uint32_t readMask)
     {
-        if (!s) return;
-        delete s;
+        const uint32_t value[3] = { func, ref, readMask };
+        if (UpdateShadowState(m_FixedFunctionState.stencilFunc[face == GL_FRONT ? 0 : 1], value))
+            glStencilFuncSeparate(face, func, ref, readMask);
     }
 
+    void RendererInterfaceOGL::SetStencilOp(uint32_t face, uint32_t sfail, uint32_t dpfail, uint32_t dppass)
+    {
+        const uint32_t value[3] = { sfail, dpfail, dppass };
+        if (UpdateShadowState(m_FixedFunctionState.stencilOp[face == GL_FRONT ? 0 : 1], value))
+            glStencilOpSeparate(face, sfail, dpfail, dppass);
+    }
 
-    SamplerHandle RendererInterfaceOGL::createSampler(const SamplerDesc& d)
+    void RendererInterfaceOGL::SetStencilWriteMask(uint32_t mask)
     {
-        SamplerHandle sampler = new Sampler();
+        if (UpdateShadowState(m_FixedFunctionState.stencilWriteMask, mask))
+            glStencilMask(mask);
+    }
 
-        glGenSamplers(1, &sampler->handle);
+    void RendererInterfaceOGL::SetRasterState(const RasterState& rasterState)
+    {
+        uint32_t polygonMode = GL_FILL;
 
-        glSamplerParameteri(sampler->handle, GL_TEXTURE_WRAP_S, convertWrapMode(d.wrapMode[0]));
-        glSamplerParameteri(sampler->handle, GL_TEXTURE_WRAP_T, convertWrapMode(d.wrapMode[1]));
-        glSamplerParameteri(sampler->handle, GL_TEXTURE_WRAP_R, convertWrapMode(d.wrapMode[2]));
-        glSamplerParameterfv(sampler->handle, GL_TEXTURE_BORDER_COLOR, (const float*)&d.borderColor);
-        glSamplerParameterf(sampler->handle, GL_TEXTURE_LOD_BIAS, d.mipBias);
+        switch (rasterState.fillMode)
+        {
+        case RasterState::FILL_LINE:
+            polygonMode = GL_LINE;
+            break;
+        case RasterState::FILL_SOLID:
+            polygonMode = GL_FILL;
+            break;
 
-        if (d.anisotropy > 1.f)
+        default:
+            SIGNAL_ERROR_FMT("Unknown fill mode specified %d", rasterState.fillMode);
+            break;
+        }
+
+        if (UpdateShadowState(m_FixedFunctionState.polygonMode, polygonMode))
+            glPolygonMode(GL_FRONT_AND_BACK, polygonMode);
+
+        switch (rasterState.cullMode)
         {
-            glSamplerParameterf(sampler->handle, GL_TEXTURE_MAX_ANISOTROPY_EXT, d.anisotropy);
+        case RasterState::CULL_BACK:
+            if (UpdateShadowState(m_FixedFunctionState.cullFace, uint32_t(GL_BACK)))
+                glCullFace(GL_BACK);
+            SetCapability(GL_CULL_FACE, m_FixedFunctionState.cullFaceEnable, true);
+            break;
+        case RasterState::CULL_FRONT:
+            if (UpdateShadowState(m_FixedFunctionState.cullFace, uint32_t(GL_FRONT)))
+                glCullFace(GL_FRONT);
+            SetCapability(GL_CULL_FACE, m_FixedFunctionState.cullFaceEnable, true);
+            break;
+        case RasterState::CULL_NONE:
+            SetCapability(GL_CULL_FACE, m_FixedFunctionState.cullFaceEnable, false);
+            break;
+        default:
+            SIGNAL_ERROR_FMT("Unknown cullMode %d", rasterState.cullMode);
         }
-        
-        if (d.shadowCompare)
+
+        uint32_t frontFace = rasterState.frontCounterClockwise ? GL_CCW : GL_CW;
+        if (UpdateShadowState(m_FixedFunctionState.frontFace, frontFace))
+            glFrontFace(frontFace);
+
+        SetCapability(GL_DEPTH_CLAMP, m_FixedFunctionState.depthClampEnable, rasterState.depthClipEnable);
+        SetCapability(GL_SCISSOR_TEST, m_FixedFunctionState.scissorTestEnable, rasterState.scissorEnable);
+
+        bool polygonOffsetEnable = rasterState.depthBias != 0 || rasterState.slopeScaledDepthBias != 0.f;
+        SetCapability(GL_POLYGON_OFFSET_FILL, m_FixedFunctionState.polygonOffsetEnable, polygonOffsetEnable);
+
+        if (polygonOffsetEnable)
         {
-            glSamplerParameteri(sampler->handle, GL_TEXTURE_COMPARE_FUNC, GL_LESS);
-            glSamplerParameteri(sampler->handle, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
-            glSamplerParameteri(sampler->handle, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-            glSamplerParameteri(sampler->handle, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            const float polygonOffset[2] = { rasterState.slopeScaledDepthBias, float(rasterState.depthBias) };
+            if (UpdateShadowState(m_FixedFunctionState.polygonOffset, polygonOffset))
+                glPolygonOffset(polygonOffset[0], polygonOffset[1]);
         }
-        else
+
+        SetCapability(GL_MULTISAMPLE, m_FixedFunctionState.multisampleEnable, rasterState.multisampleEnable);
+
+        if (rasterState.multisampleEnable)
         {
-            glSamplerParameteri(sampler->handle, GL_TEXTURE_MIN_FILTER, d.mipFilter ? GL_LINEAR_MIPMAP_LINEAR : (d.minFilter ? GL_LINEAR : GL_NEAREST));
-            glSamplerParameteri(sampler->handle, GL_TEXTURE_MAG_FILTER, d.magFilter ? GL_LINEAR : GL_NEAREST);
+            if (UpdateShadowState(m_FixedFunctionState.sampleMask, ~0u))
+                glSampleMaski(0, ~0u);
+            CHECK_GL_ERROR();
         }
-    
-        return sampler;
-    }
 
+        if (rasterState.antialiasedLineEnable)
+        {
+            SIGNAL_ERROR("Antialiased line rasterizer state requested");
+        }
 
-    void RendererInterfaceOGL::destroySampler(SamplerHandle s)
-    {
-        if (!s) return;
-        delete s;
+        if (rasterState.conservativeRasterEnable)
+        {
+            glEnable(GL_CONSERVATIVE_RASTERIZATION_NV);
+            m_bConservativeRasterEnabled = true;
+            CHECK_GL_ERROR();
+        }
+        else if (m_bConservativeRasterEnabled)
+        {
+            glDisable(GL_CONSERVATIVE_RASTERIZATION_NV);
+            m_bConservativeRasterEnabled = false;
+        }
+
+        if (rasterState.forcedSampleCount)
+        {
+            if (glRasterSamplesEXT)
+            {
+                glEnable(GL_RASTER_MULTISAMPLE_EXT);
+                glRasterSamplesEXT(rasterState.forcedSampleCount, TRUE);
+                m_bForcedSampleCountEnabled = true;
+                CHECK_GL_ERROR();
+            }
+            else
+            {
+                SIGNAL_ERROR("Trying to use forcedSampleCount but glRasterSamplesEXT function is NULL");
+            }
+        }
+        else if (m_bForcedSampleCountEnabled)
+        {
+            glDisable(GL_RASTER_MULTISAMPLE_EXT);
+            m_bForcedSampleCountEnabled = false;
+        }
+
+        if (rasterState.programmableSamplePositionsEnable)
+        {
+            if (glFramebufferSampleLocationsfvNV)
+            {
+                float locations[32];
+                for (int pt = 0; pt < 16; pt++)
+                {
+                    locations[pt * 2 + 0] = float(rasterState.samplePositionsX[pt]) / 16.0f;
+                    locations[pt * 2 + 1] = float(rasterState.samplePositionsY[pt]) / 16.0f;
+                }
+
+                glFramebufferSampleLocationsfvNV(GL_FRAMEBUFFER, 0, rasterState.forcedSampleCount, locations);
+                glFramebufferParameteri(GL_FRAMEBUFFER, GL_FRAMEBUFFER_PROGRAMMABLE_SAMPLE_LOCATIONS_NV, 1);
+                CHECK_GL_ERROR();
+            }
+            else
+            {
+                SIGNAL_ERROR("Trying to use programmableSamplePositions but glFramebufferSampleLocationsfvNV function is NULL");
+            }
+        }
     }
 
-    InputLayoutHandle RendererInterfaceOGL::createInputLayout(const VertexAttributeDesc * d, uint32_t attributeCount, const void * vertexShaderBinary, const size_t binarySize)
+
+
+    void RendererInterfaceOGL::SetBlendState(const BlendState& blendState, uint32_t targetCount)
     {
-        (void)vertexShaderBinary;
-        (void)binarySize;
+        SetCapability(GL_SAMPLE_ALPHA_TO_COVERAGE, m_FixedFunctionState.alphaToCoverageEnable, blendState.alphaToCoverage);
 
-        InputLayoutHandle i = new InputLayout();
+        for (uint32_t i = 0; i < targetCount; ++i)
+        {
+            if (UpdateShadowState(m_FixedFunctionState.blendEnable[i], uint8_t(blendState.blendEnable[i])))
+            {
+                if (blendState.blendEnable[i])
+                    glEnablei(GL_BLEND, i);
+                else
+                    glDisablei(GL_BLEND, i);
+            }
 
-        i->attributes.resize(attributeCount);
+            // The equation and factors have no effect on targets without blending
+            if (blendState.blendEnable[i])
+            {
+                const uint32_t blendEquation[2] = {
+                    convertBlendOp(blendState.blendOp[i]),
+                    convertBlendOp(blendState.blendOpAlpha[i]) };
 
-        for (uint32_t attr = 0; attr < attributeCount; attr++)
-            i->attributes[attr] = d[attr];
+                if (UpdateShadowState(m_FixedFunctionState.blendEquation[i], blendEquation))
+                    glBlendEquationSeparatei(i, blendEquation[0], blendEquation[1]);
 
-        return i;
-    }
+                const uint32_t blendFunc[4] = {
+                    convertBlendValue(blendState.srcBlend[i]),
+                    convertBlendValue(blendState.destBlend[i]),
+                    convertBlendValue(blendState.srcBlendAlpha[i]),
+                    convertBlendValue(blendState.destBlendAlpha[i]) };
 
-    void RendererInterfaceOGL::destroyInputLayout(InputLayoutHandle i)
-    {
-        if (!i) return;
-        delete i;
+                if (UpdateShadowState(m_FixedFunctionState.blendFunc[i], blendFunc))
+                    glBlendFuncSeparatei(i, blendFunc[0], blendFunc[1], blendFunc[2], blendFunc[3]);
+            }
+
+            if (UpdateShadowState(m_FixedFunctionState.colorMask[i], uint8_t(blendState.colorWriteEnable[i])))
+            {
+                glColorMaski(i,
+                    (blendState.colorWriteEnable[i] & BlendState::COLOR_MASK_RED) != 0,
+                    (blendState.colorWriteEnable[i] & BlendState::COLOR_MASK_GREEN) != 0,
+                    (blendState.colorWriteEnable[i] & BlendState::COLOR_MASK_BLUE) != 0,
+                    (blendState.colorWriteEnable[i] & BlendState::COLOR_MASK_ALPHA) != 0);
+            }
+        }
     }
 
-    void RendererInterfaceOGL::ApplyState(const DrawCallState& state)
-    {
-        CHECK_GL_ERROR();
-        
-        BindVAO();
 
-        size_t nattr = 0;
-        if (state.inputLayout)
+    void RendererInterfaceOGL::SetDepthStencilState(const DepthStencilState& depthState)
+    {
+        SetCapability(GL_DEPTH_TEST, m_FixedFunctionState.depthTestEnable, depthState.depthEnable);
+
+        if (depthState.depthEnable)
         {
-            for (nattr = 0; nattr < state.inputLayout->attributes.size(); nattr++)
-            {
-                const VertexAttributeDesc& attr = state.inputLayout->attributes[nattr];
-                const VertexBufferBinding* binding = nullptr;
-
-                for (uint32_t buf = 0; buf < state.vertexBufferCount; buf++)
-                {
-                    if (state.vertexBuffers[buf].slot == attr.bufferIndex)
-                    {
-                        binding = &state.vertexBuffers[buf];
-                        break;
-                    }
-                }
+            uint8_t depthMask = (depthState.depthWriteMask == DepthStencilState::DEPTH_WRITE_MASK_ALL) ? GL_TRUE : GL_FALSE;
+            if (UpdateShadowState(m_FixedFunctionState.depthMask, depthMask))
+                glDepthMask(depthMask);
 
-                if (binding == nullptr)
-                {
-                    SIGNAL_ERROR_FMT("Vertex buffer for slot %d is not bound", attr.bufferIndex);
-                    continue;
-                }
+            uint32_t depthFunc = convertComparisonFunc(depthState.depthFunc);
+            if (UpdateShadowState(m_FixedFunctionState.depthFunc, depthFunc))
+                glDepthFunc(depthFunc);
+        }
 
-                glBindBuffer(GL_ARRAY_BUFFER, binding->buffer->bufferHandle);
+        SetCapability(GL_STENCIL_TEST, m_FixedFunctionState.stencilTestEnable, depthState.stencilEnable);
 
-                const FormatMapping& formatMapping = GetFormatMapping(attr.format);
+        if (depthState.stencilEnable)
+        {
+            SetStencilFunc(GL_FRONT, convertComparisonFunc(depthState.frontFace.stencilFunc), depthState.stencilRefValue, depthState.stencilReadMask);
+            SetStencilOp(GL_FRONT, convertStencilOp(depthState.frontFace.stencilFailOp),
+                convertStencilOp(depthState.frontFace.stencilDepthFailOp),
+                convertStencilOp(depthState.frontFace.stencilPassOp));
 
-                if(formatMapping.type == GL_INT || formatMapping.type == GL_UNSIGNED_INT)
-                    glVertexAttribIPointer(
-                        GLuint(nattr), 
-                        GLint(formatMapping.components), 
-                        formatMapping.type, 
-                        GLsizei(binding->stride), 
-                        (const void*)size_t(binding->offset + attr.offset));
-                else
-                    glVertexAttribPointer(
-                        GLuint(nattr), 
-                        GLint(formatMapping.components), 
-                        formatMapping.type, 
-                        GL_TRUE, 
-                        GLsizei(binding->stride), 
-                        (const void*)size_t(binding->offset + attr.offset));
+            SetStencilFunc(GL_BACK, convertComparisonFunc(depthState.backFace.stencilFunc), depthState.stencilRefValue, depthState.stencilReadMask);
+            SetStencilOp(GL_BACK, convertStencilOp(depthState.backFace.stencilFailOp),
+                convertStencilOp(depthState.backFace.stencilDepthFailOp),
+                convertStencilOp(depthState.backFace.stencilPassOp));
 
-                glVertexAttribDivisor(GLuint(nattr), attr.isInstanced ? 1 : 0);
-                glEnableVertexAttribArray(GLuint(nattr));
-            }
+            SetStencilWriteMask(depthState.stencilWriteMask);
         }
+        else
+        {
+            // Stencil clears still go through the write mask
+            SetStencilWriteMask(~0u);
+        }
+    }
 
-        glBindBuffer(GL_ARRAY_BUFFER, GL_NONE);
 
-        static GLint nMaxVertexAttrs = 0;
-        if(nMaxVertexAttrs == 0)
-            glGetIntegerv(GL_MAX_VERTEX_ATTRIBS, &nMaxVertexAttrs);
 
-        for (; int(nattr) < nMaxVertexAttrs; nattr++)
-            glDisableVertexAttribArray(GLuint(nattr));
+    template<typename TDrawCallState>
+    void RendererInterfaceOGL::DrawImpl(const TDrawCallState& state, const DrawArguments* args, uint32_t numDrawCalls)
+    {
+        ApplyDrawCallState(state);
 
-        const RenderState& renderState = state.renderState;
+        IssueDraws(convertPrimType(state.primType), args, numDrawCalls);
 
         CHECK_GL_ERROR();
+    }
 
-        SetShaders(state);
-        BindShaderResources(state);
-        BindRenderTargets(renderState);
+    template<typename TDrawCallState>
+    void RendererInterfaceOGL::DrawIndexedImpl(const TDrawCallState& state, const DrawArguments* args, uint32_t numDrawCalls)
+    {
+        ApplyDrawCallState(state);
 
-        SetRasterState(renderState.rasterState); // requires a bound framebuffer for programmable sample positions
-        SetBlendState(renderState.blendState, state.renderState.targetCount);
-        SetDepthStencilState(renderState.depthStencilState);
+        IssueIndexedDraws(convertPrimType(state.primType), state.indexBuffer, state.indexBufferFormat, state.indexBufferOffset, args, numDrawCalls);
 
-        ClearRenderTargets(renderState); // requires the correct depth and maybe blend state
+        CHECK_GL_ERROR();
     }
 
-
-    void RendererInterfaceOGL::BindVAO()
+    void RendererInterfaceOGL::IssueDraws(uint32_t primType, const DrawArguments* args, uint32_t numDrawCalls)
     {
-        if (!m_nVAO)
+        // Draws without instancing are submitted with one call, the others one by one
+        bool instanced = false;
+        for (uint32_t n = 0; n < numDrawCalls; n++)
+            instanced = instanced || args[n].instanceCount != 1 || args[n].startInstanceLocation != 0;
+
+        if (numDrawCalls > 1 && !instanced)
         {
-            glGenVertexArrays(1, &m_nVAO);
+            m_MultiDrawFirsts.resize(numDrawCalls);
+            m_MultiDrawCounts.resize(numDrawCalls);
+
+            for (uint32_t n = 0; n < numDrawCalls; n++)
+            {
+                m_MultiDrawFirsts[n] = args[n].startVertexLocation;
+                m_MultiDrawCounts[n] = args[n].vertexCount;
+            }
+
+            glMultiDrawArrays(primType, m_MultiDrawFirsts.data(), m_MultiDrawCounts.data(), numDrawCalls);
+            CHECK_GL_ERROR();
+            return;
         }
 
-        glBindVertexArray(m_nVAO);
+        for (uint32_t n = 0; n < numDrawCalls; n++)
+        {
+            glDrawArraysInstancedBaseInstance(primType, args[n].startVertexLocation, args[n].vertexCount, args[n].instanceCount, args[n].startInstanceLocation);
+            CHECK_GL_ERROR();
+        }
     }
 
-
-    void RendererInterfaceOGL::BindRenderTargets(const RenderState& renderState)
+    void RendererInterfaceOGL::IssueIndexedDraws(uint32_t primType, BufferHandle indexBuffer, Format::Enum indexFormat, uint32_t indexBufferOffset, const DrawArguments* args, uint32_t numDrawCalls)
     {
-        FrameBuffer* framebuffer = GetCachedFrameBuffer(renderState);
+        GLenum indexType = convertIndexFormat(indexFormat);
+        uint32_t indexSize = indexType == GL_UNSIGNED_SHORT ? 2 : 4;
 
-        if (framebuffer != m_pCurrentFrameBuffer)
+        if (indexBuffer)
         {
-            if (framebuffer)
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer->bufferHandle);
+        }
+
+        bool instanced = false;
+        for (uint32_t n = 0; n < numDrawCalls; n++)
+            instanced = instanced || args[n].instanceCount != 1 || args[n].startInstanceLocation != 0;
+
+        if (numDrawCalls > 1 && !instanced)
+        {
+            m_MultiDrawCounts.resize(numDrawCalls);
+            m_MultiDrawIndexOffsets.resize(numDrawCalls);
+            m_MultiDrawBaseVertices.resize(numDrawCalls);
+
+            for (uint32_t n = 0; n < numDrawCalls; n++)
             {
-                glBindFramebuffer(GL_FRAMEBUFFER, framebuffer->handle);
-                glDrawBuffers(framebuffer->numBuffers, framebuffer->drawBuffers);
+                m_MultiDrawCounts[n] = args[n].vertexCount;
+                m_MultiDrawIndexOffsets[n] = (const void*)size_t(args[n].startIndexLocation * indexSize + indexBufferOffset);
+                m_MultiDrawBaseVertices[n] = args[n].startVertexLocation;
             }
-            else
+
+            glMultiDrawElementsBaseVertex(primType, m_MultiDrawCounts.data(), indexType, m_MultiDrawIndexOffsets.data(), numDrawCalls, m_MultiDrawBaseVertices.data());
+            CHECK_GL_ERROR();
+        }
+        else
+        {
+            for (uint32_t n = 0; n < numDrawCalls; n++)
             {
-                glBindFramebuffer(GL_FRAMEBUFFER, GL_NONE);
+                uint32_t indexOffset = args[n].startIndexLocation * indexSize + indexBufferOffset;
+                glDrawElementsInstancedBaseVertexBaseInstance(primType, args[n].vertexCount, indexType, (const void*)size_t(indexOffset),
+                    args[n].instanceCount, args[n].startVertexLocation, args[n].startInstanceLocation);
+                CHECK_GL_ERROR();
             }
-
-            m_pCurrentFrameBuffer = framebuffer;
         }
 
-        // setting scissor and viewports
-        if (!m_bCurrentViewportsValid 
-            || memcmp(m_vCurrentViewports, renderState.viewports, renderState.viewportCount * sizeof(NVRHI::Viewport)) != 0 
-            || memcmp(m_vCurrentScissorRects, renderState.scissorRects, renderState.viewportCount * sizeof(NVRHI::Rect)) != 0)
+        if (indexBuffer)
         {
-            m_bCurrentViewportsValid = true;
-            memcpy(m_vCurrentViewports, renderState.viewports, renderState.viewportCount * sizeof(NVRHI::Viewport));
-            memcpy(m_vCurrentScissorRects, renderState.scissorRects, renderState.viewportCount * sizeof(NVRHI::Rect));
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, GL_NONE);
+        }
+    }
 
-            for (uint32_t rt = 0; rt < renderState.viewportCount; rt++)
-            {
-                float vx = renderState.viewports[rt].minX;
-                float vy = renderState.viewports[rt].minY;
-                float vw = renderState.viewports[rt].maxX - renderState.viewports[rt].minX;
-                float vh = renderState.viewports[rt].maxY - renderState.viewports[rt].minY;
+    template<typename TDrawCallState>
+    void RendererInterfaceOGL::DrawIndirectImpl(const TDrawCallState& state, BufferHandle indirectParams, uint32_t offsetBytes)
+    {
+        ApplyDrawCallState(state);
+
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectParams->bufferHandle);
 
-                int32_t sx = renderState.scissorRects[rt].minX;
-                int32_t sy = renderState.scissorRects[rt].minY;
-                int32_t sw = renderState.scissorRects[rt].maxX - renderState.scissorRects[rt].minX;
-                int32_t sh = renderState.scissorRects[rt].maxY - renderState.scissorRects[rt].minY;
+        uint32_t nPrimType = convertPrimType(state.primType);
+        glDrawArraysIndirect(nPrimType, (const void*)size_t(offsetBytes));
+        CHECK_GL_ERROR();
 
-                glViewportIndexedf(rt, vx, vy, vw, vh);
-                glDepthRangeIndexed(rt, renderState.viewports[rt].minZ, renderState.viewports[rt].maxZ);
-                glScissorIndexed(rt, sx, sy, sw, sh);
-           }
-        }
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, GL_NONE);
     }
 
-    void RendererInterfaceOGL::ClearRenderTargets(const RenderState& renderState)
+    template<typename TDrawCallState>
+    void RendererInterfaceOGL::MultiDrawIndirectImpl(const TDrawCallState& state, bool indexed, BufferHandle argsBuffer, uint32_t argsOffsetBytes, uint32_t argsStrideBytes, uint32_t maxDrawCount, BufferHandle countBuffer, uint32_t countOffsetBytes)
     {
-        uint32_t nClearBitField = 0;
-        if (renderState.clearColorTarget)
+        ApplyDrawCallState(state);
+
+        IssueMultiDrawIndirect(convertPrimType(state.primType), indexed, state.indexBuffer, state.indexBufferFormat, state.indexBufferOffset, argsBuffer, argsOffsetBytes, argsStrideBytes, maxDrawCount, countBuffer, countOffsetBytes);
+    }
+
+    void RendererInterfaceOGL::IssueMultiDrawIndirect(uint32_t primType, bool indexed, BufferHandle indexBuffer, Format::Enum indexFormat, uint32_t indexBufferOffset, BufferHandle argsBuffer, uint32_t argsOffsetBytes, uint32_t argsStrideBytes, uint32_t maxDrawCount, BufferHandle countBuffer, uint32_t countOffsetBytes)
+    {
+        uint32_t recordSize = indexed ? sizeof(DrawIndexedIndirectArguments) : sizeof(DrawIndirectArguments);
+
+        if (!argsBuffer || (argsStrideBytes & 3) != 0 || (argsStrideBytes != 0 && argsStrideBytes < recordSize) || (countOffsetBytes & 3) != 0)
         {
-            nClearBitField = GL_COLOR_BUFFER_BIT;
-            glClearColor(renderState.clearColor.r, renderState.clearColor.g, renderState.clearColor.b, renderState.clearColor.a);
+            SIGNAL_ERROR("Invalid indirect draw arguments");
+            return;
         }
 
-        if (renderState.clearDepthTarget)
+        // The records only contain the first index, the element buffer binding has no offset.
+        // The other backends reject the offset as well, see the comment on multiDrawIndexedIndirect.
+        if (indexed && indexBufferOffset != 0)
         {
-            nClearBitField |= GL_DEPTH_BUFFER_BIT;
-            glClearDepthf(renderState.clearDepth);
+            SIGNAL_ERROR("Indirect indexed draws do not support a nonzero indexBufferOffset");
+            return;
         }
 
-        if (renderState.clearStencilTarget)
+        if (countBuffer && !m_bIndirectParametersSupported)
         {
-            nClearBitField |= GL_STENCIL_BUFFER_BIT;
-            glClearStencil(renderState.clearStencil);
+            SIGNAL_ERROR("Indirect draws with a count buffer require ARB_indirect_parameters");
+            return;
         }
 
-        if (nClearBitField)
+        if (maxDrawCount == 0)
+            return;
+
+        GLenum indexType = indexed ? convertIndexFormat(indexFormat) : GL_UNSIGNED_INT;
+
+        if (indexed && indexBuffer)
         {
-            glClear(nClearBitField);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer->bufferHandle);
         }
-    }
 
-    FrameBuffer* RendererInterfaceOGL::GetCachedFrameBuffer(const RenderState& renderState)
-    {
-        if (renderState.targetCount == 1 && renderState.targets[0] == m_DefaultBackBuffer && renderState.depthTarget == nullptr)
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, argsBuffer->bufferHandle);
+
+        const void* indirect = (const void*)size_t(argsOffsetBytes);
+
+        if (countBuffer)
         {
-            // Special case: back buffer rendering
-            return nullptr;
+            glBindBuffer(GL_PARAMETER_BUFFER_ARB, countBuffer->bufferHandle);
+
+            if (indexed)
+                glMultiDrawElementsIndirectCountARB(primType, indexType, indirect, countOffsetBytes, maxDrawCount, argsStrideBytes);
+            else
+                glMultiDrawArraysIndirectCountARB(primType, indirect, countOffsetBytes, maxDrawCount, argsStrideBytes);
+
+            glBindBuffer(GL_PARAMETER_BUFFER_ARB, GL_NONE);
+        }
+        else
+        {
+            if (indexed)
+                glMultiDrawElementsIndirect(primType, indexType, indirect, maxDrawCount, argsStrideBytes);
+            else
+                glMultiDrawArraysIndirect(primType, indirect, maxDrawCount, argsStrideBytes);
         }
+        CHECK_GL_ERROR();
+
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, GL_NONE);
 
-        CrcHash hasher;
-        for (uint32_t rt = 0; rt < renderState.targetCount; rt++)
+        if (indexed && indexBuffer)
         {
-            hasher.Add(renderState.targets[rt]);
-            hasher.Add(renderState.targetIndicies[rt]);
-            hasher.Add(renderState.targetMipSlices[rt]);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, GL_NONE);
         }
-        hasher.Add(renderState.depthTarget);
-        hasher.Add(renderState.depthIndex);
-        hasher.Add(renderState.depthMipSlice);
-        uint32_t hash = hasher.Get();
+    }
 
-        auto it = m_CachedFrameBuffers.find(hash);
-        if (it != m_CachedFrameBuffers.end())
-            return it->second;
+    void RendererInterfaceOGL::draw(const DrawCallState& state, const DrawArguments* args, uint32_t numDrawCalls)
+    {
+        DrawImpl(state, args, numDrawCalls);
+    }
 
-        FrameBuffer* framebuffer = new FrameBuffer();
+    void RendererInterfaceOGL::drawIndexed(const DrawCallState& state, const DrawArguments* args, uint32_t numDrawCalls)
+    {
+        DrawIndexedImpl(state, args, numDrawCalls);
+    }
 
-        glGenFramebuffers(1, &framebuffer->handle);
-        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer->handle);
+    void RendererInterfaceOGL::drawIndirect(const DrawCallState& state, BufferHandle indirectParams, uint32_t offsetBytes)
+    {
+        DrawIndirectImpl(state, indirectParams, offsetBytes);
+    }
 
-        for (uint32_t rt = 0; rt < renderState.targetCount; rt++)
-        {
-            if (renderState.targets[rt] == m_DefaultBackBuffer)
-            {
-                SIGNAL_ERROR("Cannot bind the default back buffer unless it's the only render target bound, no depth");
-            }
-            else if (renderState.targets[rt] != nullptr)
-            {
-                framebuffer->renderTargets[rt] = renderState.targets[rt];
-                framebuffer->renderTargets[rt]->usedInFrameBuffers = true;
+    void RendererInterfaceOGL::drawCompact(const CompactDrawCallState& state, const DrawArguments* args, uint32_t numDrawCalls)
+    {
+        DrawImpl(state, args, numDrawCalls);
+    }
 
-                if (renderState.targetIndicies[rt] == ~0u || renderState.targets[rt]->desc.depthOrArraySize == 0)
-                    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + rt, renderState.targets[rt]->bindTarget, renderState.targets[rt]->handle, renderState.targetMipSlices[rt]);
-                else
-                    glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + rt, renderState.targets[rt]->handle, renderState.targetMipSlices[rt], renderState.targetIndicies[rt]);
+    void RendererInterfaceOGL::drawIndexedCompact(const CompactDrawCallState& state, const DrawArguments* args, uint32_t numDrawCalls)
+    {
+        DrawIndexedImpl(state, args, numDrawCalls);
+    }
 
-                framebuffer->drawBuffers[(framebuffer->numBuffers)++] = GL_COLOR_ATTACHMENT0 + rt;
-            }
-        }
+    void RendererInterfaceOGL::drawIndirectCompact(const CompactDrawCallState& state, BufferHandle indirectParams, uint32_t offsetBytes)
+    {
+        DrawIndirectImpl(state, indirectParams, offsetBytes);
+    }
 
-        if (renderState.depthTarget)
-        {
-            framebuffer->depthTarget = renderState.depthTarget;
-            framebuffer->depthTarget->usedInFrameBuffers = true;
+    void RendererInterfaceOGL::drawIndexedIndirect(const DrawCallState& state, BufferHandle indirectParams, uint32_t offsetBytes)
+    {
+        MultiDrawIndirectImpl(state, true, indirectParams, offsetBytes, 0, 1, nullptr, 0);
+    }
 
-            GLenum attachment;
+    void RendererInterfaceOGL::multiDrawIndirect(const DrawCallState& state, BufferHandle argsBuffer, uint32_t argsOffsetBytes, uint32_t argsStrideBytes, uint32_t maxDrawCount, BufferHandle countBuffer, uint32_t countOffsetBytes)
+    {
+        MultiDrawIndirectImpl(state, false, argsBuffer, argsOffsetBytes, argsStrideBytes, maxDrawCount, countBuffer, countOffsetBytes);
+    }
 
-            if (renderState.depthTarget->desc.format == Format::D24S8)
-                attachment = GL_DEPTH_STENCIL_ATTACHMENT;
-            else
-                attachment = GL_DEPTH_ATTACHMENT;
+    void RendererInterfaceOGL::multiDrawIndexedIndirect(const DrawCallState& state, BufferHandle argsBuffer, uint32_t argsOffsetBytes, uint32_t argsStrideBytes, uint32_t maxDrawCount, BufferHandle countBuffer, uint32_t countOffsetBytes)
+    {
+        MultiDrawIndirectImpl(state, true, argsBuffer, argsOffsetBytes, argsStrideBytes, maxDrawCount, countBuffer, countOffsetBytes);
+    }
 
-            if (renderState.depthIndex == ~0u || renderState.depthTarget->desc.depthOrArraySize == 0)
-                glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, renderState.depthTarget->bindTarget, renderState.depthTarget->handle, renderState.depthMipSlice);
-            else
-                glFramebufferTextureLayer(GL_FRAMEBUFFER, attachment, renderState.depthTarget->handle, renderState.depthMipSlice, renderState.depthIndex);
-        }
+    void RendererInterfaceOGL::drawIndexedIndirectCompact(const CompactDrawCallState& state, BufferHandle indirectParams, uint32_t offsetBytes)
+    {
+        MultiDrawIndirectImpl(state, true, indirectParams, offsetBytes, 0, 1, nullptr, 0);
+    }
+
+    void RendererInterfaceOGL::multiDrawIndirectCompact(const CompactDrawCallState& state, BufferHandle argsBuffer, uint32_t argsOffsetBytes, uint32_t argsStrideBytes, uint32_t maxDrawCount, BufferHandle countBuffer, uint32_t countOffsetBytes)
+    {
+        MultiDrawIndirectImpl(state, false, argsBuffer, argsOffsetBytes, argsStrideBytes, maxDrawCount, countBuffer, countOffsetBytes);
+    }
+
+    void RendererInterfaceOGL::multiDrawIndexedIndirectCompact(const CompactDrawCallState& state, BufferHandle argsBuffer, uint32_t argsOffsetBytes, uint32_t argsStrideBytes, uint32_t maxDrawCount, BufferHandle countBuffer, uint32_t countOffsetBytes)
+    {
+        MultiDrawIndirectImpl(state, true, argsBuffer, argsOffsetBytes, argsStrideBytes, maxDrawCount, countBuffer, countOffsetBytes);
+    }
+
+    void RendererInterfaceOGL::dispatch(const NVRHI::DispatchState& state, uint32_t groupsX, uint32_t groupsY, uint32_t groupsZ)
+    {
+        ApplyState(state);
+
+        glDispatchCompute(groupsX, groupsY, groupsZ);
+
+        glMemoryBarrier(DispatchBarrierBits);
 
         CHECK_GL_ERROR();
+    }
 
-        uint32_t status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
-        if (status != GL_FRAMEBUFFER_COMPLETE)
-            SIGNAL_ERROR("Incomplete framebuffer!");
 
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
-        m_CachedFrameBuffers[hash] = framebuffer;
+    void RendererInterfaceOGL::dispatchIndirect(const DispatchState& state, BufferHandle indirectParams, uint32_t offsetBytes)
+    {
+        ApplyState(state);
 
-        return framebuffer;
+        glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, indirectParams->bufferHandle);
+
+        glDispatchComputeIndirect(offsetBytes);
+
+        CHECK_GL_ERROR();
+
+        glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, GL_NONE);
+
+        glMemoryBarrier(DispatchBarrierBits);
     }
 
 
-    void RendererInterfaceOGL::SetShaders(const DrawCallState& state)
+    void RendererInterfaceOGL::ApplyState(const DispatchState& state)
     {
-        glUseProgramStages(m_nGraphicsPipeline, GL_VERTEX_SHADER_BIT,           state.VS.shader ? state.VS.shader->handle : GL_NONE);
-        glUseProgramStages(m_nGraphicsPipeline, GL_TESS_CONTROL_SHADER_BIT,     state.HS.shader ? state.HS.shader->handle : GL_NONE);
-        glUseProgramStages(m_nGraphicsPipeline, GL_TESS_EVALUATION_SHADER_BIT,  state.DS.shader ? state.DS.shader->handle : GL_NONE);
-        glUseProgramStages(m_nGraphicsPipeline, GL_GEOMETRY_SHADER_BIT,         state.GS.shader ? state.GS.shader->handle : GL_NONE);
-        glUseProgramStages(m_nGraphicsPipeline, GL_FRAGMENT_SHADER_BIT,         state.PS.shader ? state.PS.shader->handle : GL_NONE);
-    
-        glBindProgramPipeline(m_nGraphicsPipeline);
+        const ShaderHandle shaders[ShaderType::GRAPHIC_SHADERS_NUM + 1] = { nullptr, nullptr, nullptr, nullptr, nullptr, state.shader };
+
+        BindProgramPipeline(GetCachedProgramPipeline(shaders)->handle);
+
+        BindStageResources(state);
+        FlushBindings();
     }
 
-    void RendererInterfaceOGL::BindShaderResources(const PipelineStageBindings& state)
+    bool RendererInterfaceOGL::ValidateGraphicsState(const GraphicsState& state)
     {
-        CHECK_GL_ERROR();
+        if (!state.pipeline)
+        {
+            SIGNAL_ERROR("No pipeline specified in GraphicsState");
+            return false;
+        }
 
-        // binding textures
-        for (uint32_t nBinding = 0; nBinding < state.textureBindingCount; ++nBinding)
+        const GraphicsPipelineDesc& desc = state.pipeline->desc;
+
+        if (state.bindings)
         {
-            const TextureBinding& binding = state.textures[nBinding];
+            const ShaderHandle pipelineShaders[ShaderType::GRAPHIC_SHADERS_NUM] = { desc.VS, desc.HS, desc.DS, desc.GS, desc.PS };
 
-            if (binding.texture == m_DefaultBackBuffer)
-            {
-                SIGNAL_ERROR("Cannot bind the default back buffer as a texture or image");
-            }
-            else if (binding.texture)
+            for (uint32_t stage = 0; stage < ShaderType::GRAPHIC_SHADERS_NUM; stage++)
             {
-                if (binding.isWritable)
+                ShaderHandle shader = state.bindings->graphicsShaders[stage];
+
+                if (shader && shader != pipelineShaders[stage])
                 {
-                    GLenum format = binding.texture->formatMapping.internalFormat;
-                    if (binding.format != Format::UNKNOWN)
-                        format = GetFormatMapping(binding.format).internalFormat;
+                    SIGNAL_ERROR("Binding set was created for a different shader than the one used by the pipeline");
+                    return false;
+                }
+            }
+        }
+
+        if (state.targetCount != desc.renderTargetCount)
+        {
+            SIGNAL_ERROR_FMT("Pipeline expects %d render targets, but %d are bound", desc.renderTargetCount, state.targetCount);
+            return false;
+        }
 
-                    glBindImageTexture(binding.slot, binding.texture->handle, binding.mipLevel, GL_TRUE, 0, GL_READ_WRITE, format);
-                    CHECK_GL_ERROR();
+        return true;
+    }
 
-                    m_vecBoundImages.push_back(binding.slot);
-                }
-                else
-                {
-                    glActiveTexture(GL_TEXTURE0 + binding.slot);
+    bool RendererInterfaceOGL::ValidateComputeState(const ComputeState& state)
+    {
+        if (!state.pipeline)
+        {
+            SIGNAL_ERROR("No pipeline specified in ComputeState");
+            return false;
+        }
 
-                    if(binding.texture->formatMapping.abstractFormat == Format::SRGBA8_UNORM)
-                        glBindTexture(binding.texture->bindTarget, binding.texture->srgbView);
-                    else
-                        glBindTexture(binding.texture->bindTarget, binding.texture->handle);
+        if (state.bindings && state.bindings->computeShader && state.bindings->computeShader != state.pipeline->desc.CS)
+        {
+            SIGNAL_ERROR("Binding set was created for a different shader than the one used by the pipeline");
+            return false;
+        }
 
-                    CHECK_GL_ERROR();
+        return true;
+    }
 
-                    m_vecBoundTextures.push_back(std::make_pair(binding.slot, binding.texture->bindTarget));
-                }
-            }
+    void RendererInterfaceOGL::BindBindingList(const BindingList& list)
+    {
+        for (const auto& texture : list.textures)
+        {
+            TextureSlot slot = { texture.target, texture.handle };
+            RequestBinding(m_TextureBindings, texture.slot, slot);
         }
 
-        // binding samplers
-        for (uint32_t nSampler = 0; nSampler < state.textureSamplerBindingCount; ++nSampler)
+        for (const auto& image : list.images)
         {
-            const SamplerBinding& binding = state.textureSamplers[nSampler];
+            ImageSlot slot = { image.handle, image.level, image.format, image.defaultView };
+            RequestBinding(m_ImageBindings, image.slot, slot);
+        }
+
+        for (const auto& sampler : list.samplers)
+            RequestBinding(m_SamplerBindings, sampler.slot, uint32_t(sampler.handle));
+
+        for (const auto& cbuffer : list.constantBuffers)
+            RequestBinding(m_UniformBufferBindings, cbuffer.slot, GetConstantBufferSlot(cbuffer.buffer));
+
+        for (const auto& buffer : list.storageBuffers)
+            RequestBinding(m_StorageBufferBindings, buffer.slot, uint32_t(buffer.handle));
+
+        FlushBindings();
+    }
 
-            glBindSampler(binding.slot, binding.sampler->handle);
-            m_vecBoundSamplers.push_back(binding.slot);
+    template<typename T>
+    void RendererInterfaceOGL::RequestBinding(BindingTable<T>& table, uint32_t slot, const T& value)
+    {
+        if (slot >= table.bound.size())
+        {
+            SIGNAL_ERROR_FMT("Binding slot %d is out of range", slot);
+            return;
         }
 
-        // binding constant buffers
-        for (uint32_t i = 0; i < state.constantBufferBindingCount; i++)
+        table.pending[slot] = value;
+
+        if (value == table.bound[slot])
         {
-            const ConstantBufferBinding& binding = state.constantBuffers[i];
+            m_StateCallStatistics.skippedBindings++;
+            return;
+        }
+
+        table.dirtyBegin = __min(table.dirtyBegin, slot);
+        table.dirtyEnd = __max(table.dirtyEnd, slot + 1);
+    }
 
-            glBindBufferBase(GL_UNIFORM_BUFFER, binding.slot, binding.buffer->handle);
-            m_vecBoundConstantBuffers.push_back(binding.slot);
+    template<typename T>
+    void RendererInterfaceOGL::RequestUnbindAll(BindingTable<T>& table)
+    {
+        for (uint32_t slot = 0; slot < uint32_t(table.bound.size()); slot++)
+        {
+            if (!(table.bound[slot] == T()))
+                RequestBinding(table, slot, T());
         }
+    }
 
-        // binding ssbo`s
-        for (uint32_t nBuffer = 0; nBuffer < state.bufferBindingCount; ++nBuffer)
+    template<typename T>
+    void RendererInterfaceOGL::FlushBindingTable(BindingTable<T>& table, void (RendererInterfaceOGL::*bindRange)(uint32_t first, uint32_t count))
+    {
+        // Every run of changed slots goes to GL as one range, the unchanged slots in between are left alone
+        uint32_t slot = table.dirtyBegin;
+        while (slot < table.dirtyEnd)
         {
-            const BufferBinding& binding = state.buffers[nBuffer];
-
-            if (binding.isWritable || binding.buffer->desc.structStride > 0)
+            if (table.pending[slot] == table.bound[slot])
             {
-                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding.slot, binding.buffer->bufferHandle);
-                m_vecBoundBuffers.push_back(binding.slot);
-            }
-            else
-            {
-                glActiveTexture(GL_TEXTURE0 + binding.slot);
-                glBindTexture(GL_TEXTURE_BUFFER, binding.buffer->ssboHandle);
-                glActiveTexture(GL_TEXTURE0);
-                m_vecBoundTextures.push_back(std::make_pair(binding.slot, GL_TEXTURE_BUFFER));
+                slot++;
+                continue;
             }
+
+            uint32_t first = slot;
+            while (slot < table.dirtyEnd && !(table.pending[slot] == table.bound[slot]))
+                slot++;
+
+            (this->*bindRange)(first, slot - first);
+
+            for (uint32_t i = first; i < slot; i++)
+                table.bound[i] = table.pending[i];
         }
+
+        table.dirtyBegin = uint32_t(table.bound.size());
+        table.dirtyEnd = 0;
     }
 
-    void RendererInterfaceOGL::BindShaderResources(const DrawCallState& state)
+    void RendererInterfaceOGL::FlushBindings()
     {
-        BindShaderResources(state.VS);
-        BindShaderResources(state.HS);
-        BindShaderResources(state.DS);
-        BindShaderResources(state.GS);
-        BindShaderResources(state.PS);
-    }
+        FlushBindingTable(m_TextureBindings, &RendererInterfaceOGL::BindTextureRange);
+        FlushBindingTable(m_ImageBindings, &RendererInterfaceOGL::BindImageRange);
+        FlushBindingTable(m_SamplerBindings, &RendererInterfaceOGL::BindSamplerRange);
+        FlushBindingTable(m_UniformBufferBindings, &RendererInterfaceOGL::BindUniformBufferRange);
+        FlushBindingTable(m_StorageBufferBindings, &RendererInterfaceOGL::BindStorageBufferRange);
 
+        CHECK_GL_ERROR();
+    }
 
-    void RendererInterfaceOGL::SetRasterState(const RasterState& rasterState)
+    void RendererInterfaceOGL::BindTextureRange(uint32_t first, uint32_t count)
     {
-        switch (rasterState.fillMode)
+        if (m_bMultiBindSupported)
         {
-        case RasterState::FILL_LINE:
-            glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-            break;
-        case RasterState::FILL_SOLID:
-            glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-            break;
+            m_MultiBindNames.resize(count);
+            for (uint32_t i = 0; i < count; i++)
+                m_MultiBindNames[i] = m_TextureBindings.pending[first + i].handle;
 
-        default:
-            SIGNAL_ERROR_FMT("Unknown fill mode specified %d", rasterState.fillMode);
-            break;
+            glBindTextures(first, count, m_MultiBindNames.data());
+            m_StateCallStatistics.emittedBindingCalls++;
+            return;
         }
 
-        switch (rasterState.cullMode)
+        for (uint32_t slot = first; slot < first + count; slot++)
         {
-        case RasterState::CULL_BACK:
-            glCullFace(GL_BACK);
-            glEnable(GL_CULL_FACE);
-            break;
-        case RasterState::CULL_FRONT:
-            glCullFace(GL_FRONT);
-            glEnable(GL_CULL_FACE);
-            break;
-        case RasterState::CULL_NONE:
-            glDisable(GL_CULL_FACE);
-            break;
-        default:
-            SIGNAL_ERROR_FMT("Unknown cullMode %d", rasterState.cullMode);
-        }
+            const TextureSlot& texture = m_TextureBindings.pending[slot];
 
-        glFrontFace(rasterState.frontCounterClockwise ? GL_CCW : GL_CW);
+            glActiveTexture(GL_TEXTURE0 + slot);
 
-        if (rasterState.depthClipEnable)
-        {
-            glEnable(GL_DEPTH_CLAMP);
+            // Unbinding needs the target that the previous texture was bound to
+            if (texture.handle)
+                glBindTexture(texture.target, texture.handle);
+            else
+                glBindTexture(m_TextureBindings.bound[slot].target, GL_NONE);
+
+            m_StateCallStatistics.emittedBindingCalls += 2;
         }
 
-        if (rasterState.scissorEnable)
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    void RendererInterfaceOGL::BindImageRange(uint32_t first, uint32_t count)
+    {
+        bool defaultViews = m_bMultiBindSupported;
+        for (uint32_t slot = first; slot < first + count && defaultViews; slot++)
         {
-            glEnable(GL_SCISSOR_TEST);
+            const ImageSlot& image = m_ImageBindings.pending[slot];
+            defaultViews = image.defaultView || !image.handle;
         }
-        else
+
+        if (defaultViews)
         {
-            glDisable(GL_SCISSOR_TEST);
+            m_MultiBindNames.resize(count);
+            for (uint32_t i = 0; i < count; i++)
+                m_MultiBindNames[i] = m_ImageBindings.pending[first + i].handle;
+
+            glBindImageTextures(first, count, m_MultiBindNames.data());
+            m_StateCallStatistics.emittedBindingCalls++;
+            return;
         }
 
-        if (rasterState.depthBias != 0 || rasterState.slopeScaledDepthBias != 0.f)
+        for (uint32_t slot = first; slot < first + count; slot++)
         {
-            glEnable(GL_POLYGON_OFFSET_FILL);
-            glPolygonOffset(rasterState.slopeScaledDepthBias, float(rasterState.depthBias));
+            const ImageSlot& image = m_ImageBindings.pending[slot];
+
+            if (image.handle)
+                glBindImageTexture(slot, image.handle, image.level, GL_TRUE, 0, GL_READ_WRITE, image.format);
+            else
+                glBindImageTexture(slot, GL_NONE, 0, GL_FALSE, 0, GL_READ_ONLY, GL_R32UI);
+
+            m_StateCallStatistics.emittedBindingCalls++;
         }
+    }
 
-        if (rasterState.multisampleEnable)
+    void RendererInterfaceOGL::BindSamplerRange(uint32_t first, uint32_t count)
+    {
+        if (m_bMultiBindSupported)
         {
-            glEnable(GL_MULTISAMPLE);
-            glSampleMaski(0, ~0u);
-            CHECK_GL_ERROR();
+            glBindSamplers(first, count, &m_SamplerBindings.pending[first]);
+            m_StateCallStatistics.emittedBindingCalls++;
+            return;
         }
-        else
+
+        for (uint32_t slot = first; slot < first + count; slot++)
         {
-            glDisable(GL_MULTISAMPLE);
+            glBindSampler(slot, m_SamplerBindings.pending[slot]);
+            m_StateCallStatistics.emittedBindingCalls++;
         }
+    }
 
-        if (rasterState.antialiasedLineEnable)
+    void RendererInterfaceOGL::BindUniformBufferRange(uint32_t first, uint32_t count)
+    {
+        // Some drivers validate the sizes of the unbound entries too, so a range that mixes both is bound one slot at a time
+        bool anyBuffer = false;
+        bool allBuffers = true;
+        for (uint32_t slot = first; slot < first + count; slot++)
         {
-            SIGNAL_ERROR("Antialiased line rasterizer state requested");
+            bool bound = m_UniformBufferBindings.pending[slot].handle != 0;
+            anyBuffer = anyBuffer || bound;
+            allBuffers = allBuffers && bound;
         }
 
-        if (rasterState.conservativeRasterEnable)
+        if (m_bMultiBindSupported && !anyBuffer)
         {
-            glEnable(GL_CONSERVATIVE_RASTERIZATION_NV);
-            m_bConservativeRasterEnabled = true;
-            CHECK_GL_ERROR();
+            glBindBuffersBase(GL_UNIFORM_BUFFER, first, count, nullptr);
+            m_StateCallStatistics.emittedBindingCalls++;
+            return;
         }
 
-        if (rasterState.forcedSampleCount)
+        if (m_bMultiBindSupported && allBuffers)
         {
-            if (glRasterSamplesEXT)
-            {
-                glEnable(GL_RASTER_MULTISAMPLE_EXT);
-                glRasterSamplesEXT(rasterState.forcedSampleCount, TRUE);
-                m_bForcedSampleCountEnabled = true;
-                CHECK_GL_ERROR();
-            }
-            else
+            m_MultiBindNames.resize(count);
+            m_MultiBindOffsets.resize(count);
+            m_MultiBindSizes.resize(count);
+            for (uint32_t i = 0; i < count; i++)
             {
-                SIGNAL_ERROR("Trying to use forcedSampleCount but glRasterSamplesEXT function is NULL");
+                const BufferRangeSlot& buffer = m_UniformBufferBindings.pending[first + i];
+                m_MultiBindNames[i] = buffer.handle;
+                m_MultiBindOffsets[i] = buffer.offset;
+                m_MultiBindSizes[i] = buffer.size;
             }
+
+            glBindBuffersRange(GL_UNIFORM_BUFFER, first, count, m_MultiBindNames.data(), m_MultiBindOffsets.data(), m_MultiBindSizes.data());
+            m_StateCallStatistics.emittedBindingCalls++;
+            return;
         }
 
-        if (rasterState.programmableSamplePositionsEnable)
+        for (uint32_t slot = first; slot < first + count; slot++)
         {
-            if (glFramebufferSampleLocationsfvNV)
-            {
-                float locations[32];
-                for (int pt = 0; pt < 16; pt++)
-                {
-                    locations[pt * 2 + 0] = float(rasterState.samplePositionsX[pt]) / 16.0f;
-                    locations[pt * 2 + 1] = float(rasterState.samplePositionsY[pt]) / 16.0f;
-                }
+            const BufferRangeSlot& buffer = m_UniformBufferBindings.pending[slot];
 
-                glFramebufferSampleLocationsfvNV(GL_FRAMEBUFFER, 0, rasterState.forcedSampleCount, locations);
-                glFramebufferParameteri(GL_FRAMEBUFFER, GL_FRAMEBUFFER_PROGRAMMABLE_SAMPLE_LOCATIONS_NV, 1);
-                CHECK_GL_ERROR();
-            }
+            if (buffer.handle)
+                glBindBufferRange(GL_UNIFORM_BUFFER, slot, buffer.handle, buffer.offset, buffer.size);
             else
-            {
-                SIGNAL_ERROR("Trying to use programmableSamplePositions but glFramebufferSampleLocationsfvNV function is NULL");
-            }
+                glBindBufferBase(GL_UNIFORM_BUFFER, slot, GL_NONE);
+
+            m_StateCallStatistics.emittedBindingCalls++;
         }
     }
 
+    void RendererInterfaceOGL::BindStorageBufferRange(uint32_t first, uint32_t count)
+    {
+        BindBufferRange(GL_SHADER_STORAGE_BUFFER, m_StorageBufferBindings, first, count);
+    }
 
-
-    void RendererInterfaceOGL::SetBlendState(const BlendState& blendState, uint32_t targetCount)
+    void RendererInterfaceOGL::BindBufferRange(uint32_t target, BindingTable<uint32_t>& table, uint32_t first, uint32_t count)
     {
-        if (blendState.alphaToCoverage)
+        if (m_bMultiBindSupported)
         {
-            glEnable(GL_SAMPLE_ALPHA_TO_COVERAGE);
+            glBindBuffersBase(target, first, count, &table.pending[first]);
+            m_StateCallStatistics.emittedBindingCalls++;
+            return;
         }
 
-        for (uint32_t i = 0; i < targetCount; ++i)
+        for (uint32_t slot = first; slot < first + count; slot++)
         {
-            if (blendState.blendEnable[i])
-                glEnablei(GL_BLEND, i);
-
-            uint32_t BlendOpRGB = convertBlendOp(blendState.blendOp[i]);
-            uint32_t BlendOpAlpha = convertBlendOp(blendState.blendOpAlpha[i]);
-            glBlendEquationSeparatei(i, BlendOpRGB, BlendOpAlpha);
-
-            uint32_t SrcBlendRGB = convertBlendValue(blendState.srcBlend[i]);
-            uint32_t DstBlendRGB = convertBlendValue(blendState.destBlend[i]);
-            uint32_t SrcBlendAlpha = convertBlendValue(blendState.srcBlendAlpha[i]);
-            uint32_t DstBlendAlpha = convertBlendValue(blendState.destBlendAlpha[i]);
-            glBlendFuncSeparatei(i, SrcBlendRGB, DstBlendRGB, SrcBlendAlpha, DstBlendAlpha);
-
-            glColorMaski(i,
-                (blendState.colorWriteEnable[i] & BlendState::COLOR_MASK_RED) != 0,
-                (blendState.colorWriteEnable[i] & BlendState::COLOR_MASK_GREEN) != 0,
-                (blendState.colorWriteEnable[i] & BlendState::COLOR_MASK_BLUE) != 0,
-                (blendState.colorWriteEnable[i] & BlendState::COLOR_MASK_ALPHA) != 0);
+            glBindBufferBase(target, slot, table.pending[slot]);
+            m_StateCallStatistics.emittedBindingCalls++;
         }
     }
 
-
-    void RendererInterfaceOGL::SetDepthStencilState(const DepthStencilState& depthState)
+    void RendererInterfaceOGL::TrackTextureUnitZero(uint32_t target, uint32_t handle)
     {
-        if (depthState.depthEnable)
+        // Resource creation binds textures to unit 0, the active one outside of BindTextureRange
+        TextureSlot& slot = m_TextureBindings.bound[0];
+
+        if (slot.target == target || !slot.handle)
         {
-            glEnable(GL_DEPTH_TEST);
-            glDepthMask((depthState.depthWriteMask == DepthStencilState::DEPTH_WRITE_MASK_ALL) ? GL_TRUE : GL_FALSE);
-            glDepthFunc(convertComparisonFunc(depthState.depthFunc));
+            slot.target = handle ? target : 0;
+            slot.handle = handle;
+            m_TextureBindings.pending[0] = slot;
         }
-        else
+    }
+
+    void RendererInterfaceOGL::ForgetTextureName(uint32_t handle)
+    {
+        // GL unbinds deleted objects from the units, and the name can be reused for a new object
+        if (!handle)
+            return;
+
+        for (uint32_t slot = 0; slot < uint32_t(m_TextureBindings.bound.size()); slot++)
         {
-            glDisable(GL_DEPTH_TEST);
+            if (m_TextureBindings.bound[slot].handle == handle)
+                m_TextureBindings.bound[slot] = m_TextureBindings.pending[slot] = TextureSlot();
         }
 
-        if (depthState.stencilEnable)
+        for (uint32_t slot = 0; slot < uint32_t(m_ImageBindings.bound.size()); slot++)
         {
-            glEnable(GL_STENCIL_TEST);
+            if (m_ImageBindings.bound[slot].handle == handle)
+                m_ImageBindings.bound[slot] = m_ImageBindings.pending[slot] = ImageSlot();
+        }
+    }
 
-            glStencilFuncSeparate(GL_FRONT, convertComparisonFunc(depthState.frontFace.stencilFunc), depthState.stencilRefValue, depthState.stencilReadMask);
-            glStencilOpSeparate(GL_FRONT, convertStencilOp(depthState.frontFace.stencilFailOp),
-                convertStencilOp(depthState.frontFace.stencilDepthFailOp),
-                convertStencilOp(depthState.frontFace.stencilPassOp));
+    void RendererInterfaceOGL::ForgetBufferName(uint32_t handle)
+    {
+        if (!handle)
+            return;
 
-            glStencilFuncSeparate(GL_BACK, convertComparisonFunc(depthState.backFace.stencilFunc), depthState.stencilRefValue, depthState.stencilReadMask);
-            glStencilOpSeparate(GL_BACK, convertStencilOp(depthState.backFace.stencilFailOp),
-                convertStencilOp(depthState.backFace.stencilDepthFailOp),
-                convertStencilOp(depthState.backFace.stencilPassOp));
+        for (uint32_t slot = 0; slot < uint32_t(m_UniformBufferBindings.bound.size()); slot++)
+        {
+            if (m_UniformBufferBindings.bound[slot].handle == handle)
+                m_UniformBufferBindings.bound[slot] = m_UniformBufferBindings.pending[slot] = BufferRangeSlot();
+        }
 
-            glStencilMask(depthState.stencilWriteMask);
+        for (uint32_t slot = 0; slot < uint32_t(m_StorageBufferBindings.bound.size()); slot++)
+        {
+            if (m_StorageBufferBindings.bound[slot] == handle)
+                m_StorageBufferBindings.bound[slot] = m_StorageBufferBindings.pending[slot] = 0;
         }
-        else
+
+        // VAOs that are not bound keep using a deleted buffer until something else is attached
+        for (InputLayoutHandle layout : m_InputLayouts)
         {
-            glDisable(GL_STENCIL_TEST);
+            for (uint32_t slot : layout->bufferSlots)
+            {
+                if (layout->boundBuffers[slot].buffer == handle)
+                {
+                    glVertexArrayVertexBuffer(layout->vao, slot, GL_NONE, 0, 0);
+                    memset(&layout->boundBuffers[slot], 0, sizeof(VertexBufferSlot));
+                }
+            }
         }
     }
 
+    void RendererInterfaceOGL::ForgetSamplerName(uint32_t handle)
+    {
+        if (!handle)
+            return;
 
+        for (uint32_t slot = 0; slot < uint32_t(m_SamplerBindings.bound.size()); slot++)
+        {
+            if (m_SamplerBindings.bound[slot] == handle)
+                m_SamplerBindings.bound[slot] = m_SamplerBindings.pending[slot] = 0;
+        }
+    }
 
-    void RendererInterfaceOGL::draw(const DrawCallState& state, const DrawArguments* args, uint32_t numDrawCalls)
+    void RendererInterfaceOGL::ApplyState(const GraphicsState& state)
     {
-        ApplyState(state);
+        CHECK_GL_ERROR();
 
-        uint32_t nPrimType = convertPrimType(state.primType);
+        const GraphicsPipelineDesc& desc = state.pipeline->desc;
 
-        for (uint32_t n = 0; n < numDrawCalls; n++)
-        {
-            glDrawArraysInstanced(nPrimType, args[n].startVertexLocation, args[n].vertexCount, args[n].instanceCount);
-            CHECK_GL_ERROR();
-        }
+        SetVertexAttributes(desc.inputLayout, state.vertexBuffers, state.vertexBufferCount);
 
-        RestoreDefaultState();
+        BindProgramPipeline(state.pipeline->programPipeline);
 
-        CHECK_GL_ERROR();
+        if (state.bindings)
+            BindBindingList(state.bindings->graphicsBindings);
+
+        FrameBuffer* framebuffer = GetCachedFrameBuffer(state.targetCount, state.targets, state.targetIndicies, state.targetMipSlices,
+            state.depthTarget, state.depthIndex, state.depthMipSlice);
+
+        BindFrameBuffer(framebuffer);
+        SetViewports(state.viewportCount, state.viewports, state.scissorRects);
+
+        SetRasterState(desc.rasterState); // requires a bound framebuffer for programmable sample positions
+        SetBlendState(desc.blendState, state.targetCount);
+        SetDepthStencilState(desc.depthStencilState);
     }
 
-    void RendererInterfaceOGL::drawIndexed(const DrawCallState& state, const DrawArguments* args, uint32_t numDrawCalls)
+    void RendererInterfaceOGL::ApplyState(const ComputeState& state)
+    {
+        BindProgramPipeline(state.pipeline->programPipeline);
+
+        if (state.bindings)
+            BindBindingList(state.bindings->computeBindings);
+    }
+
+    void RendererInterfaceOGL::drawWithPipeline(const GraphicsState& state, const DrawArguments* args, uint32_t numDrawCalls)
     {
+        if (!ValidateGraphicsState(state))
+            return;
+
         ApplyState(state);
 
-        if (state.indexBuffer)
-        {
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, state.indexBuffer->bufferHandle);
-        }
+        IssueDraws(state.pipeline->primType, args, numDrawCalls);
 
-        uint32_t nPrimType = convertPrimType(state.primType);
+        CHECK_GL_ERROR();
+    }
 
-        for (uint32_t n = 0; n < numDrawCalls; n++)
-        {
-            uint32_t indexOffset = args[n].startIndexLocation * 4 + state.indexBufferOffset;
-            glDrawElementsBaseVertex(nPrimType, args[n].vertexCount, GL_UNSIGNED_INT, (const void*)size_t(indexOffset), args[n].startVertexLocation);
-            CHECK_GL_ERROR();
-        }
+    void RendererInterfaceOGL::drawIndexedWithPipeline(const GraphicsState& state, const DrawArguments* args, uint32_t numDrawCalls)
+    {
+        if (!ValidateGraphicsState(state))
+            return;
 
-        RestoreDefaultState();
+        ApplyState(state);
 
-        if (state.indexBuffer)
-        {
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, GL_NONE);
-        }
+        IssueIndexedDraws(state.pipeline->primType, state.indexBuffer, state.indexBufferFormat, state.indexBufferOffset, args, numDrawCalls);
 
         CHECK_GL_ERROR();
     }
 
-    void RendererInterfaceOGL::drawIndirect(const DrawCallState& state, BufferHandle indirectParams, uint32_t offsetBytes)
+    void RendererInterfaceOGL::drawIndirectWithPipeline(const GraphicsState& state, BufferHandle indirectParams, uint32_t offsetBytes)
     {
+        if (!ValidateGraphicsState(state))
+            return;
+
         ApplyState(state);
 
         glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectParams->bufferHandle);
 
-        uint32_t nPrimType = convertPrimType(state.primType);
-        glDrawArraysIndirect(nPrimType, (const void*)size_t(offsetBytes));
+        glDrawArraysIndirect(state.pipeline->primType, (const void*)size_t(offsetBytes));
         CHECK_GL_ERROR();
 
         glBindBuffer(GL_DRAW_INDIRECT_BUFFER, GL_NONE);
+    }
 
-        RestoreDefaultState();
+    void RendererInterfaceOGL::drawIndexedIndirectWithPipeline(const GraphicsState& state, BufferHandle indirectParams, uint32_t offsetBytes)
+    {
+        multiDrawIndexedIndirectWithPipeline(state, indirectParams, offsetBytes, 0, 1, nullptr, 0);
     }
 
-    void RendererInterfaceOGL::dispatch(const NVRHI::DispatchState& state, uint32_t groupsX, uint32_t groupsY, uint32_t groupsZ)
+    void RendererInterfaceOGL::multiDrawIndirectWithPipeline(const GraphicsState& state, BufferHandle argsBuffer, uint32_t argsOffsetBytes, uint32_t argsStrideBytes, uint32_t maxDrawCount, BufferHandle countBuffer, uint32_t countOffsetBytes)
     {
+        if (!ValidateGraphicsState(state))
+            return;
+
         ApplyState(state);
 
-        glDispatchCompute(groupsX, groupsY, groupsZ);
+        IssueMultiDrawIndirect(state.pipeline->primType, false, nullptr, Format::R32_UINT, 0, argsBuffer, argsOffsetBytes, argsStrideBytes, maxDrawCount, countBuffer, countOffsetBytes);
+    }
 
-        // TODO:
-        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+    void RendererInterfaceOGL::multiDrawIndexedIndirectWithPipeline(const GraphicsState& state, BufferHandle argsBuffer, uint32_t argsOffsetBytes, uint32_t argsStrideBytes, uint32_t maxDrawCount, BufferHandle countBuffer, uint32_t countOffsetBytes)
+    {
+        if (!ValidateGraphicsState(state))
+            return;
 
-        CHECK_GL_ERROR();
+        ApplyState(state);
 
-        RestoreDefaultState();
+        IssueMultiDrawIndirect(state.pipeline->primType, true, state.indexBuffer, state.indexBufferFormat, state.indexBufferOffset, argsBuffer, argsOffsetBytes, argsStrideBytes, maxDrawCount, countBuffer, countOffsetBytes);
     }
 
+    void RendererInterfaceOGL::dispatchWithPipeline(const ComputeState& state, uint32_t groupsX, uint32_t groupsY, uint32_t groupsZ)
+    {
+        if (!ValidateComputeState(state))
+            return;
+
+        ApplyState(state);
+
+        glDispatchCompute(groupsX, groupsY, groupsZ);
 
+        glMemoryBarrier(DispatchBarrierBits);
 
-    void RendererInterfaceOGL::dispatchIndirect(const DispatchState& state, BufferHandle indirectParams, uint32_t offsetBytes)
+        CHECK_GL_ERROR();
+    }
+
+    void RendererInterfaceOGL::dispatchIndirectWithPipeline(const ComputeState& state, BufferHandle indirectParams, uint32_t offsetBytes)
     {
+        if (!ValidateComputeState(state))
+            return;
+
         ApplyState(state);
 
         glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, indirectParams->bufferHandle);
@@ -1513,22 +4516,15 @@ namespace NVRHI
 
         glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, GL_NONE);
 
-        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
-
-        RestoreDefaultState();
-    }
-
-
-    void RendererInterfaceOGL::ApplyState(const DispatchState& state)
-    {
-        glUseProgramStages(m_nComputePipeline, GL_COMPUTE_SHADER_BIT, state.shader->handle);
-        glBindProgramPipeline(m_nComputePipeline);
-
-        BindShaderResources(state);
+        glMemoryBarrier(DispatchBarrierBits);
     }
 
     void RendererInterfaceOGL::checkGLError(const char* file, int line)
     {
+        // The debug output callback has already reported the error
+        if (m_bDebugOutputEnabled)
+            return;
+
         GLint error = glGetError();
 
         if (error)
@@ -1570,81 +4566,59 @@ namespace NVRHI
     void RendererInterfaceOGL::executeRenderThreadCommand(IRenderThreadCommand* onCommand)
     {
         //we have a simple implementation
+        RestoreDefaultState();
         onCommand->executeAndDispose();
+        InvalidateState();
     }
 
-
-    void RendererInterfaceOGL::RestoreDefaultState()
+    CommandListHandle RendererInterfaceOGL::createCommandList()
     {
-        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-        glCullFace(GL_BACK);
-        glFrontFace(GL_CW);
-        glDisable(GL_CULL_FACE);
-        glDisable(GL_SCISSOR_TEST);
-        glDisable(GL_SAMPLE_ALPHA_TO_COVERAGE);
-        glDisable(GL_POLYGON_OFFSET_FILL);
-
-        glDisable(GL_BLEND);
-
-        glDisable(GL_DEPTH_TEST);
-        glDisable(GL_DEPTH_CLAMP);
-
-
-        // restoring stencil values
-        glDisable(GL_STENCIL_TEST);
-        glStencilFuncSeparate(GL_FRONT, GL_ALWAYS, 0, (uint32_t)-1);
-        glStencilFuncSeparate(GL_BACK, GL_ALWAYS, 0, (uint32_t)-1);
-        glStencilOpSeparate(GL_FRONT, GL_KEEP, GL_KEEP, GL_KEEP);
-        glStencilOpSeparate(GL_BACK, GL_KEEP, GL_KEEP, GL_KEEP);
-        glStencilMask((uint32_t)-1);
-
-        // unbinding shader resources
+        return new DeferredCommandList();
+    }
 
-        // samplers
-        for (uint32_t nSampler = 0; nSampler < m_vecBoundSamplers.size(); ++nSampler)
-        {
-            glBindSampler(m_vecBoundSamplers[nSampler], GL_NONE);
-        }
-        m_vecBoundSamplers.resize(0);
+    void RendererInterfaceOGL::destroyCommandList(CommandListHandle commandList)
+    {
+        delete static_cast<DeferredCommandList*>(commandList);
+    }
 
-        // Textures
-        for (uint32_t nTexture = 0; nTexture < m_vecBoundTextures.size(); ++nTexture)
+    void RendererInterfaceOGL::executeCommandLists(const CommandListHandle* commandLists, uint32_t numCommandLists)
+    {
+        for (uint32_t i = 0; i < numCommandLists; i++)
         {
-            glActiveTexture(GL_TEXTURE0 + m_vecBoundTextures[nTexture].first);
-            CHECK_GL_ERROR();
-
-            glBindTexture(m_vecBoundTextures[nTexture].second, GL_NONE);
-            CHECK_GL_ERROR();
+            if (commandLists[i])
+                static_cast<const DeferredCommandList*>(commandLists[i])->execute(this);
         }
+    }
 
-        glActiveTexture(GL_TEXTURE0);
-        m_vecBoundTextures.resize(0);
 
-        // images
-        for (uint32_t nImage = 0; nImage < m_vecBoundImages.size(); nImage++)
-        {
-            glBindImageTexture(m_vecBoundImages[nImage], GL_NONE, 0, GL_FALSE, 0, GL_READ_ONLY, GL_R32UI);
-            CHECK_GL_ERROR();
-        }
-        m_vecBoundImages.resize(0);
+    void RendererInterfaceOGL::RestoreDefaultState()
+    {
+        if (UpdateShadowState(m_FixedFunctionState.polygonMode, uint32_t(GL_FILL)))
+            glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+        if (UpdateShadowState(m_FixedFunctionState.cullFace, uint32_t(GL_BACK)))
+            glCullFace(GL_BACK);
+        if (UpdateShadowState(m_FixedFunctionState.frontFace, uint32_t(GL_CW)))
+            glFrontFace(GL_CW);
 
-        // constant buffers
-        for (uint32_t nCB = 0; nCB < m_vecBoundConstantBuffers.size(); nCB++)
-        {
-            glBindBufferBase(GL_UNIFORM_BUFFER, m_vecBoundConstantBuffers[nCB], GL_NONE);
-        }
-        m_vecBoundConstantBuffers.resize(0);
+        SetCapability(GL_CULL_FACE, m_FixedFunctionState.cullFaceEnable, false);
+        SetCapability(GL_SCISSOR_TEST, m_FixedFunctionState.scissorTestEnable, false);
+        SetCapability(GL_SAMPLE_ALPHA_TO_COVERAGE, m_FixedFunctionState.alphaToCoverageEnable, false);
+        SetCapability(GL_POLYGON_OFFSET_FILL, m_FixedFunctionState.polygonOffsetEnable, false);
 
-        // buffers
-        for (uint32_t nBuffer = 0; nBuffer < m_vecBoundBuffers.size(); nBuffer++)
-        {
-            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, m_vecBoundBuffers[nBuffer], GL_NONE);
-        }
-        m_vecBoundBuffers.resize(0);
+        const uint8_t blendDisabled[BlendState::MAX_MRT_BLEND_COUNT] = { };
+        if (UpdateShadowState(m_FixedFunctionState.blendEnable, blendDisabled))
+            glDisable(GL_BLEND);
 
-        glBindVertexArray(GL_NONE);
+        SetCapability(GL_DEPTH_TEST, m_FixedFunctionState.depthTestEnable, false);
+        SetCapability(GL_DEPTH_CLAMP, m_FixedFunctionState.depthClampEnable, false);
 
-        glBindProgramPipeline(GL_NONE);
+        // restoring stencil values
+        SetCapability(GL_STENCIL_TEST, m_FixedFunctionState.stencilTestEnable, false);
+        SetStencilFunc(GL_FRONT, GL_ALWAYS, 0, (uint32_t)-1);
+        SetStencilFunc(GL_BACK, GL_ALWAYS, 0, (uint32_t)-1);
+        SetStencilOp(GL_FRONT, GL_KEEP, GL_KEEP, GL_KEEP);
+        SetStencilOp(GL_BACK, GL_KEEP, GL_KEEP, GL_KEEP);
+        SetStencilWriteMask((uint32_t)-1);
 
         if (m_bConservativeRasterEnabled)
         {
@@ -1657,6 +4631,51 @@ namespace NVRHI
             glDisable(GL_RASTER_MULTISAMPLE_EXT);
             m_bForcedSampleCountEnabled = false;
         }
+
+        UnbindShaderResources();
+    }
+
+    void RendererInterfaceOGL::InvalidateState()
+    {
+        memset(&m_FixedFunctionState, 0xFF, sizeof(m_FixedFunctionState));
+        m_bCurrentViewportsValid = false;
+        m_nCurrentVAO = ~0u;
+        m_nCurrentProgramPipeline = ~0u;
+
+        // The slots that had something bound get a name that no request matches, so they are bound again when used.
+        // The other slots are left to the application, like they were before.
+        for (auto& texture : m_TextureBindings.bound)
+            if (texture.handle) texture.handle = ~0u;
+        for (auto& image : m_ImageBindings.bound)
+            if (image.handle) image.handle = ~0u;
+        for (auto& sampler : m_SamplerBindings.bound)
+            if (sampler) sampler = ~0u;
+        for (auto& buffer : m_UniformBufferBindings.bound)
+            if (buffer.handle) buffer.handle = ~0u;
+        for (auto& buffer : m_StorageBufferBindings.bound)
+            if (buffer) buffer = ~0u;
+
+        m_TextureBindings.pending = m_TextureBindings.bound;
+        m_ImageBindings.pending = m_ImageBindings.bound;
+        m_SamplerBindings.pending = m_SamplerBindings.bound;
+        m_UniformBufferBindings.pending = m_UniformBufferBindings.bound;
+        m_StorageBufferBindings.pending = m_StorageBufferBindings.bound;
+    }
+
+    void RendererInterfaceOGL::UnbindShaderResources()
+    {
+        RequestUnbindAll(m_TextureBindings);
+        RequestUnbindAll(m_ImageBindings);
+        RequestUnbindAll(m_SamplerBindings);
+        RequestUnbindAll(m_UniformBufferBindings);
+        RequestUnbindAll(m_StorageBufferBindings);
+        FlushBindings();
+
+        glBindVertexArray(GL_NONE);
+        m_nCurrentVAO = 0;
+
+        glBindProgramPipeline(GL_NONE);
+        m_nCurrentProgramPipeline = 0;
     }
 
     void RendererInterfaceOGL::UnbindFrameBuffer()
@@ -1679,6 +4698,7 @@ namespace NVRHI
         TextureHandle t = new Texture();
 
         glBindTexture(target, texture);
+        TrackTextureUnitZero(target, texture);
 
         GLenum internalFormat = 0;
         glGetTexLevelParameteriv(target, 0, GL_TEXTURE_INTERNAL_FORMAT, (GLint*)&internalFormat);
@@ -1742,6 +4762,7 @@ namespace NVRHI
     {
         for (auto t : m_NonManagedTextures)
         {
+            ForgetTextureName(t->handle);
             t->handle = 0; // prevent glDeleteTextures call in ~Texture
             delete t;
         }
@@ -1819,6 +4840,22 @@ namespace NVRHI
     }
 
 
+    uint32_t RendererInterfaceOGL::convertIndexFormat(Format::Enum format)
+    {
+        switch (format)
+        {
+        case Format::R16_UINT:
+            return GL_UNSIGNED_SHORT;
+        case Format::R32_UINT:
+            return GL_UNSIGNED_INT;
+        default:
+            SIGNAL_ERROR_FMT("Unsupported index format %d", format);
+        }
+
+        return GL_UNSIGNED_INT;
+    }
+
+
     uint32_t RendererInterfaceOGL::convertWrapMode(SamplerDesc::WrapMode in_eMode)
     {
         switch (in_eMode)
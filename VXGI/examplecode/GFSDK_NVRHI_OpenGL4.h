@@ -11,13 +11,147 @@
 #pragma once
 
 #include <GFSDK_NVRHI.h>
+#include "GFSDK_NVRHI_Cache.h"
 
 #include <vector>
 #include <map>
+#include <deque>
+#include <list>
+#include <string>
+#include <unordered_set>
+#include <unordered_map>
+
+// Same declaration as in glext.h, so that the header does not depend on the GL headers
+typedef struct __GLsync *GLsync;
 
 namespace NVRHI
 {
     class FrameBuffer;
+    class ProgramPipeline;
+    class ProgramBinaryArchive;
+    struct BindingList;
+
+    // Attachments of a cached framebuffer object, unused color slots are zero
+    struct FrameBufferKey
+    {
+        TextureHandle           renderTargets[8];
+        uint32_t                renderTargetIndices[8];
+        uint32_t                renderTargetMipSlices[8];
+        TextureHandle           depthTarget;
+        uint32_t                depthIndex;
+        uint32_t                depthMipSlice;
+    };
+
+    // Shaders of a cached program pipeline, one per graphics stage and the compute shader
+    struct ProgramPipelineKey
+    {
+        ShaderHandle            shaders[ShaderType::GRAPHIC_SHADERS_NUM + 1];
+    };
+
+    // Last values of the fixed-function state that RendererInterfaceOGL has sent to GL, so that only the changes are emitted.
+    // InvalidateState fills it with 0xFF bytes, which are compared bitwise and never match a value that is being set.
+    struct FixedFunctionState
+    {
+        uint8_t                 cullFaceEnable;
+        uint8_t                 scissorTestEnable;
+        uint8_t                 depthClampEnable;
+        uint8_t                 polygonOffsetEnable;
+        uint8_t                 multisampleEnable;
+        uint8_t                 alphaToCoverageEnable;
+        uint8_t                 depthTestEnable;
+        uint8_t                 stencilTestEnable;
+        uint8_t                 depthMask;
+        uint32_t                polygonMode;
+        uint32_t                cullFace;
+        uint32_t                frontFace;
+        float                   polygonOffset[2];
+        uint32_t                sampleMask;
+        uint32_t                depthFunc;
+        uint32_t                stencilFunc[2][3];  // func, ref and read mask for the front and back faces
+        uint32_t                stencilOp[2][3];    // sfail, dpfail and dppass for the front and back faces
+        uint32_t                stencilWriteMask;
+        uint8_t                 blendEnable[BlendState::MAX_MRT_BLEND_COUNT];
+        uint32_t                blendEquation[BlendState::MAX_MRT_BLEND_COUNT][2];
+        uint32_t                blendFunc[BlendState::MAX_MRT_BLEND_COUNT][4];
+        uint8_t                 colorMask[BlendState::MAX_MRT_BLEND_COUNT];
+    };
+
+    // Number of fixed-function state changes and resource binding calls that were sent to GL,
+    // and the values that were skipped because GL already had them
+    struct StateCallStatistics
+    {
+        uint64_t                emittedCalls;
+        uint64_t                skippedCalls;
+        uint64_t                emittedBindingCalls;
+        uint64_t                skippedBindings;
+    };
+
+    // Extensions and implementation limits, queried once so that the backend never asks the driver for them while rendering
+    struct Capabilities
+    {
+        std::unordered_set<std::string> extensions;
+        uint32_t                uniformBufferOffsetAlignment;
+        uint32_t                maxUniformBlockSize;
+        uint32_t                maxVertexAttribs;
+        uint32_t                maxVertexAttribBindings;
+        uint32_t                maxViewports;
+
+        // The minimums that GL 4.3 guarantees, except the alignment, which is a common maximum
+        Capabilities()
+            : uniformBufferOffsetAlignment(256)
+            , maxUniformBlockSize(16384)
+            , maxVertexAttribs(16)
+            , maxVertexAttribBindings(16)
+            , maxViewports(16)
+        { }
+    };
+
+    struct TextureSlot
+    {
+        uint32_t                target;
+        uint32_t                handle;
+
+        bool operator==(const TextureSlot& other) const { return target == other.target && handle == other.handle; }
+    };
+
+    struct ImageSlot
+    {
+        uint32_t                handle;
+        int32_t                 level;
+        uint32_t                format;
+        bool                    defaultView;    // level 0 in the texture's own format, which is what glBindImageTextures binds
+
+        bool operator==(const ImageSlot& other) const { return handle == other.handle && level == other.level && format == other.format; }
+    };
+
+    // A buffer bound to an indexed binding point, either whole or as a range of the upload ring
+    struct BufferRangeSlot
+    {
+        uint32_t                handle;
+        uint32_t                offset;
+        uint32_t                size;
+
+        bool operator==(const BufferRangeSlot& other) const { return handle == other.handle && offset == other.offset && size == other.size; }
+    };
+
+    // Objects bound to the slots of one kind of indexed GL binding point, and the ones requested for the next draw or dispatch.
+    // The two only differ in [dirtyBegin, dirtyEnd).
+    template<typename T>
+    struct BindingTable
+    {
+        std::vector<T>          bound;
+        std::vector<T>          pending;
+        uint32_t                dirtyBegin;
+        uint32_t                dirtyEnd;
+
+        void reset(uint32_t size)
+        {
+            bound.assign(size, T());
+            pending.assign(size, T());
+            dirtyBegin = size;
+            dirtyEnd = 0;
+        }
+    };
 
     class RendererInterfaceOGL : public IRendererInterface
     {
@@ -36,12 +170,43 @@ namespace NVRHI
         TextureDesc             describeTexture(TextureHandle t) override;
         void                    clearTextureFloat(TextureHandle t, const Color& clearColor) override;
         void                    clearTextureUInt(TextureHandle t, uint32_t clearColor) override;
+        void                    clearTextureRegionFloat(TextureHandle t, const TextureRegion& region, const Color& clearColor) override;
+        void                    clearTextureRegionUInt(TextureHandle t, const TextureRegion& region, uint32_t clearColor) override;
+
+        FenceHandle             createFence() override;
+        void                    destroyFence(FenceHandle f) override;
+        void                    signalFence(FenceHandle f, uint64_t value) override;
+        uint64_t                getFenceCompletedValue(FenceHandle f) override;
+        void                    waitFence(FenceHandle f, uint64_t value) override;
+        void                    setMaxFramesInFlight(uint32_t maxFrames) override;
+        void                    beginFrame() override;
+        void                    endFrame() override;
+        FrameStatistics         getFrameStatistics() override;
+        void                    drawIndexedIndirect(const DrawCallState& state, BufferHandle indirectParams, uint32_t offsetBytes) override;
+        void                    multiDrawIndirect(const DrawCallState& state, BufferHandle argsBuffer, uint32_t argsOffsetBytes, uint32_t argsStrideBytes, uint32_t maxDrawCount, BufferHandle countBuffer, uint32_t countOffsetBytes) override;
+        void                    multiDrawIndexedIndirect(const DrawCallState& state, BufferHandle argsBuffer, uint32_t argsOffsetBytes, uint32_t argsStrideBytes, uint32_t maxDrawCount, BufferHandle countBuffer, uint32_t countOffsetBytes) override;
+        void                    drawIndexedIndirectWithPipeline(const GraphicsState& state, BufferHandle indirectParams, uint32_t offsetBytes) override;
+        void                    multiDrawIndirectWithPipeline(const GraphicsState& state, BufferHandle argsBuffer, uint32_t argsOffsetBytes, uint32_t argsStrideBytes, uint32_t maxDrawCount, BufferHandle countBuffer, uint32_t countOffsetBytes) override;
+        void                    multiDrawIndexedIndirectWithPipeline(const GraphicsState& state, BufferHandle argsBuffer, uint32_t argsOffsetBytes, uint32_t argsStrideBytes, uint32_t maxDrawCount, BufferHandle countBuffer, uint32_t countOffsetBytes) override;
+        void                    drawIndexedIndirectCompact(const CompactDrawCallState& state, BufferHandle indirectParams, uint32_t offsetBytes) override;
+        void                    multiDrawIndirectCompact(const CompactDrawCallState& state, BufferHandle argsBuffer, uint32_t argsOffsetBytes, uint32_t argsStrideBytes, uint32_t maxDrawCount, BufferHandle countBuffer, uint32_t countOffsetBytes) override;
+        void                    multiDrawIndexedIndirectCompact(const CompactDrawCallState& state, BufferHandle argsBuffer, uint32_t argsOffsetBytes, uint32_t argsStrideBytes, uint32_t maxDrawCount, BufferHandle countBuffer, uint32_t countOffsetBytes) override;
+        void                    setStateCacheLimits(uint32_t maxEntries, uint64_t maxBytes) override;
         void                    writeTexture(TextureHandle t, uint32_t subresource, const void* data, uint32_t rowPitch, uint32_t depthPitch) override;
+        void                    writeTextureRegion(TextureHandle t, const TextureRegion& region, const void* data, uint32_t rowPitch, uint32_t depthPitch) override;
+        void                    copyTexture(TextureHandle dest, const TextureRegion& destRegion, TextureHandle src, const TextureRegion& srcRegion) override;
+        void                    copyBufferToTexture(TextureHandle dest, const TextureRegion& destRegion, BufferHandle src, uint32_t srcOffsetBytes, uint32_t rowPitch, uint32_t depthPitch) override;
+        void                    copyTextureToBuffer(BufferHandle dest, uint32_t destOffsetBytes, uint32_t rowPitch, uint32_t depthPitch, TextureHandle src, const TextureRegion& srcRegion) override;
+        void                    resolveTexture(TextureHandle dest, uint32_t destMipLevel, uint32_t destArraySlice, TextureHandle src, uint32_t srcArraySlice) override;
         void                    destroyTexture(TextureHandle t) override;
 
         BufferHandle            createBuffer(const BufferDesc& d, const void* data) override;
         void                    writeBuffer(BufferHandle b, const void* data, size_t dataSize) override;
+        void                    writeBufferRange(BufferHandle b, uint32_t offsetBytes, const void* data, size_t dataSize) override;
+        void*                   mapBuffer(BufferHandle b, MapMode::Enum mode, uint32_t offsetBytes, size_t sizeBytes) override;
+        void                    unmapBuffer(BufferHandle b) override;
         void                    clearBufferUInt(BufferHandle b, uint32_t clearValue) override;
+        void                    clearBufferUIntRange(BufferHandle b, uint32_t offsetBytes, size_t sizeBytes, uint32_t clearValue) override;
         void                    copyToBuffer(BufferHandle dest, uint32_t destOffsetBytes, BufferHandle src, uint32_t srcOffsetBytes, size_t dataSizeBytes) override;
         void                    readBuffer(BufferHandle b, void* data, size_t* dataSize) override; // for debugging purposes only
         void                    destroyBuffer(BufferHandle b) override;
@@ -60,11 +225,11 @@ namespace NVRHI
         InputLayoutHandle       createInputLayout(const VertexAttributeDesc* d, uint32_t attributeCount, const void* vertexShaderBinary, const size_t binarySize) override;
         void                    destroyInputLayout(InputLayoutHandle i) override;
 
-        PerformanceQueryHandle  createPerformanceQuery(const char*) override { return nullptr; }
-        void                    destroyPerformanceQuery(PerformanceQueryHandle) override { }
-        void                    beginPerformanceQuery(PerformanceQueryHandle, bool) override { }
-        void                    endPerformanceQuery(PerformanceQueryHandle) override { }
-        float                   getPerformanceQueryTimeMS(PerformanceQueryHandle) override { return 0.f; }
+        PerformanceQueryHandle  createPerformanceQuery(const char* name) override;
+        void                    destroyPerformanceQuery(PerformanceQueryHandle query) override;
+        void                    beginPerformanceQuery(PerformanceQueryHandle query, bool onlyAnnotation) override;
+        void                    endPerformanceQuery(PerformanceQueryHandle query) override;
+        float                   getPerformanceQueryTimeMS(PerformanceQueryHandle query) override;
 
         GraphicsAPI::Enum       getGraphicsAPI() override { return GraphicsAPI::OPENGL4; };
 
@@ -82,59 +247,231 @@ namespace NVRHI
         void                    setEnableUavBarriersForTexture(TextureHandle, bool) override { }
         void                    setEnableUavBarriersForBuffer(BufferHandle, bool) override { }
 
+        GraphicsPipelineHandle  createGraphicsPipeline(const GraphicsPipelineDesc& d) override;
+        void                    destroyGraphicsPipeline(GraphicsPipelineHandle p) override;
+        ComputePipelineHandle   createComputePipeline(const ComputePipelineDesc& d) override;
+        void                    destroyComputePipeline(ComputePipelineHandle p) override;
+        BindingSetHandle        createBindingSet(const BindingSetDesc& d) override;
+        void                    destroyBindingSet(BindingSetHandle b) override;
+
+        void                    drawWithPipeline(const GraphicsState& state, const DrawArguments* args, uint32_t numDrawCalls) override;
+        void                    drawIndexedWithPipeline(const GraphicsState& state, const DrawArguments* args, uint32_t numDrawCalls) override;
+        void                    drawIndirectWithPipeline(const GraphicsState& state, BufferHandle indirectParams, uint32_t offsetBytes) override;
+        void                    dispatchWithPipeline(const ComputeState& state, uint32_t groupsX, uint32_t groupsY, uint32_t groupsZ) override;
+        void                    dispatchIndirectWithPipeline(const ComputeState& state, BufferHandle indirectParams, uint32_t offsetBytes) override;
+
+        void                    drawCompact(const CompactDrawCallState& state, const DrawArguments* args, uint32_t numDrawCalls) override;
+        void                    drawIndexedCompact(const CompactDrawCallState& state, const DrawArguments* args, uint32_t numDrawCalls) override;
+        void                    drawIndirectCompact(const CompactDrawCallState& state, BufferHandle indirectParams, uint32_t offsetBytes) override;
+
+        CommandListHandle       createCommandList() override;
+        void                    destroyCommandList(CommandListHandle commandList) override;
+        void                    executeCommandLists(const CommandListHandle* commandLists, uint32_t numCommandLists) override;
+
+        ReadbackHandle          beginBufferReadback(BufferHandle b, uint32_t offsetBytes, size_t sizeBytes) override;
+        ReadbackHandle          beginTextureReadback(TextureHandle t, const TextureRegion& region) override;
+        bool                    isReadbackReady(ReadbackHandle r) override;
+        const void*             mapReadback(ReadbackHandle r, uint32_t* rowPitch, uint32_t* depthPitch) override;
+        void                    releaseReadback(ReadbackHandle r) override;
+
+        using IRendererInterface::draw;
+        using IRendererInterface::drawIndexed;
+        using IRendererInterface::drawIndirect;
+        using IRendererInterface::drawIndexedIndirect;
+        using IRendererInterface::multiDrawIndirect;
+        using IRendererInterface::multiDrawIndexedIndirect;
+        using IRendererInterface::dispatch;
+        using IRendererInterface::dispatchIndirect;
+
         void                    ApplyState(const DrawCallState& state);
+        void                    ApplyState(const CompactDrawCallState& state);
+        // RestoreDefaultState hands GL over to the application with the default fixed-function state and no resources bound.
+        // InvalidateState must be called when the application has changed GL state and has not restored the defaults.
         void                    RestoreDefaultState();
+        void                    InvalidateState();
         void                    UnbindFrameBuffer();
+        StateCallStatistics     getStateCallStatistics() const { return m_StateCallStatistics; }
+        const Capabilities&     getCapabilities() const { return m_Capabilities; }
+        void                    resetStateCallStatistics() { m_StateCallStatistics = StateCallStatistics(); }
 
         TextureHandle           getHandleForDefaultBackBuffer() { return m_DefaultBackBuffer; }
         TextureHandle           getHandleForTexture(uint32_t target, uint32_t texture);
         uint32_t                getTextureOpenGLName(TextureHandle t);
         void                    releaseNonManagedTextures();
 
+        // Program binary archive: while it is open, createShader loads programs from the archive instead of compiling them,
+        // and keeps the binaries of the programs it compiles. saveProgramBinaryArchive writes them back to the file,
+        // optionally dropping the binaries that were not used since the archive was opened.
+        // openProgramBinaryArchive returns false if the driver cannot return program binaries; a missing or invalid file is not an error.
+        bool                    openProgramBinaryArchive(const char* fileName);
+        bool                    saveProgramBinaryArchive(bool discardUnused);
+        void                    closeProgramBinaryArchive();
+        CacheStatistics         getProgramBinaryArchiveStatistics() const;
+
     protected:
 
         IErrorCallback*         m_pErrorCallback;
 
-        uint32_t                m_nGraphicsPipeline;
-        uint32_t                m_nComputePipeline;
-        uint32_t                m_nVAO;
+        uint32_t                m_nCurrentProgramPipeline;
+        uint32_t                m_nVAO;             // used for draws without an input layout
+        uint32_t                m_nCurrentVAO;
+        uint32_t                m_nResolveFramebuffers[2];
+        bool                    m_bIndirectParametersSupported;
+        bool                    m_bCapabilitiesValid;
+        bool                    m_bDebugOutputEnabled;
+        bool                    m_bDebugGroupsSupported;
+        Capabilities            m_Capabilities;
 
         // state cache
-        std::vector<uint32_t>   m_vecBoundSamplers;
-        std::vector<uint32_t>   m_vecBoundConstantBuffers;
-        std::vector<uint32_t>   m_vecBoundBuffers;
-        std::vector<uint32_t>   m_vecBoundImages;
-        std::vector<std::pair<uint32_t, uint32_t> > m_vecBoundTextures;
+        BindingTable<TextureSlot> m_TextureBindings;
+        BindingTable<ImageSlot> m_ImageBindings;
+        BindingTable<uint32_t>  m_SamplerBindings;
+        BindingTable<BufferRangeSlot> m_UniformBufferBindings;
+        BindingTable<uint32_t>  m_StorageBufferBindings;
+        std::vector<uint32_t>   m_MultiBindNames;
+        std::vector<intptr_t>   m_MultiBindOffsets;
+        std::vector<intptr_t>   m_MultiBindSizes;
+        bool                    m_bMultiBindSupported;
         bool                    m_bConservativeRasterEnabled;
         bool                    m_bForcedSampleCountEnabled;
+        FixedFunctionState      m_FixedFunctionState;
+        StateCallStatistics     m_StateCallStatistics;
 
-        std::map<uint32_t, FrameBuffer*> m_CachedFrameBuffers;
+        BoundedCache<FrameBufferKey, FrameBuffer*> m_CachedFrameBuffers;
+        std::unordered_map<ProgramPipelineKey, ProgramPipeline*, BytewiseHash<ProgramPipelineKey>, BytewiseEqual<ProgramPipelineKey>> m_CachedProgramPipelines;
         std::vector<TextureHandle> m_NonManagedTextures;
+        std::vector<InputLayoutHandle> m_InputLayouts;
         TextureHandle           m_DefaultBackBuffer;
         FrameBuffer*            m_pCurrentFrameBuffer;
         NVRHI::Viewport         m_vCurrentViewports[16];
         NVRHI::Rect             m_vCurrentScissorRects[16];
         bool                    m_bCurrentViewportsValid;
 
-        FrameBuffer*            GetCachedFrameBuffer(const RenderState& state);
-
-        void                    BindVAO();
+        // All readback staging buffers, and the ones that are not used by an active readback
+        std::vector<Readback*>  m_Readbacks;
+        std::vector<Readback*>  m_FreeReadbacks;
+
+        // Scratch arrays for glMultiDrawArrays and glMultiDrawElementsBaseVertex, kept to avoid allocations per draw
+        std::vector<int32_t>    m_MultiDrawFirsts;
+        std::vector<int32_t>    m_MultiDrawCounts;
+        std::vector<int32_t>    m_MultiDrawBaseVertices;
+        std::vector<const void*> m_MultiDrawIndexOffsets;
+        uint64_t                m_ReadbackPeakBytes;
+
+        // Sync objects inserted at the end of the frames that the GPU may not have finished yet, oldest first
+        std::deque<GLsync>      m_FrameSyncs;
+        uint32_t                m_MaxFramesInFlight;
+        uint64_t                m_FrameIndex;
+
+        // Persistently mapped ring that constant buffer contents and buffer writes are copied into, when ARB_buffer_storage is available.
+        // Positions grow monotonically, the offset in the buffer is the position modulo the ring size.
+        // Everything before m_UploadRingTail has been retired, and m_UploadRingFences protect the regions up to m_UploadRingFenced.
+        // The tail doesn't move past the allocations that mapBuffer handed out until they are unmapped, oldest first in m_UploadRingMapped.
+        bool                    m_bBufferStorageSupported;
+        uint32_t                m_nUploadRing;
+        uint8_t*                m_pUploadRingData;
+        uint64_t                m_UploadRingSize;
+        uint64_t                m_UploadRingHead;
+        uint64_t                m_UploadRingTail;
+        uint64_t                m_UploadRingFenced;
+        uint64_t                m_UploadPeakBytes;
+        std::deque<std::pair<GLsync, uint64_t>> m_UploadRingFences;
+        std::list<uint64_t>     m_UploadRingMapped;
+
+        // GL_TIMESTAMP query pairs that no performance query is waiting on
+        std::vector<std::pair<uint32_t, uint32_t>> m_FreeTimerQueries;
+
+        ProgramBinaryArchive*   m_pProgramBinaryArchive;
+
+        FrameBuffer*            GetCachedFrameBuffer(uint32_t targetCount, const TextureHandle* targets, const uint32_t* targetIndicies, const uint32_t* targetMipSlices,
+                                    TextureHandle depthTarget, uint32_t depthIndex, uint32_t depthMipSlice);
+        void                    ReleaseFrameBuffers(const std::vector<FrameBuffer*>& framebuffers);
+
+        uint32_t                CreateRetrievableProgram(uint32_t programType, const char* source);
+        ProgramPipeline*        GetCachedProgramPipeline(const ShaderHandle* shaders);
+        void                    BindProgramPipeline(uint32_t programPipeline);
+
+        void                    TexSubImage(TextureHandle t, const TextureRegion& box, const void* pixels, uint32_t rowPitch, uint32_t depthPitch);
+        void                    UploadTextureData(TextureHandle t, const TextureRegion& box, const void* data, uint32_t rowPitch, uint32_t depthPitch);
+
+        Readback*               AllocateReadback(size_t size);
+        bool                    WaitForReadback(Readback* r, uint64_t timeout);
+        void                    ResolvePerformanceQuery(PerformanceQueryHandle query);
+        void                    UpdateFence(Fence* f, uint64_t waitValue);
+        void                    RetireCompletedFrames(uint32_t maxPendingFrames);
+        PoolStatistics          GetReadbackStatistics();
+
+        void                    CreateUploadRing(uint64_t size);
+        void*                   AllocateUploadSpace(uint64_t size, uint32_t alignment, uint64_t& ringOffset);
+        void                    FenceUploads();
+        void                    RetireUploads(uint64_t requiredTail);
+        void                    ReleaseMappedUploadSpace(uint64_t position);
+        uint64_t                GetUploadRingTailLimit() const { return m_UploadRingMapped.empty() ? ~0ull : m_UploadRingMapped.front(); }
+        void                    WriteBufferData(BufferHandle b, uint32_t offsetBytes, const void* data, size_t dataSize);
+        BufferRangeSlot         GetConstantBufferSlot(ConstantBufferHandle b);
+
+        void                    BindVAO(InputLayoutHandle inputLayout);
+        void                    SetVertexAttributes(InputLayoutHandle inputLayout, const VertexBufferBinding* vertexBuffers, uint32_t vertexBufferCount);
         void                    BindRenderTargets(const RenderState& renderState);
+        void                    BindFrameBuffer(FrameBuffer* framebuffer);
+        void                    SetViewports(uint32_t viewportCount, const Viewport* viewports, const Rect* scissorRects);
         void                    ClearRenderTargets(const RenderState& renderState);
         void                    SetRasterState(const RasterState& rasterState);
         void                    SetBlendState(const BlendState& blendState, uint32_t targetCount);
         void                    SetDepthStencilState(const DepthStencilState& depthState);
-        void                    SetShaders(const DrawCallState& state);
-        void                    BindShaderResources(const PipelineStageBindings& state);
-        void                    BindShaderResources(const DrawCallState& state);
+        void                    UnbindShaderResources();
+
+        template<typename T> void RequestBinding(BindingTable<T>& table, uint32_t slot, const T& value);
+        template<typename T> void RequestUnbindAll(BindingTable<T>& table);
+        template<typename T> void FlushBindingTable(BindingTable<T>& table, void (RendererInterfaceOGL::*bindRange)(uint32_t first, uint32_t count));
+        void                    FlushBindings();
+        void                    BindTextureRange(uint32_t first, uint32_t count);
+        void                    BindImageRange(uint32_t first, uint32_t count);
+        void                    BindSamplerRange(uint32_t first, uint32_t count);
+        void                    BindUniformBufferRange(uint32_t first, uint32_t count);
+        void                    BindStorageBufferRange(uint32_t first, uint32_t count);
+        void                    BindBufferRange(uint32_t target, BindingTable<uint32_t>& table, uint32_t first, uint32_t count);
+        void                    TrackTextureUnitZero(uint32_t target, uint32_t handle);
+        void                    ForgetTextureName(uint32_t handle);
+        void                    ForgetBufferName(uint32_t handle);
+        void                    ForgetSamplerName(uint32_t handle);
+
+        template<typename T> bool UpdateShadowState(T& shadow, const T& value);
+        void                    SetCapability(uint32_t cap, uint8_t& shadow, bool enable);
+        void                    SetStencilFunc(uint32_t face, uint32_t func, uint32_t ref, uint32_t readMask);
+        void                    SetStencilOp(uint32_t face, uint32_t sfail, uint32_t dpfail, uint32_t dppass);
+        void                    SetStencilWriteMask(uint32_t mask);
+
+        // These are instantiated for both DrawCallState and CompactDrawCallState, which share field names
+        template<typename TDrawCallState> void ApplyDrawCallState(const TDrawCallState& state);
+        template<typename TDrawCallState> void SetShaders(const TDrawCallState& state);
+        template<typename TStageBindings> void BindStageResources(const TStageBindings& state);
+        template<typename TDrawCallState> void BindShaderResources(const TDrawCallState& state);
+        template<typename TDrawCallState> void DrawImpl(const TDrawCallState& state, const DrawArguments* args, uint32_t numDrawCalls);
+        template<typename TDrawCallState> void DrawIndexedImpl(const TDrawCallState& state, const DrawArguments* args, uint32_t numDrawCalls);
+        template<typename TDrawCallState> void DrawIndirectImpl(const TDrawCallState& state, BufferHandle indirectParams, uint32_t offsetBytes);
+        template<typename TDrawCallState> void MultiDrawIndirectImpl(const TDrawCallState& state, bool indexed, BufferHandle argsBuffer, uint32_t argsOffsetBytes, uint32_t argsStrideBytes, uint32_t maxDrawCount, BufferHandle countBuffer, uint32_t countOffsetBytes);
+
+        void                    IssueDraws(uint32_t primType, const DrawArguments* args, uint32_t numDrawCalls);
+        void                    IssueIndexedDraws(uint32_t primType, BufferHandle indexBuffer, Format::Enum indexFormat, uint32_t indexBufferOffset, const DrawArguments* args, uint32_t numDrawCalls);
+        void                    IssueMultiDrawIndirect(uint32_t primType, bool indexed, BufferHandle indexBuffer, Format::Enum indexFormat, uint32_t indexBufferOffset, BufferHandle argsBuffer, uint32_t argsOffsetBytes, uint32_t argsStrideBytes, uint32_t maxDrawCount, BufferHandle countBuffer, uint32_t countOffsetBytes);
 
         void                    ApplyState(const DispatchState& state);
 
+        bool                    ValidateGraphicsState(const GraphicsState& state);
+        bool                    ValidateComputeState(const ComputeState& state);
+        void                    BakeBindings(const PipelineStageBindings& stage, BindingList& list);
+        void                    BindBindingList(const BindingList& list);
+        void                    ApplyState(const GraphicsState& state);
+        void                    ApplyState(const ComputeState& state);
+
         void                    checkGLError(const char* file, int line);
+        void                    QueryCapabilities();
 
         uint32_t                convertStencilOp(DepthStencilState::StencilOp value);
         uint32_t                convertComparisonFunc(DepthStencilState::ComparisonFunc value);
         uint32_t                convertPrimType(PrimitiveType::Enum primType);
+        uint32_t                convertIndexFormat(Format::Enum format);
         uint32_t                convertWrapMode(SamplerDesc::WrapMode in_eMode);
         uint32_t                convertBlendValue(BlendState::BlendValue value);
         uint32_t                convertBlendOp(BlendState::BlendOp value);
@@ -160,6 +160,54 @@ namespace NVRHI
         }
     };
 
+    // A box within one mip level and array slice of a texture.
+    // For 3D textures, arraySlice must be 0 and the box extends along z; for other textures, z must be 0 and depth 1.
+    // The default extents cover the whole mip level. Regions that fail isValid are rejected with an error by all backends.
+    struct TextureRegion
+    {
+        uint32_t mipLevel;
+        uint32_t arraySlice;
+        uint32_t x, y, z;
+        uint32_t width, height, depth;
+
+        TextureRegion()
+            : mipLevel(0), arraySlice(0), x(0), y(0), z(0), width(~0u), height(~0u), depth(~0u)
+        { }
+
+        TextureRegion(uint32_t _mipLevel, uint32_t _arraySlice)
+            : mipLevel(_mipLevel), arraySlice(_arraySlice), x(0), y(0), z(0), width(~0u), height(~0u), depth(~0u)
+        { }
+
+        // Whether the mip level and array slice exist in a texture with the given description; 3D textures have one slice
+        bool isValid(const TextureDesc& desc) const
+        {
+            uint32_t arraySize = ((desc.isArray || desc.isCubeMap) && desc.depthOrArraySize > 1) ? desc.depthOrArraySize : 1;
+            return mipLevel < desc.mipLevels && arraySlice < arraySize;
+        }
+
+        // Returns the region with its extents clamped to the mip level of a texture with the given description,
+        // or with empty extents if the region is not valid for that texture
+        TextureRegion resolve(const TextureDesc& desc) const
+        {
+            TextureRegion result = *this;
+            if (!isValid(desc))
+            {
+                result.width = result.height = result.depth = 0;
+                return result;
+            }
+
+            bool is3D = !desc.isArray && !desc.isCubeMap && desc.depthOrArraySize > 1;
+            uint32_t mipWidth = (desc.width >> mipLevel) ? (desc.width >> mipLevel) : 1;
+            uint32_t mipHeight = (desc.height >> mipLevel) ? (desc.height >> mipLevel) : 1;
+            uint32_t mipDepth = !is3D ? 1 : (desc.depthOrArraySize >> mipLevel) ? (desc.depthOrArraySize >> mipLevel) : 1;
+
+            result.width = x < mipWidth ? (width < mipWidth - x ? width : mipWidth - x) : 0;
+            result.height = y < mipHeight ? (height < mipHeight - y ? height : mipHeight - y) : 0;
+            result.depth = z < mipDepth ? (depth < mipDepth - z ? depth : mipDepth - z) : 0;
+            return result;
+        }
+    };
+
     //////////////////////////////////////////////////////////////////////////
     // Input Layout
     //////////////////////////////////////////////////////////////////////////
@@ -202,6 +250,20 @@ namespace NVRHI
         BufferDesc()  { memset(this, 0, sizeof(*this)); }
     };
 
+    struct MapMode
+    {
+        enum Enum
+        {
+            // The previous contents of the mapped range are not needed. CPU-writable buffers in D3D11 are renamed as a whole,
+            // so their contents outside of the mapped range become undefined; all other buffers keep them.
+            WRITE_DISCARD,
+
+            // The rest of the buffer is preserved. The application guarantees that it does not overwrite
+            // any data used by the commands issued before, so the backend does not need to synchronize.
+            WRITE_NO_OVERWRITE
+        };
+    };
+
     //////////////////////////////////////////////////////////////////////////
     // Constant Buffer
     //////////////////////////////////////////////////////////////////////////
@@ -716,6 +778,440 @@ namespace NVRHI
         { }
     };
 
+    //////////////////////////////////////////////////////////////////////////
+    // Compact Draw Call State
+    //////////////////////////////////////////////////////////////////////////
+
+    // CompactStageBindings and CompactDrawCallState are small alternatives to PipelineStageBindings and DrawCallState
+    // for draws that bind only a few resources per stage. They use the same field names as the full structures,
+    // so the backends process both with the same code, and only the populated entries are ever touched.
+
+    struct CompactStageBindings
+    {
+        enum { INLINE_TEXTURE_BINDINGS = 8, INLINE_SAMPLER_BINDINGS = 4, INLINE_BUFFER_BINDINGS = 4, INLINE_CB_BINDINGS = 4 };
+        enum { MAX_SRV_SLOTS = 128, MAX_UAV_SLOTS = 64 };
+
+        ShaderType::Enum stage;
+        ShaderHandle shader;
+
+        // These point to the inline storage below. A stage that needs more bindings than the inline capacity
+        // can point them to arrays owned by the caller instead; such arrays must stay valid until the draw call returns.
+        const TextureBinding* textures;
+        const SamplerBinding* textureSamplers;
+        const BufferBinding* buffers;
+        const ConstantBufferBinding* constantBuffers;
+        uint8_t textureBindingCount;
+        uint8_t textureSamplerBindingCount;
+        uint8_t bufferBindingCount;
+        uint8_t constantBufferBindingCount;
+
+        // One bit per occupied slot, maintained by the set* functions below
+        uint32_t srvSlotMask[MAX_SRV_SLOTS / 32];
+        uint32_t uavSlotMask[MAX_UAV_SLOTS / 32];
+        uint16_t samplerSlotMask;
+        uint16_t constantBufferSlotMask;
+
+        TextureBinding inlineTextures[INLINE_TEXTURE_BINDINGS];
+        SamplerBinding inlineSamplers[INLINE_SAMPLER_BINDINGS];
+        BufferBinding inlineBuffers[INLINE_BUFFER_BINDINGS];
+        ConstantBufferBinding inlineConstantBuffers[INLINE_CB_BINDINGS];
+
+        CompactStageBindings(ShaderType::Enum _stage = ShaderType::SHADER_PIXEL)
+            : stage(_stage)
+            , shader(nullptr)
+            , textures(inlineTextures)
+            , textureSamplers(inlineSamplers)
+            , buffers(inlineBuffers)
+            , constantBuffers(inlineConstantBuffers)
+            , textureBindingCount(0)
+            , textureSamplerBindingCount(0)
+            , bufferBindingCount(0)
+            , constantBufferBindingCount(0)
+            , samplerSlotMask(0)
+            , constantBufferSlotMask(0)
+        {
+            memset(srvSlotMask, 0, sizeof(srvSlotMask));
+            memset(uavSlotMask, 0, sizeof(uavSlotMask));
+        }
+
+        CompactStageBindings(const CompactStageBindings& other)
+        {
+            *this = other;
+        }
+
+        CompactStageBindings& operator=(const CompactStageBindings& other)
+        {
+            stage = other.stage;
+            shader = other.shader;
+            textureBindingCount = other.textureBindingCount;
+            textureSamplerBindingCount = other.textureSamplerBindingCount;
+            bufferBindingCount = other.bufferBindingCount;
+            constantBufferBindingCount = other.constantBufferBindingCount;
+            memcpy(srvSlotMask, other.srvSlotMask, sizeof(srvSlotMask));
+            memcpy(uavSlotMask, other.uavSlotMask, sizeof(uavSlotMask));
+            samplerSlotMask = other.samplerSlotMask;
+            constantBufferSlotMask = other.constantBufferSlotMask;
+
+            // Only the populated inline entries are copied; pointers to caller-owned arrays are kept as they are
+            textures = other.textures == other.inlineTextures ? inlineTextures : other.textures;
+            textureSamplers = other.textureSamplers == other.inlineSamplers ? inlineSamplers : other.textureSamplers;
+            buffers = other.buffers == other.inlineBuffers ? inlineBuffers : other.buffers;
+            constantBuffers = other.constantBuffers == other.inlineConstantBuffers ? inlineConstantBuffers : other.constantBuffers;
+            if (textures == inlineTextures) memcpy(inlineTextures, other.inlineTextures, textureBindingCount * sizeof(TextureBinding));
+            if (textureSamplers == inlineSamplers) memcpy(inlineSamplers, other.inlineSamplers, textureSamplerBindingCount * sizeof(SamplerBinding));
+            if (buffers == inlineBuffers) memcpy(inlineBuffers, other.inlineBuffers, bufferBindingCount * sizeof(BufferBinding));
+            if (constantBuffers == inlineConstantBuffers) memcpy(inlineConstantBuffers, other.inlineConstantBuffers, constantBufferBindingCount * sizeof(ConstantBufferBinding));
+            return *this;
+        }
+
+        static bool isSlotSet(const uint32_t* mask, uint32_t slot) { return (mask[slot >> 5] & (1u << (slot & 31))) != 0; }
+        static void setSlot(uint32_t* mask, uint32_t slot) { mask[slot >> 5] |= 1u << (slot & 31); }
+
+        // The set* functions replace an existing binding to the same slot and append otherwise.
+        // They return false if the slot is out of range, is occupied by a resource of another kind,
+        // or if the inline storage is full or has been replaced by a caller-owned array.
+
+        bool setTexture(uint32_t slot, TextureHandle texture, Format::Enum format = Format::UNKNOWN, uint32_t mipLevel = 0, bool isWritable = false)
+        {
+            uint32_t* mask = isWritable ? uavSlotMask : srvSlotMask;
+            if (textures != inlineTextures || slot >= (isWritable ? uint32_t(MAX_UAV_SLOTS) : uint32_t(MAX_SRV_SLOTS)))
+                return false;
+
+            TextureBinding* binding = nullptr;
+            if (isSlotSet(mask, slot))
+            {
+                for (uint32_t i = 0; i < textureBindingCount && !binding; i++)
+                    if (inlineTextures[i].slot == slot && inlineTextures[i].isWritable == isWritable)
+                        binding = &inlineTextures[i];
+
+                if (!binding)
+                    return false;
+            }
+            else
+            {
+                if (textureBindingCount == INLINE_TEXTURE_BINDINGS)
+                    return false;
+
+                binding = &inlineTextures[textureBindingCount++];
+                setSlot(mask, slot);
+            }
+
+            binding->texture = texture;
+            binding->slot = slot;
+            binding->format = format;
+            binding->mipLevel = mipLevel;
+            binding->isWritable = isWritable;
+            return true;
+        }
+
+        bool setBuffer(uint32_t slot, BufferHandle buffer, Format::Enum format = Format::UNKNOWN, bool isWritable = false)
+        {
+            uint32_t* mask = isWritable ? uavSlotMask : srvSlotMask;
+            if (buffers != inlineBuffers || slot >= (isWritable ? uint32_t(MAX_UAV_SLOTS) : uint32_t(MAX_SRV_SLOTS)))
+                return false;
+
+            BufferBinding* binding = nullptr;
+            if (isSlotSet(mask, slot))
+            {
+                for (uint32_t i = 0; i < bufferBindingCount && !binding; i++)
+                    if (inlineBuffers[i].slot == slot && inlineBuffers[i].isWritable == isWritable)
+                        binding = &inlineBuffers[i];
+
+                if (!binding)
+                    return false;
+            }
+            else
+            {
+                if (bufferBindingCount == INLINE_BUFFER_BINDINGS)
+                    return false;
+
+                binding = &inlineBuffers[bufferBindingCount++];
+                setSlot(mask, slot);
+            }
+
+            binding->buffer = buffer;
+            binding->slot = slot;
+            binding->format = format;
+            binding->isWritable = isWritable;
+            return true;
+        }
+
+        bool setSampler(uint32_t slot, SamplerHandle sampler)
+        {
+            if (textureSamplers != inlineSamplers || slot >= PipelineStageBindings::MAX_SAMPLER_BINDINGS)
+                return false;
+
+            if (samplerSlotMask & (1u << slot))
+            {
+                for (uint32_t i = 0; i < textureSamplerBindingCount; i++)
+                    if (inlineSamplers[i].slot == slot)
+                        inlineSamplers[i].sampler = sampler;
+                return true;
+            }
+
+            if (textureSamplerBindingCount == INLINE_SAMPLER_BINDINGS)
+                return false;
+
+            inlineSamplers[textureSamplerBindingCount].sampler = sampler;
+            inlineSamplers[textureSamplerBindingCount].slot = slot;
+            textureSamplerBindingCount++;
+            samplerSlotMask |= uint16_t(1u << slot);
+            return true;
+        }
+
+        bool setConstantBuffer(uint32_t slot, ConstantBufferHandle buffer)
+        {
+            if (constantBuffers != inlineConstantBuffers || slot >= PipelineStageBindings::MAX_CB_BINDINGS)
+                return false;
+
+            if (constantBufferSlotMask & (1u << slot))
+            {
+                for (uint32_t i = 0; i < constantBufferBindingCount; i++)
+                    if (inlineConstantBuffers[i].slot == slot)
+                        inlineConstantBuffers[i].buffer = buffer;
+                return true;
+            }
+
+            if (constantBufferBindingCount == INLINE_CB_BINDINGS)
+                return false;
+
+            inlineConstantBuffers[constantBufferBindingCount].buffer = buffer;
+            inlineConstantBuffers[constantBufferBindingCount].slot = slot;
+            constantBufferBindingCount++;
+            constantBufferSlotMask |= uint16_t(1u << slot);
+            return true;
+        }
+    };
+
+    // The render state is referenced rather than copied because it is normally shared by all draw calls of a pass.
+    // It must stay valid until the draw call returns.
+    struct CompactDrawCallState
+    {
+        enum { INLINE_VERTEX_BUFFERS = 4 };
+
+        PrimitiveType::Enum primType;
+        InputLayoutHandle inputLayout;
+        BufferHandle indexBuffer;
+        Format::Enum indexBufferFormat;
+        uint32_t indexBufferOffset;
+
+        CompactStageBindings VS;
+        CompactStageBindings HS;
+        CompactStageBindings DS;
+        CompactStageBindings GS;
+        CompactStageBindings PS;
+
+        // Points to inlineVertexBuffers unless redirected to a caller-owned array, same as the stage bindings
+        uint32_t vertexBufferCount;
+        const VertexBufferBinding* vertexBuffers;
+        VertexBufferBinding inlineVertexBuffers[INLINE_VERTEX_BUFFERS];
+
+        const RenderState& renderState;
+
+        explicit CompactDrawCallState(const RenderState& _renderState)
+            : primType(PrimitiveType::TRIANGLE_LIST)
+            , inputLayout(nullptr)
+            , indexBuffer(nullptr)
+            , indexBufferFormat(Format::R32_UINT)
+            , indexBufferOffset(0)
+            , VS(ShaderType::SHADER_VERTEX)
+            , HS(ShaderType::SHADER_HULL)
+            , DS(ShaderType::SHADER_DOMAIN)
+            , GS(ShaderType::SHADER_GEOMETRY)
+            , PS(ShaderType::SHADER_PIXEL)
+            , vertexBufferCount(0)
+            , vertexBuffers(inlineVertexBuffers)
+            , renderState(_renderState)
+        { }
+
+        CompactDrawCallState(const CompactDrawCallState& other)
+            : primType(other.primType)
+            , inputLayout(other.inputLayout)
+            , indexBuffer(other.indexBuffer)
+            , indexBufferFormat(other.indexBufferFormat)
+            , indexBufferOffset(other.indexBufferOffset)
+            , VS(other.VS)
+            , HS(other.HS)
+            , DS(other.DS)
+            , GS(other.GS)
+            , PS(other.PS)
+            , vertexBufferCount(other.vertexBufferCount)
+            , vertexBuffers(other.vertexBuffers == other.inlineVertexBuffers ? inlineVertexBuffers : other.vertexBuffers)
+            , renderState(other.renderState)
+        {
+            if (vertexBuffers == inlineVertexBuffers)
+                memcpy(inlineVertexBuffers, other.inlineVertexBuffers, vertexBufferCount * sizeof(VertexBufferBinding));
+        }
+
+        bool addVertexBuffer(const VertexBufferBinding& binding)
+        {
+            if (vertexBuffers != inlineVertexBuffers || vertexBufferCount == INLINE_VERTEX_BUFFERS)
+                return false;
+
+            inlineVertexBuffers[vertexBufferCount++] = binding;
+            return true;
+        }
+
+    private:
+        CompactDrawCallState& operator=(const CompactDrawCallState& other); //undefined
+    };
+
+    // Keep the compact state an order of magnitude smaller than DrawCallState
+    static_assert(sizeof(CompactStageBindings) <= 512, "CompactStageBindings exceeds its size budget");
+    static_assert(sizeof(CompactDrawCallState) <= 3072, "CompactDrawCallState exceeds its size budget");
+
+    //////////////////////////////////////////////////////////////////////////
+    // Pipelines and Binding Sets
+    //////////////////////////////////////////////////////////////////////////
+
+    // Pipelines and binding sets are immutable objects that capture the parts of DrawCallState and DispatchState
+    // that rarely change from one draw call to the next. The backend validates them and translates them into
+    // API objects once, at creation time, so that drawing with a GraphicsState or ComputeState only has to
+    // apply the per-draw state: vertex and index buffers, render targets and viewports.
+
+    class GraphicsPipeline;
+    typedef GraphicsPipeline* GraphicsPipelineHandle;
+
+    class ComputePipeline;
+    typedef ComputePipeline* ComputePipelineHandle;
+
+    class BindingSet;
+    typedef BindingSet* BindingSetHandle;
+
+    struct GraphicsPipelineDesc
+    {
+        PrimitiveType::Enum primType;
+        InputLayoutHandle inputLayout;
+
+        ShaderHandle VS;
+        ShaderHandle HS;
+        ShaderHandle DS;
+        ShaderHandle GS;
+        ShaderHandle PS;
+
+        BlendState blendState;
+        DepthStencilState depthStencilState;
+        RasterState rasterState;
+
+        // Formats and sample count of the render targets that the pipeline will be used with.
+        // D3D12 bakes these into the pipeline state object; other backends only use them for validation.
+        uint32_t renderTargetCount;
+        Format::Enum renderTargetFormats[RenderState::MAX_RENDER_TARGETS];
+        Format::Enum depthTargetFormat;
+        uint32_t sampleCount;
+        uint32_t sampleQuality;
+
+        // Same as RenderState::setupExtraVoxelizationState
+        bool setupExtraVoxelizationState;
+
+        GraphicsPipelineDesc()
+            : primType(PrimitiveType::TRIANGLE_LIST)
+            , inputLayout(nullptr)
+            , VS(nullptr)
+            , HS(nullptr)
+            , DS(nullptr)
+            , GS(nullptr)
+            , PS(nullptr)
+            , renderTargetCount(0)
+            , depthTargetFormat(Format::UNKNOWN)
+            , sampleCount(1)
+            , sampleQuality(0)
+            , setupExtraVoxelizationState(false)
+        {
+            for (uint32_t rt = 0; rt < RenderState::MAX_RENDER_TARGETS; rt++)
+                renderTargetFormats[rt] = Format::UNKNOWN;
+        }
+    };
+
+    struct ComputePipelineDesc
+    {
+        ShaderHandle CS;
+
+        ComputePipelineDesc()
+            : CS(nullptr)
+        { }
+    };
+
+    // The "shader" field of every stage identifies the shader that the bindings are laid out for,
+    // and it must match the corresponding shader of the pipeline that the binding set is used with.
+    // Stages without a shader are ignored. A binding set must be destroyed before the resources it references.
+    struct BindingSetDesc
+    {
+        PipelineStageBindings VS;
+        PipelineStageBindings HS;
+        PipelineStageBindings DS;
+        PipelineStageBindings GS;
+        PipelineStageBindings PS;
+        PipelineStageBindings CS;
+
+        BindingSetDesc()
+            : VS(ShaderType::SHADER_VERTEX)
+            , HS(ShaderType::SHADER_HULL)
+            , DS(ShaderType::SHADER_DOMAIN)
+            , GS(ShaderType::SHADER_GEOMETRY)
+            , PS(ShaderType::SHADER_PIXEL)
+            , CS(ShaderType::SHADER_COMPUTE)
+        { }
+    };
+
+    // Per-draw state used together with a graphics pipeline and a binding set.
+    // Render targets are not cleared here; use clearTextureFloat or clearTextureUInt instead.
+    struct GraphicsState
+    {
+        GraphicsPipelineHandle pipeline;
+        BindingSetHandle bindings;
+
+        BufferHandle indexBuffer;
+        Format::Enum indexBufferFormat;
+        uint32_t indexBufferOffset;
+
+        uint32_t vertexBufferCount;
+        VertexBufferBinding vertexBuffers[DrawCallState::MAX_VERTEX_ATTRIBUTE_COUNT];
+
+        uint32_t targetCount;
+        TextureHandle targets[RenderState::MAX_RENDER_TARGETS];
+        uint32_t targetIndicies[RenderState::MAX_RENDER_TARGETS];
+        uint32_t targetMipSlices[RenderState::MAX_RENDER_TARGETS];
+
+        TextureHandle depthTarget;
+        uint32_t depthIndex;
+        uint32_t depthMipSlice;
+
+        uint32_t viewportCount;
+        Viewport viewports[RenderState::MAX_VIEWPORTS];
+        Rect     scissorRects[RenderState::MAX_VIEWPORTS];
+
+        GraphicsState()
+            : pipeline(nullptr)
+            , bindings(nullptr)
+            , indexBuffer(nullptr)
+            , indexBufferFormat(Format::R32_UINT)
+            , indexBufferOffset(0)
+            , vertexBufferCount(0)
+            , targetCount(0)
+            , depthTarget(nullptr)
+            , depthIndex(0)
+            , depthMipSlice(0)
+            , viewportCount(0)
+        {
+            memset(vertexBuffers, 0, sizeof(vertexBuffers));
+            memset(targets, 0, sizeof(targets));
+            memset(targetIndicies, 0, sizeof(targetIndicies));
+            memset(targetMipSlices, 0, sizeof(targetMipSlices));
+        }
+    };
+
+    struct ComputeState
+    {
+        ComputePipelineHandle pipeline;
+        BindingSetHandle bindings;
+
+        ComputeState()
+            : pipeline(nullptr)
+            , bindings(nullptr)
+        { }
+    };
+
     //////////////////////////////////////////////////////////////////////////
     // Misc
     //////////////////////////////////////////////////////////////////////////
@@ -743,6 +1239,49 @@ namespace NVRHI
     class PerformanceQuery;
     typedef PerformanceQuery* PerformanceQueryHandle;
 
+    // A ticket for data that is being copied into CPU-readable staging memory, see IRendererInterface::beginReadback
+    class Readback;
+    typedef Readback* ReadbackHandle;
+
+    // A GPU timeline: a 64-bit value that advances when the GPU reaches the points where the fence was signaled
+    class Fence;
+    typedef Fence* FenceHandle;
+
+    struct PoolStatistics
+    {
+        uint64_t capacity;  // Size of the pool, in the units given in FrameStatistics
+        uint64_t inUse;     // Allocated and not retired yet
+        uint64_t peak;      // Largest inUse value since the renderer was created
+
+        PoolStatistics() : capacity(0), inUse(0), peak(0) { }
+    };
+
+    struct CacheStatistics
+    {
+        uint64_t hits;      // Lookups that found an existing object
+        uint64_t misses;    // Lookups that created a new object
+        uint64_t evictions; // Objects removed to stay within the limits, see IRendererInterface::setStateCacheLimits
+        uint64_t entries;   // Objects in the cache now
+        uint64_t bytes;     // Estimated memory of those objects
+
+        CacheStatistics() : hits(0), misses(0), evictions(0), entries(0), bytes(0) { }
+    };
+
+    // Returned by IRendererInterface::getFrameStatistics. Pools that a backend doesn't have are reported as zeros.
+    struct FrameStatistics
+    {
+        uint64_t frameIndex;                // Number of endFrame calls
+        uint32_t framesInFlight;            // Frames ended on the CPU that the GPU hasn't finished yet
+        uint32_t pendingDeletions;          // Destroyed objects that are waiting for the GPU before they are freed
+        PoolStatistics uploadBytes;         // Upload ring used by buffer, texture and constant buffer writes
+        PoolStatistics viewDescriptors;     // Shader-visible CBV/SRV/UAV descriptor ring
+        PoolStatistics samplerDescriptors;  // Shader-visible sampler descriptor ring
+        PoolStatistics readbackBytes;       // Staging memory owned by the readback pool
+        CacheStatistics stateObjects;       // Framebuffers, pipeline states, root signatures and D3D11 state objects created for draw calls
+
+        FrameStatistics() : frameIndex(0), framesInFlight(0), pendingDeletions(0) { }
+    };
+
     struct DrawArguments
     {
         uint32_t vertexCount;
@@ -760,6 +1299,42 @@ namespace NVRHI
         { }
     };
 
+    // Layout of the records in the argument buffers of drawIndirect and multiDrawIndirect.
+    // Same as D3D12_DRAW_ARGUMENTS and DrawArraysIndirectCommand in GL.
+    struct DrawIndirectArguments
+    {
+        uint32_t vertexCount;
+        uint32_t instanceCount;
+        uint32_t startVertexLocation;
+        uint32_t startInstanceLocation;
+
+        DrawIndirectArguments()
+            : vertexCount(0)
+            , instanceCount(1)
+            , startVertexLocation(0)
+            , startInstanceLocation(0)
+        { }
+    };
+
+    // Layout of the records in the argument buffers of drawIndexedIndirect and multiDrawIndexedIndirect.
+    // Same as D3D12_DRAW_INDEXED_ARGUMENTS and DrawElementsIndirectCommand in GL.
+    struct DrawIndexedIndirectArguments
+    {
+        uint32_t indexCount;
+        uint32_t instanceCount;
+        uint32_t startIndexLocation;
+        int32_t baseVertexLocation;
+        uint32_t startInstanceLocation;
+
+        DrawIndexedIndirectArguments()
+            : indexCount(0)
+            , instanceCount(1)
+            , startIndexLocation(0)
+            , baseVertexLocation(0)
+            , startInstanceLocation(0)
+        { }
+    };
+
     // Should be implemented by the application.
     // Clients will call signalError(...) on every error it encounters, in addition to returning one of the 
     // failure status codes. The application can display a message box in case of errors.
@@ -773,6 +1348,49 @@ namespace NVRHI
     };
 
 
+    //////////////////////////////////////////////////////////////////////////
+    // Command Lists
+    //////////////////////////////////////////////////////////////////////////
+
+    // A command list records rendering work that is executed later by IRendererInterface::executeCommandLists.
+    // Recording does not access the renderer or the graphics API, so different command lists can be recorded
+    // concurrently on different threads. A single command list must only be used by one thread at a time.
+    // Only the pipeline-based state is accepted because it references immutable objects.
+    // The state and the data arguments are copied into the list when a command is recorded, but the
+    // resources, pipelines and binding sets they reference must stay alive until the list is executed.
+    class ICommandList
+    {
+        ICommandList& operator=(const ICommandList& other); //undefined
+    protected:
+        // Use IRendererInterface::destroyCommandList
+        virtual ~ICommandList() {};
+    public:
+        // Discards the recorded commands so that the list can be recorded again.
+        // A recorded list can be executed any number of times.
+        virtual void reset() = 0;
+
+        virtual void draw(const GraphicsState& state, const DrawArguments* args, uint32_t numDrawCalls) = 0;
+        virtual void drawIndexed(const GraphicsState& state, const DrawArguments* args, uint32_t numDrawCalls) = 0;
+        virtual void drawIndirect(const GraphicsState& state, BufferHandle indirectParams, uint32_t offsetBytes) = 0;
+
+        virtual void dispatch(const ComputeState& state, uint32_t groupsX, uint32_t groupsY, uint32_t groupsZ) = 0;
+        virtual void dispatchIndirect(const ComputeState& state, BufferHandle indirectParams, uint32_t offsetBytes) = 0;
+
+        virtual void clearTextureFloat(TextureHandle t, const Color& clearColor) = 0;
+        virtual void clearTextureUInt(TextureHandle t, uint32_t clearColor) = 0;
+        virtual void clearBufferUInt(BufferHandle b, uint32_t clearValue) = 0;
+        virtual void copyToBuffer(BufferHandle dest, uint32_t destOffsetBytes, BufferHandle src, uint32_t srcOffsetBytes, size_t dataSizeBytes) = 0;
+        virtual void writeConstantBuffer(ConstantBufferHandle b, const void* data, size_t dataSize) = 0;
+
+        // See the indirect draw functions of IRendererInterface
+        virtual void drawIndexedIndirect(const GraphicsState& state, BufferHandle indirectParams, uint32_t offsetBytes) = 0;
+        virtual void multiDrawIndirect(const GraphicsState& state, BufferHandle argsBuffer, uint32_t argsOffsetBytes, uint32_t argsStrideBytes, uint32_t maxDrawCount, BufferHandle countBuffer, uint32_t countOffsetBytes) = 0;
+        virtual void multiDrawIndexedIndirect(const GraphicsState& state, BufferHandle argsBuffer, uint32_t argsOffsetBytes, uint32_t argsStrideBytes, uint32_t maxDrawCount, BufferHandle countBuffer, uint32_t countOffsetBytes) = 0;
+    };
+
+    typedef ICommandList* CommandListHandle;
+
+
     //////////////////////////////////////////////////////////////////////////
     // IRendererInterface
     //////////////////////////////////////////////////////////////////////////
@@ -861,6 +1479,154 @@ namespace NVRHI
 		// A barrier should still be placed before the first draw call in the group and after the last one.
 		virtual void setEnableUavBarriersForTexture(TextureHandle texture, bool enableBarriers) = 0;
 		virtual void setEnableUavBarriersForBuffer(BufferHandle buffer, bool enableBarriers) = 0;
+
+        // Pipelines and binding sets, see the "Pipelines and Binding Sets" section above.
+        // These are appended at the end of the interface to keep the layout of the existing methods intact.
+        // Pipelines must be destroyed before the shaders and input layouts they reference.
+        virtual GraphicsPipelineHandle createGraphicsPipeline(const GraphicsPipelineDesc& d) = 0;
+        virtual void destroyGraphicsPipeline(GraphicsPipelineHandle p) = 0;
+        virtual ComputePipelineHandle createComputePipeline(const ComputePipelineDesc& d) = 0;
+        virtual void destroyComputePipeline(ComputePipelineHandle p) = 0;
+        virtual BindingSetHandle createBindingSet(const BindingSetDesc& d) = 0;
+        virtual void destroyBindingSet(BindingSetHandle b) = 0;
+
+        virtual void drawWithPipeline(const GraphicsState& state, const DrawArguments* args, uint32_t numDrawCalls) = 0;
+        virtual void drawIndexedWithPipeline(const GraphicsState& state, const DrawArguments* args, uint32_t numDrawCalls) = 0;
+        virtual void drawIndirectWithPipeline(const GraphicsState& state, BufferHandle indirectParams, uint32_t offsetBytes) = 0;
+
+        virtual void dispatchWithPipeline(const ComputeState& state, uint32_t groupsX, uint32_t groupsY, uint32_t groupsZ) = 0;
+        virtual void dispatchIndirectWithPipeline(const ComputeState& state, BufferHandle indirectParams, uint32_t offsetBytes) = 0;
+
+        // Same as draw, drawIndexed and drawIndirect with a DrawCallState, see the "Compact Draw Call State" section above
+        virtual void drawCompact(const CompactDrawCallState& state, const DrawArguments* args, uint32_t numDrawCalls) = 0;
+        virtual void drawIndexedCompact(const CompactDrawCallState& state, const DrawArguments* args, uint32_t numDrawCalls) = 0;
+        virtual void drawIndirectCompact(const CompactDrawCallState& state, BufferHandle indirectParams, uint32_t offsetBytes) = 0;
+
+        // Command lists, see the "Command Lists" section above.
+        // Lists are created and destroyed on the render thread; a list must not be destroyed while it is being recorded.
+        // executeCommandLists runs the recorded commands of every list in array order, as if they were issued
+        // on the renderer directly, and must be called on the render thread.
+        virtual CommandListHandle createCommandList() = 0;
+        virtual void destroyCommandList(CommandListHandle commandList) = 0;
+        virtual void executeCommandLists(const CommandListHandle* commandLists, uint32_t numCommandLists) = 0;
+
+        // Asynchronous readback. beginBufferReadback and beginTextureReadback schedule a copy into staging memory
+        // that the backend recycles, and return a ticket without waiting for the GPU. The copy sees all work issued before it.
+        // isReadbackReady polls the ticket. mapReadback returns the data, waiting for the copy if it is not complete yet;
+        // the pointer stays valid until releaseReadback, which returns the staging memory to the backend.
+        // Buffer data starts at the requested offset. Texture rows are rowPitch bytes apart and depth slices depthPitch bytes apart;
+        // the pitch pointers may be null. Every ticket must be released, including the ones that were never mapped.
+        virtual ReadbackHandle beginBufferReadback(BufferHandle b, uint32_t offsetBytes, size_t sizeBytes) = 0;
+        virtual ReadbackHandle beginTextureReadback(TextureHandle t, const TextureRegion& region) = 0;
+        virtual bool isReadbackReady(ReadbackHandle r) = 0;
+        virtual const void* mapReadback(ReadbackHandle r, uint32_t* rowPitch, uint32_t* depthPitch) = 0;
+        virtual void releaseReadback(ReadbackHandle r) = 0;
+
+        ReadbackHandle beginReadback(BufferHandle b, uint32_t offsetBytes, size_t sizeBytes) { return beginBufferReadback(b, offsetBytes, sizeBytes); }
+        ReadbackHandle beginReadback(TextureHandle t, const TextureRegion& region) { return beginTextureReadback(t, region); }
+
+        // Maps a range of a buffer for writing and returns a pointer to the start of the range. D3D11 maps CPU-writable
+        // buffers directly; otherwise the range is written into staging memory and copied into the buffer by unmapBuffer,
+        // which D3D12 and GL take from their upload ring. GL maps ranges larger than a quarter of the ring directly,
+        // and a mapping keeps the ring from being reused past it, so unmap soon.
+        // The data can be written from any thread, but mapBuffer and unmapBuffer must be called on the render thread.
+        // Only one range of a buffer can be mapped at a time, and the buffer must not be used by commands issued
+        // between mapBuffer and unmapBuffer. The written data is visible to the commands issued after unmapBuffer.
+        virtual void* mapBuffer(BufferHandle b, MapMode::Enum mode, uint32_t offsetBytes, size_t sizeBytes) = 0;
+        virtual void unmapBuffer(BufferHandle b) = 0;
+
+        // Partial updates that only transfer the affected bytes or texels.
+        // writeBufferRange writes dataSize bytes starting at offsetBytes. clearBufferUIntRange clears sizeBytes bytes starting
+        // at offsetBytes; both must be multiples of the element size, which is 4 bytes or structStride for structured buffers.
+        // writeTextureRegion writes the region of one mip level and array slice (or cube face) of a texture; the source rows
+        // are rowPitch bytes apart and the depth slices depthPitch bytes apart, like in writeTexture.
+        virtual void writeBufferRange(BufferHandle b, uint32_t offsetBytes, const void* data, size_t dataSize) = 0;
+        virtual void clearBufferUIntRange(BufferHandle b, uint32_t offsetBytes, size_t sizeBytes, uint32_t clearValue) = 0;
+        virtual void writeTextureRegion(TextureHandle t, const TextureRegion& region, const void* data, uint32_t rowPitch, uint32_t depthPitch) = 0;
+
+        // GPU-side copies. The copied area is the texture region clamped to its subresource; in copyTexture that is the source
+        // region, and only the mip level, array slice and origin of the destination region are used. copyTexture needs formats
+        // with the same texel size and equal sample counts. For buffer <-> texture copies, the rows in the buffer are rowPitch
+        // bytes apart and the depth slices depthPitch bytes apart; D3D12 requires a 512-byte aligned offset and a 256-byte
+        // aligned rowPitch, and D3D11 does not support these copies at all. resolveTexture resolves one array slice of
+        // a multisampled texture into one subresource of a single-sampled texture of the same size; the D3D backends only
+        // resolve color formats.
+        virtual void copyTexture(TextureHandle dest, const TextureRegion& destRegion, TextureHandle src, const TextureRegion& srcRegion) = 0;
+        virtual void copyBufferToTexture(TextureHandle dest, const TextureRegion& destRegion, BufferHandle src, uint32_t srcOffsetBytes, uint32_t rowPitch, uint32_t depthPitch) = 0;
+        virtual void copyTextureToBuffer(BufferHandle dest, uint32_t destOffsetBytes, uint32_t rowPitch, uint32_t depthPitch, TextureHandle src, const TextureRegion& srcRegion) = 0;
+        virtual void resolveTexture(TextureHandle dest, uint32_t destMipLevel, uint32_t destArraySlice, TextureHandle src, uint32_t srcArraySlice) = 0;
+
+        // Same as clearTextureFloat and clearTextureUInt, but only for a region of one mip level and array slice or cube face;
+        // for 3D textures, the region selects a range of depth slices. D3D11 can only clear partial rectangles of
+        // 2D and array textures, and only when the context supports ID3D11DeviceContext1::ClearView.
+        virtual void clearTextureRegionFloat(TextureHandle t, const TextureRegion& region, const Color& clearColor) = 0;
+        virtual void clearTextureRegionUInt(TextureHandle t, const TextureRegion& region, uint32_t clearColor) = 0;
+
+        // Timeline fences. signalFence sets the fence to the value once the GPU has finished all previously issued commands;
+        // the signaled values must increase. getFenceCompletedValue returns the last value reached without waiting,
+        // and waitFence blocks the calling thread until the value is reached. A new fence starts at zero.
+        // On D3D12, signalFence submits the pending commands to the queue.
+        virtual FenceHandle createFence() = 0;
+        virtual void destroyFence(FenceHandle f) = 0;
+        virtual void signalFence(FenceHandle f, uint64_t value) = 0;
+        virtual uint64_t getFenceCompletedValue(FenceHandle f) = 0;
+        virtual void waitFence(FenceHandle f, uint64_t value) = 0;
+
+        // Frame boundaries. endFrame submits the work of the frame and retires the transient allocations and deferred
+        // deletions of the frames that the GPU has finished, without waiting. beginFrame blocks while maxFramesInFlight
+        // frames are still queued on the GPU, which bounds the latency and the memory held by transient pools.
+        // The default is 2 frames in flight. Applications that never call these functions keep the old behavior.
+        virtual void setMaxFramesInFlight(uint32_t maxFrames) = 0;
+        virtual void beginFrame() = 0;
+        virtual void endFrame() = 0;
+        virtual FrameStatistics getFrameStatistics() = 0;
+
+        // Indexed and multiple indirect draws, for all three kinds of draw state.
+        // The argument buffer holds maxDrawCount records of DrawIndirectArguments or DrawIndexedIndirectArguments starting at
+        // argsOffsetBytes and argsStrideBytes apart; a stride of 0 means tightly packed records, other strides must be multiples of 4.
+        // When countBuffer is not null, the number of draws is the minimum of maxDrawCount and the uint32 at countOffsetBytes
+        // in that buffer, so that a GPU pass can write a compacted list of draws and their count.
+        // The argument and count buffers must be created with isDrawIndirectArgs. Indexed indirect draws require a zero
+        // indexBufferOffset on all backends, because GL has no way to apply it; put the offset into startIndexLocation of the records
+        // instead. On GL, the count buffer requires ARB_indirect_parameters. D3D11 issues the draws one by one
+        // and does not support the count buffer.
+        virtual void drawIndexedIndirect(const DrawCallState& state, BufferHandle indirectParams, uint32_t offsetBytes) = 0;
+        virtual void multiDrawIndirect(const DrawCallState& state, BufferHandle argsBuffer, uint32_t argsOffsetBytes, uint32_t argsStrideBytes, uint32_t maxDrawCount, BufferHandle countBuffer, uint32_t countOffsetBytes) = 0;
+        virtual void multiDrawIndexedIndirect(const DrawCallState& state, BufferHandle argsBuffer, uint32_t argsOffsetBytes, uint32_t argsStrideBytes, uint32_t maxDrawCount, BufferHandle countBuffer, uint32_t countOffsetBytes) = 0;
+        virtual void drawIndexedIndirectWithPipeline(const GraphicsState& state, BufferHandle indirectParams, uint32_t offsetBytes) = 0;
+        virtual void multiDrawIndirectWithPipeline(const GraphicsState& state, BufferHandle argsBuffer, uint32_t argsOffsetBytes, uint32_t argsStrideBytes, uint32_t maxDrawCount, BufferHandle countBuffer, uint32_t countOffsetBytes) = 0;
+        virtual void multiDrawIndexedIndirectWithPipeline(const GraphicsState& state, BufferHandle argsBuffer, uint32_t argsOffsetBytes, uint32_t argsStrideBytes, uint32_t maxDrawCount, BufferHandle countBuffer, uint32_t countOffsetBytes) = 0;
+        virtual void drawIndexedIndirectCompact(const CompactDrawCallState& state, BufferHandle indirectParams, uint32_t offsetBytes) = 0;
+        virtual void multiDrawIndirectCompact(const CompactDrawCallState& state, BufferHandle argsBuffer, uint32_t argsOffsetBytes, uint32_t argsStrideBytes, uint32_t maxDrawCount, BufferHandle countBuffer, uint32_t countOffsetBytes) = 0;
+        virtual void multiDrawIndexedIndirectCompact(const CompactDrawCallState& state, BufferHandle argsBuffer, uint32_t argsOffsetBytes, uint32_t argsStrideBytes, uint32_t maxDrawCount, BufferHandle countBuffer, uint32_t countOffsetBytes) = 0;
+
+        // Limits of the caches of objects that the backends create on demand for draw and dispatch states: GL framebuffers,
+        // D3D12 pipeline states and root signatures, and D3D11 blend, depth-stencil and rasterizer states. Each cache evicts
+        // its least recently used objects when it holds more than maxEntries objects or more than maxBytes of estimated memory;
+        // 0 means no limit. Evicted objects are destroyed after the GPU has finished using them, and are created again when
+        // they are needed. The default is 4096 entries, the D3D11 limit of unique state objects of each kind, and no byte limit.
+        virtual void setStateCacheLimits(uint32_t maxEntries, uint64_t maxBytes) = 0;
+
+        void draw(const GraphicsState& state, const DrawArguments* args, uint32_t numDrawCalls) { drawWithPipeline(state, args, numDrawCalls); }
+        void drawIndexed(const GraphicsState& state, const DrawArguments* args, uint32_t numDrawCalls) { drawIndexedWithPipeline(state, args, numDrawCalls); }
+        void drawIndirect(const GraphicsState& state, BufferHandle indirectParams, uint32_t offsetBytes) { drawIndirectWithPipeline(state, indirectParams, offsetBytes); }
+        void drawIndexedIndirect(const GraphicsState& state, BufferHandle indirectParams, uint32_t offsetBytes) { drawIndexedIndirectWithPipeline(state, indirectParams, offsetBytes); }
+        void multiDrawIndirect(const GraphicsState& state, BufferHandle argsBuffer, uint32_t argsOffsetBytes, uint32_t argsStrideBytes, uint32_t maxDrawCount, BufferHandle countBuffer, uint32_t countOffsetBytes)
+            { multiDrawIndirectWithPipeline(state, argsBuffer, argsOffsetBytes, argsStrideBytes, maxDrawCount, countBuffer, countOffsetBytes); }
+        void multiDrawIndexedIndirect(const GraphicsState& state, BufferHandle argsBuffer, uint32_t argsOffsetBytes, uint32_t argsStrideBytes, uint32_t maxDrawCount, BufferHandle countBuffer, uint32_t countOffsetBytes)
+            { multiDrawIndexedIndirectWithPipeline(state, argsBuffer, argsOffsetBytes, argsStrideBytes, maxDrawCount, countBuffer, countOffsetBytes); }
+
+        void draw(const CompactDrawCallState& state, const DrawArguments* args, uint32_t numDrawCalls) { drawCompact(state, args, numDrawCalls); }
+        void drawIndexed(const CompactDrawCallState& state, const DrawArguments* args, uint32_t numDrawCalls) { drawIndexedCompact(state, args, numDrawCalls); }
+        void drawIndirect(const CompactDrawCallState& state, BufferHandle indirectParams, uint32_t offsetBytes) { drawIndirectCompact(state, indirectParams, offsetBytes); }
+        void drawIndexedIndirect(const CompactDrawCallState& state, BufferHandle indirectParams, uint32_t offsetBytes) { drawIndexedIndirectCompact(state, indirectParams, offsetBytes); }
+        void multiDrawIndirect(const CompactDrawCallState& state, BufferHandle argsBuffer, uint32_t argsOffsetBytes, uint32_t argsStrideBytes, uint32_t maxDrawCount, BufferHandle countBuffer, uint32_t countOffsetBytes)
+            { multiDrawIndirectCompact(state, argsBuffer, argsOffsetBytes, argsStrideBytes, maxDrawCount, countBuffer, countOffsetBytes); }
+        void multiDrawIndexedIndirect(const CompactDrawCallState& state, BufferHandle argsBuffer, uint32_t argsOffsetBytes, uint32_t argsStrideBytes, uint32_t maxDrawCount, BufferHandle countBuffer, uint32_t countOffsetBytes)
+            { multiDrawIndexedIndirectCompact(state, argsBuffer, argsOffsetBytes, argsStrideBytes, maxDrawCount, countBuffer, countOffsetBytes); }
+
+        void dispatch(const ComputeState& state, uint32_t groupsX, uint32_t groupsY, uint32_t groupsZ) { dispatchWithPipeline(state, groupsX, groupsY, groupsZ); }
+        void dispatchIndirect(const ComputeState& state, BufferHandle indirectParams, uint32_t offsetBytes) { dispatchIndirectWithPipeline(state, indirectParams, offsetBytes); }
     };
 
 }